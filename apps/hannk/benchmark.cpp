@@ -1,10 +1,12 @@
 #include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
 #include "HalideRuntime.h"
 
 #include "halide_benchmark.h"
+#include "interpreter/batch_interpreter.h"
 #include "interpreter/interpreter.h"
 #include "tflite/tflite_parser.h"
 #include "util/error_util.h"
@@ -12,7 +14,8 @@
 
 namespace hannk {
 
-void run_benchmark(const std::string &filename, const InterpreterOptions &options) {
+void run_benchmark(const std::string &filename, const InterpreterOptions &options,
+                   const std::string &profile_trace) {
     if (!options.trace) {
         // In trace mode, don't send *anything* to stdout
         std::cout << filename;
@@ -34,7 +37,26 @@ void run_benchmark(const std::string &filename, const InterpreterOptions &option
 
     if (!options.trace) {
         auto result = Halide::Tools::benchmark([&]() { interpreter.execute(); });
-        std::cout << ": " << result.wall_time * 1e6 << " us" << std::endl;
+        std::cout << ": " << result.wall_time * 1e6 << " us";
+        if (options.inter_op_threads > 1) {
+            std::cout << " (" << options.inter_op_threads << " inter-op threads)";
+        }
+        if (options.tile_cache_size > 0) {
+            std::cout << " (tiled for " << options.tile_cache_size << " bytes)";
+        }
+        std::cout << std::endl;
+
+        if (Profiler *profiler = interpreter.profiler()) {
+            profiler->dump(std::cout);
+            if (!profile_trace.empty()) {
+                std::ofstream trace(profile_trace);
+                profiler->write_chrome_trace(trace);
+                if (!trace) {
+                    std::cerr << "Unable to write " << profile_trace << "\n";
+                    exit(-1);
+                }
+            }
+        }
 
         halide_profiler_report(nullptr);
         halide_profiler_reset();
@@ -44,6 +66,90 @@ void run_benchmark(const std::string &filename, const InterpreterOptions &option
     }
 }
 
+// Compare the latency of the model with and without elementwise ops fused into convs.
+void run_fusion_comparison(const std::string &filename, InterpreterOptions options) {
+    std::cout << filename;
+
+    std::vector<char> buffer = read_entire_file(filename);
+
+    double wall_time[2];
+    for (int fused = 0; fused < 2; fused++) {
+        options.fuse_elementwise = fused != 0;
+        Interpreter interpreter(parse_tflite_model_from_buffer(buffer.data()), options);
+        if (!interpreter.prepare()) {
+            std::cerr << "hannk::Interpreter::prepare() failed\n";
+            exit(-1);
+        }
+        wall_time[fused] = Halide::Tools::benchmark([&]() { interpreter.execute(); }).wall_time;
+    }
+    std::cout << ": " << wall_time[1] * 1e6 << " us fused, "
+              << wall_time[0] * 1e6 << " us unfused ("
+              << wall_time[0] / wall_time[1] << "x)" << std::endl;
+}
+
+// Report the arena size needed for the model by each allocation strategy,
+// compared to the lower bound.
+void run_allocation_comparison(const std::string &filename, InterpreterOptions options) {
+    std::cout << filename << ":";
+
+    std::vector<char> buffer = read_entire_file(filename);
+
+    for (AllocationStrategy strategy : {AllocationStrategy::GreedyBySize,
+                                        AllocationStrategy::GreedyByBreadth,
+                                        AllocationStrategy::BestFit}) {
+        options.allocation_strategy = strategy;
+        Interpreter interpreter(parse_tflite_model_from_buffer(buffer.data()), options);
+        if (!interpreter.prepare()) {
+            std::cerr << "hannk::Interpreter::prepare() failed\n";
+            exit(-1);
+        }
+        if (strategy == AllocationStrategy::GreedyBySize) {
+            std::cout << " lower bound " << interpreter.arena_lower_bound() << " bytes;";
+        }
+        const double ratio = interpreter.arena_lower_bound() > 0 ?
+                                 (double)interpreter.arena_size() / interpreter.arena_lower_bound() :
+                                 1.0;
+        std::cout << " " << to_string(strategy) << " " << interpreter.arena_size()
+                  << " (" << ratio << "x)";
+    }
+    std::cout << std::endl;
+}
+
+// Measure throughput when running batches of inferences on one or more
+// instances of the model.
+void run_batch_benchmark(const std::string &filename, const InterpreterOptions &options,
+                         int batch_size, int instances) {
+    std::cout << filename;
+
+    std::vector<char> buffer = read_entire_file(filename);
+    auto make_model = [&buffer]() -> OpPtr {
+        return parse_tflite_model_from_buffer(buffer.data());
+    };
+
+    BatchInterpreter interpreter(make_model, instances, options);
+    if (!interpreter.prepare()) {
+        std::cerr << "hannk::BatchInterpreter::prepare() failed\n";
+        exit(-1);
+    }
+
+    // The values of the inputs don't matter for timing.
+    InferenceBuffers inputs;
+    for (const TensorPtr &t : interpreter.inputs()) {
+        HalideBuffer<void> buf = t->buffer().copy();
+        memset(buf.data(), 0, buf.size_in_bytes());
+        inputs.emplace_back(std::move(buf));
+    }
+    std::vector<InferenceBuffers> batch(batch_size, inputs);
+
+    auto result = Halide::Tools::benchmark([&]() { interpreter.execute(batch); });
+    std::cout << ": " << result.wall_time * 1e6 / batch_size << " us per inference, "
+              << batch_size / result.wall_time << " inferences/sec"
+              << " (batch of " << batch_size << ", " << instances << " instances)" << std::endl;
+
+    halide_profiler_report(nullptr);
+    halide_profiler_reset();
+}
+
 }  // namespace hannk
 
 // Change the visibility of the main function to support Hexagon where the
@@ -51,6 +157,11 @@ void run_benchmark(const std::string &filename, const InterpreterOptions &option
 // from other targets where we compile the file into an executable.
 __attribute__((visibility("default"))) int main(int argc, char **argv) {
     hannk::InterpreterOptions options;
+    int batch_size = 0;
+    int instances = 1;
+    bool compare_fusion = false;
+    bool compare_allocation = false;
+    std::string profile_trace;
 
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "--verbose")) {
@@ -61,6 +172,56 @@ __attribute__((visibility("default"))) int main(int argc, char **argv) {
             options.trace = true;
             continue;
         }
+        if (!strcmp(argv[i], "--profile")) {
+            options.profile = true;
+            continue;
+        }
+        if (!strncmp(argv[i], "--profile_trace=", 16)) {
+            options.profile = true;
+            profile_trace = argv[i] + 16;
+            continue;
+        }
+        if (!strncmp(argv[i], "--inter_op_threads=", 19)) {
+            options.inter_op_threads = atoi(argv[i] + 19);
+            if (options.inter_op_threads < 1) {
+                HLOG(ERROR) << "--inter_op_threads must be at least 1.\n";
+                exit(-1);
+            }
+            continue;
+        }
+        if (!strncmp(argv[i], "--tile_cache_size=", 18)) {
+            const long long size = atoll(argv[i] + 18);
+            if (size < 1) {
+                HLOG(ERROR) << "--tile_cache_size must be at least 1.\n";
+                exit(-1);
+            }
+            options.tile_cache_size = (size_t)size;
+            continue;
+        }
+        if (!strcmp(argv[i], "--compare_allocation")) {
+            compare_allocation = true;
+            continue;
+        }
+        if (!strcmp(argv[i], "--compare_fusion")) {
+            compare_fusion = true;
+            continue;
+        }
+        if (!strncmp(argv[i], "--batch=", 8)) {
+            batch_size = atoi(argv[i] + 8);
+            if (batch_size < 1) {
+                HLOG(ERROR) << "--batch must be at least 1.\n";
+                exit(-1);
+            }
+            continue;
+        }
+        if (!strncmp(argv[i], "--instances=", 12)) {
+            instances = atoi(argv[i] + 12);
+            if (instances < 1) {
+                HLOG(ERROR) << "--instances must be at least 1.\n";
+                exit(-1);
+            }
+            continue;
+        }
         if (argv[i][0] == '-') {
             HLOG(ERROR) << "Unknown flag: " << argv[i] << ".\n";
             exit(-1);
@@ -72,11 +233,50 @@ __attribute__((visibility("default"))) int main(int argc, char **argv) {
         exit(-1);
     }
 
+    if (batch_size > 0 && options.trace) {
+        HLOG(ERROR) << "You cannot specify --trace and --batch at the same time.\n";
+        exit(-1);
+    }
+
+    if (compare_fusion && (options.trace || batch_size > 0)) {
+        HLOG(ERROR) << "You cannot specify --compare_fusion with --trace or --batch.\n";
+        exit(-1);
+    }
+
+    if (compare_allocation && (options.trace || batch_size > 0 || compare_fusion)) {
+        HLOG(ERROR) << "You cannot specify --compare_allocation with --trace, --batch or --compare_fusion.\n";
+        exit(-1);
+    }
+
+    if (options.profile && (options.trace || batch_size > 0 || compare_fusion || compare_allocation)) {
+        HLOG(ERROR) << "You cannot specify --profile with --trace, --batch, --compare_fusion or --compare_allocation.\n";
+        exit(-1);
+    }
+
+    int model_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2)) {
+            model_count++;
+        }
+    }
+    if (!profile_trace.empty() && model_count > 1) {
+        HLOG(ERROR) << "You cannot specify --profile_trace with more than one model.\n";
+        exit(-1);
+    }
+
     for (int i = 1; i < argc; i++) {
         if (!strncmp(argv[i], "--", 2)) {
             continue;
         }
-        hannk::run_benchmark(argv[i], options);
+        if (compare_allocation) {
+            hannk::run_allocation_comparison(argv[i], options);
+        } else if (compare_fusion) {
+            hannk::run_fusion_comparison(argv[i], options);
+        } else if (batch_size > 0) {
+            hannk::run_batch_benchmark(argv[i], options, batch_size, instances);
+        } else {
+            hannk::run_benchmark(argv[i], options, profile_trace);
+        }
     }
 
     std::cout << "Done!\n";
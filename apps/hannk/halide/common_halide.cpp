@@ -1,4 +1,5 @@
 #include "halide/common_halide.h"
+#include "halide/constants.h"
 
 using namespace Halide;
 using namespace Halide::ConciseCasts;
@@ -8,7 +9,7 @@ namespace hannk {
 int get_register_count(const Target &target) {
     switch (target.arch) {
     case Target::X86:
-        return target.features_any_of({Target::AVX512_Skylake, Target::AVX512_Cannonlake, Target::AVX512_SapphireRapids}) ? 32 : 16;
+        return target.features_any_of({Target::AVX512_Skylake, Target::AVX512_Cannonlake, Target::AVX512_VNNI, Target::AVX512_SapphireRapids}) ? 32 : 16;
     case Target::ARM:
         return target.bits == 64 ? 32 : 16;
     case Target::Hexagon:
@@ -21,6 +22,7 @@ int get_register_count(const Target &target) {
 int get_vector_reduction_factor(const Target &target, Type t) {
     if (target.arch == Target::Hexagon ||
         target.has_feature(Target::ARMDotProd) ||
+        target.has_feature(Target::AVX512_VNNI) ||
         target.has_feature(Target::AVX512_SapphireRapids)) {
         return 32 / t.bits();
     }
@@ -247,4 +249,17 @@ Expr quantize_and_relu_u8(const Expr &x, const Expr &multiplier, const Expr &shi
     }
 }
 
+Expr add_quantized_u8(const Expr &a, const Expr &a_zero, const Expr &a_multiplier,
+                      const Expr &b, const Expr &b_zero, const Expr &b_multiplier,
+                      const Expr &zero, const Expr &min, const Expr &max) {
+    Expr a_shifted = (i16(a) - i16(a_zero)) << add_input_shift;
+    Expr b_shifted = (i16(b) - i16(b_zero)) << add_input_shift;
+
+    Expr sum = widening_mul(a_shifted, a_multiplier) + widening_mul(b_shifted, b_multiplier);
+    Expr result = i16_sat(rounding_shift_right(sum, add_output_shift));
+
+    result = u8_sat(saturating_add(result, zero));
+    return clamp(result, min, max);
+}
+
 }  // namespace hannk
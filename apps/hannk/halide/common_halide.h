@@ -69,6 +69,12 @@ Halide::Expr quantize_i16(const Halide::Expr &x, const Halide::Expr &multiplier,
 Halide::Expr quantize_and_relu_u8(const Halide::Expr &x, const Halide::Expr &multiplier, const Halide::Expr &shift, const Halide::Expr &zero,
                                   const Halide::Expr &min, const Halide::Expr &max, const Halide::Target &target);
 
+// Compute the sum of two quantized u8 values a and b, as the Add op does. The multipliers
+// are relative to add_input_shift and add_output_shift (see constants.h).
+Halide::Expr add_quantized_u8(const Halide::Expr &a, const Halide::Expr &a_zero, const Halide::Expr &a_multiplier,
+                              const Halide::Expr &b, const Halide::Expr &b_zero, const Halide::Expr &b_multiplier,
+                              const Halide::Expr &zero, const Halide::Expr &min, const Halide::Expr &max);
+
 }  // namespace hannk
 
 #endif  // HANNK_COMMON_HALIDE_H
@@ -16,7 +16,22 @@ Var ci("ci"), co("co");
 // without widening 8-bit multiplication, it's faster to just subtract the
 // offsets and use 16-bit multiplications.
 bool use_8bit_multiply(const Target &target) {
-    return target.arch != Target::X86 || target.has_feature(Target::AVX512_SapphireRapids);
+    return target.arch != Target::X86 ||
+           target.features_any_of({Target::AVX512_VNNI, Target::AVX512_SapphireRapids});
+}
+
+// The type of the tiled filter. x86's 8-bit dot products (vpdpbusd) multiply
+// unsigned by signed 8-bit values, so on x86 we store the filter as a signed
+// value offset by -128 from its quantized value. The filter zero passed to the
+// Conv generator is still the unsigned zero.
+Type tiled_filter_type(const Target &target) {
+    if (!use_8bit_multiply(target)) {
+        return Int(16);
+    } else if (target.arch == Target::X86) {
+        return Int(8);
+    } else {
+        return UInt(8);
+    }
 }
 
 // How many registers to use as accumulators, as a function of the target.
@@ -42,6 +57,12 @@ public:
     // to load vectors, so making this value larger helps for big reductions.
     GeneratorParam<int> unroll_reduction_{"unroll_reduction", 4};
 
+    // When true, the quantized result of the convolution is added to another
+    // tensor, as the Add op does, before it is written to the output. The
+    // output_* inputs then describe the quantization of the result before
+    // the add, and the extra inputs declared in configure() describe the add.
+    GeneratorParam<bool> fused_add_{"fused_add", false};
+
     // Unsigned 8-bit input tensor, indexed by c, x, y, b.
     Input<Buffer<uint8_t, 4>> input_{"input"};
     Input<uint8_t> input_zero_{"input_zero"};
@@ -72,11 +93,27 @@ public:
 
     Output<Buffer<void, 4>> output_{"output"};
 
+    // Only present if fused_add is true. The addend has the same shape as
+    // the output, and output_zero and the multipliers are those of the Add op.
+    Input<Buffer<uint8_t, 4>> *addend_ = nullptr;
+    Input<uint8_t> *addend_zero_ = nullptr;
+    Input<int16_t> *addend_multiplier_ = nullptr;
+    Input<int16_t> *result_multiplier_ = nullptr;
+    Input<uint8_t> *sum_zero_ = nullptr;
+    Input<uint8_t> *sum_min_ = nullptr;
+    Input<uint8_t> *sum_max_ = nullptr;
+
     void configure() {
-        if (use_8bit_multiply(target)) {
-            filter_.set_type(UInt(8));
-        } else {
-            filter_.set_type(Int(16));
+        filter_.set_type(tiled_filter_type(target));
+
+        if (fused_add_) {
+            addend_ = add_input<Buffer<uint8_t, 4>>("addend");
+            addend_zero_ = add_input<uint8_t>("addend_zero");
+            addend_multiplier_ = add_input<int16_t>("addend_multiplier");
+            result_multiplier_ = add_input<int16_t>("result_multiplier");
+            sum_zero_ = add_input<uint8_t>("sum_zero");
+            sum_min_ = add_input<uint8_t>("sum_min");
+            sum_max_ = add_input<uint8_t>("sum_max");
         }
     }
 
@@ -106,6 +143,14 @@ public:
         Expr input_rdxyc =
             input(r.z, x * stride_x_ + r.x * dilation_x_, y * stride_y_ + r.y * dilation_y_, b);
 
+        // The zero of the filter as it is stored, which is shifted for signed
+        // filters (see tiled_filter_type).
+        const Type filter_type = tiled_filter_type(target);
+        Expr filter_zero = filter_zero_;
+        if (filter_type == Int(8)) {
+            filter_zero = i16(filter_zero_) - 128;
+        }
+
         Func offset_c("offset_c");
         Func sum_input("sum_input");
         Func convolved("convolved");
@@ -129,18 +174,21 @@ public:
             // We can then separate this into several reductions. First, the terms that
             // depend only on c.
             Expr r_size = filter_width * filter_height * filter_depth;
+            // Products of the 8-bit filter and input values fit in 16 bits, signed
+            // or unsigned to match the filter.
+            const Type wide_type = filter_type.with_bits(16);
             // We need the negative of this reduction, so compute the sum first, and then
             // subtract it after.
-            offset_c(c) += i32(u16(filter_rdxyc) * u16(input_zero_));
+            offset_c(c) += i32(cast(wide_type, filter_rdxyc) * cast(wide_type, input_zero_));
             offset_c(c) =
-                bias_(c) + i32(u16(filter_zero_) * u16(input_zero_)) * r_size - offset_c(c);
+                bias_(c) + i32(cast(wide_type, filter_zero) * cast(wide_type, input_zero_)) * r_size - offset_c(c);
 
             // The sum of the input is used to compute the filter_zero * input term.
             // TODO: This is separable, but a bit messy to optimize this way.
             sum_input(x, y, b) += i32(input_rdxyc);
 
             // Finally, the terms that depend on all of c, x, y, b.
-            convolved(c, x, y, b) = offset_c(c) - i32(filter_zero_) * sum_input(x, y, b);
+            convolved(c, x, y, b) = offset_c(c) - i32(filter_zero) * sum_input(x, y, b);
         } else {
             // Without 8-bit widening multiplies, we already subtracted the offsets,
             // and just have a single reduction of 16-bit multiplies to compute.
@@ -156,6 +204,11 @@ public:
         } else {
             output = quantize_i16(convolved(c, x, y, b), output_multiplier_, output_shift_, target);
         }
+        if (fused_add_) {
+            output = add_quantized_u8(output, output_zero_, *result_multiplier_,
+                                      (*addend_)(c, x, y, b), *addend_zero_, *addend_multiplier_,
+                                      *sum_zero_, *sum_min_, *sum_max_);
+        }
         output_(c, x, y, b) = output;
 
         // Schedule
@@ -164,6 +217,12 @@ public:
         interpret_as_tensor(output_);
         require_same_min_extent(3, input_, output_);
         require_same_min_extent(0, bias_, output_);
+        if (fused_add_) {
+            interpret_as_tensor(*addend_);
+            for (int d = 0; d < 4; d++) {
+                require_same_min_extent(d, output_, *addend_);
+            }
+        }
 
         const int filter_alignment = vector_reduction * accum_vector_size;
         filter_.set_host_alignment(filter_alignment * filter_.type().bytes());
@@ -216,9 +275,11 @@ public:
         }
 
         // In case there are no suitable tile sizes, just make a dummy split so the
-        // rest of the schedule still works.
+        // rest of the schedule still works. The addend is read in the output stage,
+        // so loads of it need to be predicated too.
         output_
-            .split(c, co, c, accum_vector_size * min_tile_c, TailStrategy::PredicateStores)
+            .split(c, co, c, accum_vector_size * min_tile_c,
+                   fused_add_ ? TailStrategy::Predicate : TailStrategy::PredicateStores)
             .split(x, xo, x, 1)
             .reorder(c, x, co, xo, y, b)
             .vectorize(c);
@@ -234,7 +295,7 @@ public:
 
         if (use_8bit_multiply(target)) {
             // Specialize this to avoid computing sum_input when it isn't needed.
-            convolved.specialize(filter_zero_ == 0);
+            convolved.specialize(filter_zero == 0);
         }
 
         RVar rco, rci;
@@ -330,11 +391,7 @@ public:
     Output<Buffer<void, 6>> output_{"output"};
 
     void configure() {
-        if (use_8bit_multiply(target)) {
-            output_.set_type(UInt(8));
-        } else {
-            output_.set_type(Int(16));
-        }
+        output_.set_type(tiled_filter_type(target));
     }
 
     void generate() {
@@ -347,7 +404,11 @@ public:
 
         Expr filter_cxyb =
             i16(input_bounded(co * vector_reduction + ci, x, y, bo * vector_tile + bi)) - i16(input_zero_);
-        output_(ci, bi, co, bo, x, y) = cast(output_.type(), filter_cxyb + output_zero_);
+        Expr output_zero = i16(output_zero_);
+        if (output_.type() == Int(8)) {
+            output_zero -= 128;
+        }
+        output_(ci, bi, co, bo, x, y) = cast(output_.type(), filter_cxyb + output_zero);
 
         // Schedule.
         output_.dim(0).set_min(0).set_extent(vector_reduction);
@@ -19,6 +19,11 @@ public:
     // x of the input, instead of the x dimension of the buffer.
     GeneratorParam<bool> shallow_{"shallow", false};
 
+    // When true, the quantized result of the convolution is added to another
+    // tensor, as the Add op does, before it is written to the output. See the
+    // Conv generator for how the inputs are interpreted.
+    GeneratorParam<bool> fused_add_{"fused_add", false};
+
     // Unsigned 8-bit input tensor, indexed by ci, x, y, b.
     Input<Buffer<uint8_t, 4>> input_{"input"};
     Input<uint8_t> input_zero_{"input_zero"};
@@ -53,6 +58,27 @@ public:
 
     Output<Buffer<uint8_t, 4>> output_{"output"};
 
+    // Only present if fused_add is true. The addend has the same shape as the output.
+    Input<Buffer<uint8_t, 4>> *addend_ = nullptr;
+    Input<uint8_t> *addend_zero_ = nullptr;
+    Input<int16_t> *addend_multiplier_ = nullptr;
+    Input<int16_t> *result_multiplier_ = nullptr;
+    Input<uint8_t> *sum_zero_ = nullptr;
+    Input<uint8_t> *sum_min_ = nullptr;
+    Input<uint8_t> *sum_max_ = nullptr;
+
+    void configure() {
+        if (fused_add_) {
+            addend_ = add_input<Buffer<uint8_t, 4>>("addend");
+            addend_zero_ = add_input<uint8_t>("addend_zero");
+            addend_multiplier_ = add_input<int16_t>("addend_multiplier");
+            result_multiplier_ = add_input<int16_t>("result_multiplier");
+            sum_zero_ = add_input<uint8_t>("sum_zero");
+            sum_min_ = add_input<uint8_t>("sum_min");
+            sum_max_ = add_input<uint8_t>("sum_max");
+        }
+    }
+
     void generate() {
         // The algorithm.
 
@@ -130,9 +156,15 @@ public:
         convolved(c, x, y, b) = offset_c(filter_c);
         convolved(c, x, y, b) += i32(filter_zeroed_rdxy) * i32(input_rdxy);
 
-        output_(c, x, y, b) =
+        Expr output =
             quantize_and_relu_u8(convolved(c, x, y, b), output_multiplier_, output_shift_,
                                  output_zero_, output_min_, output_max_, target);
+        if (fused_add_) {
+            output = add_quantized_u8(output, output_zero_, *result_multiplier_,
+                                      (*addend_)(c, x, y, b), *addend_zero_, *addend_multiplier_,
+                                      *sum_zero_, *sum_min_, *sum_max_);
+        }
+        output_(c, x, y, b) = output;
 
         // Schedule.
         interpret_as_tensor(input_);
@@ -140,6 +172,12 @@ public:
         interpret_as_tensor(bias_);
         interpret_as_tensor(output_);
         require_same_min_extent(3, input_, output_);
+        if (fused_add_) {
+            interpret_as_tensor(*addend_);
+            for (int d = 0; d < 4; d++) {
+                require_same_min_extent(d, output_, *addend_);
+            }
+        }
         if (shallow_) {
             // Shallow inputs should have fused c and x, and left x as a dummy dim.
             output_.dim(1).set_min(0).set_extent(1);
@@ -180,6 +218,9 @@ public:
         // Only tile when the input is at least this many tiles to avoid this.
         const int kMinTiles = 4;
         Var xo("xo"), yo("yo"), co("co");
+        // The addend is read in the output stage, so loads of it need to be
+        // predicated too.
+        const TailStrategy c_tail = fused_add_ ? TailStrategy::Predicate : TailStrategy::PredicateStores;
         Expr output_width = output_.dim(1).extent();
         Expr output_height = output_.dim(2).extent();
         Expr use_tiles =
@@ -188,7 +229,7 @@ public:
         output_.compute_root()
             .specialize(use_tiles)
             .tile(x, y, xo, yo, x, y, kTileW, kTileH, TailStrategy::ShiftInwards)
-            .split(c, co, c, vector_size, TailStrategy::PredicateStores)
+            .split(c, co, c, vector_size, c_tail)
             .reorder(x, y, c, xo, yo, b, co)
             .unroll(x)
             .unroll(y)
@@ -197,7 +238,7 @@ public:
         // In the general case, use dummy 1x1 tiles.
         output_
             .tile(x, y, xo, yo, x, y, 1, 1)
-            .split(c, co, c, vector_size, TailStrategy::PredicateStores)
+            .split(c, co, c, vector_size, c_tail)
             .reorder(x, y, c, xo, yo, b, co)
             .unroll(x)
             .unroll(y)
@@ -28,15 +28,9 @@ public:
     void generate() {
         Var x("x"), y("y");
 
-        Expr input1 = (i16(input1_(x, y)) - i16(input1_zero_)) << add_input_shift;
-        Expr input2 = (i16(input2_(x, y)) - i16(input2_zero_)) << add_input_shift;
-
-        input1 = widening_mul(input1, input1_multiplier_);
-        input2 = widening_mul(input2, input2_multiplier_);
-        Expr output = i16_sat(rounding_shift_right(input1 + input2, add_output_shift));
-
-        output = u8_sat(saturating_add(output, output_zero_));
-        output_(x, y) = clamp(output, output_min_, output_max_);
+        output_(x, y) = add_quantized_u8(input1_(x, y), input1_zero_, input1_multiplier_,
+                                         input2_(x, y), input2_zero_, input2_multiplier_,
+                                         output_zero_, output_min_, output_max_);
 
         // Schedule.
         const int vector_size = natural_vector_size<uint8_t>();
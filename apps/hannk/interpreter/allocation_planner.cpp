@@ -1,12 +1,12 @@
 #include "interpreter/allocation_planner.h"
+#include "util/error_util.h"
 
 #include <algorithm>
 #include <cassert>
 #include <iomanip>
 #include <iostream>
-#include <iterator>
 #include <limits>
-#include <list>
+#include <numeric>
 
 #ifndef HANNK_USE_TRIVIAL_ALLOCATION_PLANNER
 #define HANNK_USE_TRIVIAL_ALLOCATION_PLANNER 0
@@ -39,9 +39,142 @@ int AllocationPlanner::block_count() const {
     return (int)block_requirements_.size();
 }
 
-void AllocationPlanner::commit() {
+const char *to_string(AllocationStrategy strategy) {
+    switch (strategy) {
+    case AllocationStrategy::GreedyBySize:
+        return "GreedyBySize";
+    case AllocationStrategy::GreedyByBreadth:
+        return "GreedyByBreadth";
+    case AllocationStrategy::BestFit:
+        return "BestFit";
+    case AllocationStrategy::Auto:
+        return "Auto";
+    default:
+        HLOG(FATAL) << "Unknown AllocationStrategy";
+        return nullptr;
+    }
+}
+
+std::vector<size_t> AllocationPlanner::layout(AllocationStrategy strategy) const {
+    assert(strategy != AllocationStrategy::Auto);
+
+    // All the strategies are variations on a basic greedy algorithm: take the
+    // blocks in some order, and place each one in a gap we find that has no
+    // overlap in the time domain with the blocks already placed. If there is
+    // no such gap, add the block to the end. (Algorithms inspired by TFMicro's
+    // greedy allocator, and by "Efficient Memory Management for Deep Neural
+    // Net Inference", Pisarchyk and Lee.)
+    const int block_count = (int)block_requirements_.size();
+
+    const auto by_size = [this](int a, int b) -> bool {
+        const BlockRequirements &ra = block_requirements_[a];
+        const BlockRequirements &rb = block_requirements_[b];
+        // Sort in decreasing (well, really non-increasing) order by size.
+        if (ra.size_needed != rb.size_needed) {
+            return ra.size_needed > rb.size_needed;
+        }
+
+        // If sizes are equal, sort by increasing time of first use.
+        return ra.first_use < rb.first_use;
+    };
+
+    std::vector<int> order;
+    order.reserve(block_count);
+    if (strategy == AllocationStrategy::GreedyByBreadth) {
+        // Find the memory in use at each time, and visit the times from the
+        // busiest to the least busy, taking the blocks live at each time
+        // that we haven't taken already.
+        int max_time = 0;
+        for (const auto &r : block_requirements_) {
+            max_time = std::max(max_time, r.last_use);
+        }
+        std::vector<size_t> breadth(max_time + 1, 0);
+        for (const auto &r : block_requirements_) {
+            for (int t = std::max(r.first_use, 0); t <= r.last_use; t++) {
+                breadth[t] += r.size_needed;
+            }
+        }
+        std::vector<int> times(max_time + 1);
+        std::iota(times.begin(), times.end(), 0);
+        std::stable_sort(times.begin(), times.end(), [&breadth](int a, int b) -> bool {
+            return breadth[a] > breadth[b];
+        });
+
+        std::vector<bool> taken(block_count, false);
+        for (int t : times) {
+            const size_t first_at_t = order.size();
+            for (int i = 0; i < block_count; i++) {
+                const BlockRequirements &r = block_requirements_[i];
+                if (!taken[i] && r.first_use <= t && t <= r.last_use) {
+                    order.push_back(i);
+                    taken[i] = true;
+                }
+            }
+            std::sort(order.begin() + first_at_t, order.end(), by_size);
+        }
+        // Blocks that are never live (which shouldn't happen) go last.
+        for (int i = 0; i < block_count; i++) {
+            if (!taken[i]) {
+                order.push_back(i);
+            }
+        }
+    } else {
+        for (int i = 0; i < block_count; i++) {
+            order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), by_size);
+    }
+
+    // Experimentation on our standard suite of models originally showed no
+    // difference between first-fit and best-fit when placing the largest
+    // blocks first, but best-fit matters when taking blocks in other orders.
+    const bool best_fit = strategy != AllocationStrategy::GreedyBySize;
+
+    std::vector<size_t> offsets(block_count, kInvalidOffset);
+    // The blocks placed so far, kept sorted by offset.
+    std::vector<int> placed;
+    placed.reserve(block_count);
+    for (int i : order) {
+        const BlockRequirements &req = block_requirements_[i];
+        size_t candidate_offset = 0;
+        size_t best_offset = kInvalidOffset;
+        size_t best_gap = kInvalidOffset;
+        for (int j : placed) {
+            const BlockRequirements &other = block_requirements_[j];
+            const bool has_time_overlap = !(other.first_use > req.last_use || req.first_use > other.last_use);
+            if (!has_time_overlap) {
+                continue;
+            }
+            // See if there's a gap between the blocks before this one and
+            // this one, and if so, if it's large enough to use here.
+            if (offsets[j] >= candidate_offset) {
+                const size_t gap = offsets[j] - candidate_offset;
+                if (gap >= req.size_needed && gap < best_gap) {
+                    best_offset = candidate_offset;
+                    best_gap = gap;
+                    if (!best_fit) {
+                        break;
+                    }
+                }
+            }
+            candidate_offset = std::max(candidate_offset, align_up(offsets[j] + other.size_needed, alignment_));
+        }
+
+        // If there's no gap, we implicitly extend the memory arena.
+        offsets[i] = best_offset != kInvalidOffset ? best_offset : candidate_offset;
+        const auto insert_at = std::upper_bound(placed.begin(), placed.end(), offsets[i],
+                                                [&offsets](size_t offset, int j) -> bool {
+                                                    return offset < offsets[j];
+                                                });
+        placed.insert(insert_at, i);
+    }
+    return offsets;
+}
+
+void AllocationPlanner::commit(AllocationStrategy strategy) {
     assert(!committed_);
     committed_ = true;
+    strategy_ = strategy == AllocationStrategy::Auto ? AllocationStrategy::GreedyBySize : strategy;
 
     // This happens in some unusual cases
     if (block_requirements_.empty()) {
@@ -60,110 +193,32 @@ void AllocationPlanner::commit() {
 
 #else
 
-    // Use a basic greedy algorithm to lay out the buffers;
-    // the basic idea here is to start with the largest block,
-    // then progress into smaller blocks, picking out the first large-enough
-    // gap we find that has no overlap in the time domain. If there is
-    // no such gap, add the block to the end. This isn't perfect, of course,
-    // but pretty good in practice. (Algorithm inspired by TFMicro's greedy allocator.)
-
-    // Make a list of all the block requirements, sorted by descending size.
-    // (This list will just point to the entries in the block_requirements_ list.)
-    std::vector<BlockRequirements *> block_requirements_sorted;
-    block_requirements_sorted.reserve(block_requirements_.size());
-    for (auto &r : block_requirements_) {
-        block_requirements_sorted.push_back(&r);
-    }
-
-    std::sort(block_requirements_sorted.begin(), block_requirements_sorted.end(),
-              [](BlockRequirements *a, BlockRequirements *b) -> bool {
-                  // Sort in decreasing (well, really non-increasing) order by size.
-                  if (a->size_needed != b->size_needed) {
-                      return a->size_needed > b->size_needed;
-                  }
-
-                  // If sizes are equal, sort by increasing time of first use.
-                  return a->first_use < b->first_use;
-              });
-
-    // This is a list that we keep sorted (by offset) as we go along.
-    // It just points to entries in block_requirements_sorted, so it's crucial
-    // that block_requirements_sorted be kept in the same order after this.
-    std::list<BlockRequirements *> offsets;
-
-    using OffsetsIterator = std::list<BlockRequirements *>::iterator;
-
-    // Put the first (largest) block at offset 0.
-    block_requirements_sorted[0]->calculated_offset = 0;
-    offsets.push_back(block_requirements_sorted[0]);
-
-    // Process the rest in descending order, trying to find a gap that fits.
-    for (size_t i = 1; i < block_requirements_sorted.size(); ++i) {
-        BlockRequirements *req = block_requirements_sorted[i];
-        size_t candidate_offset = 0;
-
-        OffsetsIterator prior = offsets.end();
-        for (;;) {
-            // Find the first block after 'prior' that's active at the same time as 'req'.
-            OffsetsIterator next = (prior != offsets.end()) ? std::next(prior) : offsets.begin();
-            for (; next != offsets.end(); ++next) {
-                const bool has_time_overlap = !((*next)->first_use > req->last_use || req->first_use > (*next)->last_use);
-                if (has_time_overlap) {
-                    // Can't safely insert between prior and next -- advance and try again until
-                    // we find a block we have no time overlap with (or run out of blocks).
-                    break;
-                }
-            }
-
-            // If there's a prior block, the candidate_offset begins just past prior's end.
-            if (prior != offsets.end()) {
-                const size_t prior_end_offset = (*prior)->calculated_offset + (*prior)->size_needed;
-                if (prior_end_offset > candidate_offset) {
-                    candidate_offset = align_up(prior_end_offset, alignment_);
-                }
-            }
-
-            if (next == offsets.end()) {
-                // There is no next block, so we're just going to append after the last one.
-                break;
-            }
-
-            // There is a next block -- let's see if there's a gap between prior and next,
-            // and if so, if it's large enough to use here.
-            if ((*next)->calculated_offset >= candidate_offset) {
-                const size_t gap = (*next)->calculated_offset - candidate_offset;
-                if (gap >= req->size_needed) {
-                    // Note that we take a first-fit approach here, rather than a best-fit.
-                    // (Experimentation on our standard suite of models showed literally
-                    // *no* size difference in arena size needed for a best-fit algorithm,
-                    // and no meaningful performance difference.)
-                    break;
-                }
-            }
-
-            // Not enough space, keep trying
-            prior = next;
+    const auto memory_needed_for = [this](const std::vector<size_t> &offsets) -> size_t {
+        size_t needed = 0;
+        for (size_t i = 0; i < offsets.size(); i++) {
+            needed = std::max(needed, offsets[i] + block_requirements_[i].size_needed);
         }
+        return needed;
+    };
 
-        // OK, so we've found an offset to use (either in an existing gap that's
-        // not in use for this block's timeframe, or by implicitly extending
-        // the memory arena size). Save it in the requirements, and then
-        // update the offsets list so that it remains in order.
-        assert(req->calculated_offset == kInvalidOffset);
-        req->calculated_offset = candidate_offset;
-
-        bool inserted = false;
-        for (OffsetsIterator it = offsets.begin(); it != offsets.end(); ++it) {
-            if (candidate_offset < (*it)->calculated_offset) {
-                offsets.insert(it, req);
-                inserted = true;
-                break;
+    std::vector<size_t> offsets;
+    if (strategy == AllocationStrategy::Auto) {
+        // Ties go to the earlier strategy.
+        for (AllocationStrategy s : {AllocationStrategy::GreedyBySize,
+                                     AllocationStrategy::GreedyByBreadth,
+                                     AllocationStrategy::BestFit}) {
+            std::vector<size_t> s_offsets = layout(s);
+            if (offsets.empty() || memory_needed_for(s_offsets) < memory_needed_for(offsets)) {
+                offsets = std::move(s_offsets);
+                strategy_ = s;
             }
         }
-        if (!inserted) {
-            assert(candidate_offset >= offsets.back()->calculated_offset);
-            offsets.push_back(req);
-        }
+    } else {
+        offsets = layout(strategy);
+    }
+
+    for (size_t i = 0; i < offsets.size(); i++) {
+        block_requirements_[i].calculated_offset = offsets[i];
     }
 #endif  // HANNK_USE_TRIVIAL_ALLOCATION_PLANNER
 
@@ -182,6 +237,27 @@ size_t AllocationPlanner::memory_needed() const {
     return needed;
 }
 
+size_t AllocationPlanner::lower_bound() const {
+    // The memory in use only grows when a block's lifetime begins, so we
+    // only need to look at those times.
+    size_t result = 0;
+    for (const auto &a : block_requirements_) {
+        size_t live = 0;
+        for (const auto &b : block_requirements_) {
+            if (b.first_use <= a.first_use && a.first_use <= b.last_use) {
+                live += b.size_needed;
+            }
+        }
+        result = std::max(result, live);
+    }
+    return result;
+}
+
+AllocationStrategy AllocationPlanner::strategy() const {
+    assert(committed_);
+    return strategy_;
+}
+
 size_t AllocationPlanner::get_block_offset(int block_id) const {
     assert(committed_);
     assert(block_id >= 0 && block_id < (int)block_requirements_.size());
@@ -6,6 +6,23 @@
 
 namespace hannk {
 
+// How AllocationPlanner lays out blocks. Each strategy places the blocks one
+// at a time, next to blocks already placed that are live at the same time.
+enum class AllocationStrategy {
+    // Place the largest blocks first, each at the lowest offset it fits at.
+    GreedyBySize,
+    // Place the blocks live at the time with the most memory in use first
+    // (largest first), then those of the next busiest time, and so on, each
+    // in the smallest gap it fits in.
+    GreedyByBreadth,
+    // Place the largest blocks first, each in the smallest gap it fits in.
+    BestFit,
+    // Try each of the above, and use whichever needs the least memory.
+    Auto,
+};
+
+const char *to_string(AllocationStrategy strategy);
+
 // AllocationPlanner is used to plan a series of allocations in which we can
 // overlap blocks that don't have any lifespan in common.
 class AllocationPlanner {
@@ -23,12 +40,20 @@ public:
 
     // Commit all the blocks added and compute a layout. It is an error to
     // call add_block() after this.
-    void commit();
+    void commit(AllocationStrategy strategy = AllocationStrategy::Auto);
 
     // The largest contiguous block of memory that's needed to hold the layout.
     // It is an error to call this before commit().
     size_t memory_needed() const;
 
+    // The most memory used by the blocks live at any one time. No layout
+    // can need less memory than this.
+    size_t lower_bound() const;
+
+    // The strategy used for the layout; never Auto.
+    // It is an error to call this before commit().
+    AllocationStrategy strategy() const;
+
     // Calculated layout offset for the nth block added to the planner.
     // It is an error to call this before commit().
     size_t get_block_offset(int block_id) const;
@@ -56,6 +81,10 @@ private:
     std::vector<BlockRequirements> block_requirements_;
 
     bool committed_ = false;
+    AllocationStrategy strategy_ = AllocationStrategy::Auto;
+
+    // Compute the offset of each block with the given strategy, which must not be Auto.
+    std::vector<size_t> layout(AllocationStrategy strategy) const;
 
     void check_overlap();
 };
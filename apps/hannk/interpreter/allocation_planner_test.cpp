@@ -0,0 +1,168 @@
+#include "interpreter/allocation_planner.h"
+#include "interpreter/interpreter.h"
+#include "interpreter/test_models.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+using namespace hannk;
+using namespace hannk::test;
+
+namespace {
+
+const AllocationStrategy strategies[] = {
+    AllocationStrategy::GreedyBySize,
+    AllocationStrategy::GreedyByBreadth,
+    AllocationStrategy::BestFit,
+    AllocationStrategy::Auto,
+};
+
+struct Block {
+    size_t size;
+    int first_use, last_use;
+};
+
+// Lay out blocks with strategy, and check that blocks live at the same time
+// don't overlap in memory, that every offset is aligned, and that the
+// layout needs at least the most memory live at any one time. Returns the
+// memory needed, or 0 on failure.
+size_t check_layout(const std::vector<Block> &blocks, AllocationStrategy strategy, size_t alignment) {
+    AllocationPlanner planner(alignment);
+    for (const Block &b : blocks) {
+        planner.add_block(b.size, b.first_use, b.last_use);
+    }
+    planner.commit(strategy);
+
+    size_t max_live = 0;
+    for (const Block &a : blocks) {
+        size_t live = 0;
+        for (const Block &b : blocks) {
+            if (b.first_use <= a.first_use && a.first_use <= b.last_use) {
+                live += b.size;
+            }
+        }
+        max_live = std::max(max_live, live);
+    }
+
+    const size_t needed = planner.memory_needed();
+    if (needed < max_live || planner.lower_bound() != max_live) {
+        std::cerr << to_string(strategy) << ": needs " << needed << " bytes, with lower bound "
+                  << planner.lower_bound() << ", but " << max_live << " bytes are live at once\n";
+        return 0;
+    }
+    if (planner.strategy() == AllocationStrategy::Auto ||
+        (strategy != AllocationStrategy::Auto && planner.strategy() != strategy)) {
+        std::cerr << to_string(strategy) << ": used strategy " << to_string(planner.strategy()) << "\n";
+        return 0;
+    }
+
+    for (int i = 0; i < (int)blocks.size(); i++) {
+        const size_t a = planner.get_block_offset(i);
+        if (a % alignment != 0 || a + blocks[i].size > needed) {
+            std::cerr << to_string(strategy) << ": block " << i << " at " << a << " is misaligned or outside the "
+                      << needed << " bytes needed\n";
+            return 0;
+        }
+        for (int j = 0; j < i; j++) {
+            const size_t b = planner.get_block_offset(j);
+            const bool live_together = blocks[i].first_use <= blocks[j].last_use &&
+                                       blocks[j].first_use <= blocks[i].last_use;
+            const bool overlap = a < b + blocks[j].size && b < a + blocks[i].size;
+            if (live_together && overlap) {
+                std::cerr << to_string(strategy) << ": blocks " << j << " and " << i
+                          << " are live at the same time and overlap in memory\n";
+                return 0;
+            }
+        }
+    }
+    return needed;
+}
+
+bool test_random_layouts() {
+    std::mt19937 rng(1);
+    for (int trial = 0; trial < 500; trial++) {
+        const size_t alignment = size_t(1) << (rng() % 7);
+        const int block_count = 1 + rng() % 40;
+        const int time_count = 1 + rng() % 30;
+        std::vector<Block> blocks;
+        for (int i = 0; i < block_count; i++) {
+            Block b;
+            // Mostly small blocks, with some large ones, and some of the
+            // same size.
+            b.size = rng() % 4 == 0 ? 1 + rng() % 100000 : 1 + rng() % 1000;
+            if (i > 0 && rng() % 8 == 0) {
+                b.size = blocks[rng() % i].size;
+            }
+            b.first_use = rng() % time_count;
+            b.last_use = b.first_use + rng() % 8;
+            blocks.push_back(b);
+        }
+
+        size_t best = 0;
+        for (AllocationStrategy strategy : strategies) {
+            const size_t needed = check_layout(blocks, strategy, alignment);
+            if (needed == 0) {
+                std::cerr << "in trial " << trial << "\n";
+                return false;
+            }
+            if (strategy == AllocationStrategy::Auto && needed != best) {
+                std::cerr << "Auto needs " << needed << " bytes, but the best strategy needs " << best << "\n";
+                return false;
+            }
+            best = best == 0 ? needed : std::min(best, needed);
+        }
+    }
+    return true;
+}
+
+// Run a model with each strategy, and check they all compute the same thing.
+bool test_models() {
+    std::vector<HalideBuffer<const void>> expected;
+    for (AllocationStrategy strategy : strategies) {
+        InterpreterOptions options;
+        options.allocation_strategy = strategy;
+        Interpreter interpreter(make_branchy_model(), std::move(options));
+        if (!interpreter.prepare()) {
+            std::cerr << "prepare() failed\n";
+            return false;
+        }
+        if (interpreter.arena_size() < interpreter.arena_lower_bound()) {
+            std::cerr << to_string(strategy) << ": the arena is smaller than its lower bound\n";
+            return false;
+        }
+        fill_inputs(interpreter.inputs(), 3);
+        interpreter.execute();
+
+        std::vector<TensorPtr> outputs = interpreter.outputs();
+        for (size_t i = 0; i < outputs.size(); i++) {
+            HalideBuffer<const void> output = outputs[i]->buffer();
+            if (expected.size() == i) {
+                expected.push_back(output.copy());
+                continue;
+            }
+            CompareBuffersOptions compare_options;
+            compare_options.require_exact();
+            if (!dynamic_type_dispatch<CompareBuffers>(output.type(), expected[i], output, compare_options).ok) {
+                std::cerr << to_string(strategy) << ": output " << i << " differs from "
+                          << to_string(strategies[0]) << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (!test_random_layouts()) {
+        return -1;
+    }
+    if (!test_models()) {
+        return -1;
+    }
+
+    std::cout << "Success!\n";
+    return 0;
+}
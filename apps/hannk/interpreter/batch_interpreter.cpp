@@ -0,0 +1,103 @@
+#include "interpreter/batch_interpreter.h"
+#include "util/error_util.h"
+
+#include <atomic>
+#include <thread>
+
+namespace hannk {
+
+namespace {
+
+std::vector<TensorPtr> non_constant(std::vector<TensorPtr> tensors) {
+    std::vector<TensorPtr> result;
+    for (auto &t : tensors) {
+        if (!t->is_constant()) {
+            result.push_back(std::move(t));
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+BatchInterpreter::BatchInterpreter(const std::function<OpPtr()> &make_model, int instance_count,
+                                   InterpreterOptions options) {
+    HCHECK(instance_count >= 1);
+    for (int i = 0; i < instance_count; i++) {
+        instances_.push_back(std::make_unique<Interpreter>(make_model(), options));
+    }
+}
+
+BatchInterpreter::~BatchInterpreter() {
+}
+
+bool BatchInterpreter::prepare() {
+    if (prepared_) {
+        HLOG(ERROR) << "Do not call prepare() twice";
+        return false;
+    }
+    for (auto &instance : instances_) {
+        if (!instance->prepare()) {
+            return false;
+        }
+    }
+    for (size_t i = 1; i < instances_.size(); i++) {
+        if (!instances_[i]->share_constants_with(*instances_[0])) {
+            // Still correct, just using more memory.
+            HLOG(WARNING) << "Instance " << i << " of the model differs from the first; not sharing constants.";
+        }
+    }
+    prepared_ = true;
+    return true;
+}
+
+std::vector<TensorPtr> BatchInterpreter::inputs() {
+    return non_constant(instances_[0]->inputs());
+}
+
+void BatchInterpreter::run_one(Interpreter *instance, const InferenceBuffers &inputs, InferenceBuffers *outputs) {
+    std::vector<TensorPtr> input_tensors = non_constant(instance->inputs());
+    HCHECK(inputs.size() == input_tensors.size())
+        << "Expected " << input_tensors.size() << " inputs, got " << inputs.size();
+    for (size_t i = 0; i < inputs.size(); i++) {
+        auto buf = input_tensors[i]->buffer();
+        buf.copy_from(inputs[i]);
+    }
+
+    instance->execute();
+
+    outputs->clear();
+    for (const TensorPtr &t : instance->outputs()) {
+        // Make a copy since the Buffer references memory owned by the instance.
+        outputs->emplace_back(t->buffer().copy());
+    }
+}
+
+std::vector<InferenceBuffers> BatchInterpreter::execute(const std::vector<InferenceBuffers> &batch) {
+    std::vector<InferenceBuffers> results(batch.size());
+    if (!prepared_) {
+        HLOG(ERROR) << "Must call prepare() before execute()";
+        return results;
+    }
+
+    std::atomic<size_t> next{0};
+    auto run_instance = [&](Interpreter *instance) {
+        for (size_t i = next++; i < batch.size(); i = next++) {
+            run_one(instance, batch[i], &results[i]);
+        }
+    };
+
+    // Don't start more threads than there are inferences to run.
+    const size_t thread_count = std::min(instances_.size(), batch.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; i++) {
+        threads.emplace_back(run_instance, instances_[i].get());
+    }
+    run_instance(instances_[0].get());
+    for (auto &t : threads) {
+        t.join();
+    }
+    return results;
+}
+
+}  // namespace hannk
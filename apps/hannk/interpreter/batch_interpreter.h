@@ -0,0 +1,60 @@
+#ifndef HANNK_BATCH_INTERPRETER_H
+#define HANNK_BATCH_INTERPRETER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "interpreter/interpreter.h"
+
+namespace hannk {
+
+// The inputs or outputs of one inference: one buffer per non-constant
+// input (or per output) of the model, in the order of Interpreter::inputs()
+// (or Interpreter::outputs()).
+using InferenceBuffers = std::vector<HalideBuffer<const void>>;
+
+// BatchInterpreter runs many inferences of one model. It holds one or more
+// instances of the model, prepared once and reused for every inference,
+// with the constant Tensors of all instances shared. With one instance,
+// inferences run one after another; with more, each instance runs on its
+// own thread, taking the next inference whenever it finishes one.
+class BatchInterpreter {
+    std::vector<std::unique_ptr<Interpreter>> instances_;
+    bool prepared_ = false;
+
+    void run_one(Interpreter *instance, const InferenceBuffers &inputs, InferenceBuffers *outputs);
+
+public:
+    // make_model is called once per instance, and must return the same model each time.
+    BatchInterpreter(const std::function<OpPtr()> &make_model, int instance_count,
+                     InterpreterOptions options = InterpreterOptions());
+    ~BatchInterpreter();
+
+    // Prepare every instance. Must be called exactly once, before execute().
+    // Returns false if an error occurs, in which case execute() should not be called.
+    [[nodiscard]] bool prepare();
+
+    // Run an inference for each entry in batch, and return their outputs,
+    // which are copies that remain valid after later calls.
+    std::vector<InferenceBuffers> execute(const std::vector<InferenceBuffers> &batch);
+
+    int instance_count() const {
+        return (int)instances_.size();
+    }
+
+    // The non-constant input Tensors of the first instance, which can be used
+    // to find the types and shapes the inputs to execute() must have.
+    std::vector<TensorPtr> inputs();
+
+    // Movable but not copyable.
+    BatchInterpreter() = delete;
+    BatchInterpreter(const BatchInterpreter &) = delete;
+    BatchInterpreter &operator=(const BatchInterpreter &) = delete;
+    BatchInterpreter(BatchInterpreter &&) = default;
+    BatchInterpreter &operator=(BatchInterpreter &&) = default;
+};
+
+}  // namespace hannk
+
+#endif  // HANNK_BATCH_INTERPRETER_H
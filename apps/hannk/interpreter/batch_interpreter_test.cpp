@@ -0,0 +1,119 @@
+#include "interpreter/batch_interpreter.h"
+#include "interpreter/test_models.h"
+
+#include <iostream>
+
+using namespace hannk;
+using namespace hannk::test;
+
+namespace {
+
+bool same_buffers(const HalideBuffer<const void> &a, const HalideBuffer<const void> &b) {
+    CompareBuffersOptions options;
+    options.require_exact();
+    return dynamic_type_dispatch<CompareBuffers>(a.type(), a, b, options).ok;
+}
+
+// Run each inference on a fresh Interpreter, for comparison.
+std::vector<InferenceBuffers> run_individually(const std::vector<InferenceBuffers> &batch) {
+    std::vector<InferenceBuffers> results;
+    for (const InferenceBuffers &inputs : batch) {
+        Interpreter interpreter(make_conv_model(Epilogue::Relu));
+        if (!interpreter.prepare()) {
+            std::cerr << "prepare() failed\n";
+            exit(-1);
+        }
+        std::vector<TensorPtr> input_tensors = interpreter.inputs();
+        for (size_t i = 0; i < inputs.size(); i++) {
+            auto buf = input_tensors[i]->buffer();
+            buf.copy_from(inputs[i]);
+        }
+        interpreter.execute();
+        InferenceBuffers outputs;
+        for (const TensorPtr &t : interpreter.outputs()) {
+            outputs.emplace_back(t->buffer().copy());
+        }
+        results.push_back(std::move(outputs));
+    }
+    return results;
+}
+
+bool test_batch(int instance_count, const std::vector<InferenceBuffers> &batch,
+                const std::vector<InferenceBuffers> &expected) {
+    BatchInterpreter batch_interpreter([]() { return make_conv_model(Epilogue::Relu); }, instance_count);
+    if (!batch_interpreter.prepare()) {
+        std::cerr << "BatchInterpreter::prepare() failed\n";
+        return false;
+    }
+    // Run the batch twice, to check that reusing the instances is safe.
+    for (int run = 0; run < 2; run++) {
+        std::vector<InferenceBuffers> results = batch_interpreter.execute(batch);
+        if (results.size() != expected.size()) {
+            std::cerr << "Expected " << expected.size() << " results, got " << results.size() << "\n";
+            return false;
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            if (results[i].size() != 1 || !same_buffers(expected[i][0], results[i][0])) {
+                std::cerr << "Inference " << i << " with " << instance_count
+                          << " instances doesn't match running it alone\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool test_share_constants() {
+    Interpreter a(make_conv_model(Epilogue::Relu, 0));
+    Interpreter b(make_conv_model(Epilogue::Relu, 0));
+    Interpreter c(make_conv_model(Epilogue::Relu, 1));
+    if (!a.prepare() || !b.prepare() || !c.prepare()) {
+        std::cerr << "prepare() failed\n";
+        return false;
+    }
+    if (!b.share_constants_with(a)) {
+        std::cerr << "Identical models didn't share their constants\n";
+        return false;
+    }
+    if (c.share_constants_with(a)) {
+        std::cerr << "Models with different weights shared their constants\n";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const int batch_size = 7;
+    std::vector<InferenceBuffers> batch;
+    {
+        Interpreter interpreter(make_conv_model(Epilogue::Relu));
+        if (!interpreter.prepare()) {
+            std::cerr << "prepare() failed\n";
+            return -1;
+        }
+        for (int i = 0; i < batch_size; i++) {
+            fill_inputs(interpreter.inputs(), i * 100);
+            InferenceBuffers inputs;
+            for (const TensorPtr &t : interpreter.inputs()) {
+                inputs.emplace_back(t->buffer().copy());
+            }
+            batch.push_back(std::move(inputs));
+        }
+    }
+    const std::vector<InferenceBuffers> expected = run_individually(batch);
+
+    for (int instance_count : {1, 3}) {
+        if (!test_batch(instance_count, batch, expected)) {
+            return -1;
+        }
+    }
+
+    if (!test_share_constants()) {
+        return -1;
+    }
+
+    std::cout << "Success!\n";
+    return 0;
+}
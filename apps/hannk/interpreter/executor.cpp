@@ -0,0 +1,243 @@
+#include "interpreter/executor.h"
+#include "interpreter/ops.h"
+#include "util/error_util.h"
+
+#include <algorithm>
+
+namespace hannk {
+
+namespace {
+
+// A piece of memory read or written by an op. Accesses conflict if they
+// have the same key and overlapping [begin, end) ranges.
+struct Access {
+    enum Key : uintptr_t {
+        // The tensor storage arena. The range is the part of the arena used.
+        Arena = 0,
+        // Tensors outside the arena which alias other tensors. We can't
+        // tell which of these share memory, so they all conflict.
+        AliasedOutsideArena = 1,
+        // Anything else is the address of a Tensor with memory of its own.
+    };
+
+    uintptr_t key;
+    size_t begin, end;
+    bool is_write;
+
+    bool conflicts_with(const Access &other) const {
+        return (is_write || other.is_write) &&
+               key == other.key &&
+               begin < other.end &&
+               other.begin < end;
+    }
+};
+
+class FindAccesses : public OpVisitor {
+    using OpVisitor::visit;
+
+    const ArenaLayout &arena_layout_;
+
+    void add_access(const TensorPtr &t, bool is_write) {
+        if (t->is_constant()) {
+            // Nothing ever writes to these.
+            return;
+        }
+        auto it = arena_layout_.find(t.get());
+        if (it != arena_layout_.end()) {
+            accesses.push_back({Access::Arena, it->second.begin, it->second.end, is_write});
+        } else if (t->alias_type() != AliasType::None) {
+            accesses.push_back({Access::AliasedOutsideArena, 0, 1, is_write});
+        } else {
+            accesses.push_back({(uintptr_t)t.get(), 0, 1, is_write});
+        }
+    }
+
+    void visit_leaf(const Op *op) override {
+        for (int i = 0; i < op->input_count(); i++) {
+            add_access(op->input(i), false);
+        }
+        for (int i = 0; i < op->output_count(); i++) {
+            add_access(op->output(i), true);
+        }
+    }
+
+public:
+    explicit FindAccesses(const ArenaLayout &arena_layout)
+        : arena_layout_(arena_layout) {
+    }
+
+    std::vector<Access> accesses;
+};
+
+class FindUnits : public OpVisitor {
+    using OpVisitor::visit;
+
+    void visit_leaf(const Op *op) override {
+        units.push_back(op);
+    }
+
+    void visit(const OpGroup *op) override {
+        for (int i = 0; i < op->op_count(); i++) {
+            units.push_back(op->op(i));
+        }
+    }
+
+public:
+    std::vector<const Op *> units;
+};
+
+}  // namespace
+
+std::vector<Op *> find_units(Op *root) {
+    FindUnits finder;
+    root->accept(&finder);
+
+    std::vector<Op *> units;
+    for (const Op *op : finder.units) {
+        // The visitors only give us const access, but the model is ours to run.
+        units.push_back(const_cast<Op *>(op));
+    }
+    return units;
+}
+
+ParallelExecutor::ParallelExecutor(Op *root, const ArenaLayout &arena_layout, int num_threads) {
+    std::vector<std::vector<Access>> accesses;
+    for (Op *op : find_units(root)) {
+        FindAccesses find_accesses(arena_layout);
+        op->accept(&find_accesses);
+        accesses.push_back(std::move(find_accesses.accesses));
+
+        Node node;
+        node.op = op;
+        nodes_.push_back(std::move(node));
+    }
+
+    // The model is in a valid sequential order, so each op only needs to
+    // wait for the earlier ops it conflicts with.
+    for (int i = 0; i < (int)nodes_.size(); i++) {
+        for (int j = 0; j < i; j++) {
+            bool conflict = false;
+            for (const Access &a : accesses[i]) {
+                for (const Access &b : accesses[j]) {
+                    if (a.conflicts_with(b)) {
+                        conflict = true;
+                        break;
+                    }
+                }
+                if (conflict) {
+                    break;
+                }
+            }
+            if (conflict) {
+                nodes_[j].successors.push_back(i);
+                nodes_[i].predecessor_count++;
+            }
+        }
+    }
+
+    waiting_for_.resize(nodes_.size());
+    for (int i = 1; i < num_threads; i++) {
+        workers_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ParallelExecutor::~ParallelExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) {
+        t.join();
+    }
+}
+
+void ParallelExecutor::run_one(std::unique_lock<std::mutex> &lock) {
+    const int i = ready_.top();
+    ready_.pop();
+
+    lock.unlock();
+    nodes_[i].op->execute();
+    lock.lock();
+
+    bool notify = (--remaining_ == 0);
+    for (int s : nodes_[i].successors) {
+        if (--waiting_for_[s] == 0) {
+            ready_.push(s);
+            notify = true;
+        }
+    }
+    if (notify) {
+        cv_.notify_all();
+    }
+}
+
+void ParallelExecutor::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return shutdown_ || !ready_.empty(); });
+        if (shutdown_) {
+            return;
+        }
+        run_one(lock);
+    }
+}
+
+void ParallelExecutor::execute() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    HCHECK(remaining_ == 0) << "ParallelExecutor::execute() is not reentrant";
+
+    remaining_ = (int)nodes_.size();
+    for (int i = 0; i < (int)nodes_.size(); i++) {
+        waiting_for_[i] = nodes_[i].predecessor_count;
+        if (waiting_for_[i] == 0) {
+            ready_.push(i);
+        }
+    }
+    cv_.notify_all();
+
+    while (remaining_ > 0) {
+        if (!ready_.empty()) {
+            run_one(lock);
+        } else {
+            cv_.wait(lock, [this]() { return remaining_ == 0 || !ready_.empty(); });
+        }
+    }
+}
+
+int ParallelExecutor::dependency_count() const {
+    int count = 0;
+    for (const Node &n : nodes_) {
+        count += (int)n.successors.size();
+    }
+    return count;
+}
+
+int ParallelExecutor::critical_path_length() const {
+    // Successors always come later in the model, so one pass in order suffices.
+    std::vector<int> depth(nodes_.size(), 1);
+    int result = 0;
+    for (int i = 0; i < (int)nodes_.size(); i++) {
+        for (int s : nodes_[i].successors) {
+            depth[s] = std::max(depth[s], depth[i] + 1);
+        }
+        result = std::max(result, depth[i]);
+    }
+    return result;
+}
+
+void ParallelExecutor::dump(std::ostream &os) const {
+    os << "ParallelExecutor: " << op_count() << " ops, "
+       << dependency_count() << " dependencies, critical path of "
+       << critical_path_length() << " ops, "
+       << workers_.size() + 1 << " threads\n";
+    for (int i = 0; i < (int)nodes_.size(); i++) {
+        os << "  " << i << ": " << nodes_[i].op->name() << " ->";
+        for (int s : nodes_[i].successors) {
+            os << ' ' << s;
+        }
+        os << '\n';
+    }
+}
+
+}  // namespace hannk
@@ -0,0 +1,91 @@
+#ifndef HANNK_EXECUTOR_H
+#define HANNK_EXECUTOR_H
+
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "interpreter/model.h"
+
+namespace hannk {
+
+// The byte range of the tensor storage arena used by a Tensor.
+struct ArenaRange {
+    size_t begin;
+    size_t end;
+};
+using ArenaLayout = std::unordered_map<const Tensor *, ArenaRange>;
+
+// Find the units of work in a model: the ops in the outermost OpGroup, or
+// the root op itself if it isn't a group.
+std::vector<Op *> find_units(Op *root);
+
+// ParallelExecutor runs the ops of a model, running ops that don't depend
+// on each other concurrently on a pool of threads. Each op in the model's
+// outermost OpGroup is run as a unit. An op depends on an earlier op if
+// they access overlapping memory and at least one of them writes to it;
+// the arena layout is used to find tensors that share memory, so ops
+// never run concurrently with ops using memory the allocation planner
+// has reused.
+class ParallelExecutor {
+public:
+    // The model and layout must not change while the executor is in use.
+    // The thread calling execute() also runs ops, so num_threads - 1 threads
+    // are started.
+    ParallelExecutor(Op *root, const ArenaLayout &arena_layout, int num_threads);
+    ~ParallelExecutor();
+
+    // Run all the ops, and return once they have all finished.
+    void execute();
+
+    // The number of ops, and of dependencies between them.
+    int op_count() const {
+        return (int)nodes_.size();
+    }
+    int dependency_count() const;
+
+    // The length of the longest chain of dependent ops. If this is close to
+    // op_count(), there isn't much to run concurrently.
+    int critical_path_length() const;
+
+    void dump(std::ostream &os) const;
+
+    // Neither movable nor copyable.
+    ParallelExecutor() = delete;
+    ParallelExecutor(const ParallelExecutor &) = delete;
+    ParallelExecutor &operator=(const ParallelExecutor &) = delete;
+    ParallelExecutor(ParallelExecutor &&) = delete;
+    ParallelExecutor &operator=(ParallelExecutor &&) = delete;
+
+private:
+    struct Node {
+        Op *op;
+        std::vector<int> successors;
+        int predecessor_count = 0;
+    };
+    std::vector<Node> nodes_;
+
+    std::vector<std::thread> workers_;
+
+    // Everything below is protected by mutex_.
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    // Ready ops are run in the order of the model where possible, which
+    // is the order the allocation planner assumed.
+    std::priority_queue<int, std::vector<int>, std::greater<int>> ready_;
+    std::vector<int> waiting_for_;
+    int remaining_ = 0;
+    bool shutdown_ = false;
+
+    void worker_loop();
+    void run_one(std::unique_lock<std::mutex> &lock);
+};
+
+}  // namespace hannk
+
+#endif  // HANNK_EXECUTOR_H
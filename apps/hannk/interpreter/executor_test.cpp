@@ -0,0 +1,72 @@
+#include "interpreter/interpreter.h"
+#include "interpreter/test_models.h"
+
+#include <iostream>
+
+using namespace hannk;
+using namespace hannk::test;
+
+namespace {
+
+// Run a model with the given number of inter-op threads on inputs made from
+// each of seeds, and return copies of its outputs for each run.
+std::vector<std::vector<HalideBuffer<const void>>> run(int inter_op_threads, const std::vector<int> &seeds,
+                                                        bool *concurrent) {
+    InterpreterOptions options;
+    options.inter_op_threads = inter_op_threads;
+    Interpreter interpreter(make_branchy_model(), std::move(options));
+    if (!interpreter.prepare()) {
+        std::cerr << "prepare() failed\n";
+        exit(-1);
+    }
+    if (concurrent) {
+        const ParallelExecutor *executor = interpreter.executor();
+        *concurrent = executor && executor->critical_path_length() < executor->op_count();
+    }
+
+    std::vector<std::vector<HalideBuffer<const void>>> results;
+    for (int seed : seeds) {
+        fill_inputs(interpreter.inputs(), seed);
+        interpreter.execute();
+        results.emplace_back();
+        for (const TensorPtr &output : interpreter.outputs()) {
+            results.back().push_back(output->buffer().copy());
+        }
+    }
+    return results;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    // Run many times, so that the ops are likely to finish in many different
+    // orders.
+    std::vector<int> seeds;
+    for (int i = 0; i < 50; i++) {
+        seeds.push_back(i);
+    }
+
+    bool concurrent = false;
+    auto parallel = run(4, seeds, &concurrent);
+    auto sequential = run(1, seeds, nullptr);
+    if (!concurrent) {
+        std::cerr << "None of the ops of the branches can run concurrently\n";
+        return -1;
+    }
+
+    CompareBuffersOptions compare_options;
+    compare_options.require_exact();
+    for (size_t i = 0; i < seeds.size(); i++) {
+        for (size_t j = 0; j < sequential[i].size(); j++) {
+            const HalideBuffer<const void> &expected = sequential[i][j];
+            const HalideBuffer<const void> &actual = parallel[i][j];
+            if (!dynamic_type_dispatch<CompareBuffers>(expected.type(), expected, actual, compare_options).ok) {
+                std::cerr << "Output " << j << " of run " << i << " differs when ops run concurrently\n";
+                return -1;
+            }
+        }
+    }
+
+    std::cout << "Success!\n";
+    return 0;
+}
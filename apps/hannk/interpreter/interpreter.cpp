@@ -1,6 +1,9 @@
 #include "interpreter/interpreter.h"
 #include "interpreter/allocation_planner.h"
+#include "interpreter/executor.h"
+#include "interpreter/profiler.h"
 #include "interpreter/transforms.h"
+#include "util/buffer_util.h"
 #include "util/error_util.h"
 
 #include "HalideRuntime.h"
@@ -89,7 +92,8 @@ public:
     std::map<TensorStoragePtr, TensorAllocationInfo> tensor_info;
 };
 
-std::unique_ptr<char[]> allocate_tensors(const Op *root, const InterpreterOptions &options) {
+std::unique_ptr<char[]> allocate_tensors(const Op *root, const InterpreterOptions &options, ArenaLayout *arena_layout,
+                                         size_t *arena_size, size_t *arena_lower_bound) {
     // Find the tensors that we want to allocate in an arena,
     // along the needed storage size and lifetime for each.
     FindAllocatableTensors find_tensors;
@@ -116,11 +120,15 @@ std::unique_ptr<char[]> allocate_tensors(const Op *root, const InterpreterOption
         info.block_index = planner.add_block(info.size_needed, info.first_use, info.last_use);
         assert(info.block_index >= 0);
     }
-    planner.commit();
+    planner.commit(options.allocation_strategy);
+    *arena_size = planner.memory_needed();
+    *arena_lower_bound = planner.lower_bound();
 
     if (options.verbosity >= 1) {
         std::ostringstream oss;
-        oss << "Arena memory needed: " << planner.memory_needed() << '\n';
+        oss << "Arena memory needed: " << planner.memory_needed()
+            << " (lower bound " << planner.lower_bound()
+            << ", strategy " << to_string(planner.strategy()) << ")\n";
         oss << "    Offsets:";
         for (int i = 0; i < planner.block_count(); i++) {
             oss << ' ' << planner.get_block_offset(i);
@@ -144,9 +152,11 @@ std::unique_ptr<char[]> allocate_tensors(const Op *root, const InterpreterOption
 
     for (const auto &it : find_tensors.tensor_info) {
         const auto &info = it.second;
-        char *new_host = arena_base + planner.get_block_offset(info.block_index);
+        const size_t offset = planner.get_block_offset(info.block_index);
+        char *new_host = arena_base + offset;
         for (const auto &t : info.tensors) {
             t->allocate_from_arena_pointer(new_host);
+            (*arena_layout)[t.get()] = {offset, offset + info.size_needed};
         }
     }
 
@@ -246,6 +256,15 @@ bool Interpreter::prepare() {
 
     dump_model("Model after prepare():", 3);
 
+    if (options_.fuse_elementwise) {
+        model_ = fuse_elementwise(std::move(model_));
+        if (!model_) {
+            HLOG(ERROR) << "fuse_elementwise() failed.";
+            return false;
+        }
+        dump_model("Model after fuse_elementwise():", 3);
+    }
+
     model_ = pad_for_ops(std::move(model_));
     if (!model_) {
         HLOG(ERROR) << "pad_for_ops() failed.";
@@ -272,11 +291,18 @@ bool Interpreter::prepare() {
     model_ = remove_dead_ops(std::move(model_));
     dump_model("Model after remove_dead_ops:", 3);
 
+    if (options_.tile_cache_size > 0) {
+        model_ = tile_ops(std::move(model_), options_.tile_cache_size);
+        dump_model("Model after tile_ops:", 3);
+    }
+
 #ifndef NDEBUG
     do_check_op_order(model_.get());
 #endif
     assert(tensor_storage_arena_ == nullptr);
-    tensor_storage_arena_ = allocate_tensors(model_.get(), options_);
+    ArenaLayout arena_layout;
+    tensor_storage_arena_ = allocate_tensors(model_.get(), options_, &arena_layout,
+                                             &arena_size_, &arena_lower_bound_);
 
 #ifndef NDEBUG
     VerifyAllAllocated verify_all;
@@ -285,6 +311,17 @@ bool Interpreter::prepare() {
 
     dump_model("Model after all transformations:", 2);
 
+    if (options_.profile) {
+        profiler_ = std::make_unique<Profiler>(model_.get(), arena_layout);
+    } else if (options_.inter_op_threads > 1 && !options_.trace) {
+        executor_ = std::make_unique<ParallelExecutor>(model_.get(), arena_layout, options_.inter_op_threads);
+        if (options_.verbosity >= 1) {
+            std::ostringstream os;
+            executor_->dump(os);
+            HLOG(INFO) << os.str();
+        }
+    }
+
     prepared_ = true;
     return true;
 }
@@ -294,7 +331,110 @@ void Interpreter::execute() {
         HLOG(ERROR) << "Must call prepare() before execute()";
         return;
     }
-    model_->execute();
+    if (profiler_) {
+        profiler_->execute();
+    } else if (executor_) {
+        executor_->execute();
+    } else {
+        model_->execute();
+    }
+}
+
+namespace {
+
+class FindLeafOps : public OpVisitor {
+    using OpVisitor::visit;
+
+    void visit_leaf(const Op *op) override {
+        ops.push_back(op);
+    }
+
+    void visit(const TiledOpGroup *op) override {
+        // The constants used by a TiledOpGroup are inputs of its ops,
+        // not of the group.
+        for (int i = 0; i < op->op_count(); i++) {
+            op->op(i)->accept(this);
+        }
+    }
+
+public:
+    std::vector<const Op *> ops;
+};
+
+bool same_shape(const Tensor &a, const Tensor &b) {
+    if (a.type() != b.type() || a.rank() != b.rank()) {
+        return false;
+    }
+    for (int d = 0; d < a.rank(); d++) {
+        if (a.bounds(d) != b.bounds(d)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool same_contents(const Tensor &a, const Tensor &b) {
+    CompareBuffersOptions options;
+    options.require_exact();
+    options.verbose = false;
+    return dynamic_type_dispatch<CompareBuffers>(a.type(), a.buffer(), b.buffer(), options).ok;
+}
+
+}  // namespace
+
+bool Interpreter::share_constants_with(const Interpreter &other) {
+    HCHECK(prepared_ && other.prepared_);
+
+    FindLeafOps ours, theirs;
+    model_->accept(&ours);
+    other.model_->accept(&theirs);
+
+    // Check that the prepared models match before changing anything.
+    if (ours.ops.size() != theirs.ops.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < ours.ops.size(); i++) {
+        const Op *a = ours.ops[i];
+        const Op *b = theirs.ops[i];
+        if (a->name() != b->name() || a->input_count() != b->input_count()) {
+            return false;
+        }
+        for (int j = 0; j < a->input_count(); j++) {
+            const TensorPtr &ta = a->input(j);
+            const TensorPtr &tb = b->input(j);
+            if (ta->is_constant() != tb->is_constant()) {
+                return false;
+            }
+            // Models with the same structure can still have different
+            // weights, so compare the values too.
+            if (ta->is_constant() && ta != tb &&
+                (!same_shape(*ta, *tb) || !same_contents(*ta, *tb))) {
+                return false;
+            }
+        }
+    }
+
+    std::map<const Tensor *, TensorPtr> replacements;
+    for (size_t i = 0; i < ours.ops.size(); i++) {
+        // The visitor only gives us const access, but the model is ours to change.
+        Op *a = const_cast<Op *>(ours.ops[i]);
+        const Op *b = theirs.ops[i];
+        for (int j = 0; j < a->input_count(); j++) {
+            if (a->input(j)->is_constant() && a->input(j) != b->input(j)) {
+                replacements[a->input(j).get()] = b->input(j);
+                a->set_input(j, b->input(j));
+            }
+        }
+    }
+
+    // The model's own list of inputs may also hold on to constants.
+    for (int j = 0; j < model_->input_count(); j++) {
+        auto it = replacements.find(model_->input(j).get());
+        if (it != replacements.end()) {
+            model_->set_input(j, it->second);
+        }
+    }
+    return true;
 }
 
 TensorPtr Interpreter::get_tensor(const std::string &name) {
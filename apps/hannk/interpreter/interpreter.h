@@ -1,10 +1,14 @@
 #ifndef HANNK_INTERPRETER_H
 #define HANNK_INTERPRETER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "interpreter/allocation_planner.h"
+#include "interpreter/executor.h"
 #include "interpreter/model.h"
+#include "interpreter/profiler.h"
 
 namespace hannk {
 
@@ -14,11 +18,41 @@ struct InterpreterOptions {
 
     // Whether to enable tracing.
     bool trace = false;
+
+    // How many ops may run at once. Values greater than 1 run ops that
+    // don't depend on each other concurrently, which helps models with
+    // parallel branches whose ops don't use all the cores on their own.
+    // Ignored when tracing or profiling, to keep the trace in order.
+    int inter_op_threads = 1;
+
+    // Whether to time each op as the model runs. See Interpreter::profiler().
+    bool profile = false;
+
+    // Whether to fuse elementwise ops into the conv ops producing their
+    // inputs. This is off by default because it isn't exact: a fused
+    // activation rounds the conv's result once, where the unfused ops round
+    // it twice, so results can differ by one from TFLite's.
+    bool fuse_elementwise = false;
+
+    // If nonzero, chains of ops that each consume the output of the op
+    // before them run a tile of rows at a time, with the tiles chosen so
+    // the intermediate results of a tile fit in this many bytes (e.g. the
+    // size of the L2 cache). This trades recomputing the rows at the edges
+    // of tiles for less memory traffic and a smaller arena.
+    size_t tile_cache_size = 0;
+
+    // How to lay out the intermediate Tensors in the arena. The default
+    // tries every strategy and uses whichever needs the smallest arena.
+    AllocationStrategy allocation_strategy = AllocationStrategy::Auto;
 };
 
 class Interpreter {
     OpPtr model_;
     std::unique_ptr<char[]> tensor_storage_arena_;
+    size_t arena_size_ = 0;
+    size_t arena_lower_bound_ = 0;
+    std::unique_ptr<ParallelExecutor> executor_;
+    std::unique_ptr<Profiler> profiler_;
     InterpreterOptions options_;
     bool prepared_ = false;
 
@@ -42,6 +76,36 @@ public:
 
     void execute();
 
+    // Use the constant Tensors of another Interpreter, prepared from the same
+    // model, in place of this Interpreter's own copies, so that instances of a
+    // model running side by side share their weights (including any made by
+    // prepare(), such as tiled filters). Returns false and changes nothing if
+    // the prepared models don't match, including if any of their constants
+    // have different values.
+    [[nodiscard]] bool share_constants_with(const Interpreter &other);
+
+    // The size of the arena holding the model's intermediate Tensors, and the
+    // most memory those Tensors use at any one time, which is the smallest
+    // the arena could possibly be. Only valid after prepare().
+    size_t arena_size() const {
+        return arena_size_;
+    }
+    size_t arena_lower_bound() const {
+        return arena_lower_bound_;
+    }
+
+    // The per-op statistics gathered by execute(), if the profile option is
+    // set, or null otherwise. Only valid after prepare().
+    Profiler *profiler() {
+        return profiler_.get();
+    }
+
+    // The executor running ops concurrently, if inter_op_threads is greater
+    // than 1, or null otherwise. Only valid after prepare().
+    const ParallelExecutor *executor() const {
+        return executor_.get();
+    }
+
     // Return the Tensor(s) that are the initial input(s) of the Model.
     std::vector<TensorPtr> inputs();
 
@@ -43,7 +43,9 @@ struct DimMap {
     Interval evaluate(Interval x) const {
         Interval result = x;
         result += pre_bounds;
-        result /= inv_stride;
+        if (inv_stride != 1) {
+            result /= inv_stride;
+        }
         result *= stride;
         result += bounds;
         return result;
@@ -103,7 +105,7 @@ struct DimMap {
     }
 
     DimMap &elementwise(int offset = 0) {
-        return upsample(1);
+        return upsample(1, Interval(offset));
     }
 
     DimMap &stencil(const Interval &filter) {
@@ -153,7 +155,13 @@ public:
     Interval evaluate(int dim_in, const Box &output) const {
         Interval result = at(dim_in).bounds;
         for (int i = 0; i < (int)output.size(); i++) {
-            result = Union(result, at(dim_in, i).evaluate(output[i]));
+            // Output dimensions this input dimension doesn't depend on
+            // map to an empty interval, which shouldn't widen the result.
+            Interval dep = at(dim_in, i).evaluate(output[i]);
+            if (dep.empty()) {
+                continue;
+            }
+            result = result.empty() ? dep : Union(result, dep);
         }
         return result;
     }
@@ -0,0 +1,153 @@
+#include "interpreter/interpreter.h"
+#include "interpreter/model.h"
+#include "interpreter/test_models.h"
+
+#include <iostream>
+
+using namespace hannk;
+using namespace hannk::test;
+
+namespace {
+
+bool check_box(const char *name, const Box &result, const Box &expected) {
+    bool ok = result.size() == expected.size();
+    for (size_t i = 0; ok && i < result.size(); i++) {
+        ok = result[i] == expected[i];
+    }
+    if (!ok) {
+        std::cerr << name << ": expected";
+        for (const Interval &i : expected) {
+            std::cerr << " " << i;
+        }
+        std::cerr << ", got";
+        for (const Interval &i : result) {
+            std::cerr << " " << i;
+        }
+        std::cerr << "\n";
+    }
+    return ok;
+}
+
+// Check BoundsMap::evaluate on regions that don't start at 0, as the tiles
+// of a TiledOpGroup don't.
+bool test_bounds_map() {
+    const Box output = {Interval(0, 15), Interval(3, 7), Interval(2, 4), Interval(0, 0)};
+
+    BoundsMap elementwise = BoundsMap::elementwise(4);
+    if (!check_box("elementwise", elementwise.evaluate(output), output)) {
+        return false;
+    }
+
+    BoundsMap offset = BoundsMap::elementwise(4);
+    offset.elementwise(1, 1, 2);
+    if (!check_box("offset", offset.evaluate(output),
+                   {Interval(0, 15), Interval(5, 9), Interval(2, 4), Interval(0, 0)})) {
+        return false;
+    }
+
+    BoundsMap stencil = BoundsMap::elementwise(4);
+    stencil.stencil(1, 1, Interval(-1, 1));
+    if (!check_box("stencil", stencil.evaluate(output),
+                   {Interval(0, 15), Interval(2, 8), Interval(2, 4), Interval(0, 0)})) {
+        return false;
+    }
+
+    BoundsMap downsample = BoundsMap::elementwise(4);
+    downsample.downsample(2, 2, 2, Interval(0, 2));
+    if (!check_box("downsample", downsample.evaluate(output),
+                   {Interval(0, 15), Interval(3, 7), Interval(4, 10), Interval(0, 0)})) {
+        return false;
+    }
+
+    BoundsMap upsample = BoundsMap::elementwise(4);
+    upsample.upsample(1, 1, 2);
+    if (!check_box("upsample", upsample.evaluate(output),
+                   {Interval(0, 15), Interval(1, 3), Interval(2, 4), Interval(0, 0)})) {
+        return false;
+    }
+
+    // An input dimension that depends on no output dimension is the same
+    // for any output region.
+    BoundsMap constant(4, 4);
+    constant.constant(0, 8).elementwise(1, 1).elementwise(2, 2).elementwise(3, 3);
+    if (!check_box("constant", constant.evaluate(output),
+                   {Interval(0, 7), Interval(3, 7), Interval(2, 4), Interval(0, 0)})) {
+        return false;
+    }
+
+    return true;
+}
+
+// Check the padding the default (untiled) path adds for a conv with 'same'
+// padding: a 3x3 conv needs one more row and column on each side.
+bool test_pad_for_ops() {
+    const int width = 12;
+    const int height = 10;
+    Interpreter interpreter(make_conv_model(Epilogue::None, 0, width, height));
+    if (!interpreter.prepare()) {
+        std::cerr << "prepare() failed\n";
+        return false;
+    }
+    TensorPtr padded = interpreter.get_tensor("input.padded");
+    if (!padded) {
+        std::cerr << "The conv's input wasn't padded\n";
+        return false;
+    }
+    if (padded->extent(1) != width + 2 || padded->extent(2) != height + 2 ||
+        padded->extent(3) != 1) {
+        std::cerr << "Expected the padded input to be " << width + 2 << "x" << height + 2
+                  << ", got " << padded->extent(1) << "x" << padded->extent(2) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Check that a TiledOpGroup's bounds compose those of the ops in its chain:
+// a 3x3 max pool with stride 2, a 3x3 max pool with stride 1, and an add.
+bool test_tiled_op_group_bounds() {
+    const halide_type_t u8 = halide_type_of<uint8_t>();
+    TensorPtr input = make_tensor("input", u8, {8, 41, 41, 1}, 0.02f, 128);
+    TensorPtr pooled = make_tensor("pooled", u8, {8, 20, 20, 1}, 0.02f, 128);
+    TensorPtr pooled2 = make_tensor("pooled2", u8, {8, 18, 18, 1}, 0.02f, 128);
+    TensorPtr addend = make_tensor("addend", u8, {8, 18, 18, 1}, 0.02f, 128);
+    TensorPtr output = make_tensor("output", u8, {8, 18, 18, 1}, 0.04f, 128);
+
+    std::vector<OpPtr> ops;
+    ops.push_back(make_op<Pool2DOp>(input, pooled, std::array<int, 2>{2, 2}, std::array<int, 2>{3, 3},
+                                    Padding::Valid, Pool2DOp::Max, ActivationFunction::None));
+    ops.push_back(make_op<Pool2DOp>(pooled, pooled2, std::array<int, 2>{1, 1}, std::array<int, 2>{3, 3},
+                                    Padding::Valid, Pool2DOp::Max, ActivationFunction::None));
+    ops.push_back(make_op<BinaryOp>(pooled2, addend, output, BinaryOp::Add));
+    TiledOpGroup group(std::move(ops));
+
+    const Box region = {Interval(0, 7), Interval(3, 7), Interval(2, 4), Interval(0, 0)};
+    if (group.input(0) != input || group.input(1) != addend) {
+        std::cerr << "Unexpected inputs of the TiledOpGroup\n";
+        return false;
+    }
+    if (!check_box("tiled input", group.map_bounds(0, 0).evaluate(region),
+                   {Interval(0, 7), Interval(6, 20), Interval(4, 14), Interval(0, 0)})) {
+        return false;
+    }
+    if (!check_box("tiled addend", group.map_bounds(1, 0).evaluate(region), region)) {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (!test_bounds_map()) {
+        return -1;
+    }
+    if (!test_pad_for_ops()) {
+        return -1;
+    }
+    if (!test_tiled_op_group_bounds()) {
+        return -1;
+    }
+
+    std::cout << "Success!\n";
+    return 0;
+}
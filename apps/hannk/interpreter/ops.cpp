@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <atomic>
 #include <cmath>
 #include <iostream>
@@ -5,6 +6,7 @@
 #include "halide/add_uint8_uint8.h"
 #include "halide/average_pool_uint8.h"
 #include "halide/constants.h"
+#include "halide/conv_add_u8_u8_u8.h"
 #include "halide/conv_u8_u8_i16.h"
 #include "halide/conv_u8_u8_u8.h"
 #ifdef CONV_R16
@@ -12,6 +14,9 @@
 #include "halide/conv_r16_u8_u8_u8.h"
 #endif
 #include "halide/copy_uint8_uint8.h"
+#include "halide/depthwise_conv_add_broadcast_uint8.h"
+#include "halide/depthwise_conv_add_shallow_uint8.h"
+#include "halide/depthwise_conv_add_uint8.h"
 #include "halide/depthwise_conv_broadcast_uint8.h"
 #include "halide/depthwise_conv_shallow_uint8.h"
 #include "halide/depthwise_conv_uint8.h"
@@ -434,26 +439,51 @@ MultiplyParams get_quantized_multiply_params(const QuantizationInfo &a, const Qu
     return result;
 }
 
-void add_uint8(const HalideBuffer<const void> &in1, const QuantizationInfo &in1q, int in1sign,
-               const HalideBuffer<const void> &in2, const QuantizationInfo &in2q, int in2sign,
-               const HalideBuffer<void> &out, const QuantizationInfo &outq,
-               ActivationFunction activation = ActivationFunction::None) {
-    const int in1_zero = in1q.uniform_zero();
-    const int in2_zero = in2q.uniform_zero();
-    const int out_zero = outq.uniform_zero();
+struct AddParams {
+    int in1_zero;
+    int in1_multiplier;
+    int in2_zero;
+    int in2_multiplier;
+    int out_zero;
+    Interval out_range;
+};
+
+AddParams get_add_params(const QuantizationInfo &in1q, int in1sign,
+                         const QuantizationInfo &in2q, int in2sign,
+                         const QuantizationInfo &outq, ActivationFunction activation) {
+    AddParams result;
+    result.in1_zero = in1q.uniform_zero();
+    result.in2_zero = in2q.uniform_zero();
+    result.out_zero = outq.uniform_zero();
 
     const float in1_scale = in1q.uniform_scale() * (1 << add_output_shift);
     const float in2_scale = in2q.uniform_scale() * (1 << add_output_shift);
     const float out_scale = outq.uniform_scale() * (1 << add_input_shift);
 
-    const int in1_multiplier = std::lround(in1_scale / out_scale) * in1sign;
-    const int in2_multiplier = std::lround(in2_scale / out_scale) * in2sign;
+    result.in1_multiplier = std::lround(in1_scale / out_scale) * in1sign;
+    result.in2_multiplier = std::lround(in2_scale / out_scale) * in2sign;
 
-    const auto out_range = get_output_range(activation, outq);
+    result.out_range = get_output_range(activation, outq);
+    return result;
+}
+
+// Get the parameters for adding an addend to the result of a conv, as
+// described by fused_add. The result is in1 and the addend is in2.
+AddParams get_fused_add_params(const FusedAdd &fused_add, const QuantizationInfo &addendq,
+                               const QuantizationInfo &outq) {
+    return get_add_params(fused_add.result_quantization, fused_add.result_sign,
+                          addendq, fused_add.addend_sign, outq, fused_add.activation);
+}
+
+void add_uint8(const HalideBuffer<const void> &in1, const QuantizationInfo &in1q, int in1sign,
+               const HalideBuffer<const void> &in2, const QuantizationInfo &in2q, int in2sign,
+               const HalideBuffer<void> &out, const QuantizationInfo &outq,
+               ActivationFunction activation = ActivationFunction::None) {
+    const AddParams params = get_add_params(in1q, in1sign, in2q, in2sign, outq, activation);
 
     auto add_rank2 = [&](halide_buffer_t *in1_buf, halide_buffer_t *in2_buf, halide_buffer_t *out_buf) {
-        add_uint8_uint8(in1_buf, in1_zero, in1_multiplier, in2_buf, in2_zero, in2_multiplier,
-                        out_zero, out_range.min, out_range.max, out_buf);
+        add_uint8_uint8(in1_buf, params.in1_zero, params.in1_multiplier, in2_buf, params.in2_zero, params.in2_multiplier,
+                        params.out_zero, params.out_range.min, params.out_range.max, out_buf);
     };
     elementwise_loop_nest<2>(add_rank2, in1, in2, out);
 }
@@ -799,9 +829,11 @@ BoundsMap ConvOp::map_bounds(int input_idx, int output_idx) const {
             result.constant(i + 3, filter()->bounds(i));
         }
         return result;
-    } else {
-        assert(input_idx == 2);
+    } else if (input_idx == 2) {
         return BoundsMap(1, output()->rank()).elementwise(0, 0);
+    } else {
+        assert(input_idx == 3);
+        return BoundsMap::elementwise(output()->rank());
     }
 }
 
@@ -831,6 +863,20 @@ void call_conv2d(halide_buffer_t *input, halide_buffer_t *filter, halide_buffer_
        output);
 }
 
+void call_conv2d_add(halide_buffer_t *input, halide_buffer_t *filter, halide_buffer_t *bias,
+                     const MultiplyParams &params, const std::array<int, 2> &stride,
+                     const std::array<int, 2> &dilation, const Interval &output_range,
+                     halide_buffer_t *addend, const AddParams &add_params, halide_buffer_t *output) {
+    // There is no big reduction version of this; the alignment it requires of
+    // the input is also sufficient for this one.
+    conv_add_u8_u8_u8(input, (uint8_t)params.a_zero, filter, (uint8_t)params.b_zero, bias,
+                      stride[0], stride[1], dilation[0], dilation[1], params.c.mantissa(),
+                      -params.c.exponent(), (uint8_t)params.c_zero, output_range.min, output_range.max,
+                      addend, (uint8_t)add_params.in2_zero, (int16_t)add_params.in2_multiplier,
+                      (int16_t)add_params.in1_multiplier, (uint8_t)add_params.out_zero,
+                      (uint8_t)add_params.out_range.min, (uint8_t)add_params.out_range.max, output);
+}
+
 }  // namespace
 
 bool ConvOp::prepare() {
@@ -853,23 +899,33 @@ void ConvOp::execute() {
     const TensorPtr &in = input();
     const TensorPtr &filt = filter();
     const TensorPtr &out = output();
+    const TensorPtr add = addend();
 
     if (in->type() == halide_type_of<uint8_t>() &&
-        (out->type() == halide_type_of<uint8_t>() || out->type() == halide_type_of<int16_t>())) {
+        (out->type() == halide_type_of<uint8_t>() || out->type() == halide_type_of<int16_t>()) &&
+        (!add || (add->type() == halide_type_of<uint8_t>() && out->type() == halide_type_of<uint8_t>()))) {
         auto input_buf = in->buffer();
         auto filter_buf = filt->buffer();
         auto bias_buf = bias()->buffer();
         auto output_buf = out->buffer();
-
+        // The addend has the same shape as the output, and gets the same
+        // treatment below.
+        HalideBuffer<void> addend_buf = add ? add->buffer() : output_buf;
+
+        // With a fused add, the conv's own result is quantized as described
+        // by the fused add, not as the output.
+        const QuantizationInfo &result_quantization =
+            add ? fused_add_.result_quantization : out->quantization();
         MultiplyParams params =
-            get_quantized_multiply_params(in->quantization(), filt->quantization(), out->quantization());
+            get_quantized_multiply_params(in->quantization(), filt->quantization(), result_quantization);
 
-        const auto output_range = get_output_range(activation_, out->quantization());
+        const auto output_range = get_output_range(activation_, result_quantization);
 
         // Pad with dummy dimensions up to 2D.
         while (input_buf.dimensions() < 4) {
             input_buf.embed(input_buf.dimensions() - 1, 1);
             output_buf.embed(output_buf.dimensions() - 1, 1);
+            addend_buf.embed(addend_buf.dimensions() - 1, 1);
             filter_buf.add_dimension();
         }
 
@@ -883,9 +939,11 @@ void ConvOp::execute() {
             // them all where possible, which might be a further improvement.
             while (can_fuse_xy(FuseType::Pad, input_buf) &&
                    can_fuse_xy(FuseType::Pad, output_buf) &&
+                   can_fuse_xy(FuseType::Pad, addend_buf) &&
                    input_buf.dim(1).extent() == output_buf.dim(1).extent()) {
                 fuse_xy(FuseType::Pad, input_buf);
                 fuse_xy(FuseType::Pad, output_buf);
+                fuse_xy(FuseType::Pad, addend_buf);
             }
 
             if (output_buf.dim(1).extent() < output_buf.dim(2).extent()) {
@@ -894,10 +952,17 @@ void ConvOp::execute() {
                 // if we tiled y instead. We can do this by just swapping the x and y dimensions.
                 input_buf.transpose(1, 2);
                 output_buf.transpose(1, 2);
+                addend_buf.transpose(1, 2);
             }
         }
 
-        call_conv2d(input_buf, filter_buf, bias_buf, params, stride_, dilation_, output_range, output_buf);
+        if (add) {
+            const AddParams add_params = get_fused_add_params(fused_add_, add->quantization(), out->quantization());
+            call_conv2d_add(input_buf, filter_buf, bias_buf, params, stride_, dilation_, output_range,
+                            addend_buf, add_params, output_buf);
+        } else {
+            call_conv2d(input_buf, filter_buf, bias_buf, params, stride_, dilation_, output_range, output_buf);
+        }
     } else {
         HLOG(FATAL) << "Unsupported type " << out->type() << "\n";
     }
@@ -928,6 +993,30 @@ void call_depthwise_conv_uint8(
     }
 }
 
+// As above, for the variants with a fused add.
+void call_depthwise_conv_add_uint8(
+    halide_buffer_t *input, halide_buffer_t *filter, halide_buffer_t *bias,
+    const MultiplyParams &params, const std::array<int, 2> &stride, const std::array<int, 2> &dilation,
+    int input_stride_x, const Interval &output_range, halide_buffer_t *addend, const AddParams &add_params,
+    halide_buffer_t *output) {
+    using DepthwiseConvAddFn = decltype(&::hannk::depthwise_conv_add_uint8);
+
+    DepthwiseConvAddFn fn;
+    if (input_stride_x != 0) {
+        fn = depthwise_conv_add_shallow_uint8;
+    } else if (input->dim[0].extent == 1) {
+        fn = depthwise_conv_add_broadcast_uint8;
+    } else {
+        fn = ::hannk::depthwise_conv_add_uint8;
+    }
+    fn(input, (uint8_t)params.a_zero, filter, (uint8_t)params.b_zero, bias,
+       stride[0], stride[1], dilation[0], dilation[1], input_stride_x, params.c.mantissa(), -params.c.exponent(),
+       (uint8_t)params.c_zero, (uint8_t)output_range.min, (uint8_t)output_range.max,
+       addend, (uint8_t)add_params.in2_zero, (int16_t)add_params.in2_multiplier,
+       (int16_t)add_params.in1_multiplier, (uint8_t)add_params.out_zero,
+       (uint8_t)add_params.out_range.min, (uint8_t)add_params.out_range.max, output);
+}
+
 bool can_be_shallow(int alignment, int extent_0, int extent_1) {
     assert(alignment > 0);
     // This is correct: we want to use shallow when the vector size (ie, alignment)
@@ -967,6 +1056,8 @@ BoundsMap DepthwiseConv2DOp::map_bounds(int input_idx, int output_idx) const {
             .constant(2, filter()->bounds(2));
     } else if (input_idx == 2) {
         return BoundsMap(1, 4).elementwise(0, 0);
+    } else if (input_idx == 3) {
+        return BoundsMap::elementwise(4);
     } else {
         return BoundsMap(0, 4);
     }
@@ -990,19 +1081,28 @@ void DepthwiseConv2DOp::execute() {
     const TensorPtr &in = input();
     const TensorPtr &filt = filter();
     const TensorPtr &out = output();
+    const TensorPtr add = addend();
 
     if (in->type() == halide_type_of<uint8_t>() &&
         filt->type() == halide_type_of<uint8_t>() &&
-        out->type() == halide_type_of<uint8_t>()) {
+        out->type() == halide_type_of<uint8_t>() &&
+        (!add || add->type() == halide_type_of<uint8_t>())) {
         auto input_buf = in->buffer();
         auto filter_buf = filt->buffer().sliced(3, 0);
         auto bias_buf = bias()->buffer();
         auto output_buf = out->buffer();
-
+        // The addend has the same shape as the output, and gets the same
+        // treatment below.
+        HalideBuffer<void> addend_buf = add ? add->buffer() : output_buf;
+
+        // With a fused add, the conv's own result is quantized as described
+        // by the fused add, not as the output.
+        const QuantizationInfo &result_quantization =
+            add ? fused_add_.result_quantization : out->quantization();
         MultiplyParams params =
-            get_quantized_multiply_params(in->quantization(), filt->quantization(), out->quantization());
+            get_quantized_multiply_params(in->quantization(), filt->quantization(), result_quantization);
 
-        const auto output_range = get_output_range(activation_, out->quantization());
+        const auto output_range = get_output_range(activation_, result_quantization);
 
         // If the number of channels is small and divides the channel alignment,
         // and the stride of the filter in x is 1, we can use the "shallow"
@@ -1012,15 +1112,23 @@ void DepthwiseConv2DOp::execute() {
         if (stride_[0] == 1 &&
             can_fuse_cx(FuseType::InPlace, input_buf) &&
             can_fuse_cx(FuseType::InPlace, output_buf) &&
+            can_fuse_cx(FuseType::InPlace, addend_buf) &&
             can_be_shallow(channel_alignment_, input_buf.dim(0).extent(), input_buf.dim(1).extent())) {
             input_stride_x = input_buf.dim(1).stride();
             fuse_cx(FuseType::InPlace, input_buf);
             fuse_cx(FuseType::InPlace, output_buf);
+            fuse_cx(FuseType::InPlace, addend_buf);
         }
 
         assert(depth_multiplier_ == 1 || depth_multiplier_ >= out->extent(0));
-        call_depthwise_conv_uint8(input_buf, filter_buf, bias_buf, params,
-                                  stride_, dilation_, input_stride_x, output_range, output_buf);
+        if (add) {
+            const AddParams add_params = get_fused_add_params(fused_add_, add->quantization(), out->quantization());
+            call_depthwise_conv_add_uint8(input_buf, filter_buf, bias_buf, params, stride_, dilation_,
+                                          input_stride_x, output_range, addend_buf, add_params, output_buf);
+        } else {
+            call_depthwise_conv_uint8(input_buf, filter_buf, bias_buf, params,
+                                      stride_, dilation_, input_stride_x, output_range, output_buf);
+        }
     } else {
         HLOG(FATAL) << "Unsupported type " << out->type() << "\n";
     }
@@ -1214,8 +1322,9 @@ BoundsMap PadOp::map_bounds(int input_idx, int output_idx) const {
         if (input(1)) {
             BoundsMap result(rank, rank);
             const auto &padding = input(1)->buffer<const int32_t>();
-            for (int d = 0; d < output()->rank(); d++) {
-                result.elementwise(d, d, padding(0, d));
+            for (int d = 0; d < rank; d++) {
+                // The padding is stored in reverse order of the dimensions.
+                result.elementwise(d, d, -padding(0, rank - d - 1));
             }
             return result;
         } else {
@@ -1730,6 +1839,307 @@ void TileConvFilterOp::execute() {
     }
 }
 
+namespace {
+
+HalideBuffer<void> crop_to_box(HalideBuffer<void> buf, const Box &box) {
+    for (int d = 0; d < (int)box.size(); d++) {
+        buf.crop(d, box[d].min, box[d].extent());
+    }
+    return buf;
+}
+
+// Make a view of (the beginning of) scratch with the bounds of box.
+HalideBuffer<void> scratch_view(HalideBuffer<void> scratch, const Box &box) {
+    for (int d = 0; d < (int)box.size(); d++) {
+        scratch.crop(d, 0, box[d].extent());
+        scratch.translate(d, box[d].min);
+    }
+    return scratch;
+}
+
+// Find the parts of the outputs and inputs of a chain of ops needed to
+// compute the given region of the output of the last op. Returns false if
+// an op wouldn't need any of one of its inputs, which ops don't expect.
+bool plan_tile(const std::vector<OpPtr> &ops, Box region, TiledOpGroup::Tile *tile) {
+    tile->resize(ops.size());
+    for (int i = (int)ops.size() - 1; i >= 0; i--) {
+        const Op *op = ops[i].get();
+        TiledOpGroup::OpTile &op_tile = (*tile)[i];
+        op_tile.output = region;
+        op_tile.inputs.assign(op->input_count(), Box());
+        for (int j = 0; j < op->input_count(); j++) {
+            const TensorPtr &input = op->input(j);
+            if (!input || input->is_constant()) {
+                continue;
+            }
+            Box required = intersect(op->map_bounds(j, 0).evaluate(region), input->bounds());
+            if (is_empty(required)) {
+                return false;
+            }
+            op_tile.inputs[j] = std::move(required);
+        }
+        // The output of the previous op is input 0 of this one.
+        region = op_tile.inputs[0];
+    }
+    return true;
+}
+
+// Whether a dependency is just a shift by the range in its bounds.
+bool is_shift(const DimMap &m) {
+    return m.stride == 1 && m.inv_stride == 1 && m.pre_bounds == Interval(0, 0);
+}
+
+// Compose the dependency of a producer's input on its output (f) with the
+// dependency of that output on the chain's output (g), if the result is
+// also a DimMap.
+bool compose(const DimMap &f, const DimMap &g, DimMap *result) {
+    if (is_shift(f)) {
+        *result = g;
+        result->bounds += f.bounds;
+        return true;
+    } else if (is_shift(g)) {
+        *result = f;
+        result->pre_bounds += g.bounds;
+        return true;
+    } else if (f.inv_stride == 1 && g.inv_stride == 1 &&
+               f.pre_bounds == Interval(0, 0) && g.pre_bounds == Interval(0, 0)) {
+        *result = DimMap(f.stride * g.stride, 1, g.bounds * f.stride + f.bounds);
+        return true;
+    }
+    return false;
+}
+
+void add_to(Interval &a, const Interval &b) {
+    if (!b.empty()) {
+        a = a.empty() ? b : Union(a, b);
+    }
+}
+
+// Add the dependency of an input of an op in the chain on the chain's
+// output to result. `inner` maps the input to the op's output, which has
+// rank `rank`, and `outer` maps the op's output to the chain's output. An
+// input dimension that depends on the chain's output in a way a BoundsMap
+// can't express depends on all of `input_bounds` instead, which is always
+// enough.
+void add_composed(const BoundsMap &inner, const BoundsMap &outer, int rank, const Box &input_bounds,
+                  int output_rank, BoundsMap *result) {
+    for (int d = 0; d < (int)input_bounds.size(); d++) {
+        Interval constant = result->at(d).bounds;
+        add_to(constant, inner.at(d).bounds);
+        bool exact = true;
+        for (int m = 0; m < rank && exact; m++) {
+            const DimMap &f = inner.at(d, m);
+            if (f.stride == 0) {
+                add_to(constant, f.bounds);
+                continue;
+            }
+            if (!outer.at(m).bounds.empty()) {
+                add_to(constant, f.evaluate(outer.at(m).bounds));
+            }
+            for (int k = 0; k < output_rank && exact; k++) {
+                const DimMap &g = outer.at(m, k);
+                if (g.stride == 0) {
+                    if (!g.bounds.empty()) {
+                        add_to(constant, f.evaluate(g.bounds));
+                    }
+                    continue;
+                }
+                DimMap h;
+                DimMap &existing = result->at(d, k);
+                // Two dependencies on the same output dimension can only be
+                // combined if they are the same.
+                exact = compose(f, g, &h) &&
+                        (existing.stride == 0 ||
+                         (existing.stride == h.stride && existing.inv_stride == h.inv_stride &&
+                          existing.pre_bounds == h.pre_bounds && existing.bounds == h.bounds));
+                if (exact) {
+                    existing = h;
+                }
+            }
+        }
+        if (!exact) {
+            for (int k = 0; k < output_rank; k++) {
+                result->at(d, k) = DimMap();
+            }
+            constant = input_bounds[d];
+        }
+        result->at(d).constant(constant);
+    }
+}
+
+}  // namespace
+
+std::vector<TensorPtr> TiledOpGroup::chain_inputs(const std::vector<OpPtr> &ops) {
+    std::vector<TensorPtr> result;
+    for (size_t i = 0; i < ops.size(); i++) {
+        for (int j = 0; j < ops[i]->input_count(); j++) {
+            const TensorPtr &input = ops[i]->input(j);
+            // Constants are left out, so ops outside the group can't be
+            // ordered after this one because of them.
+            if (!input || input->is_constant() || (i > 0 && j == 0)) {
+                continue;
+            }
+            if (std::find(result.begin(), result.end(), input) == result.end()) {
+                result.push_back(input);
+            }
+        }
+    }
+    return result;
+}
+
+TiledOpGroup::TiledOpGroup(std::vector<OpPtr> ops)
+    : Op(chain_inputs(ops), {ops.back()->output()}), ops_(std::move(ops)) {
+    for (size_t i = 1; i < ops_.size(); i++) {
+        assert(ops_[i]->input(0) == ops_[i - 1]->output());
+        assert(ops_[i - 1]->output()->consumers().size() == 1);
+    }
+}
+
+bool TiledOpGroup::plan(size_t cache_size) {
+    assert(tiles_.empty());
+
+    const int intermediate_count = (int)ops_.size() - 1;
+    const Box bounds = output()->bounds();
+    const int height = bounds[2].extent();
+    // Start with a single tile, to see if the intermediates already fit.
+    for (int tile_count = 1; tile_count <= height; tile_count *= 2) {
+        const int tile_height = ceil_div(height, tile_count);
+        std::vector<Tile> tiles;
+        for (int y = bounds[2].min; y <= bounds[2].max; y += tile_height) {
+            Box region = bounds;
+            region[2] = Interval(y, std::min(y + tile_height - 1, bounds[2].max));
+            Tile tile;
+            if (!plan_tile(ops_, region, &tile)) {
+                return false;
+            }
+            tiles.push_back(std::move(tile));
+        }
+
+        // The scratch for each intermediate must hold its part of any tile.
+        std::vector<std::vector<int>> extents(intermediate_count);
+        size_t size = 0;
+        for (int i = 0; i < intermediate_count; i++) {
+            const TensorPtr &t = ops_[i]->output();
+            extents[i].assign(t->rank(), 0);
+            for (const Tile &tile : tiles) {
+                for (int d = 0; d < t->rank(); d++) {
+                    extents[i][d] = std::max(extents[i][d], tile[i].output[d].extent());
+                }
+            }
+            size_t elem_count = 1;
+            for (int e : extents[i]) {
+                elem_count *= e;
+            }
+            size += elem_count * t->type().bytes();
+        }
+        if (size > cache_size) {
+            continue;
+        }
+        if (tile_count == 1) {
+            // Tiling wouldn't keep anything in cache that isn't already.
+            return false;
+        }
+
+        for (int i = 0; i < intermediate_count; i++) {
+            const TensorPtr &t = ops_[i]->output();
+            scratch_.emplace_back(t->type(), extents[i]);
+            unallocated_.push_back(t->buffer());
+        }
+
+        sources_.resize(ops_.size());
+        for (size_t i = 0; i < ops_.size(); i++) {
+            Op *op = ops_[i].get();
+            sources_[i].resize(op->input_count());
+            for (int j = 0; j < op->input_count(); j++) {
+                TensorPtr input = op->input(j);
+                if (!input || input->is_constant() || (i > 0 && j == 0)) {
+                    continue;
+                }
+                TensorPtr proxy = std::make_shared<Tensor>(input->name() + ".tile", input->type(),
+                                                           input->bounds(), input->quantization());
+                op->set_input(j, proxy);
+                sources_[i][j] = std::move(input);
+            }
+        }
+
+        tiles_ = std::move(tiles);
+        return true;
+    }
+    return false;
+}
+
+std::vector<OpPtr> TiledOpGroup::release_ops() {
+    assert(tiles_.empty());
+    return std::move(ops_);
+}
+
+BoundsMap TiledOpGroup::map_bounds(int input_idx, int output_idx) const {
+    assert(output_idx == 0);
+    const TensorPtr &in = input(input_idx);
+    const int output_rank = output()->rank();
+    BoundsMap result(in->rank(), output_rank);
+
+    // Walk back from the last op, composing the dependency of each op's
+    // output on the chain's output with the dependencies of its inputs.
+    BoundsMap outer = BoundsMap::elementwise(output_rank);
+    for (int i = (int)ops_.size() - 1; i >= 0; i--) {
+        const Op *op = ops_[i].get();
+        const int rank = op->output()->rank();
+        for (int j = 0; j < op->input_count(); j++) {
+            // After plan(), inputs from outside the chain are proxies.
+            TensorPtr source = sources_.empty() || !sources_[i][j] ? op->input(j) : sources_[i][j];
+            if (source == in && !(i > 0 && j == 0)) {
+                add_composed(op->map_bounds(j, 0), outer, rank, in->bounds(), output_rank, &result);
+            }
+        }
+        if (i > 0) {
+            const int input_rank = op->input(0)->rank();
+            BoundsMap next(input_rank, output_rank);
+            add_composed(op->map_bounds(0, 0), outer, rank, op->input(0)->bounds(), output_rank, &next);
+            outer = next;
+        }
+    }
+    return result;
+}
+
+void TiledOpGroup::execute() {
+    const int last = (int)ops_.size() - 1;
+    const TensorPtr &out = output();
+    HalideBuffer<void> output_buf = out->buffer();
+
+    for (const Tile &tile : tiles_) {
+        for (int i = 0; i <= last; i++) {
+            Op *op = ops_[i].get();
+            const OpTile &op_tile = tile[i];
+            for (int j = 0; j < op->input_count(); j++) {
+                if (sources_[i][j]) {
+                    op->input(j)->exchange_buffer(crop_to_box(sources_[i][j]->buffer(), op_tile.inputs[j]));
+                }
+            }
+            if (i < last) {
+                op->output()->exchange_buffer(scratch_view(scratch_[i], op_tile.output));
+            } else {
+                out->exchange_buffer(crop_to_box(output_buf, op_tile.output));
+            }
+            op->execute();
+        }
+    }
+
+    for (int i = 0; i < last; i++) {
+        ops_[i]->output()->exchange_buffer(unallocated_[i]);
+    }
+    out->exchange_buffer(std::move(output_buf));
+}
+
+void TiledOpGroup::dump(std::ostream &os, int indent) const {
+    Op::dump(os, indent);
+    os << std::string(indent, ' ') << "  " << tiles_.size() << " tiles of:\n";
+    for (const auto &i : ops_) {
+        i->dump(os, indent + 4);
+    }
+    os << "\n";
+}
+
 BoundsMap TransposeOp::map_bounds(int input_idx, int output_idx) const {
     assert(output_idx == 0);
     if (input_idx == 0) {
@@ -1903,6 +2313,7 @@ ACCEPT_AND_MUTATE_IMPL(SplitOp)
 ACCEPT_AND_MUTATE_IMPL(ReductionOp)
 ACCEPT_AND_MUTATE_IMPL(ReshapeOp)
 ACCEPT_AND_MUTATE_IMPL(TileConvFilterOp)
+ACCEPT_AND_MUTATE_IMPL(TiledOpGroup)
 ACCEPT_AND_MUTATE_IMPL(TransposeOp)
 ACCEPT_AND_MUTATE_IMPL(UpsampleChannelsOp)
 ACCEPT_AND_MUTATE_IMPL(UnaryOp)
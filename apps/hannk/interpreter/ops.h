@@ -22,6 +22,19 @@ enum class Padding {
     Valid,
 };
 
+// Describes an add of another tensor (the addend) to the result of a
+// ConvOp or DepthwiseConv2DOp, fused into the output stage of the conv by
+// fuse_elementwise(). The result of the conv is first quantized with
+// result_quantization and the conv's activation, as if it were stored to a
+// tensor, and then added to the addend as a BinaryOp would.
+struct FusedAdd {
+    QuantizationInfo result_quantization;
+    // These are -1 for subtracting the result or the addend.
+    int result_sign = 1;
+    int addend_sign = 1;
+    ActivationFunction activation = ActivationFunction::None;
+};
+
 // This is an abstract helper op for elementwise operations.
 class ElementwiseOp : public Op {
 public:
@@ -55,6 +68,13 @@ public:
         : ElementwiseOp({a, b}, {output}), op_(op), activation_(activation) {
     }
 
+    Operator op() const {
+        return op_;
+    }
+    ActivationFunction activation() const {
+        return activation_;
+    }
+
     void execute() override;
 
     std::string name() const override {
@@ -100,20 +120,23 @@ class ConvOp : public Op {
     std::array<int, 2> dilation_;
     Padding padding_;
     ActivationFunction activation_;
+    FusedAdd fused_add_;
 
     // calculated in prepare()
     int vector_reduction_ = 0;
     int vector_tile_ = 0;
 
 public:
+    // If addend is not null, the op adds it to the result as described by fused_add.
     ConvOp(const TensorPtr &input, const TensorPtr &filter, const TensorPtr &bias, const TensorPtr &output,
            std::array<int, 2> stride, std::array<int, 2> dilation, Padding padding,
-           ActivationFunction activation)
-        : Op({input, filter, bias}, {output}),
+           ActivationFunction activation, const TensorPtr &addend = nullptr, FusedAdd fused_add = FusedAdd())
+        : Op(addend ? std::vector<TensorPtr>{input, filter, bias, addend} : std::vector<TensorPtr>{input, filter, bias}, {output}),
           stride_(stride),
           dilation_(dilation),
           padding_(padding),
-          activation_(activation) {
+          activation_(activation),
+          fused_add_(std::move(fused_add)) {
     }
 
     const TensorPtr &filter() const {
@@ -122,6 +145,12 @@ public:
     const TensorPtr &bias() const {
         return Op::input(2);
     }
+    TensorPtr addend() const {
+        return input_count() > 3 ? Op::input(3) : nullptr;
+    }
+    const FusedAdd &fused_add() const {
+        return fused_add_;
+    }
 
     std::array<int, 2> stride() const {
         return stride_;
@@ -143,7 +172,7 @@ public:
     void execute() override;
 
     std::string name() const override {
-        return "ConvOp";
+        return addend() ? "ConvOp(+Add)" : "ConvOp";
     }
 
 private:
@@ -157,20 +186,24 @@ class DepthwiseConv2DOp : public Op {
     std::array<int, 2> dilation_;
     Padding padding_;
     ActivationFunction activation_;
+    FusedAdd fused_add_;
 
     // calculated in prepare()
     int channel_alignment_ = 0;
 
 public:
+    // If addend is not null, the op adds it to the result as described by fused_add.
     DepthwiseConv2DOp(const TensorPtr &input, const TensorPtr &filter, const TensorPtr &bias, const TensorPtr &output,
                       int depth_multiplier, std::array<int, 2> stride, std::array<int, 2> dilation,
-                      Padding padding, ActivationFunction activation)
-        : Op({input, filter, bias}, {output}),
+                      Padding padding, ActivationFunction activation,
+                      const TensorPtr &addend = nullptr, FusedAdd fused_add = FusedAdd())
+        : Op(addend ? std::vector<TensorPtr>{input, filter, bias, addend} : std::vector<TensorPtr>{input, filter, bias}, {output}),
           depth_multiplier_(depth_multiplier),
           stride_(stride),
           dilation_(dilation),
           padding_(padding),
-          activation_(activation) {
+          activation_(activation),
+          fused_add_(std::move(fused_add)) {
     }
 
     int depth_multiplier() const {
@@ -182,6 +215,12 @@ public:
     const TensorPtr &bias() const {
         return Op::input(2);
     }
+    TensorPtr addend() const {
+        return input_count() > 3 ? Op::input(3) : nullptr;
+    }
+    const FusedAdd &fused_add() const {
+        return fused_add_;
+    }
 
     BoundsMap map_bounds(int input_idx, int output_idx) const override;
 
@@ -202,7 +241,7 @@ public:
     void execute() override;
 
     std::string name() const override {
-        return "DepthwiseConv2DOp";
+        return addend() ? "DepthwiseConv2DOp(+Add)" : "DepthwiseConv2DOp";
     }
 
 private:
@@ -515,6 +554,80 @@ private:
     OpMutatorFn mutate_impl() const override;
 };
 
+// Runs a chain of ops, each consuming the output of the one before it, one
+// tile (a range of rows) of the chain's output at a time. For each tile, each
+// op computes only the part of its output that the next op needs, as found
+// by map_bounds(), into scratch buffers small enough to stay in cache; rows
+// needed by neighboring tiles are computed once per tile. The intermediate
+// Tensors of the chain are never allocated, and visitors see this as a
+// single leaf op, so the allocation planner never sees them either.
+class TiledOpGroup : public Op {
+public:
+    // The part of an op's output, and of each of its inputs, that one tile
+    // uses. Constant inputs are used whole, and have an empty Box.
+    struct OpTile {
+        Box output;
+        std::vector<Box> inputs;
+    };
+    using Tile = std::vector<OpTile>;
+
+private:
+    std::vector<OpPtr> ops_;
+    std::vector<Tile> tiles_;
+    // The scratch memory for each intermediate Tensor (the output of every
+    // op but the last), big enough for its part of any tile.
+    std::vector<HalideBuffer<void>> scratch_;
+    // The (unallocated) buffers of the intermediate Tensors, restored after
+    // each execute().
+    std::vector<HalideBuffer<void>> unallocated_;
+    // The ops' inputs from outside the chain are replaced with Tensors of
+    // their own, so they can be cropped to each tile without affecting any
+    // other op using them. This is the original input for each of those,
+    // and null for everything else, by op and input index.
+    std::vector<std::vector<TensorPtr>> sources_;
+
+    static std::vector<TensorPtr> chain_inputs(const std::vector<OpPtr> &ops);
+
+public:
+    // The ops must already be prepared, and must form a chain: the output of
+    // each op must be input 0 of the next op, and not used by anything else.
+    explicit TiledOpGroup(std::vector<OpPtr> ops);
+
+    // Choose tiles so that the parts of the intermediate Tensors used by
+    // each tile fit in cache_size bytes, and set up to run them. Returns
+    // false if that isn't possible, or if the whole intermediate Tensors
+    // already fit, in which case the ops should be taken back with
+    // release_ops() and run as usual.
+    bool plan(size_t cache_size);
+
+    // Give up ownership of the ops, which must not have been planned.
+    std::vector<OpPtr> release_ops();
+
+    BoundsMap map_bounds(int input_idx, int output_idx) const override;
+
+    void execute() override;
+
+    int op_count() const {
+        return ops_.size();
+    }
+    const Op *op(int i) const {
+        return ops_[i].get();
+    }
+    int tile_count() const {
+        return tiles_.size();
+    }
+
+    void dump(std::ostream &os, int indent = 0) const override;
+
+    std::string name() const override {
+        return "TiledOpGroup";
+    }
+
+private:
+    void accept_impl(OpVisitor *v) const override;
+    OpMutatorFn mutate_impl() const override;
+};
+
 class TransposeOp : public Op {
 public:
     TransposeOp(const TensorPtr &input, const TensorPtr &dims, const TensorPtr &output)
@@ -556,6 +669,10 @@ public:
         : ElementwiseOp({input}, {output}), op_(op) {
     }
 
+    Operator op() const {
+        return op_;
+    }
+
     void execute() override;
 
     std::string name() const override {
@@ -610,6 +727,7 @@ protected:
     friend class SpaceDepthOp;
     friend class SplitOp;
     friend class TileConvFilterOp;
+    friend class TiledOpGroup;
     friend class TransposeOp;
     friend class UnaryOp;
     friend class UpsampleChannelsOp;
@@ -633,6 +751,7 @@ protected:
     virtual void visit(const SpaceDepthOp *op) { visit_leaf(op); }
     virtual void visit(const SplitOp *op) { visit_leaf(op); }
     virtual void visit(const TileConvFilterOp *op) { visit_leaf(op); }
+    virtual void visit(const TiledOpGroup *op) { visit_leaf(op); }
     virtual void visit(const TransposeOp *op) { visit_leaf(op); }
     virtual void visit(const UnaryOp *op) { visit_leaf(op); }
     virtual void visit(const UpsampleChannelsOp *op) { visit_leaf(op); }
@@ -668,6 +787,7 @@ protected:
     friend class SpaceDepthOp;
     friend class SplitOp;
     friend class TileConvFilterOp;
+    friend class TiledOpGroup;
     friend class TransposeOp;
     friend class UnaryOp;
     friend class UpsampleChannelsOp;
@@ -691,6 +811,7 @@ protected:
     virtual OpPtr visit(std::unique_ptr<SpaceDepthOp> op) { return visit_leaf(std::move(op)); }
     virtual OpPtr visit(std::unique_ptr<SplitOp> op) { return visit_leaf(std::move(op)); }
     virtual OpPtr visit(std::unique_ptr<TileConvFilterOp> op) { return visit_leaf(std::move(op)); }
+    virtual OpPtr visit(std::unique_ptr<TiledOpGroup> op) { return visit_leaf(std::move(op)); }
     virtual OpPtr visit(std::unique_ptr<TransposeOp> op) { return visit_leaf(std::move(op)); }
     virtual OpPtr visit(std::unique_ptr<UnaryOp> op) { return visit_leaf(std::move(op)); }
     virtual OpPtr visit(std::unique_ptr<UpsampleChannelsOp> op) { return visit_leaf(std::move(op)); }
@@ -0,0 +1,238 @@
+#include "interpreter/profiler.h"
+#include "interpreter/ops.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+namespace hannk {
+
+namespace {
+
+int64_t extent_product(const TensorPtr &t, int begin, int end) {
+    int64_t result = 1;
+    for (int d = begin; d < std::min(end, t->rank()); d++) {
+        result *= t->extent(d);
+    }
+    return result;
+}
+
+// Counts the multiply-adds done by the ops that do most of the work in
+// typical models. Other ops are counted as doing nothing.
+class CountFlops : public OpVisitor {
+    using OpVisitor::visit;
+
+    void visit(const ConvOp *op) override {
+        // The filter has been tiled to ci % n, co % k, ci / n, co / k, x, y.
+        const int64_t channels = op->input()->extent(0);
+        const int64_t taps = extent_product(op->filter(), 4, 6);
+        flops += 2.0 * op->output()->number_of_elements() * channels * taps;
+    }
+
+    void visit(const DepthwiseConv2DOp *op) override {
+        // The filter is indexed by c, x, y.
+        const int64_t taps = extent_product(op->filter(), 1, 3);
+        flops += 2.0 * op->output()->number_of_elements() * taps;
+    }
+
+    void visit(const TiledOpGroup *op) override {
+        // This doesn't count the work repeated at the edges of tiles.
+        for (int i = 0; i < op->op_count(); i++) {
+            op->op(i)->accept(this);
+        }
+    }
+
+public:
+    double flops = 0.0;
+};
+
+size_t size_in_bytes(const TensorPtr &t) {
+    return t ? t->buffer().size_in_bytes() : 0;
+}
+
+void write_json_string(std::ostream &os, const std::string &s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\';
+        }
+        os << c;
+    }
+    os << '"';
+}
+
+}  // namespace
+
+Profiler::Profiler(Op *root, const ArenaLayout &arena_layout)
+    : epoch_(Clock::now()) {
+    const std::vector<Op *> units = find_units(root);
+
+    // Find the range of units using each Tensor in the arena.
+    std::map<const Tensor *, std::pair<int, int>> lifetimes;
+    const int unit_count = (int)units.size();
+    for (int i = 0; i < unit_count; i++) {
+        const Op *op = units[i];
+        auto use = [&](const TensorPtr &t) {
+            if (!t || arena_layout.find(t.get()) == arena_layout.end()) {
+                return;
+            }
+            auto it = lifetimes.emplace(t.get(), std::make_pair(i, i)).first;
+            it->second.second = i;
+        };
+        for (int j = 0; j < op->input_count(); j++) {
+            use(op->input(j));
+        }
+        for (int j = 0; j < op->output_count(); j++) {
+            use(op->output(j));
+        }
+    }
+
+    for (int i = 0; i < unit_count; i++) {
+        const Op *op = units[i];
+
+        OpProfile profile;
+        profile.name = op->name();
+        if (op->output_count() > 0 && op->output(0)) {
+            profile.output_name = op->output(0)->name();
+        }
+
+        for (const auto &l : lifetimes) {
+            if (l.second.first <= i && i <= l.second.second) {
+                profile.arena_high_water = std::max(profile.arena_high_water, arena_layout.at(l.first).end);
+            }
+        }
+
+        CountFlops count_flops;
+        op->accept(&count_flops);
+        profile.flops = count_flops.flops;
+
+        profiles_.push_back(std::move(profile));
+        ops_.push_back(units[i]);
+    }
+}
+
+void Profiler::execute() {
+    for (int i = 0; i < (int)ops_.size(); i++) {
+        Op *op = ops_[i];
+
+        const Clock::time_point begin = Clock::now();
+        op->execute();
+        const Clock::time_point end = Clock::now();
+        const double seconds = std::chrono::duration<double>(end - begin).count();
+
+        OpProfile &p = profiles_[i];
+        if (p.runs == 0 || seconds < p.min_seconds) {
+            p.min_seconds = seconds;
+        }
+        p.max_seconds = std::max(p.max_seconds, seconds);
+        p.total_seconds += seconds;
+        p.runs++;
+
+        // Dynamic Tensors may change size from run to run, so measure
+        // these after running the op.
+        p.bytes_read = 0;
+        for (int j = 0; j < op->input_count(); j++) {
+            p.bytes_read += size_in_bytes(op->input(j));
+        }
+        p.bytes_written = 0;
+        for (int j = 0; j < op->output_count(); j++) {
+            p.bytes_written += size_in_bytes(op->output(j));
+        }
+
+        if (events_.size() < max_trace_events) {
+            const double begin_us = std::chrono::duration<double, std::micro>(begin - epoch_).count();
+            events_.push_back({i, begin_us, seconds * 1e6});
+        }
+    }
+}
+
+void Profiler::reset() {
+    for (OpProfile &p : profiles_) {
+        p.runs = 0;
+        p.total_seconds = 0.0;
+        p.min_seconds = 0.0;
+        p.max_seconds = 0.0;
+    }
+    events_.clear();
+    epoch_ = Clock::now();
+}
+
+void Profiler::dump(std::ostream &os) const {
+    std::vector<int> order(profiles_.size());
+    double total_seconds = 0.0;
+    for (int i = 0; i < (int)profiles_.size(); i++) {
+        order[i] = i;
+        total_seconds += profiles_[i].total_seconds;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return profiles_[a].total_seconds > profiles_[b].total_seconds;
+    });
+
+    const std::ios_base::fmtflags flags = os.flags();
+    os << std::left << std::setw(5) << "#"
+       << std::setw(24) << "op"
+       << std::setw(32) << "output"
+       << std::right << std::setw(8) << "runs"
+       << std::setw(12) << "avg us"
+       << std::setw(12) << "min us"
+       << std::setw(12) << "max us"
+       << std::setw(8) << "%"
+       << std::setw(12) << "KB read"
+       << std::setw(12) << "KB written"
+       << std::setw(12) << "arena KB"
+       << std::setw(10) << "GFLOP/s"
+       << "\n";
+    os << std::fixed << std::setprecision(1);
+    for (int i : order) {
+        const OpProfile &p = profiles_[i];
+        std::string output_name = p.output_name;
+        if (output_name.size() > 31) {
+            output_name = "..." + output_name.substr(output_name.size() - 28);
+        }
+        os << std::left << std::setw(5) << i
+           << std::setw(24) << p.name
+           << std::setw(32) << output_name
+           << std::right << std::setw(8) << p.runs
+           << std::setw(12) << p.average_seconds() * 1e6
+           << std::setw(12) << p.min_seconds * 1e6
+           << std::setw(12) << p.max_seconds * 1e6
+           << std::setw(8) << (total_seconds > 0.0 ? 100.0 * p.total_seconds / total_seconds : 0.0)
+           << std::setw(12) << p.bytes_read / 1024.0
+           << std::setw(12) << p.bytes_written / 1024.0
+           << std::setw(12) << p.arena_high_water / 1024.0;
+        if (p.flops > 0.0) {
+            os << std::setw(10) << p.gflops_per_second();
+        } else {
+            os << std::setw(10) << "-";
+        }
+        os << "\n";
+    }
+    const int runs = profiles_.empty() ? 0 : profiles_[0].runs;
+    os << "Total: " << (runs > 0 ? total_seconds / runs * 1e6 : 0.0) << " us per run over "
+       << runs << " runs\n";
+    os.flags(flags);
+}
+
+void Profiler::write_chrome_trace(std::ostream &os) const {
+    os << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < events_.size(); i++) {
+        const TraceEvent &e = events_[i];
+        const OpProfile &p = profiles_[e.op];
+        os << "{\"name\":";
+        write_json_string(os, p.name);
+        os << ",\"cat\":\"op\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+           << ",\"ts\":" << e.begin
+           << ",\"dur\":" << e.duration
+           << ",\"args\":{\"index\":" << e.op
+           << ",\"output\":";
+        write_json_string(os, p.output_name);
+        os << ",\"bytes_read\":" << p.bytes_read
+           << ",\"bytes_written\":" << p.bytes_written
+           << ",\"arena_high_water\":" << p.arena_high_water
+           << ",\"flops\":" << p.flops
+           << "}}" << (i + 1 < events_.size() ? ",\n" : "\n");
+    }
+    os << "],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+}  // namespace hannk
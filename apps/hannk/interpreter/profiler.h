@@ -0,0 +1,101 @@
+#ifndef HANNK_PROFILER_H
+#define HANNK_PROFILER_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "interpreter/executor.h"
+#include "interpreter/model.h"
+
+namespace hannk {
+
+// What the Profiler knows about one op, accumulated over every run.
+struct OpProfile {
+    // The name of the op, and of its first output, to tell ops apart.
+    std::string name;
+    std::string output_name;
+
+    int runs = 0;
+    double total_seconds = 0.0;
+    double min_seconds = 0.0;
+    double max_seconds = 0.0;
+
+    // The sizes of the op's input and output Tensors, per run. This is an
+    // estimate of the memory traffic of the op: ops may read their inputs
+    // more than once, or only read part of them.
+    size_t bytes_read = 0;
+    size_t bytes_written = 0;
+
+    // The end of the highest byte of the arena used by any Tensor live
+    // while the op runs.
+    size_t arena_high_water = 0;
+
+    // The floating point (or integer multiply-add) operations the op does
+    // per run, counting a multiply-add as two. Zero if we don't know how to
+    // count them for this op.
+    double flops = 0.0;
+
+    double average_seconds() const {
+        return runs > 0 ? total_seconds / runs : 0.0;
+    }
+    double gflops_per_second() const {
+        return total_seconds > 0.0 ? flops * runs / total_seconds * 1e-9 : 0.0;
+    }
+};
+
+// Profiler runs the ops of a model one at a time, in order, timing each
+// one. Each op in the model's outermost OpGroup is timed as a unit, as
+// ParallelExecutor schedules them.
+class Profiler {
+public:
+    // The model and layout must not change while the profiler is in use.
+    Profiler(Op *root, const ArenaLayout &arena_layout);
+
+    // Run all the ops, recording how long each one takes.
+    void execute();
+
+    // Forget everything recorded so far.
+    void reset();
+
+    const std::vector<OpProfile> &ops() const {
+        return profiles_;
+    }
+
+    // Print a table of the ops, with the ops taking the most time first.
+    void dump(std::ostream &os) const;
+
+    // Write the runs recorded so far in the Chrome trace event format, which
+    // can be viewed in chrome://tracing or https://ui.perfetto.dev. Only the
+    // first max_trace_events runs of ops are kept.
+    void write_chrome_trace(std::ostream &os) const;
+
+    static constexpr size_t max_trace_events = 100000;
+
+    // Neither movable nor copyable.
+    Profiler() = delete;
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+    Profiler(Profiler &&) = delete;
+    Profiler &operator=(Profiler &&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceEvent {
+        int op;
+        // Microseconds since the profiler was created or reset.
+        double begin;
+        double duration;
+    };
+
+    std::vector<Op *> ops_;
+    std::vector<OpProfile> profiles_;
+    std::vector<TraceEvent> events_;
+    Clock::time_point epoch_;
+};
+
+}  // namespace hannk
+
+#endif  // HANNK_PROFILER_H
@@ -197,6 +197,16 @@ void Tensor::resize_dynamic(const Box &new_shape) {
     storage_ = nullptr;
 }
 
+HalideBuffer<void> Tensor::exchange_buffer(HalideBuffer<void> buffer) {
+    assert(!is_dynamic());
+    assert(alias_type() == AliasType::None);
+    assert(buffer.type() == buffer_.type());
+    assert(buffer.dimensions() == buffer_.dimensions());
+
+    std::swap(buffer, buffer_);
+    return buffer;
+}
+
 bool Tensor::has_external_alias() const {
     if (alias_info_ != nullptr) {
         for (const auto &weak : alias_info_->aliases) {
@@ -233,6 +233,11 @@ public:
 
     void resize_dynamic(const Box &new_shape);
 
+    // Replace the buffer with another of the same type and rank, returning
+    // the old one. This is used to run ops on one tile of a Tensor at a
+    // time; nothing else may use the Tensor until the old buffer is restored.
+    HalideBuffer<void> exchange_buffer(HalideBuffer<void> buffer);
+
     AliasType alias_type() const {
         return alias_info_ != nullptr ? alias_info_->alias_type : AliasType::None;
     }
@@ -0,0 +1,149 @@
+#ifndef HANNK_TEST_MODELS_H
+#define HANNK_TEST_MODELS_H
+
+// Small quantized models built directly as Ops, for the interpreter's tests.
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "interpreter/model.h"
+#include "interpreter/ops.h"
+#include "util/buffer_util.h"
+
+namespace hannk {
+namespace test {
+
+inline QuantizationInfo uniform_quantization(float scale, int zero) {
+    QuantizationInfo q;
+    q.scale = {scale};
+    q.zero = {zero};
+    return q;
+}
+
+// A Tensor with no storage yet, to be allocated by the Interpreter.
+inline TensorPtr make_tensor(const std::string &name, halide_type_t type, const std::vector<int> &shape,
+                             float scale, int zero) {
+    HalideBuffer<void> buffer(type, nullptr, shape);
+    return std::make_shared<Tensor>(name, std::move(buffer), uniform_quantization(scale, zero));
+}
+
+// A constant uint8 Tensor filled with pseudorandom data.
+inline TensorPtr make_constant_u8(const std::string &name, const std::vector<int> &shape,
+                                  float scale, int zero, int seed) {
+    HalideBuffer<void> buffer(halide_type_of<uint8_t>(), shape);
+    dynamic_type_dispatch<FillWithRandom>(buffer.type(), buffer, seed);
+    auto t = std::make_shared<Tensor>(name, std::move(buffer), uniform_quantization(scale, zero));
+    t->set_constant();
+    return t;
+}
+
+// A constant int32 bias, with values small enough that the output of the
+// conv it is added to isn't saturated.
+inline TensorPtr make_bias(const std::string &name, int extent, float scale, int seed) {
+    HalideBuffer<int32_t> buffer(extent);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int32_t> dis(-2000, 2000);
+    buffer.for_each_value([&](int32_t &value) { value = dis(rng); });
+    auto t = std::make_shared<Tensor>(name, std::move(buffer), uniform_quantization(scale, 0));
+    t->set_constant();
+    return t;
+}
+
+// A 3x3 conv with 'same' padding and pseudorandom weights and bias, which
+// depend only on seed.
+inline OpPtr make_conv(const TensorPtr &input, const TensorPtr &output, int seed) {
+    const int in_channels = input->extent(0);
+    const int out_channels = output->extent(0);
+    const float input_scale = input->quantization().uniform_scale();
+    TensorPtr filter = make_constant_u8(output->name() + ".filter", {in_channels, 3, 3, out_channels}, 0.01f, 128, seed);
+    TensorPtr bias = make_bias(output->name() + ".bias", out_channels, input_scale * 0.01f, seed + 1);
+    return make_op<ConvOp>(input, filter, bias, output, std::array<int, 2>{1, 1},
+                           std::array<int, 2>{1, 1}, Padding::Same, ActivationFunction::None);
+}
+
+// What follows the conv in make_conv_model().
+enum class Epilogue {
+    None,
+    Relu,
+    Add,
+};
+
+// A 3x3 conv with 'same' padding, from an input named "input" to an
+// intermediate named "conv", followed by the given epilogue writing to
+// "output". The Add epilogue adds a second input named "addend". The
+// weights depend only on seed, so models built with the same seed are
+// identical. Dimensions are (c, x, y, b), as elsewhere in hannk.
+inline OpPtr make_conv_model(Epilogue epilogue, int seed = 0, int width = 12, int height = 10) {
+    const int in_channels = 8;
+    const int out_channels = 16;
+    const halide_type_t u8 = halide_type_of<uint8_t>();
+
+    TensorPtr input = make_tensor("input", u8, {in_channels, width, height, 1}, 0.02f, 128);
+    TensorPtr conv = make_tensor(epilogue == Epilogue::None ? "output" : "conv", u8,
+                                 {out_channels, width, height, 1}, 0.05f, 100);
+
+    std::vector<TensorPtr> inputs = {input};
+    std::vector<OpPtr> ops;
+    ops.push_back(make_conv(input, conv, seed));
+
+    TensorPtr output = conv;
+    if (epilogue == Epilogue::Relu) {
+        // Requantize as well, so that fusing changes how often we round.
+        output = make_tensor("output", u8, {out_channels, width, height, 1}, 0.03f, 0);
+        ops.push_back(make_op<UnaryOp>(conv, output, UnaryOp::Relu));
+    } else if (epilogue == Epilogue::Add) {
+        TensorPtr addend = make_tensor("addend", u8, {out_channels, width, height, 1}, 0.04f, 120);
+        output = make_tensor("output", u8, {out_channels, width, height, 1}, 0.08f, 110);
+        inputs.push_back(addend);
+        ops.push_back(make_op<BinaryOp>(conv, addend, output, BinaryOp::Add));
+    }
+
+    return make_op<OpGroup>(std::move(inputs), std::vector<TensorPtr>{output}, std::move(ops));
+}
+
+// An inception-style block: three branches from "input" (a conv, a conv
+// followed by a relu, and a max pool), concatenated into the output
+// "concat". The two conv branches are also added into a second output,
+// "sum", so their results are used by more than one op. Dimensions are
+// (c, x, y, b).
+inline OpPtr make_branchy_model(int seed = 0, int width = 16, int height = 12) {
+    const int in_channels = 8;
+    const int conv_channels = 16;
+    const halide_type_t u8 = halide_type_of<uint8_t>();
+
+    TensorPtr input = make_tensor("input", u8, {in_channels, width, height, 1}, 0.02f, 128);
+    TensorPtr branch1 = make_tensor("branch1", u8, {conv_channels, width, height, 1}, 0.05f, 100);
+    TensorPtr branch2_conv = make_tensor("branch2_conv", u8, {conv_channels, width, height, 1}, 0.05f, 100);
+    TensorPtr branch2 = make_tensor("branch2", u8, {conv_channels, width, height, 1}, 0.03f, 0);
+    TensorPtr branch3 = make_tensor("branch3", u8, {in_channels, width, height, 1}, 0.02f, 128);
+    TensorPtr concat = make_tensor("concat", u8, {2 * conv_channels + in_channels, width, height, 1}, 0.05f, 100);
+    TensorPtr sum = make_tensor("sum", u8, {conv_channels, width, height, 1}, 0.08f, 110);
+
+    std::vector<OpPtr> ops;
+    ops.push_back(make_conv(input, branch1, seed));
+    ops.push_back(make_conv(input, branch2_conv, seed + 2));
+    ops.push_back(make_op<UnaryOp>(branch2_conv, branch2, UnaryOp::Relu));
+    ops.push_back(make_op<Pool2DOp>(input, branch3, std::array<int, 2>{1, 1}, std::array<int, 2>{3, 3},
+                                    Padding::Same, Pool2DOp::Max, ActivationFunction::None));
+    ops.push_back(make_op<ConcatenationOp>(std::vector<TensorPtr>{branch1, branch2, branch3}, concat, 0));
+    ops.push_back(make_op<BinaryOp>(branch1, branch2, sum, BinaryOp::Add));
+
+    return make_op<OpGroup>(std::vector<TensorPtr>{input}, std::vector<TensorPtr>{concat, sum}, std::move(ops));
+}
+
+// Fill the non-constant inputs of a model with pseudorandom data.
+inline void fill_inputs(const std::vector<TensorPtr> &inputs, int seed) {
+    for (const TensorPtr &t : inputs) {
+        if (!t->is_constant()) {
+            HalideBuffer<void> buf = t->buffer();
+            dynamic_type_dispatch<FillWithRandom>(buf.type(), buf, seed++);
+        }
+    }
+}
+
+}  // namespace test
+}  // namespace hannk
+
+#endif  // HANNK_TEST_MODELS_H
@@ -395,7 +395,8 @@ class PadForOps : public OpMutator {
             auto inputs = op->inputs();
             auto outputs = op->outputs();
             op = make_prepared_op<ConvOp>(conv_input, conv_filter, op->bias(), op->output(),
-                                          op->stride(), op->dilation(), op->padding(), op->activation());
+                                          op->stride(), op->dilation(), op->padding(), op->activation(),
+                                          op->addend(), op->fused_add());
             new_ops.push_back(std::move(op));
 
             return make_prepared_op<OpGroup>(std::move(inputs), std::move(outputs), std::move(new_ops));
@@ -421,7 +422,7 @@ class PadForOps : public OpMutator {
 
             op = make_prepared_op<DepthwiseConv2DOp>(upsampled, op->filter(), op->bias(), op->output(),
                                                      /*depth_multiplier*/ 1, op->stride(), op->dilation(),
-                                                     op->padding(), op->activation());
+                                                     op->padding(), op->activation(), op->addend(), op->fused_add());
         }
 
         // TODO: It might be worth enabling UpsampleChannels to handle padding, and fusing the padding
@@ -439,7 +440,7 @@ class PadForOps : public OpMutator {
                 new_ops.push_back(std::move(padding_op));
                 op = make_prepared_op<DepthwiseConv2DOp>(padding_output, op->filter(), op->bias(), op->output(),
                                                          op->depth_multiplier(), op->stride(), op->dilation(),
-                                                         op->padding(), op->activation());
+                                                         op->padding(), op->activation(), op->addend(), op->fused_add());
             }
 
             auto inputs = op->inputs();
@@ -535,6 +536,218 @@ OpPtr fuse_pad_ops(OpPtr op) {
 
 namespace {
 
+bool same_bounds(const Box &a, const Box &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!(a[i] == b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// If applying activation a and then b is the same as applying one activation,
+// return true and set result to it.
+bool compose_activations(ActivationFunction a, ActivationFunction b, ActivationFunction *result) {
+    if (a == ActivationFunction::None || a == b) {
+        *result = b;
+    } else if (b == ActivationFunction::None) {
+        *result = a;
+    } else if ((a == ActivationFunction::Relu && b == ActivationFunction::Relu6) ||
+               (a == ActivationFunction::Relu6 && b == ActivationFunction::Relu)) {
+        *result = ActivationFunction::Relu6;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<ConvOp> remake_conv(const ConvOp *op, const TensorPtr &output, ActivationFunction activation,
+                                    const TensorPtr &addend = nullptr, FusedAdd fused_add = FusedAdd()) {
+    return std::make_unique<ConvOp>(op->input(), op->filter(), op->bias(), output,
+                                    op->stride(), op->dilation(), op->padding(), activation,
+                                    addend, std::move(fused_add));
+}
+
+std::unique_ptr<DepthwiseConv2DOp> remake_conv(const DepthwiseConv2DOp *op, const TensorPtr &output, ActivationFunction activation,
+                                               const TensorPtr &addend = nullptr, FusedAdd fused_add = FusedAdd()) {
+    return std::make_unique<DepthwiseConv2DOp>(op->input(), op->filter(), op->bias(), output,
+                                               op->depth_multiplier(), op->stride(), op->dilation(),
+                                               op->padding(), activation, addend, std::move(fused_add));
+}
+
+// Replace elementwise ops with a copy of the conv producing their input that
+// does the elementwise work in its output stage. The original conv is left
+// in place without any consumers, for remove_dead_ops() to clean up.
+class FuseElementwise : public OpMutator {
+    using OpMutator::visit;
+
+    std::unordered_set<Tensor *> root_outputs_;
+
+    // Whether t is an intermediate result that only the op consuming it
+    // needs, so that op can be fused into the op producing it.
+    bool is_fusable_intermediate(const TensorPtr &t) const {
+        return t->type() == halide_type_of<uint8_t>() &&
+               t->producers().size() == 1 &&
+               t->consumers().size() == 1 &&
+               root_outputs_.count(t.get()) == 0 &&
+               !t->is_constant() &&
+               !t->is_external() &&
+               !t->is_dynamic();
+    }
+
+    static bool is_fusable_output(const TensorPtr &t) {
+        return t->type() == halide_type_of<uint8_t>() && !t->is_dynamic();
+    }
+
+    // Fuse an activation function into the conv op producing input, writing
+    // to output instead. Quantizing the result of the conv directly to the
+    // output, rather than to input first, also folds the requantization
+    // these ops do into the conv.
+    template<typename ConvT>
+    OpPtr fuse_activation(const ConvT *conv, const TensorPtr &output, ActivationFunction activation) {
+        if (conv->addend()) {
+            // The activation of the fused add would need to change instead.
+            return nullptr;
+        }
+        ActivationFunction composed;
+        if (!compose_activations(conv->activation(), activation, &composed)) {
+            return nullptr;
+        }
+        return make_prepared_op(remake_conv(conv, output, composed));
+    }
+
+    template<typename ConvT>
+    OpPtr fuse_add(const ConvT *conv, const TensorPtr &addend, const TensorPtr &output, FusedAdd fused_add) {
+        if (conv->addend()) {
+            return nullptr;
+        }
+        return make_prepared_op(remake_conv(conv, output, conv->activation(), addend, std::move(fused_add)));
+    }
+
+    OpPtr visit(std::unique_ptr<UnaryOp> op) override {
+        const TensorPtr &input = op->input();
+        const TensorPtr &output = op->output();
+        if (!is_fusable_intermediate(input) || !is_fusable_output(output)) {
+            return op;
+        }
+
+        ActivationFunction activation;
+        switch (op->op()) {
+        case UnaryOp::Relu:
+            activation = ActivationFunction::Relu;
+            break;
+        case UnaryOp::Relu6:
+            activation = ActivationFunction::Relu6;
+            break;
+        case UnaryOp::ReluN1To1:
+            activation = ActivationFunction::ReluN1To1;
+            break;
+        default:
+            return op;
+        }
+
+        const Op *producer = input->producers().front();
+        OpPtr fused;
+        if (const ConvOp *conv = cast_op<ConvOp>(producer)) {
+            fused = fuse_activation(conv, output, activation);
+        } else if (const DepthwiseConv2DOp *conv = cast_op<DepthwiseConv2DOp>(producer)) {
+            fused = fuse_activation(conv, output, activation);
+        }
+        if (!fused) {
+            return op;
+        }
+        fused_++;
+        return fused;
+    }
+
+    OpPtr visit(std::unique_ptr<BinaryOp> op) override {
+        if (op->op() != BinaryOp::Add && op->op() != BinaryOp::Sub) {
+            return op;
+        }
+        const TensorPtr &output = op->output();
+        if (!is_fusable_output(output) || op->input(0).get() == op->input(1).get()) {
+            return op;
+        }
+
+        // Try fusing into the producer of either input. The other input
+        // is the addend, which must not be broadcast.
+        for (int i = 0; i < 2; i++) {
+            const TensorPtr &input = op->input(i);
+            const TensorPtr &addend = op->input(1 - i);
+            if (!is_fusable_intermediate(input) ||
+                addend->type() != halide_type_of<uint8_t>() ||
+                !same_bounds(input->bounds(), output->bounds()) ||
+                !same_bounds(addend->bounds(), output->bounds())) {
+                continue;
+            }
+
+            FusedAdd fused_add;
+            fused_add.result_quantization = input->quantization();
+            fused_add.result_sign = (op->op() == BinaryOp::Sub && i == 1) ? -1 : 1;
+            fused_add.addend_sign = (op->op() == BinaryOp::Sub && i == 0) ? -1 : 1;
+            fused_add.activation = op->activation();
+
+            const Op *producer = input->producers().front();
+            OpPtr fused;
+            if (const ConvOp *conv = cast_op<ConvOp>(producer)) {
+                fused = fuse_add(conv, addend, output, std::move(fused_add));
+            } else if (const DepthwiseConv2DOp *conv = cast_op<DepthwiseConv2DOp>(producer)) {
+                fused = fuse_add(conv, addend, output, std::move(fused_add));
+            }
+            if (fused) {
+                fused_++;
+                return fused;
+            }
+        }
+        return op;
+    }
+
+    template<class T>
+    std::unique_ptr<T> make_prepared_op(std::unique_ptr<T> op) {
+        if (!op->prepare()) {
+            HLOG(ERROR) << "fuse_elementwise: new_op " << op->name() << " failed prepare()";
+            prepare_failed = true;
+        }
+        return op;
+    }
+
+    int fused_ = 0;
+
+public:
+    explicit FuseElementwise(const Op *root) {
+        for (int i = 0; i < root->output_count(); i++) {
+            root_outputs_.insert(root->output(i).get());
+        }
+    }
+
+    int fused() const {
+        return fused_;
+    }
+
+    bool prepare_failed = false;
+};
+
+}  // namespace
+
+OpPtr fuse_elementwise(OpPtr op) {
+    FuseElementwise fuser(op.get());
+    op = fuser.mutate(std::move(op));
+    if (fuser.prepare_failed) {
+        return nullptr;
+    }
+    if (fuser.fused() > 0) {
+        // Remove the convs we replaced now, so the later transforms don't
+        // waste time padding them, tiling their filters, etc.
+        op = remove_dead_ops(std::move(op));
+    }
+    return op;
+}
+
+namespace {
+
 bool can_execute_with_all_constant_inputs(const Op *op) {
     for (int i = 0; i < op->input_count(); i++) {
         if (!op->input(i)->is_constant()) {
@@ -608,4 +821,124 @@ OpPtr flatten_groups(OpPtr op) {
     return make_op<OpGroup>(inputs, outputs, std::move(flattener.flattened));
 }
 
+namespace {
+
+// Find runs of consecutive ops in which each op consumes the output of the
+// one before it, and nothing else uses that output, and wrap each run in a
+// TiledOpGroup if there's a tiling of it that keeps its intermediate results
+// in cache.
+class TileOps : public OpMutator {
+    using OpMutator::visit;
+
+    std::unordered_set<Tensor *> root_outputs_;
+    size_t cache_size_;
+
+    static bool is_tileable_elementwise(const Op *op) {
+        return cast_op<BinaryOp>(op) || cast_op<UnaryOp>(op) || cast_op<ElementwiseProgramOp>(op);
+    }
+
+    // Whether op can compute any range of rows of its output separately.
+    static bool is_tileable(const Op *op) {
+        const bool elementwise = is_tileable_elementwise(op);
+        if (!elementwise && !cast_op<ConvOp>(op) && !cast_op<DepthwiseConv2DOp>(op) && !cast_op<PadOp>(op)) {
+            return false;
+        }
+        if (op->output_count() != 1) {
+            return false;
+        }
+        const TensorPtr &output = op->output();
+        if (output->rank() != 4 || output->is_dynamic() || output->alias_type() != AliasType::None) {
+            return false;
+        }
+        for (int j = 0; j < op->input_count(); j++) {
+            const TensorPtr &input = op->input(j);
+            if (!input) {
+                continue;
+            }
+            if (input->is_constant()) {
+                // Constants are used whole, so the elementwise ops can
+                // only use them if they are broadcast across the rows.
+                if (elementwise && input->rank() > 2 && input->extent(2) != 1) {
+                    return false;
+                }
+            } else if (input->rank() != 4 || input->is_dynamic() ||
+                       (elementwise && !(input->bounds(2) == output->bounds(2)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Whether op can follow prev in a chain.
+    bool continues_chain(const Op *prev, const Op *op) const {
+        const TensorPtr &t = prev->output();
+        if (op->input(0) != t ||
+            t->producers().size() != 1 ||
+            t->consumers().size() != 1 ||
+            root_outputs_.count(t.get()) > 0 ||
+            t->is_constant() ||
+            t->is_external()) {
+            return false;
+        }
+        for (int j = 1; j < op->input_count(); j++) {
+            if (op->input(j) == t) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void add_chain(std::vector<OpPtr> chain, std::vector<OpPtr> *ops) {
+        if (chain.size() >= 2) {
+            auto tiled = make_op<TiledOpGroup>(std::move(chain));
+            if (tiled->plan(cache_size_)) {
+                ops->push_back(std::move(tiled));
+                return;
+            }
+            chain = tiled->release_ops();
+        }
+        for (auto &i : chain) {
+            ops->push_back(std::move(i));
+        }
+    }
+
+    OpPtr visit(std::unique_ptr<OpGroup> op) override {
+        std::vector<TensorPtr> inputs = op->inputs();
+        std::vector<TensorPtr> outputs = op->outputs();
+
+        std::vector<OpPtr> ops_new;
+        std::vector<OpPtr> chain;
+        for (int i = 0; i < op->op_count(); i++) {
+            OpPtr sub_op = op->take_op(i);
+            if (!is_tileable(sub_op.get())) {
+                add_chain(std::move(chain), &ops_new);
+                chain.clear();
+                ops_new.push_back(mutate(std::move(sub_op)));
+                continue;
+            }
+            if (!chain.empty() && !continues_chain(chain.back().get(), sub_op.get())) {
+                add_chain(std::move(chain), &ops_new);
+                chain.clear();
+            }
+            chain.push_back(std::move(sub_op));
+        }
+        add_chain(std::move(chain), &ops_new);
+        return make_op<OpGroup>(inputs, outputs, std::move(ops_new));
+    }
+
+public:
+    TileOps(const Op *root, size_t cache_size)
+        : cache_size_(cache_size) {
+        for (int i = 0; i < root->output_count(); i++) {
+            root_outputs_.insert(root->output(i).get());
+        }
+    }
+};
+
+}  // namespace
+
+OpPtr tile_ops(OpPtr op, size_t cache_size) {
+    return TileOps(op.get(), cache_size).mutate(std::move(op));
+}
+
 }  // namespace hannk
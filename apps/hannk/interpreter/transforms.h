@@ -5,6 +5,15 @@
 
 namespace hannk {
 
+// Fuse elementwise ops into the output stage of the ConvOp or
+// DepthwiseConv2DOp producing their input, when nothing else uses the
+// result of the conv. This handles activation functions (and the
+// requantization they do) and adds of another tensor of the same shape.
+// This should be run before pad_for_ops() and in_place().
+// New ops will have prepare() called on them; this will return nullptr
+// if any of those calls fail.
+[[nodiscard]] OpPtr fuse_elementwise(OpPtr op);
+
 // Rewrites ops to be in-place operations when possible.
 [[nodiscard]] OpPtr in_place(OpPtr op);
 
@@ -31,6 +40,13 @@ namespace hannk {
 // a waste; this combines them. (This should be run after flatten_groups().)
 [[nodiscard]] OpPtr fuse_pad_ops(OpPtr op);
 
+// Wrap chains of ops that each consume the output of the one before it in
+// TiledOpGroups, which run the chain a tile of rows at a time so that the
+// intermediate results of each tile fit in cache_size bytes. The
+// intermediate Tensors of the chains are left unallocated. This should be
+// the last transform, after remove_dead_ops().
+[[nodiscard]] OpPtr tile_ops(OpPtr op, size_t cache_size);
+
 }  // namespace hannk
 
 #endif  // HANNK_TRANSFORMS_H
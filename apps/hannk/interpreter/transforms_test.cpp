@@ -0,0 +1,120 @@
+#include "interpreter/interpreter.h"
+#include "interpreter/test_models.h"
+
+#include <iostream>
+
+using namespace hannk;
+using namespace hannk::test;
+
+namespace {
+
+// Run a model on inputs made from seed, and return a copy of its output.
+// If conv_kept is not null, set it to whether the intermediate result of
+// the conv is still in the prepared model.
+HalideBuffer<const void> run(OpPtr model, InterpreterOptions options, int seed, bool *conv_kept) {
+    Interpreter interpreter(std::move(model), std::move(options));
+    if (!interpreter.prepare()) {
+        std::cerr << "prepare() failed\n";
+        exit(-1);
+    }
+    if (conv_kept) {
+        *conv_kept = interpreter.get_tensor("conv") != nullptr;
+    }
+    fill_inputs(interpreter.inputs(), seed);
+    interpreter.execute();
+    return interpreter.outputs()[0]->buffer().copy();
+}
+
+// Check that fusing the epilogue into the conv happens, and changes the
+// output by no more than tolerance.
+bool test_fusion(Epilogue epilogue, const char *name, int tolerance) {
+    InterpreterOptions fused_options;
+    fused_options.fuse_elementwise = true;
+    InterpreterOptions unfused_options;
+    unfused_options.fuse_elementwise = false;
+
+    bool fused_kept_conv = false, unfused_kept_conv = false;
+    HalideBuffer<const void> fused = run(make_conv_model(epilogue), fused_options, 1, &fused_kept_conv);
+    HalideBuffer<const void> unfused = run(make_conv_model(epilogue), unfused_options, 1, &unfused_kept_conv);
+
+    if (fused_kept_conv || !unfused_kept_conv) {
+        std::cerr << name << ": fuse_elementwise didn't control whether the conv was fused\n";
+        return false;
+    }
+
+    CompareBuffersOptions compare_options;
+    compare_options.exact_thresh = 0;
+    compare_options.close_thresh = tolerance;
+    compare_options.max_close_percent = 1.0;
+    if (!dynamic_type_dispatch<CompareBuffers>(fused.type(), unfused, fused, compare_options).ok) {
+        std::cerr << name << ": fused and unfused results differ by more than " << tolerance << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Check that tiling a chain of ops happens when the intermediates don't fit
+// in the cache, and doesn't change the output.
+bool test_tiling() {
+    const size_t cache_size = 1024;
+    InterpreterOptions tiled_options;
+    tiled_options.fuse_elementwise = false;
+    tiled_options.tile_cache_size = cache_size;
+    tiled_options.profile = true;
+    InterpreterOptions untiled_options;
+    untiled_options.fuse_elementwise = false;
+
+    // Make the model tall enough that the intermediates don't fit.
+    Interpreter tiled_interpreter(make_conv_model(Epilogue::Relu, 0, 12, 40), std::move(tiled_options));
+    if (!tiled_interpreter.prepare()) {
+        std::cerr << "prepare() failed\n";
+        return false;
+    }
+    bool tiled = false;
+    for (const OpProfile &op : tiled_interpreter.profiler()->ops()) {
+        tiled = tiled || op.name == "TiledOpGroup";
+    }
+    if (!tiled) {
+        std::cerr << "tile_cache_size " << cache_size << " didn't tile the model\n";
+        return false;
+    }
+    fill_inputs(tiled_interpreter.inputs(), 2);
+    tiled_interpreter.execute();
+    HalideBuffer<const void> tiled_output = tiled_interpreter.outputs()[0]->buffer().copy();
+
+    HalideBuffer<const void> untiled_output =
+        run(make_conv_model(Epilogue::Relu, 0, 12, 40), std::move(untiled_options), 2, nullptr);
+
+    CompareBuffersOptions compare_options;
+    compare_options.require_exact();
+    if (!dynamic_type_dispatch<CompareBuffers>(tiled_output.type(), untiled_output, tiled_output, compare_options).ok) {
+        std::cerr << "Tiled and untiled results differ\n";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    // A fused activation quantizes the result of the conv once, directly
+    // to the output, instead of to the intermediate and then again to the
+    // output. The two roundings can differ by one.
+    if (!test_fusion(Epilogue::Relu, "conv+relu", 1)) {
+        return -1;
+    }
+
+    // A fused add quantizes the conv's result to the intermediate's
+    // quantization and adds exactly as the Add op does, so the results
+    // should be identical.
+    if (!test_fusion(Epilogue::Add, "conv+add", 0)) {
+        return -1;
+    }
+
+    if (!test_tiling()) {
+        return -1;
+    }
+
+    std::cout << "Success!\n";
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <dlfcn.h>
+#include <fstream>
 #include <iostream>
 #include <random>
 
@@ -380,6 +381,9 @@ void ModelRunner::status() {
     if (verbosity > 0) {
         std::cout << "Using random seed: " << seed_tracker_.next_seed() << "\n";
         std::cout << "Using threads: " << threads << "\n";
+        std::cout << "Using inter-op threads: " << inter_op_threads << "\n";
+        std::cout << "Fusing elementwise ops: " << fuse_elementwise << "\n";
+        std::cout << "Tile cache size: " << tile_cache_size << "\n";
 
 #if HANNK_BUILD_TFLITE
         std::string tf_ver = TfLiteVersion();
@@ -395,7 +399,7 @@ void ModelRunner::status() {
     }
 }
 
-ModelRunner::RunResult ModelRunner::run_in_hannk(const std::vector<char> &buffer) {
+ModelRunner::RunResult ModelRunner::run_in_hannk(const std::string &filename, const std::vector<char> &buffer) {
     RunResult result;
 
     std::unique_ptr<OpGroup> model = parse_tflite_model_from_buffer(buffer.data());
@@ -406,6 +410,10 @@ ModelRunner::RunResult ModelRunner::run_in_hannk(const std::vector<char> &buffer
 
     InterpreterOptions options;
     options.verbosity = verbosity;
+    options.inter_op_threads = inter_op_threads;
+    options.fuse_elementwise = fuse_elementwise;
+    options.tile_cache_size = tile_cache_size;
+    options.profile = profile || !profile_trace.empty();
     Interpreter interpreter(std::move(model), std::move(options));
     if (!interpreter.prepare()) {
         std::cerr << "hannk::Interpreter::prepare() failed\n";
@@ -450,6 +458,22 @@ ModelRunner::RunResult ModelRunner::run_in_hannk(const std::vector<char> &buffer
         });
     }
 
+    if (Profiler *profiler = interpreter.profiler()) {
+        if (!csv_output) {
+            profiler->dump(std::cout);
+        }
+        if (!profile_trace.empty()) {
+            const auto n = filename.rfind('/');
+            const std::string trace_filename =
+                profile_trace + (n == std::string::npos ? filename : filename.substr(n + 1)) + ".json";
+            std::ofstream trace(trace_filename);
+            profiler->write_chrome_trace(trace);
+            if (!trace) {
+                std::cerr << "Unable to write " << trace_filename << "\n";
+            }
+        }
+    }
+
     return result;
 }
 
@@ -568,10 +592,26 @@ int ModelRunner::parse_flags(int argc, char **argv, std::vector<std::string> &fi
              this->external_delegate_path = value;
              return 0;
          }},
+        {"fuse_elementwise", [this](const std::string &value) {
+             this->fuse_elementwise = std::stoi(value) != 0;
+             return 0;
+         }},
+        {"inter_op_threads", [this](const std::string &value) {
+             this->inter_op_threads = std::stoi(value);
+             return 0;
+         }},
         {"keep_going", [this](const std::string &value) {
              this->keep_going = std::stoi(value) != 0;
              return 0;
          }},
+        {"profile", [this](const std::string &value) {
+             this->profile = std::stoi(value) != 0;
+             return 0;
+         }},
+        {"profile_trace", [this](const std::string &value) {
+             this->profile_trace = value;
+             return 0;
+         }},
         {"seed", [&seed](const std::string &value) {
              seed = std::stoi(value);
              return 0;
@@ -580,6 +620,10 @@ int ModelRunner::parse_flags(int argc, char **argv, std::vector<std::string> &fi
              this->threads = std::stoi(value);
              return 0;
          }},
+        {"tile_cache_size", [this](const std::string &value) {
+             this->tile_cache_size = std::stoull(value);
+             return 0;
+         }},
         {"tolerance", [this](const std::string &value) {
              this->tolerance = std::stof(value);
              return 0;
@@ -654,8 +698,8 @@ void ModelRunner::run(const std::string &filename) {
     const auto exec_tflite = [this, &buffer]() {
         return run_in_tflite(buffer);
     };
-    const auto exec_hannk = [this, &buffer]() {
-        return run_in_hannk(buffer);
+    const auto exec_hannk = [this, &filename, &buffer]() {
+        return run_in_hannk(filename, buffer);
     };
     const auto exec_hannk_external_delegate = [this, &buffer]() {
         DelegatePtr delegate_ptr;
@@ -686,7 +730,7 @@ void ModelRunner::run(const std::string &filename) {
             std::cerr << "Only kHannk is available in this build.\n";
             exit(1);
         }
-        results[i] = run_in_hannk(buffer);
+        results[i] = run_in_hannk(filename, buffer);
 #endif
     }
 
@@ -101,6 +101,14 @@ struct ModelRunner {
     };
 
     int threads = 1;
+    int inter_op_threads = 1;
+    bool fuse_elementwise = false;
+    size_t tile_cache_size = 0;
+    // Print the time taken by each op of the model when run in hannk, and if
+    // profile_trace is not empty, write them in the Chrome trace event format
+    // to profile_trace followed by the name of the model and ".json".
+    bool profile = false;
+    std::string profile_trace;
     int verbosity = 0;
     bool do_run[kNumRuns];  // no way to default-init everything to anything but zero, alas
     bool do_benchmark = true;
@@ -133,7 +141,7 @@ private:
         std::vector<HalideBuffer<const void>> outputs;
         std::chrono::duration<double> time{0};
     };
-    RunResult run_in_hannk(const std::vector<char> &buffer);
+    RunResult run_in_hannk(const std::string &filename, const std::vector<char> &buffer);
 #if HANNK_BUILD_TFLITE
     RunResult run_in_tflite(const std::vector<char> &buffer, TfLiteDelegate *delegate = nullptr);
 #endif
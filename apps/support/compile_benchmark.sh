@@ -0,0 +1,42 @@
+#!/bin/bash
+#
+# Measures how long a generator takes to lower its pipeline, with
+# simplifier memoization off and on. Only the Halide IR is emitted, so
+# LLVM's share of compile time is left out.
+#
+# $1 = generator executable
+# $2 = generator name
+# $3 = directory for temporary outputs
+# $4... = generator params
+#
+# Set ITERATIONS to change the number of runs of each configuration;
+# the fastest is reported.
+
+set -euo pipefail
+
+GENERATOR=$1
+NAME=$2
+OUT=$3
+shift 3
+
+ITERATIONS=${ITERATIONS:-5}
+mkdir -p "${OUT}"
+
+# The lowering time of the pipeline, in ms, from the compile time profile.
+lowering_ms() {
+    grep '"category": "lowering", "name": "lower", "count"' "$1" | sed -e 's/.*"total_ms": \([0-9.]*\).*/\1/'
+}
+
+for MEMO in 0 1; do
+    BEST=
+    for ((i = 0; i < ITERATIONS; i++)); do
+        PROFILE="${OUT}/compile_profile_${MEMO}.json"
+        HL_SIMPLIFY_MEMO=${MEMO} HL_COMPILE_PROFILE="${PROFILE}" \
+            "${GENERATOR}" -g "${NAME}" -e stmt -o "${OUT}" "$@"
+        MS=$(lowering_ms "${PROFILE}")
+        if [[ -z "${BEST}" ]] || (($(echo "${MS} < ${BEST}" | bc))); then
+            BEST=${MS}
+        fi
+    done
+    echo "${NAME} lowering with HL_SIMPLIFY_MEMO=${MEMO}: ${BEST} ms"
+done
@@ -695,6 +695,14 @@ void set_function_attributes_from_halide_target_options(llvm::Function &fn) {
     fn.addFnAttr("reciprocal-estimates", "none");
 }
 
+int64_t count_llvm_instructions(const llvm::Module &module) {
+    int64_t count = 0;
+    for (const llvm::Function &fn : module) {
+        count += fn.getInstructionCount();
+    }
+    return count;
+}
+
 void embed_bitcode(llvm::Module *M, const string &halide_command) {
     // Save llvm.compiler.used and remote it.
     SmallVector<Constant *, 2> used_array;
@@ -104,6 +104,11 @@ std::unique_ptr<llvm::TargetMachine> make_target_machine(const llvm::Module &mod
 /** Set the appropriate llvm Function attributes given the Halide Target. */
 void set_function_attributes_from_halide_target_options(llvm::Function &);
 
+/** The number of instructions in all the function bodies of an
+ * llvm::Module. Used to measure how passes change the size of the
+ * IR. */
+int64_t count_llvm_instructions(const llvm::Module &module);
+
 /** Save a copy of the llvm IR currently represented by the module as
  * data in the __LLVM,__bitcode section. Emulates clang's
  * -fembed-bitcode flag and is useful to satisfy Apple's bitcode
@@ -8,6 +8,7 @@
 #include "CodeGen_LLVM.h"
 #include "CodeGen_Posix.h"
 #include "CodeGen_Targets.h"
+#include "CompileTimeProfiler.h"
 #include "CompilerLogger.h"
 #include "Debug.h"
 #include "Deinterleave.h"
@@ -37,6 +38,7 @@
 namespace Halide {
 
 std::unique_ptr<llvm::Module> codegen_llvm(const Module &module, llvm::LLVMContext &context) {
+    Internal::ScopedCompileTimer timer("llvm", "LLVM IR generation", module.name());
     std::unique_ptr<Internal::CodeGen_LLVM> cg(Internal::CodeGen_LLVM::new_for_target(module.target(), context));
     return cg->compile(module);
 }
@@ -1081,6 +1083,10 @@ void CodeGen_LLVM::optimize_module() {
     debug(3) << "Optimizing module\n";
 
     auto time_start = std::chrono::high_resolution_clock::now();
+    ScopedCompileTimer timer("llvm", "LLVM optimization", module->getModuleIdentifier());
+    if (timer.is_active()) {
+        timer.set_size_before(count_llvm_instructions(*module));
+    }
 
     if (debug::debug_level() >= 3) {
         module->print(dbgs(), nullptr, false, true);
@@ -1228,6 +1234,10 @@ void CodeGen_LLVM::optimize_module() {
         module->print(dbgs(), nullptr, false, true);
     }
 
+    if (timer.is_active()) {
+        timer.set_size_after(count_llvm_instructions(*module));
+    }
+
     auto *logger = get_compiler_logger();
     if (logger) {
         auto time_end = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,250 @@
+#include "CompileTimeProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "IRVisitor.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+std::string json_string(const std::string &s) {
+    std::ostringstream o;
+    o << "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            o << "\\" << c;
+        } else if ((unsigned char)c < 0x20) {
+            o << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+        } else {
+            o << c;
+        }
+    }
+    o << "\"";
+    return o.str();
+}
+
+void emit_json_report(std::ostream &o, const std::vector<CompileTimeEvent> &all) {
+    struct Summary {
+        int64_t count = 0;
+        double total_us = 0, max_us = 0;
+        int64_t size_growth = 0;
+    };
+    std::map<std::pair<std::string, std::string>, Summary> summaries;
+    for (const auto &e : all) {
+        Summary &s = summaries[{e.category, e.name}];
+        s.count++;
+        s.total_us += e.duration_us;
+        s.max_us = std::max(s.max_us, e.duration_us);
+        if (e.size_before >= 0 && e.size_after >= 0) {
+            s.size_growth += e.size_after - e.size_before;
+        }
+    }
+
+    // Most expensive steps first.
+    std::vector<std::pair<std::pair<std::string, std::string>, Summary>> sorted(summaries.begin(), summaries.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+        return a.second.total_us > b.second.total_us;
+    });
+
+    o << std::fixed << std::setprecision(3);
+    o << "{\n";
+    o << " \"summary\": [";
+    const char *sep = "\n";
+    for (const auto &it : sorted) {
+        o << sep << "  {\"category\": " << json_string(it.first.first)
+          << ", \"name\": " << json_string(it.first.second)
+          << ", \"count\": " << it.second.count
+          << ", \"total_ms\": " << it.second.total_us / 1000
+          << ", \"max_ms\": " << it.second.max_us / 1000
+          << ", \"size_growth\": " << it.second.size_growth << "}";
+        sep = ",\n";
+    }
+    o << "\n ],\n";
+    o << " \"events\": [";
+    sep = "\n";
+    for (const auto &e : all) {
+        o << sep << "  {\"category\": " << json_string(e.category)
+          << ", \"name\": " << json_string(e.name)
+          << ", \"context\": " << json_string(e.context)
+          << ", \"thread\": " << e.thread
+          << ", \"start_ms\": " << e.start_us / 1000
+          << ", \"duration_ms\": " << e.duration_us / 1000
+          << ", \"size_before\": " << e.size_before
+          << ", \"size_after\": " << e.size_after << "}";
+        sep = ",\n";
+    }
+    o << "\n ],\n";
+    o << " \"version\": \"HalideCompileTimeProfileV1\"\n";
+    o << "}\n";
+}
+
+void emit_trace_events(std::ostream &o, const std::vector<CompileTimeEvent> &all) {
+    o << std::fixed << std::setprecision(3);
+    o << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    const char *sep = "\n";
+    for (const auto &e : all) {
+        o << sep << " {\"name\": " << json_string(e.name)
+          << ", \"cat\": " << json_string(e.category)
+          << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << e.thread
+          << ", \"ts\": " << e.start_us
+          << ", \"dur\": " << e.duration_us
+          << ", \"args\": {\"context\": " << json_string(e.context);
+        if (e.size_before >= 0) {
+            o << ", \"size_before\": " << e.size_before;
+        }
+        if (e.size_after >= 0) {
+            o << ", \"size_after\": " << e.size_after;
+        }
+        o << "}}";
+        sep = ",\n";
+    }
+    o << "\n]}\n";
+}
+
+struct ProfilerState {
+    std::mutex mutex;
+    CompileTimeProfiler::Clock::time_point epoch = CompileTimeProfiler::Clock::now();
+    std::vector<CompileTimeEvent> events;
+    std::map<std::thread::id, int> thread_ids;
+    std::string json_path, trace_path;
+
+    // -1 means not yet read from the environment.
+    std::atomic<int> enabled{-1};
+
+    ProfilerState() {
+        json_path = get_env_variable("HL_COMPILE_PROFILE");
+        trace_path = get_env_variable("HL_COMPILE_TRACE");
+    }
+
+    ~ProfilerState() {
+        if (!json_path.empty()) {
+            std::ofstream f(json_path);
+            emit_json_report(f, events);
+        }
+        if (!trace_path.empty()) {
+            std::ofstream f(trace_path);
+            emit_trace_events(f, events);
+        }
+    }
+};
+
+ProfilerState &profiler_state() {
+    static ProfilerState state;
+    return state;
+}
+
+class CountNodes : public IRGraphVisitor {
+    std::set<const IRNode *> seen;
+
+public:
+    int64_t count = 0;
+
+    void include(const Expr &e) override {
+        if (seen.insert(e.get()).second) {
+            count++;
+            e.accept(this);
+        }
+    }
+
+    void include(const Stmt &s) override {
+        if (seen.insert(s.get()).second) {
+            count++;
+            s.accept(this);
+        }
+    }
+};
+
+}  // namespace
+
+bool CompileTimeProfiler::enabled() {
+    ProfilerState &state = profiler_state();
+    int e = state.enabled.load(std::memory_order_relaxed);
+    if (e < 0) {
+        e = (!state.json_path.empty() || !state.trace_path.empty()) ? 1 : 0;
+        state.enabled.store(e, std::memory_order_relaxed);
+    }
+    return e != 0;
+}
+
+void CompileTimeProfiler::set_enabled(bool enabled) {
+    profiler_state().enabled.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+void CompileTimeProfiler::record(const std::string &category, const std::string &name, const std::string &context,
+                                 Clock::time_point start, Clock::time_point end,
+                                 int64_t size_before, int64_t size_after) {
+    ProfilerState &state = profiler_state();
+    CompileTimeEvent event;
+    event.name = name;
+    event.category = category;
+    event.context = context;
+    event.start_us = std::chrono::duration<double, std::micro>(start - state.epoch).count();
+    event.duration_us = std::chrono::duration<double, std::micro>(end - start).count();
+    event.size_before = size_before;
+    event.size_after = size_after;
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.thread_ids.emplace(std::this_thread::get_id(), (int)state.thread_ids.size()).first;
+    event.thread = it->second;
+    state.events.push_back(std::move(event));
+}
+
+std::vector<CompileTimeEvent> CompileTimeProfiler::events() {
+    ProfilerState &state = profiler_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.events;
+}
+
+void CompileTimeProfiler::reset() {
+    ProfilerState &state = profiler_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.events.clear();
+}
+
+void CompileTimeProfiler::emit_json(std::ostream &o) {
+    emit_json_report(o, events());
+}
+
+void CompileTimeProfiler::emit_chrome_trace(std::ostream &o) {
+    emit_trace_events(o, events());
+}
+
+ScopedCompileTimer::ScopedCompileTimer(const std::string &category, const std::string &name, const std::string &context)
+    : active(CompileTimeProfiler::enabled()) {
+    if (active) {
+        this->category = category;
+        this->name = name;
+        this->context = context;
+        start = CompileTimeProfiler::Clock::now();
+    }
+}
+
+ScopedCompileTimer::~ScopedCompileTimer() {
+    if (active) {
+        CompileTimeProfiler::record(category, name, context, start, CompileTimeProfiler::Clock::now(),
+                                    size_before, size_after);
+    }
+}
+
+int64_t count_ir_nodes(const Stmt &s) {
+    if (!s.defined()) {
+        return 0;
+    }
+    CountNodes counter;
+    counter.include(s);
+    return counter.count;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,127 @@
+#ifndef HALIDE_COMPILE_TIME_PROFILER_H
+#define HALIDE_COMPILE_TIME_PROFILER_H
+
+/** \file
+ * Defines a profiler that times each step of compilation (every lowering
+ * pass, LLVM optimization, and LLVM code generation) and measures how
+ * the size of the IR changes across it.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Halide {
+namespace Internal {
+
+struct Stmt;
+
+/** One timed step of compilation. */
+struct CompileTimeEvent {
+    /** What ran, e.g. "storage flattening" or "LLVM optimization". */
+    std::string name;
+
+    /** The kind of step: "lowering", "llvm", or "jit". */
+    std::string category;
+
+    /** The pipeline or module the step was working on. */
+    std::string context;
+
+    /** Start time and duration, in microseconds. Start times are relative
+     * to the first use of the profiler in this process. */
+    double start_us = 0, duration_us = 0;
+
+    /** A small integer identifying the thread the step ran on. */
+    int thread = 0;
+
+    /** The size of the IR going in and coming out, or -1 if the step
+     * does not operate on IR. Lowering passes count distinct IR nodes;
+     * LLVM steps count LLVM instructions. */
+    int64_t size_before = -1, size_after = -1;
+};
+
+/** Collects CompileTimeEvents for the whole process.
+ *
+ * Profiling is off by default and costs nothing when off. Setting the
+ * environment variable HL_COMPILE_PROFILE to a file name writes a JSON
+ * report to that file when the process exits, with a summary per step
+ * (count, total and maximum time, total growth in IR size) followed by
+ * every individual event. Setting HL_COMPILE_TRACE writes the events
+ * in the Chrome trace event format, which can be loaded into
+ * chrome://tracing or https://ui.perfetto.dev to see where the time
+ * went on a timeline. Either variable turns profiling on.
+ *
+ * Counting IR nodes takes time of its own; it is done outside of the
+ * timed region, so durations are not inflated by it, but the total
+ * compile time of a profiled run will be. */
+class CompileTimeProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /** Whether steps should be timed. */
+    static bool enabled();
+
+    /** Override the environment variables. Events are recorded but only
+     * written out at exit if one of the variables is set. */
+    static void set_enabled(bool enabled);
+
+    /** Record a step. Thread-safe. */
+    static void record(const std::string &category, const std::string &name, const std::string &context,
+                       Clock::time_point start, Clock::time_point end,
+                       int64_t size_before = -1, int64_t size_after = -1);
+
+    /** All events recorded so far, in the order they finished. */
+    static std::vector<CompileTimeEvent> events();
+
+    /** Discard all recorded events. */
+    static void reset();
+
+    /** Write the recorded events as a JSON report. */
+    static void emit_json(std::ostream &o);
+
+    /** Write the recorded events in the Chrome trace event format. */
+    static void emit_chrome_trace(std::ostream &o);
+};
+
+/** Times the enclosing scope as one step, if profiling is enabled. */
+class ScopedCompileTimer {
+    bool active;
+    std::string category, name, context;
+    CompileTimeProfiler::Clock::time_point start;
+    int64_t size_before = -1, size_after = -1;
+
+public:
+    ScopedCompileTimer(const std::string &category, const std::string &name, const std::string &context = "");
+    ~ScopedCompileTimer();
+
+    ScopedCompileTimer(const ScopedCompileTimer &) = delete;
+    ScopedCompileTimer &operator=(const ScopedCompileTimer &) = delete;
+
+    /** Whether this timer will record anything. Check this before
+     * computing IR sizes to pass to the setters below. */
+    bool is_active() const {
+        return active;
+    }
+
+    /** Set the size of the IR going into and coming out of this step. */
+    // @{
+    void set_size_before(int64_t size) {
+        size_before = size;
+    }
+    void set_size_after(int64_t size) {
+        size_after = size;
+    }
+    // @}
+};
+
+/** The number of distinct IR nodes reachable from a Stmt. Nodes shared
+ * between several parents are only counted once, so this tracks the
+ * memory the IR occupies rather than the size of its printed form. */
+int64_t count_ir_nodes(const Stmt &s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -17,7 +17,10 @@ namespace {
 // TODO: for now we are just going to ignore potential issues with
 // static-initialization-order-fiasco, as CompilerLogger isn't currently used
 // from any static-initialization execution scope.
-std::unique_ptr<CompilerLogger> active_compiler_logger;
+//
+// This is per-thread so that compile_multitarget can compile several
+// targets at once, each with its own logger.
+thread_local std::unique_ptr<CompilerLogger> active_compiler_logger;
 
 class ObfuscateNames : public IRMutator {
     using IRMutator::visit;
@@ -59,13 +59,13 @@ public:
     virtual std::ostream &emit_to_stream(std::ostream &o) = 0;
 };
 
-/** Set the active CompilerLogger object, replacing any existing one.
+/** Set the active CompilerLogger object for the calling thread, replacing any existing one.
  * It is legal to pass in a nullptr (which means "don't do any compiler logging").
  * Returns the previous CompilerLogger (if any). */
 std::unique_ptr<CompilerLogger> set_compiler_logger(std::unique_ptr<CompilerLogger> compiler_logger);
 
-/** Return the currently active CompilerLogger object. If set_compiler_logger()
- * has never been called, a nullptr implementation will be returned.
+/** Return the currently active CompilerLogger object for the calling thread. If set_compiler_logger()
+ * has never been called on this thread, a nullptr implementation will be returned.
  * Do not save the pointer returned! It is intended to be used for immediate
  * calls only. */
 CompilerLogger *get_compiler_logger();
@@ -18,7 +18,7 @@ const IntImm *IntImm::make(Type t, int64_t value) {
     // Then sign-extending to get them back
     value >>= (64 - t.bits());
 
-    IntImm *node = new IntImm;
+    IntImm *node = new_ir_node<IntImm>();
     node->type = t;
     node->value = value;
     return node;
@@ -34,7 +34,7 @@ const UIntImm *UIntImm::make(Type t, uint64_t value) {
     value <<= (64 - t.bits());
     value >>= (64 - t.bits());
 
-    UIntImm *node = new UIntImm;
+    UIntImm *node = new_ir_node<UIntImm>();
     node->type = t;
     node->value = value;
     return node;
@@ -43,7 +43,7 @@ const UIntImm *UIntImm::make(Type t, uint64_t value) {
 const FloatImm *FloatImm::make(Type t, double value) {
     internal_assert(t.is_float() && t.is_scalar())
         << "FloatImm must be a scalar Float\n";
-    FloatImm *node = new FloatImm;
+    FloatImm *node = new_ir_node<FloatImm>();
     node->type = t;
     switch (t.bits()) {
     case 16:
@@ -67,7 +67,7 @@ const FloatImm *FloatImm::make(Type t, double value) {
 }
 
 const StringImm *StringImm::make(const std::string &val) {
-    StringImm *node = new StringImm;
+    StringImm *node = new_ir_node<StringImm>();
     node->type = type_of<const char *>();
     node->value = val;
     return node;
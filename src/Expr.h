@@ -5,9 +5,11 @@
  * Base classes for Halide expressions (\ref Halide::Expr) and statements (\ref Halide::Internal::Stmt)
  */
 
+#include <new>
 #include <string>
 #include <vector>
 
+#include "IRArena.h"
 #include "IntrusivePtr.h"
 #include "Type.h"
 
@@ -118,7 +120,27 @@ inline RefCount &ref_count<IRNode>(const IRNode *t) noexcept {
 
 template<>
 inline void destroy<IRNode>(const IRNode *t) {
-    delete t;
+    if (t->ref_count.is_arena_allocated()) {
+        IRArena::destroy(t);
+    } else {
+        delete t;
+    }
+}
+
+/** Allocate and construct an IR node, from the current thread's
+ * IRArena if there is one. All IR nodes should be made this way. */
+template<typename T>
+T *new_ir_node() {
+    bool thread_private;
+    if (void *mem = IRArena::allocate(sizeof(T), &thread_private)) {
+        T *node = new (mem) T;
+        node->ref_count.set_arena_allocated();
+        if (thread_private) {
+            node->ref_count.set_thread_private(true);
+        }
+        return node;
+    }
+    return new T;
 }
 
 /** IR nodes are split into expressions and statements. These are
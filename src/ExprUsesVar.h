@@ -33,7 +33,7 @@ class ExprUsesVars : public IRGraphVisitor {
         IRGraphVisitor::include(s);
     }
 
-    void visit_name(const std::string &name) {
+    void visit_name(Symbol name) {
         if (vars.contains(name)) {
             result = true;
         } else if (scope.contains(name)) {
@@ -41,12 +41,16 @@ class ExprUsesVars : public IRGraphVisitor {
         }
     }
 
+    void visit_name(const std::string &name) {
+        visit_name(Symbol(name));
+    }
+
     void visit(const Variable *op) override {
-        visit_name(op->name);
+        visit_name(op->symbol());
     }
 
     void visit(const Load *op) override {
-        visit_name(op->name);
+        visit_name(op->symbol());
         IRGraphVisitor::visit(op);
     }
 
@@ -56,7 +60,7 @@ class ExprUsesVars : public IRGraphVisitor {
     }
 
     void visit(const Call *op) override {
-        visit_name(op->name);
+        visit_name(op->symbol());
         IRGraphVisitor::visit(op);
     }
 
@@ -66,12 +70,12 @@ class ExprUsesVars : public IRGraphVisitor {
     }
 
     void visit(const LetStmt *op) override {
-        visit_name(op->name);
+        visit_name(op->symbol());
         IRGraphVisitor::visit(op);
     }
 
     void visit(const Let *op) override {
-        visit_name(op->name);
+        visit_name(op->symbol());
         IRGraphVisitor::visit(op);
     }
 
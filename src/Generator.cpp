@@ -801,7 +801,7 @@ int generate_filter_main_inner(int argc,
 gengen
   [-g GENERATOR_NAME] [-f FUNCTION_NAME] [-o OUTPUT_DIR] [-r RUNTIME_NAME]
   [-d 1|0] [-e EMIT_OPTIONS] [-n FILE_BASE_NAME] [-p PLUGIN_NAME]
-  [-s AUTOSCHEDULER_NAME] [-t TIMEOUT]
+  [-s AUTOSCHEDULER_NAME] [-t TIMEOUT] [-j COMPILE_THREADS]
   target=target-string[,target-string...]
   [generator_arg=value [...]]
 
@@ -815,6 +815,11 @@ gengen
       schedule, static_library, stmt, stmt_html, compiler_log].
      If omitted, default value is [c_header, static_library, registration].
 
+ -j  The maximum number of targets to compile at once when more than one
+     target is given. Defaults to 0, which uses the HL_COMPILE_THREADS
+     environment variable if set, otherwise the number of cores. Specify 1 to
+     compile the targets one at a time.
+
  -p  A comma-separated list of shared libraries that will be loaded before the
      generator is run. Useful for custom auto-schedulers. The generator must
      either be linked against a shared libHalide or compiled with -rdynamic
@@ -841,6 +846,7 @@ gengen
         {"-e", ""},
         {"-f", ""},
         {"-g", ""},
+        {"-j", "0"},
         {"-n", ""},
         {"-o", ""},
         {"-p", ""},
@@ -871,6 +877,12 @@ gengen
     user_assert(d_val == "1" || d_val == "0") << "-d must be 0 or 1\n"
                                               << kUsage;
 
+    const auto &j_val = flags_info["-j"];
+    user_assert(!j_val.empty() && j_val.size() <= 6 &&
+                j_val.find_first_not_of("0123456789") == std::string::npos)
+        << "-j must be a non-negative integer\n"
+        << kUsage;
+
     const std::vector<std::string> generator_names = generator_factory_provider.enumerate();
 
     const auto create_generator = [&](const std::string &generator_name, const Halide::GeneratorContext &context) -> std::unique_ptr<GeneratorBase> {
@@ -982,6 +994,7 @@ gengen
     // args.generator_params is already set
     args.autoscheduler_name = flags_info["-s"];
     args.plugin_paths = split_string(flags_info["-p"], ",");
+    args.compile_threads = std::stoi(j_val);
 
     // Allow quick-n-dirty use of compiler logging via HL_DEBUG_COMPILER_LOGGER env var
     const bool do_compiler_logging = args.output_types.count(OutputFileType::compiler_log) ||
@@ -1221,7 +1234,7 @@ void execute_generator(const ExecuteGeneratorArgs &args_in) {
                            gen->build_gradient_module(function_name) :
                            gen->build_module(function_name);
             };
-            compile_multitarget(args.function_name, output_files, args.targets, args.suffixes, module_factory, args.compiler_logger_factory);
+            compile_multitarget(args.function_name, output_files, args.targets, args.suffixes, module_factory, args.compiler_logger_factory, args.compile_threads);
         }
     }
 }
@@ -4068,6 +4068,15 @@ struct ExecuteGeneratorArgs {
 
     // Compiler Logger to use, for diagnostic work. If null, don't do any logging.
     CompilerLoggerFactory compiler_logger_factory = nullptr;
+
+    // The maximum number of targets to compile at once when producing
+    // multitarget output. If zero, the environment variable
+    // HL_COMPILE_THREADS is used if set, otherwise the number of cores; set
+    // it to 1 to compile serially. The output does not depend on this value.
+    // Note that it is only safe to use more than one thread if the Generator
+    // (and `create_generator` and `compiler_logger_factory`) can be run
+    // concurrently with other instances of itself.
+    int compile_threads = 0;
 };
 
 /**
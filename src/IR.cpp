@@ -14,7 +14,7 @@ Expr Cast::make(Type t, Expr v) {
     internal_assert(v.defined()) << "Cast of undefined\n";
     internal_assert(t.lanes() == v.type().lanes()) << "Cast may not change vector widths\n";
 
-    Cast *node = new Cast;
+    Cast *node = new_ir_node<Cast>();
     node->type = t;
     node->value = std::move(v);
     return node;
@@ -25,7 +25,7 @@ Expr Add::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "Add of undefined\n";
     internal_assert(a.type() == b.type()) << "Add of mismatched types\n";
 
-    Add *node = new Add;
+    Add *node = new_ir_node<Add>();
     node->type = a.type();
     node->a = std::move(a);
     node->b = std::move(b);
@@ -37,7 +37,7 @@ Expr Sub::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "Sub of undefined\n";
     internal_assert(a.type() == b.type()) << "Sub of mismatched types\n";
 
-    Sub *node = new Sub;
+    Sub *node = new_ir_node<Sub>();
     node->type = a.type();
     node->a = std::move(a);
     node->b = std::move(b);
@@ -49,7 +49,7 @@ Expr Mul::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "Mul of undefined\n";
     internal_assert(a.type() == b.type()) << "Mul of mismatched types\n";
 
-    Mul *node = new Mul;
+    Mul *node = new_ir_node<Mul>();
     node->type = a.type();
     node->a = std::move(a);
     node->b = std::move(b);
@@ -61,7 +61,7 @@ Expr Div::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "Div of undefined\n";
     internal_assert(a.type() == b.type()) << "Div of mismatched types\n";
 
-    Div *node = new Div;
+    Div *node = new_ir_node<Div>();
     node->type = a.type();
     node->a = std::move(a);
     node->b = std::move(b);
@@ -73,7 +73,7 @@ Expr Mod::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "Mod of undefined\n";
     internal_assert(a.type() == b.type()) << "Mod of mismatched types\n";
 
-    Mod *node = new Mod;
+    Mod *node = new_ir_node<Mod>();
     node->type = a.type();
     node->a = std::move(a);
     node->b = std::move(b);
@@ -85,7 +85,7 @@ Expr Min::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "Min of undefined\n";
     internal_assert(a.type() == b.type()) << "Min of mismatched types\n";
 
-    Min *node = new Min;
+    Min *node = new_ir_node<Min>();
     node->type = a.type();
     node->a = std::move(a);
     node->b = std::move(b);
@@ -97,7 +97,7 @@ Expr Max::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "Max of undefined\n";
     internal_assert(a.type() == b.type()) << "Max of mismatched types\n";
 
-    Max *node = new Max;
+    Max *node = new_ir_node<Max>();
     node->type = a.type();
     node->a = std::move(a);
     node->b = std::move(b);
@@ -109,7 +109,7 @@ Expr EQ::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "EQ of undefined\n";
     internal_assert(a.type() == b.type()) << "EQ of mismatched types\n";
 
-    EQ *node = new EQ;
+    EQ *node = new_ir_node<EQ>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -121,7 +121,7 @@ Expr NE::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "NE of undefined\n";
     internal_assert(a.type() == b.type()) << "NE of mismatched types\n";
 
-    NE *node = new NE;
+    NE *node = new_ir_node<NE>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -133,7 +133,7 @@ Expr LT::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "LT of undefined\n";
     internal_assert(a.type() == b.type()) << "LT of mismatched types\n";
 
-    LT *node = new LT;
+    LT *node = new_ir_node<LT>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -145,7 +145,7 @@ Expr LE::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "LE of undefined\n";
     internal_assert(a.type() == b.type()) << "LE of mismatched types\n";
 
-    LE *node = new LE;
+    LE *node = new_ir_node<LE>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -157,7 +157,7 @@ Expr GT::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "GT of undefined\n";
     internal_assert(a.type() == b.type()) << "GT of mismatched types\n";
 
-    GT *node = new GT;
+    GT *node = new_ir_node<GT>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -169,7 +169,7 @@ Expr GE::make(Expr a, Expr b) {
     internal_assert(b.defined()) << "GE of undefined\n";
     internal_assert(a.type() == b.type()) << "GE of mismatched types\n";
 
-    GE *node = new GE;
+    GE *node = new_ir_node<GE>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -183,7 +183,7 @@ Expr And::make(Expr a, Expr b) {
     internal_assert(b.type().is_bool()) << "rhs of And is not a bool\n";
     internal_assert(a.type() == b.type()) << "And of mismatched types\n";
 
-    And *node = new And;
+    And *node = new_ir_node<And>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -197,7 +197,7 @@ Expr Or::make(Expr a, Expr b) {
     internal_assert(b.type().is_bool()) << "rhs of Or is not a bool\n";
     internal_assert(a.type() == b.type()) << "Or of mismatched types\n";
 
-    Or *node = new Or;
+    Or *node = new_ir_node<Or>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     node->b = std::move(b);
@@ -208,7 +208,7 @@ Expr Not::make(Expr a) {
     internal_assert(a.defined()) << "Not of undefined\n";
     internal_assert(a.type().is_bool()) << "argument of Not is not a bool\n";
 
-    Not *node = new Not;
+    Not *node = new_ir_node<Not>();
     node->type = Bool(a.type().lanes());
     node->a = std::move(a);
     return node;
@@ -224,7 +224,7 @@ Expr Select::make(Expr condition, Expr true_value, Expr false_value) {
                     condition.type().lanes() == true_value.type().lanes())
         << "In Select, vector lanes of condition must either be 1, or equal to vector lanes of arguments\n";
 
-    Select *node = new Select;
+    Select *node = new_ir_node<Select>();
     node->type = true_value.type();
     node->condition = std::move(condition);
     node->true_value = std::move(true_value);
@@ -239,7 +239,7 @@ Expr Load::make(Type type, const std::string &name, Expr index, Buffer<> image,
     internal_assert(type.lanes() == predicate.type().lanes())
         << "Vector lanes of Load must match vector lanes of predicate\n";
 
-    Load *node = new Load;
+    Load *node = new_ir_node<Load>();
     node->type = type;
     node->name = name;
     node->predicate = std::move(predicate);
@@ -256,7 +256,7 @@ Expr Ramp::make(Expr base, Expr stride, int lanes) {
     internal_assert(lanes > 1) << "Ramp of lanes <= 1\n";
     internal_assert(stride.type() == base.type()) << "Ramp of mismatched types\n";
 
-    Ramp *node = new Ramp;
+    Ramp *node = new_ir_node<Ramp>();
     node->type = base.type().with_lanes(lanes * base.type().lanes());
     node->base = std::move(base);
     node->stride = std::move(stride);
@@ -268,7 +268,7 @@ Expr Broadcast::make(Expr value, int lanes) {
     internal_assert(value.defined()) << "Broadcast of undefined\n";
     internal_assert(lanes != 1) << "Broadcast of lanes 1\n";
 
-    Broadcast *node = new Broadcast;
+    Broadcast *node = new_ir_node<Broadcast>();
     node->type = value.type().with_lanes(lanes * value.type().lanes());
     node->value = std::move(value);
     node->lanes = lanes;
@@ -279,7 +279,7 @@ Expr Let::make(const std::string &name, Expr value, Expr body) {
     internal_assert(value.defined()) << "Let of undefined\n";
     internal_assert(body.defined()) << "Let of undefined\n";
 
-    Let *node = new Let;
+    Let *node = new_ir_node<Let>();
     node->type = body.type();
     node->name = name;
     node->value = std::move(value);
@@ -291,7 +291,7 @@ Stmt LetStmt::make(const std::string &name, Expr value, Stmt body) {
     internal_assert(value.defined()) << "Let of undefined\n";
     internal_assert(body.defined()) << "Let of undefined\n";
 
-    LetStmt *node = new LetStmt;
+    LetStmt *node = new_ir_node<LetStmt>();
     node->name = name;
     node->value = std::move(value);
     node->body = std::move(body);
@@ -302,7 +302,7 @@ Stmt AssertStmt::make(Expr condition, Expr message) {
     internal_assert(condition.defined()) << "AssertStmt of undefined\n";
     internal_assert(message.type() == Int(32)) << "AssertStmt message must be an int:" << message << "\n";
 
-    AssertStmt *node = new AssertStmt;
+    AssertStmt *node = new_ir_node<AssertStmt>();
     node->condition = std::move(condition);
     node->message = std::move(message);
     return node;
@@ -311,7 +311,7 @@ Stmt AssertStmt::make(Expr condition, Expr message) {
 Stmt ProducerConsumer::make(const std::string &name, bool is_producer, Stmt body) {
     internal_assert(body.defined()) << "ProducerConsumer of undefined\n";
 
-    ProducerConsumer *node = new ProducerConsumer;
+    ProducerConsumer *node = new_ir_node<ProducerConsumer>();
     node->name = name;
     node->is_producer = is_producer;
     node->body = std::move(body);
@@ -333,7 +333,7 @@ Stmt For::make(const std::string &name, Expr min, Expr extent, ForType for_type,
     internal_assert(extent.type() == Int(32)) << "For with non-integer extent\n";
     internal_assert(body.defined()) << "For of undefined\n";
 
-    For *node = new For;
+    For *node = new_ir_node<For>();
     node->name = name;
     node->min = std::move(min);
     node->extent = std::move(extent);
@@ -347,7 +347,7 @@ Stmt Acquire::make(Expr semaphore, Expr count, Stmt body) {
     internal_assert(semaphore.defined()) << "Acquire with undefined semaphore\n";
     internal_assert(body.defined()) << "Acquire with undefined body\n";
 
-    Acquire *node = new Acquire;
+    Acquire *node = new_ir_node<Acquire>();
     node->semaphore = std::move(semaphore);
     node->count = std::move(count);
     node->body = std::move(body);
@@ -362,7 +362,7 @@ Stmt Store::make(const std::string &name, Expr value, Expr index, Parameter para
     internal_assert(value.type().lanes() == predicate.type().lanes())
         << "Vector lanes of Store must match vector lanes of predicate\n";
 
-    Store *node = new Store;
+    Store *node = new_ir_node<Store>();
     node->name = name;
     node->predicate = std::move(predicate);
     node->value = std::move(value);
@@ -382,7 +382,7 @@ Stmt Provide::make(const std::string &name, const std::vector<Expr> &values, con
         internal_assert(arg.defined()) << "Provide to undefined location\n";
     }
 
-    Provide *node = new Provide;
+    Provide *node = new_ir_node<Provide>();
     node->name = name;
     node->values = values;
     node->args = args;
@@ -402,7 +402,7 @@ Stmt Allocate::make(const std::string &name, Type type, MemoryType memory_type,
     internal_assert(condition.defined()) << "Allocate with undefined condition\n";
     internal_assert(condition.type().is_bool()) << "Allocate condition is not boolean\n";
 
-    Allocate *node = new Allocate;
+    Allocate *node = new_ir_node<Allocate>();
     node->name = name;
     node->type = type;
     node->memory_type = memory_type;
@@ -450,7 +450,7 @@ int32_t Allocate::constant_allocation_size() const {
 }
 
 Stmt Free::make(const std::string &name) {
-    Free *node = new Free;
+    Free *node = new_ir_node<Free>();
     node->name = name;
     return node;
 }
@@ -467,7 +467,7 @@ Stmt Realize::make(const std::string &name, const std::vector<Type> &types, Memo
     internal_assert(condition.defined()) << "Realize with undefined condition\n";
     internal_assert(condition.type().is_bool()) << "Realize condition is not boolean\n";
 
-    Realize *node = new Realize;
+    Realize *node = new_ir_node<Realize>();
     node->name = name;
     node->types = types;
     node->memory_type = memory_type;
@@ -494,7 +494,7 @@ Stmt Prefetch::make(const std::string &name, const std::vector<Type> &types,
 
     user_assert(is_pure(prefetch.offset)) << "The offset to the prefetch directive must be pure.";
 
-    Prefetch *node = new Prefetch;
+    Prefetch *node = new_ir_node<Prefetch>();
     node->name = name;
     node->types = types;
     node->bounds = bounds;
@@ -508,7 +508,7 @@ Stmt Block::make(Stmt first, Stmt rest) {
     internal_assert(first.defined()) << "Block of undefined\n";
     internal_assert(rest.defined()) << "Block of undefined\n";
 
-    Block *node = new Block;
+    Block *node = new_ir_node<Block>();
 
     if (const Block *b = first.as<Block>()) {
         // Use a canonical block nesting order
@@ -537,7 +537,7 @@ Stmt Fork::make(Stmt first, Stmt rest) {
     internal_assert(first.defined()) << "Fork of undefined\n";
     internal_assert(rest.defined()) << "Fork of undefined\n";
 
-    Fork *node = new Fork;
+    Fork *node = new_ir_node<Fork>();
 
     if (const Fork *b = first.as<Fork>()) {
         // Use a canonical fork nesting order
@@ -555,7 +555,7 @@ Stmt IfThenElse::make(Expr condition, Stmt then_case, Stmt else_case) {
     internal_assert(condition.defined() && then_case.defined()) << "IfThenElse of undefined\n";
     // else_case may be null.
 
-    IfThenElse *node = new IfThenElse;
+    IfThenElse *node = new_ir_node<IfThenElse>();
     node->condition = std::move(condition);
     node->then_case = std::move(then_case);
     node->else_case = std::move(else_case);
@@ -565,7 +565,7 @@ Stmt IfThenElse::make(Expr condition, Stmt then_case, Stmt else_case) {
 Stmt Evaluate::make(Expr v) {
     internal_assert(v.defined()) << "Evaluate of undefined\n";
 
-    Evaluate *node = new Evaluate;
+    Evaluate *node = new_ir_node<Evaluate>();
     node->value = std::move(v);
     return node;
 }
@@ -698,7 +698,7 @@ Expr Call::make(Type type, const std::string &name, const std::vector<Expr> &arg
         }
     }
 
-    Call *node = new Call;
+    Call *node = new_ir_node<Call>();
     node->type = type;
     node->name = name;
     node->args = args;
@@ -712,7 +712,7 @@ Expr Call::make(Type type, const std::string &name, const std::vector<Expr> &arg
 
 Expr Variable::make(Type type, const std::string &name, Buffer<> image, Parameter param, ReductionDomain reduction_domain) {
     internal_assert(!name.empty());
-    Variable *node = new Variable;
+    Variable *node = new_ir_node<Variable>();
     node->type = type;
     node->name = name;
     node->image = std::move(image);
@@ -735,7 +735,7 @@ Expr Shuffle::make(const std::vector<Expr> &vectors,
         internal_assert(0 <= i && i < input_lanes) << "Shuffle vector index out of range: " << i << "\n";
     }
 
-    Shuffle *node = new Shuffle;
+    Shuffle *node = new_ir_node<Shuffle>();
     node->type = element_ty.with_lanes((int)indices.size());
     node->vectors = vectors;
     node->indices = indices;
@@ -878,7 +878,7 @@ bool Shuffle::is_interleave() const {
 Stmt Atomic::make(const std::string &producer_name,
                   const std::string &mutex_name,
                   Stmt body) {
-    Atomic *node = new Atomic;
+    Atomic *node = new_ir_node<Atomic>();
     node->producer_name = producer_name;
     node->mutex_name = mutex_name;
     internal_assert(body.defined()) << "Atomic must have a body statement.\n";
@@ -901,7 +901,7 @@ Expr VectorReduce::make(VectorReduce::Operator op,
                     (lanes != 0 && (vec.type().lanes() % lanes == 0)))
         << "Vector reduce output lanes must be a divisor of the number of lanes in the argument "
         << lanes << " " << vec.type().lanes() << "\n";
-    VectorReduce *node = new VectorReduce;
+    VectorReduce *node = new_ir_node<VectorReduce>();
     node->type = vec.type().with_lanes(lanes);
     node->op = op;
     node->value = std::move(vec);
@@ -15,6 +15,7 @@
 #include "Parameter.h"
 #include "PrefetchDirective.h"
 #include "Reduction.h"
+#include "Symbol.h"
 #include "Type.h"
 
 namespace Halide {
@@ -199,6 +200,12 @@ struct Select : public ExprNode<Select> {
 struct Load : public ExprNode<Load> {
     std::string name;
 
+    /** The interned form of the name, for constant-time comparison
+     * and lookups in a Scope. */
+    Symbol symbol() const {
+        return name_symbol.get(name);
+    }
+
     Expr predicate, index;
 
     // If it's a load from an image argument or compiled-in constant
@@ -219,6 +226,9 @@ struct Load : public ExprNode<Load> {
                      ModulusRemainder alignment);
 
     static const IRNodeType _node_type = IRNodeType::Load;
+
+private:
+    LazySymbol name_symbol;
 };
 
 /** A linear ramp vector node. This is vector with 'lanes' elements,
@@ -252,23 +262,41 @@ struct Broadcast : public ExprNode<Broadcast> {
  * node \ref Let::name refer to \ref Let::value. */
 struct Let : public ExprNode<Let> {
     std::string name;
+
+    /** The interned form of the name. */
+    Symbol symbol() const {
+        return name_symbol.get(name);
+    }
+
     Expr value, body;
 
     static Expr make(const std::string &name, Expr value, Expr body);
 
     static const IRNodeType _node_type = IRNodeType::Let;
+
+private:
+    LazySymbol name_symbol;
 };
 
 /** The statement form of a let node. Within the statement 'body',
  * instances of the Var named 'name' refer to 'value' */
 struct LetStmt : public StmtNode<LetStmt> {
     std::string name;
+
+    /** The interned form of the name. */
+    Symbol symbol() const {
+        return name_symbol.get(name);
+    }
+
     Expr value;
     Stmt body;
 
     static Stmt make(const std::string &name, Expr value, Stmt body);
 
     static const IRNodeType _node_type = IRNodeType::LetStmt;
+
+private:
+    LazySymbol name_symbol;
 };
 
 /** If the 'condition' is false, then evaluate and return the message,
@@ -465,6 +493,12 @@ struct Evaluate : public StmtNode<Evaluate> {
  * them to Load nodes. */
 struct Call : public ExprNode<Call> {
     std::string name;
+
+    /** The interned form of the name. */
+    Symbol symbol() const {
+        return name_symbol.get(name);
+    }
+
     std::vector<Expr> args;
     typedef enum { Image,            ///< A load from an input image
                    Extern,           ///< A call to an external C-ABI function, possibly with side-effects
@@ -691,6 +725,9 @@ struct Call : public ExprNode<Call> {
     }
 
     static const IRNodeType _node_type = IRNodeType::Call;
+
+private:
+    LazySymbol name_symbol;
 };
 
 /** A named variable. Might be a loop variable, function argument,
@@ -699,6 +736,11 @@ struct Call : public ExprNode<Call> {
 struct Variable : public ExprNode<Variable> {
     std::string name;
 
+    /** The interned form of the name. */
+    Symbol symbol() const {
+        return name_symbol.get(name);
+    }
+
     /** References to scalar parameters, or to the dimensions of buffer
      * parameters hang onto those expressions. */
     Parameter param;
@@ -729,6 +771,9 @@ struct Variable : public ExprNode<Variable> {
                      Parameter param, ReductionDomain reduction_domain);
 
     static const IRNodeType _node_type = IRNodeType::Variable;
+
+private:
+    LazySymbol name_symbol;
 };
 
 /** A for loop. Execute the 'body' statement for all values of the
@@ -745,6 +790,12 @@ struct Variable : public ExprNode<Variable> {
  * integer constant. */
 struct For : public StmtNode<For> {
     std::string name;
+
+    /** The interned form of the name. */
+    Symbol symbol() const {
+        return name_symbol.get(name);
+    }
+
     Expr min, extent;
     ForType for_type;
     DeviceAPI device_api;
@@ -760,6 +811,9 @@ struct For : public StmtNode<For> {
     }
 
     static const IRNodeType _node_type = IRNodeType::For;
+
+private:
+    LazySymbol name_symbol;
 };
 
 struct Acquire : public StmtNode<Acquire> {
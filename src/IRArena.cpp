@@ -0,0 +1,212 @@
+#include "IRArena.h"
+
+#include <atomic>
+#include <new>
+
+#include "Debug.h"
+#include "Error.h"
+#include "Expr.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+// Chunks are aligned to their size, so the chunk a node lives in can
+// be found from its address.
+constexpr size_t chunk_size = 256 * 1024;
+
+// Slots are multiples of this size. The largest IR node is well under
+// max_size_classes of them.
+constexpr size_t slot_granularity = 8;
+constexpr size_t max_size_classes = 64;
+
+// Every slot starts with a header, so that the arena can find the
+// nodes in a chunk when it closes.
+struct SlotHeader {
+    enum State : uint32_t {
+        // On the arena's list of free slots.
+        Free,
+        Live,
+        // Freed while the arena was open, but not reusable.
+        Dead,
+    };
+
+    uint32_t size_class;
+    // Atomic because a thread other than the arena's may free the node.
+    std::atomic<uint32_t> state;
+};
+static_assert(sizeof(SlotHeader) % slot_granularity == 0, "SlotHeader breaks the alignment of slots");
+
+thread_local IRArena *current_arena = nullptr;
+
+// -1 means not yet read from the environment.
+std::atomic<int> arena_mode{-1};
+
+std::atomic<int64_t> total_chunks{0};
+
+// The number of ConcurrentCompilations in existence.
+std::atomic<int> concurrent_compilations{0};
+
+}  // namespace
+
+struct IRArena::Chunk {
+    // The arena allocating from this chunk, or null once it's closed.
+    std::atomic<IRArena *> owner;
+
+    // The number of slots in use, plus one while the arena is open.
+    // Free slots count as in use until the arena closes.
+    std::atomic<int64_t> held;
+
+    // The end of the part of the chunk handed out so far.
+    char *top;
+
+    char *begin() {
+        return (char *)this + (sizeof(Chunk) + slot_granularity - 1) / slot_granularity * slot_granularity;
+    }
+
+    static Chunk *of(const void *p) {
+        return (Chunk *)((uintptr_t)p & ~(uintptr_t)(chunk_size - 1));
+    }
+
+    void release(int64_t count) {
+        if (held.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            this->~Chunk();
+            ::operator delete((void *)this, std::align_val_t(chunk_size));
+            total_chunks--;
+        }
+    }
+};
+
+IRArena::Mode IRArena::mode() {
+    int m = arena_mode.load(std::memory_order_relaxed);
+    if (m < 0) {
+        std::string env = get_env_variable("HL_IR_ARENA");
+        if (env == "1") {
+            m = (int)Mode::Shared;
+        } else if (env == "single_threaded") {
+            m = (int)Mode::ThreadPrivate;
+        } else {
+            user_assert(env.empty() || env == "0")
+                << "HL_IR_ARENA must be 0, 1, or single_threaded, not " << env << "\n";
+            m = (int)Mode::Off;
+        }
+        arena_mode.store(m, std::memory_order_relaxed);
+    }
+    return (Mode)m;
+}
+
+void IRArena::set_mode(Mode m) {
+    arena_mode.store((int)m, std::memory_order_relaxed);
+}
+
+IRArena::ConcurrentCompilation::ConcurrentCompilation() {
+    concurrent_compilations++;
+}
+
+IRArena::ConcurrentCompilation::~ConcurrentCompilation() {
+    concurrent_compilations--;
+}
+
+IRArena::IRArena(bool thread_private)
+    : thread_private(thread_private), previous(current_arena), free_lists(max_size_classes, nullptr) {
+    if (thread_private && concurrent_compilations.load() > 0) {
+        debug(1) << "Other threads may be compiling, so using an IRArena with atomic reference counts\n";
+        this->thread_private = false;
+    }
+    current_arena = this;
+}
+
+IRArena::~IRArena() {
+    internal_assert(current_arena == this) << "IRArenas must be closed in the opposite order to which they were opened\n";
+    current_arena = previous;
+
+    for (Chunk *c : chunks) {
+        char *chunk_end = (c == chunks.back()) ? top : c->top;
+        int64_t free_slots = 0;
+        for (char *p = c->begin(); p < chunk_end;) {
+            SlotHeader *h = (SlotHeader *)p;
+            if (h->state == SlotHeader::Free) {
+                free_slots++;
+            } else if (h->state == SlotHeader::Live && thread_private) {
+                // Other threads may see this node from now on.
+                const IRNode *node = (const IRNode *)(h + 1);
+                node->ref_count.set_thread_private(false);
+            }
+            p += sizeof(SlotHeader) + h->size_class * slot_granularity;
+        }
+        c->owner.store(nullptr, std::memory_order_release);
+        c->release(free_slots + 1);
+    }
+}
+
+IRArena::Chunk *IRArena::new_chunk() {
+    if (!chunks.empty()) {
+        chunks.back()->top = top;
+    }
+    void *mem = ::operator new(chunk_size, std::align_val_t(chunk_size));
+    Chunk *c = new (mem) Chunk;
+    c->owner.store(this, std::memory_order_relaxed);
+    c->held.store(1, std::memory_order_relaxed);
+    top = c->top = c->begin();
+    end = (char *)c + chunk_size;
+    chunks.push_back(c);
+    total_chunks++;
+    return c;
+}
+
+void *IRArena::allocate(size_t size, bool *thread_private) {
+    IRArena *a = current_arena;
+    if (!a) {
+        return nullptr;
+    }
+    *thread_private = a->thread_private;
+
+    const size_t size_class = (size + slot_granularity - 1) / slot_granularity;
+    internal_assert(size_class < max_size_classes) << "IR node too large for IRArena: " << size << " bytes\n";
+
+    SlotHeader *h = (SlotHeader *)a->free_lists[size_class];
+    if (h) {
+        a->free_lists[size_class] = *(void **)(h + 1);
+    } else {
+        const size_t bytes = sizeof(SlotHeader) + size_class * slot_granularity;
+        if (a->top + bytes > a->end) {
+            a->new_chunk();
+        }
+        h = (SlotHeader *)a->top;
+        a->top += bytes;
+        h->size_class = (uint32_t)size_class;
+        Chunk::of(h)->held.fetch_add(1, std::memory_order_relaxed);
+    }
+    h->state = SlotHeader::Live;
+    return h + 1;
+}
+
+void IRArena::destroy(const IRNode *node) {
+    SlotHeader *h = (SlotHeader *)node - 1;
+    Chunk *c = Chunk::of(h);
+    node->~IRNode();
+
+    IRArena *owner = c->owner.load(std::memory_order_acquire);
+    if (owner && owner == current_arena) {
+        // Recycle the slot.
+        h->state = SlotHeader::Free;
+        *(void **)(h + 1) = owner->free_lists[h->size_class];
+        owner->free_lists[h->size_class] = h;
+    } else {
+        // Freed on another thread, or while a nested arena is open, or
+        // after the arena closed.
+        if (owner) {
+            h->state = SlotHeader::Dead;
+        }
+        c->release(1);
+    }
+}
+
+int64_t IRArena::chunks_in_use() {
+    return total_chunks;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,103 @@
+#ifndef HALIDE_IR_ARENA_H
+#define HALIDE_IR_ARENA_H
+
+/** \file
+ * Defines a region from which IR nodes can be allocated, to make
+ * creating and destroying the many short-lived nodes made during
+ * lowering cheaper.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Halide {
+namespace Internal {
+
+struct IRNode;
+
+/** While an IRArena is open, the IR nodes made on the thread that
+ * opened it are carved out of large chunks of memory owned by the
+ * arena, instead of being individually allocated from the heap. The
+ * slots of nodes freed while the arena is open are reused for new
+ * nodes of the same size. Nodes may outlive the arena: closing it
+ * only stops new nodes from being allocated from it, and each chunk
+ * is returned to the heap when the last node in it is freed.
+ *
+ * If the arena is thread-private, the reference counts of its nodes
+ * are updated non-atomically while it is open. This is only safe if
+ * no other thread can reach the nodes until the arena is closed, so
+ * it must not be used while other threads are compiling. Arenas asked
+ * to be thread-private while a ConcurrentCompilation exists use atomic
+ * reference counts instead.
+ *
+ * Arenas nest, and must be closed in the opposite order they were
+ * opened. */
+class IRArena {
+public:
+    /** How lowering should use an arena. Defaults to the value of the
+     * environment variable HL_IR_ARENA: unset or 0 means no arena, 1
+     * means an arena with atomic reference counts, and single_threaded
+     * means a thread-private arena. */
+    enum class Mode {
+        Off,
+        Shared,
+        ThreadPrivate,
+    };
+    static Mode mode();
+    static void set_mode(Mode m);
+
+    /** Marks a span of time during which several threads may be
+     * compiling at once, such as compile_multitarget running its jobs
+     * on a thread pool. */
+    class ConcurrentCompilation {
+    public:
+        ConcurrentCompilation();
+        ~ConcurrentCompilation();
+
+        ConcurrentCompilation(const ConcurrentCompilation &) = delete;
+        ConcurrentCompilation &operator=(const ConcurrentCompilation &) = delete;
+    };
+
+    /** Open an arena on the current thread. */
+    explicit IRArena(bool thread_private);
+
+    /** Close the arena. */
+    ~IRArena();
+
+    IRArena(const IRArena &) = delete;
+    IRArena &operator=(const IRArena &) = delete;
+
+    /** Allocate memory for an IR node of the given size from the
+     * current thread's arena. Returns nullptr if there is no open
+     * arena on this thread. Sets *thread_private to whether the node's
+     * reference count should be non-atomic. */
+    static void *allocate(size_t size, bool *thread_private);
+
+    /** Destroy an IR node allocated with allocate. */
+    static void destroy(const IRNode *node);
+
+    /** The number of chunks of memory currently held, by all arenas
+     * and by nodes that outlived their arenas. */
+    static int64_t chunks_in_use();
+
+private:
+    struct Chunk;
+
+    Chunk *new_chunk();
+
+    bool thread_private;
+    IRArena *previous;
+    std::vector<Chunk *> chunks;
+
+    // The unused part of the most recent chunk.
+    char *top = nullptr, *end = nullptr;
+
+    // Heads of the lists of free slots, by size class.
+    std::vector<void *> free_lists;
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
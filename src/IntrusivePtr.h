@@ -19,19 +19,59 @@ namespace Internal {
 class RefCount {
     std::atomic<int> count;
 
+    // The top bits of the count are flags, which are masked off of the
+    // values returned below.
+    static constexpr int thread_private_flag = 1 << 30;
+    static constexpr int arena_flag = 1 << 29;
+    static constexpr int count_mask = arena_flag - 1;
+
 public:
     RefCount() noexcept
         : count(0) {
     }
     int increment() {
-        return ++count;
+        int c = count.load(std::memory_order_relaxed);
+        if (c & thread_private_flag) {
+            // Only one thread can reach the object, so there's no need
+            // for an atomic read-modify-write.
+            count.store(c + 1, std::memory_order_relaxed);
+            return (c + 1) & count_mask;
+        }
+        return (++count) & count_mask;
     }  // Increment and return new value
     int decrement() {
-        return --count;
+        int c = count.load(std::memory_order_relaxed);
+        if (c & thread_private_flag) {
+            count.store(c - 1, std::memory_order_relaxed);
+            return (c - 1) & count_mask;
+        }
+        return (--count) & count_mask;
     }  // Decrement and return new value
     bool is_const_zero() const {
-        return count == 0;
+        return (count & count_mask) == 0;
+    }
+
+    /** Flags used by IRArena. Objects marked thread-private have their
+     * count updated non-atomically, so the flag must be cleared before
+     * any other thread can reach the object. */
+    // @{
+    bool is_thread_private() const {
+        return count & thread_private_flag;
     }
+    void set_thread_private(bool p) {
+        if (p) {
+            count |= thread_private_flag;
+        } else {
+            count &= ~thread_private_flag;
+        }
+    }
+    bool is_arena_allocated() const {
+        return count.load(std::memory_order_relaxed) & arena_flag;
+    }
+    void set_arena_allocated() {
+        count |= arena_flag;
+    }
+    // @}
 };
 
 /**
@@ -0,0 +1,296 @@
+#include "JITCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <sstream>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Debug.h"
+#include "Error.h"
+#include "IRPrinter.h"
+#include "Module.h"
+#include "Util.h"
+
+// Set by the build; see src/CMakeLists.txt.
+#ifndef HALIDE_VERSION_MAJOR
+#define HALIDE_VERSION_MAJOR 0
+#define HALIDE_VERSION_MINOR 0
+#define HALIDE_VERSION_PATCH 0
+#endif
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+// Bump this whenever the entry layout or the key material changes.
+constexpr uint32_t kFormatVersion = 1;
+constexpr char kMagic[8] = {'H', 'L', 'J', 'I', 'T', 'C', 'A', 'C'};
+constexpr size_t kKeyLength = 32;
+
+struct EntryHeader {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t key_length;
+    char key[kKeyLength];
+    uint64_t skeleton_size;
+    uint64_t object_size;
+    uint64_t checksum;
+};
+
+// Two unrelated 64-bit hashes, for a 128-bit key.
+struct Hasher {
+    uint64_t a = 0xcbf29ce484222325ULL;
+    uint64_t b = 0x9ae16a3b2f90404fULL;
+
+    void add(const void *data, size_t size) {
+        const uint8_t *p = (const uint8_t *)data;
+        for (size_t i = 0; i < size; i++) {
+            // FNV-1a
+            a = (a ^ p[i]) * 0x100000001b3ULL;
+            // A multiplicative hash with an xorshift to mix the high bits down.
+            b = (b + p[i]) * 0x9e3779b97f4a7c15ULL;
+            b ^= b >> 29;
+        }
+    }
+
+    void add(const std::string &s) {
+        add(s.data(), s.size());
+    }
+
+    std::string hex() const {
+        std::ostringstream s;
+        s << std::hex << std::setfill('0') << std::setw(16) << a << std::setw(16) << b;
+        return s.str();
+    }
+};
+
+uint64_t checksum(const std::vector<char> &a, const std::vector<char> &b) {
+    Hasher h;
+    h.add(a.data(), a.size());
+    h.add(b.data(), b.size());
+    return h.a ^ h.b;
+}
+
+struct CacheState {
+    std::mutex mutex;
+    bool directory_set = false;
+    std::string directory;
+    JITCacheStats stats;
+};
+
+CacheState &cache_state() {
+    static CacheState state;
+    return state;
+}
+
+std::string entry_path(const std::string &dir, const std::string &key) {
+    return dir + "/" + key + ".hljit";
+}
+
+// A name for a temporary file beside an entry that won't collide with
+// one chosen by another thread or another process sharing the cache.
+std::string temp_path(const std::string &path) {
+#ifdef _WIN32
+    const int pid = _getpid();
+#else
+    const int pid = (int)getpid();
+#endif
+    static std::mutex mutex;
+    static std::mt19937_64 rng{((uint64_t)std::random_device()() << 32) ^ std::random_device()()};
+    uint64_t r;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        r = rng();
+    }
+    std::ostringstream s;
+    s << path << "." << pid << "." << std::hex << r << ".tmp";
+    return s.str();
+}
+
+}  // namespace
+
+std::string JITCache::directory() {
+    CacheState &state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.directory_set) {
+        state.directory = get_env_variable("HL_JIT_CACHE_DIR");
+        state.directory_set = true;
+    }
+    return state.directory;
+}
+
+void JITCache::set_directory(const std::string &dir) {
+    CacheState &state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.directory = dir;
+    state.directory_set = true;
+}
+
+std::string JITCache::key(const Module &m) {
+    // Print with enough precision that distinct float constants never
+    // print the same.
+    std::ostringstream s;
+    s << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    s << "format " << kFormatVersion << "\n"
+      << "halide " << HALIDE_VERSION_MAJOR << "." << HALIDE_VERSION_MINOR << "." << HALIDE_VERSION_PATCH << "\n"
+      << "llvm " << LLVM_VERSION << "\n"
+      << "llvm_args " << get_env_variable("HL_LLVM_ARGS") << "\n"
+      << "target " << m.target().to_string() << "\n"
+      << "strict_float " << m.any_strict_float() << "\n";
+
+    // The printed Module omits argument types and alignment, which the
+    // generated code depends on.
+    for (const auto &f : m.functions()) {
+        s << "func " << f.name << " " << (int)f.name_mangling << "\n";
+        for (const auto &arg : f.args) {
+            s << "arg " << arg.name << " " << (int)arg.kind << " " << arg.type
+              << " " << (int)arg.dimensions
+              << " " << arg.alignment.modulus << " " << arg.alignment.remainder << "\n";
+        }
+    }
+    for (const auto &p : m.get_metadata_name_map()) {
+        s << "metadata_name " << p.first << " " << p.second << "\n";
+    }
+    s << m;
+
+    Hasher h;
+    h.add(s.str());
+
+    // Buffer contents and external code aren't printed, so hash them directly.
+    for (const auto &b : m.buffers()) {
+        const halide_buffer_t *raw = b.raw_buffer();
+        if (raw->host) {
+            h.add(raw->host, raw->size_in_bytes());
+        }
+    }
+    for (const auto &code : m.external_code()) {
+        h.add(code.name());
+        h.add(code.contents().data(), code.contents().size());
+    }
+
+    return h.hex();
+}
+
+bool JITCache::lookup(const std::string &key, Entry &entry) {
+    const std::string dir = directory();
+    internal_assert(!dir.empty() && key.size() == kKeyLength);
+    const std::string path = entry_path(dir, key);
+
+    auto count = [](int64_t JITCacheStats::*counter) {
+        CacheState &state = cache_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stats.*counter += 1;
+    };
+
+    std::ifstream f(path, std::ios::in | std::ios::binary);
+    if (!f.is_open()) {
+        debug(2) << "JIT cache miss: " << path << "\n";
+        count(&JITCacheStats::misses);
+        return false;
+    }
+
+    f.seekg(0, std::ios::end);
+    const uint64_t file_size = (uint64_t)f.tellg();
+    f.seekg(0, std::ios::beg);
+
+    EntryHeader header;
+    bool valid = (bool)f.read((char *)&header, sizeof(header)) &&
+                 memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header.format_version == kFormatVersion &&
+                 header.key_length == kKeyLength &&
+                 memcmp(header.key, key.data(), kKeyLength) == 0;
+    // Check the sizes against the file before allocating anything, so
+    // that a truncated or corrupt entry can't ask for a huge buffer.
+    valid = valid &&
+            header.skeleton_size <= file_size - sizeof(header) &&
+            header.object_size == file_size - sizeof(header) - header.skeleton_size;
+    if (valid) {
+        entry.skeleton.resize(header.skeleton_size);
+        entry.object.resize(header.object_size);
+        valid = f.read(entry.skeleton.data(), entry.skeleton.size()) &&
+                f.read(entry.object.data(), entry.object.size()) &&
+                checksum(entry.skeleton, entry.object) == header.checksum;
+    }
+    f.close();
+
+    if (!valid) {
+        debug(1) << "Discarding invalid JIT cache entry: " << path << "\n";
+        file_unlink(path);
+        entry = Entry();
+        count(&JITCacheStats::rejected);
+        count(&JITCacheStats::misses);
+        return false;
+    }
+
+    debug(2) << "JIT cache hit: " << path << "\n";
+    count(&JITCacheStats::hits);
+    return true;
+}
+
+void JITCache::store(const std::string &key, const Entry &entry) {
+    const std::string dir = directory();
+    internal_assert(!dir.empty() && key.size() == kKeyLength);
+    const std::string path = entry_path(dir, key);
+    const std::string tmp_path = temp_path(path);
+
+    EntryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.format_version = kFormatVersion;
+    header.key_length = kKeyLength;
+    memcpy(header.key, key.data(), kKeyLength);
+    header.skeleton_size = entry.skeleton.size();
+    header.object_size = entry.object.size();
+    header.checksum = checksum(entry.skeleton, entry.object);
+
+    std::ofstream f(tmp_path, std::ios::out | std::ios::binary);
+    f.write((const char *)&header, sizeof(header));
+    f.write(entry.skeleton.data(), entry.skeleton.size());
+    f.write(entry.object.data(), entry.object.size());
+    f.close();
+    if (!f.good()) {
+        debug(1) << "Unable to write JIT cache entry: " << tmp_path << "\n";
+        file_unlink(tmp_path);
+        return;
+    }
+
+    // rename() replaces the destination atomically on posix. On Windows
+    // it fails if the destination exists, in which case another process
+    // got there first and its entry is just as good.
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        file_unlink(tmp_path);
+        return;
+    }
+
+    debug(2) << "Wrote JIT cache entry: " << path << "\n";
+    CacheState &state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.stats.stores++;
+}
+
+JITCacheStats JITCache::stats() {
+    CacheState &state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.stats;
+}
+
+void JITCache::reset_stats() {
+    CacheState &state = cache_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.stats = JITCacheStats();
+}
+
+}  // namespace Internal
+}  // namespace Halide
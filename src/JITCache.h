@@ -0,0 +1,90 @@
+#ifndef HALIDE_JIT_CACHE_H
+#define HALIDE_JIT_CACHE_H
+
+/** \file
+ * Defines an optional on-disk cache of JIT-compiled object code.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Halide {
+
+class Module;
+
+namespace Internal {
+
+/** Counters describing what the on-disk JIT cache has done in this
+ * process. */
+struct JITCacheStats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    /** Entries that were found on disk but thrown away because they
+     * were truncated, corrupt, or did not match their key. */
+    int64_t rejected = 0;
+    int64_t stores = 0;
+};
+
+/** A persistent, content-addressed cache of the object code produced
+ * by Pipeline::compile_jit, so that a process which JIT-compiles the
+ * same pipelines as a previous run can skip LLVM code generation.
+ *
+ * The cache is off by default. Setting the environment variable
+ * HL_JIT_CACHE_DIR to a writable directory, or calling set_directory,
+ * turns it on. Each entry is one file in that directory, named by a
+ * 128-bit hash of:
+ * - the lowered Module (its statements, argument types, linkage,
+ *   embedded buffers and external code),
+ * - the Target,
+ * - the Halide and LLVM versions, HL_LLVM_ARGS, and the cache format
+ *   version.
+ *
+ * Anything that changes the generated code changes the key, so stale
+ * entries are never loaded; they are simply not found. An entry that
+ * fails validation when read (bad magic, wrong format version, key
+ * mismatch, truncated, or checksum mismatch) is deleted and treated as
+ * a miss. Entries are written to a temporary file and renamed into
+ * place, so concurrent processes sharing a directory never see a
+ * partial entry. Nothing is ever evicted; the directory can be
+ * cleared at any time.
+ *
+ * Note that the Halide version does not capture local modifications
+ * to Halide itself, so don't point a build of a modified compiler at a
+ * cache populated by another build.
+ */
+class JITCache {
+public:
+    /** The object code for a pipeline, and a serialized empty
+     * llvm::Module carrying the triple, data layout, and target
+     * options it was compiled with. */
+    struct Entry {
+        std::vector<char> object;
+        std::vector<char> skeleton;
+    };
+
+    /** The directory entries are stored in, or the empty string if the
+     * cache is disabled. */
+    static std::string directory();
+
+    /** Override HL_JIT_CACHE_DIR. The empty string disables the cache. */
+    static void set_directory(const std::string &dir);
+
+    /** The key for a lowered Module, as a 32-character hex string. */
+    static std::string key(const Module &m);
+
+    /** Load the entry for a key. Returns false on a miss. */
+    static bool lookup(const std::string &key, Entry &entry);
+
+    /** Write the entry for a key. Failures are logged and otherwise
+     * ignored; the cache is only ever an optimization. */
+    static void store(const std::string &key, const Entry &entry);
+
+    static JITCacheStats stats();
+    static void reset_stats();
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
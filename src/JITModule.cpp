@@ -15,7 +15,9 @@
 
 #include "CodeGen_Internal.h"
 #include "CodeGen_LLVM.h"
+#include "CompileTimeProfiler.h"
 #include "Debug.h"
+#include "JITCache.h"
 #include "JITModule.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
@@ -171,6 +173,19 @@ JITModule::Symbol compile_and_get_function(ExecutionEngine &ee, const string &na
     return symbol;
 }
 
+// Retrieve a function pointer from object code that was added to the
+// execution engine directly, rather than compiled from a module.
+JITModule::Symbol get_loaded_function(ExecutionEngine &ee, const string &name) {
+    void *f = (void *)ee.getFunctionAddress(name);
+    if (!f) {
+        internal_error << "Unable to find " << name << " in cached object code\n";
+    }
+
+    debug(2) << "Function " << name << " is at " << f << "\n";
+
+    return JITModule::Symbol(f);
+}
+
 // Expand LLVM's search for symbols to include code contained in a set of JITModule.
 class HalideJITMemoryManager : public SectionMemoryManager {
     std::vector<JITModule> modules;
@@ -229,14 +244,84 @@ JITModule::JITModule() {
     jit_module = new JITModuleContents();
 }
 
+namespace {
+
+// Captures the object code MCJIT produces, so that it can be written to
+// the on-disk JIT cache.
+class CaptureObjectCode : public llvm::ObjectCache {
+public:
+    std::vector<char> object;
+
+    void notifyObjectCompiled(const llvm::Module *, llvm::MemoryBufferRef obj) override {
+        object.assign(obj.getBufferStart(), obj.getBufferEnd());
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override {
+        return nullptr;
+    }
+};
+
+// An empty module carrying just the triple, data layout, and module
+// flags of m, which is all that is needed to rebuild an execution
+// engine for m's object code.
+std::vector<char> make_skeleton(const llvm::Module &m) {
+    llvm::Module skeleton(m.getModuleIdentifier(), m.getContext());
+    skeleton.setTargetTriple(m.getTargetTriple());
+    skeleton.setDataLayout(m.getDataLayout());
+    llvm::SmallVector<llvm::Module::ModuleFlagEntry, 8> flags;
+    m.getModuleFlagsMetadata(flags);
+    for (const auto &flag : flags) {
+        skeleton.addModuleFlag(flag.Behavior, flag.Key->getString(), flag.Val);
+    }
+
+    llvm::SmallVector<char, 256> buffer;
+    llvm::raw_svector_ostream out(buffer);
+    llvm::WriteBitcodeToFile(skeleton, out);
+    return std::vector<char>(buffer.begin(), buffer.end());
+}
+
+}  // namespace
+
 JITModule::JITModule(const Module &m, const LoweredFunc &fn,
                      const std::vector<JITModule> &dependencies) {
     jit_module = new JITModuleContents();
+
+    std::string cache_key;
+    if (!JITCache::directory().empty()) {
+        cache_key = JITCache::key(m);
+        JITCache::Entry entry;
+        if (JITCache::lookup(cache_key, entry)) {
+            auto skeleton = llvm::parseBitcodeFile(llvm::MemoryBufferRef(llvm::StringRef(entry.skeleton.data(), entry.skeleton.size()), "skeleton"),
+                                                   jit_module->context);
+            if (skeleton) {
+                std::unique_ptr<llvm::Module> llvm_module = std::move(*skeleton);
+                std::vector<JITModule> deps_with_runtime = dependencies;
+                std::vector<JITModule> shared_runtime = JITSharedRuntime::get(llvm_module.get(), m.target());
+                deps_with_runtime.insert(deps_with_runtime.end(), shared_runtime.begin(), shared_runtime.end());
+                compile_module_impl(std::move(llvm_module), fn.name, m.target(), deps_with_runtime, {}, nullptr, &entry.object);
+                return;
+            }
+            // Fall back to compiling from scratch, which overwrites the entry.
+            llvm::consumeError(skeleton.takeError());
+        }
+    }
+
     std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(m, jit_module->context));
     std::vector<JITModule> deps_with_runtime = dependencies;
     std::vector<JITModule> shared_runtime = JITSharedRuntime::get(llvm_module.get(), m.target());
     deps_with_runtime.insert(deps_with_runtime.end(), shared_runtime.begin(), shared_runtime.end());
-    compile_module(std::move(llvm_module), fn.name, m.target(), deps_with_runtime);
+    if (cache_key.empty()) {
+        compile_module(std::move(llvm_module), fn.name, m.target(), deps_with_runtime);
+    } else {
+        JITCache::Entry entry;
+        entry.skeleton = make_skeleton(*llvm_module);
+        CaptureObjectCode capture;
+        compile_module_impl(std::move(llvm_module), fn.name, m.target(), deps_with_runtime, {}, &capture, nullptr);
+        if (!capture.object.empty()) {
+            entry.object = std::move(capture.object);
+            JITCache::store(cache_key, entry);
+        }
+    }
     // If -time-passes is in HL_LLVM_ARGS, this will print llvm passes time statstics otherwise its no-op.
     llvm::reportAndResetTimings();
 }
@@ -244,7 +329,14 @@ JITModule::JITModule(const Module &m, const LoweredFunc &fn,
 void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &function_name, const Target &target,
                                const std::vector<JITModule> &dependencies,
                                const std::vector<std::string> &requested_exports) {
+    compile_module_impl(std::move(m), function_name, target, dependencies, requested_exports, nullptr, nullptr);
+}
 
+void JITModule::compile_module_impl(std::unique_ptr<llvm::Module> m, const string &function_name, const Target &target,
+                                    const std::vector<JITModule> &dependencies,
+                                    const std::vector<std::string> &requested_exports,
+                                    llvm::ObjectCache *object_cache,
+                                    const std::vector<char> *object) {
     // Ensure that LLVM is initialized
     CodeGen_LLVM::initialize_llvm();
 
@@ -261,6 +353,11 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     DataLayout initial_module_data_layout = m->getDataLayout();
     string module_name = m->getModuleIdentifier();
 
+    ScopedCompileTimer timer("jit", object ? "JIT loading cached code" : "JIT code generation", module_name);
+    if (timer.is_active()) {
+        timer.set_size_before(count_llvm_instructions(*m));
+    }
+
     llvm::EngineBuilder engine_builder((std::move(m)));
     engine_builder.setTargetOptions(options);
     engine_builder.setErrorStr(&error_string);
@@ -299,6 +396,22 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
         ee->RegisterJITEventListener(listener);
     }
 
+    if (object_cache) {
+        ee->setObjectCache(object_cache);
+    }
+
+    if (object) {
+        // Load previously generated code from the JIT cache. The module
+        // itself is empty.
+        auto buffer = llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(object->data(), object->size()), module_name);
+        auto obj = llvm::object::ObjectFile::createObjectFile(buffer->getMemBufferRef());
+        if (!obj) {
+            internal_error << "Unable to load cached object code for " << module_name << ": "
+                           << llvm::toString(obj.takeError()) << "\n";
+        }
+        ee->addObjectFile(llvm::object::OwningBinary<llvm::object::ObjectFile>(std::move(*obj), std::move(buffer)));
+    }
+
     // Retrieve function pointers from the compiled module (which also
     // triggers compilation)
     debug(1) << "JIT compiling " << module_name
@@ -308,19 +421,24 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
 
     Symbol entrypoint;
     Symbol argv_entrypoint;
+    auto get_function = [&](const string &name) {
+        return object ? get_loaded_function(*ee, name) : compile_and_get_function(*ee, name);
+    };
     if (!function_name.empty()) {
-        entrypoint = compile_and_get_function(*ee, function_name);
+        entrypoint = get_function(function_name);
         exports[function_name] = entrypoint;
-        argv_entrypoint = compile_and_get_function(*ee, function_name + "_argv");
+        argv_entrypoint = get_function(function_name + "_argv");
         exports[function_name + "_argv"] = argv_entrypoint;
     }
 
     for (const auto &requested_export : requested_exports) {
-        exports[requested_export] = compile_and_get_function(*ee, requested_export);
+        exports[requested_export] = get_function(requested_export);
     }
 
     debug(2) << "Finalizing object\n";
     ee->finalizeObject();
+    // The object cache belongs to the caller.
+    ee->setObjectCache(nullptr);
     // Do any target-specific post-compilation module meddling
     for (auto &listener : listeners) {
         ee->UnregisterJITEventListener(listener);
@@ -451,6 +569,22 @@ void JITModule::memoization_cache_evict(uint64_t eviction_key) const {
     }
 }
 
+void JITModule::memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_get_stats");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(void *, halide_memoization_cache_stats_t *)>(f->second.address))(nullptr, stats);
+    }
+}
+
+void JITModule::memoization_cache_reset_stats() const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_reset_stats");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(void *)>(f->second.address))(nullptr);
+    }
+}
+
 void JITModule::reuse_device_allocations(bool b) const {
     std::map<std::string, Symbol>::const_iterator f =
         exports().find("halide_reuse_device_allocations");
@@ -980,6 +1114,17 @@ void JITSharedRuntime::memoization_cache_evict(uint64_t eviction_key) {
     shared_runtimes(MainShared).memoization_cache_evict(eviction_key);
 }
 
+void JITSharedRuntime::memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    *stats = halide_memoization_cache_stats_t{};
+    shared_runtimes(MainShared).memoization_cache_get_stats(stats);
+}
+
+void JITSharedRuntime::memoization_cache_reset_stats() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    shared_runtimes(MainShared).memoization_cache_reset_stats();
+}
+
 void JITSharedRuntime::reuse_device_allocations(bool b) {
     std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
     shared_runtimes(MainShared).reuse_device_allocations(b);
@@ -15,6 +15,7 @@
 
 namespace llvm {
 class Module;
+class ObjectCache;
 }
 
 namespace Halide {
@@ -242,11 +243,28 @@ struct JITModule {
     /** See JITSharedRuntime::memoization_cache_evict */
     void memoization_cache_evict(uint64_t eviction_key) const;
 
+    /** See JITSharedRuntime::memoization_cache_get_stats */
+    void memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) const;
+
+    /** See JITSharedRuntime::memoization_cache_reset_stats */
+    void memoization_cache_reset_stats() const;
+
     /** See JITSharedRuntime::reuse_device_allocations */
     void reuse_device_allocations(bool) const;
 
     /** Return true if compile_module has been called on this module. */
     bool compiled() const;
+
+private:
+    /** compile_module, optionally handing the generated object code to
+     * an llvm::ObjectCache, or loading previously generated object code
+     * instead of compiling the (then empty) module. See JITCache. */
+    void compile_module_impl(std::unique_ptr<llvm::Module> mod,
+                             const std::string &function_name, const Target &target,
+                             const std::vector<JITModule> &dependencies,
+                             const std::vector<std::string> &requested_exports,
+                             llvm::ObjectCache *object_cache,
+                             const std::vector<char> *object);
 };
 
 class JITSharedRuntime {
@@ -269,6 +287,16 @@ public:
      */
     static void memoization_cache_evict(uint64_t eviction_key);
 
+    /** Retrieve the hit, miss, and eviction counters of the memoization
+     * cache. If you are compiling statically, you should include
+     * HalideRuntime.h and call halide_memoization_cache_get_stats()
+     * instead.
+     */
+    static void memoization_cache_get_stats(halide_memoization_cache_stats_t *stats);
+
+    /** Reset the memoization cache counters to zero. */
+    static void memoization_cache_reset_stats();
+
     /** Set whether or not Halide may hold onto and reuse device
      * allocations to avoid calling expensive device API allocation
      * functions. If you are compiling statically, you should include
@@ -2,6 +2,7 @@
 #include "CodeGen_C.h"
 #include "CodeGen_Internal.h"
 #include "CodeGen_LLVM.h"
+#include "CompileTimeProfiler.h"
 #include "CompilerLogger.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Runtime_Linker.h"
@@ -344,6 +345,10 @@ void emit_file(const llvm::Module &module_in, Internal::LLVMOStream &out,
     Internal::debug(2) << "Target triple: " << module_in.getTargetTriple() << "\n";
 
     auto time_start = std::chrono::high_resolution_clock::now();
+    Internal::ScopedCompileTimer timer("llvm", "LLVM code generation", module_in.getModuleIdentifier());
+    if (timer.is_active()) {
+        timer.set_size_before(Internal::count_llvm_instructions(module_in));
+    }
 
     // Work on a copy of the module to avoid modifying the original.
     std::unique_ptr<llvm::Module> module = clone_module(module_in);
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <sstream>
 
@@ -17,6 +18,7 @@
 #include "CSE.h"
 #include "CanonicalizeGPUVars.h"
 #include "ClampUnsafeAccesses.h"
+#include "CompileTimeProfiler.h"
 #include "CompilerLogger.h"
 #include "Debug.h"
 #include "DebugArguments.h"
@@ -32,6 +34,7 @@
 #include "FuseGPUThreadLoops.h"
 #include "FuzzFloatStores.h"
 #include "HexagonOffload.h"
+#include "IRArena.h"
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
@@ -88,8 +91,36 @@ namespace {
 class LoweringLogger {
     Stmt last_written;
 
+    // When compile-time profiling is on, the time between successive
+    // calls is recorded as a pass, named after the message.
+    string pipeline_name;
+    bool profiling;
+    CompileTimeProfiler::Clock::time_point last_time;
+    int64_t last_node_count = 0;
+
+    static string pass_name(const string &message) {
+        string name = message;
+        const string prefix = "Lowering after ";
+        if (starts_with(name, prefix)) {
+            name = name.substr(prefix.size());
+        }
+        while (!name.empty() && (name.back() == ':' || name.back() == ' ')) {
+            name.pop_back();
+        }
+        return name;
+    }
+
 public:
+    LoweringLogger(const string &pipeline_name)
+        : pipeline_name(pipeline_name),
+          profiling(CompileTimeProfiler::enabled()) {
+        if (profiling) {
+            last_time = CompileTimeProfiler::Clock::now();
+        }
+    }
+
     void operator()(const string &message, const Stmt &s) {
+        profile(message, s);
         if (!s.same_as(last_written)) {
             debug(2) << message << "\n"
                      << s << "\n";
@@ -97,6 +128,31 @@ public:
         } else {
             debug(2) << message << " (unchanged)\n\n";
         }
+        if (profiling) {
+            // Don't charge the printing to the next pass.
+            last_time = CompileTimeProfiler::Clock::now();
+        }
+    }
+
+    /** Record the pass that just ran, without printing anything. */
+    void profile(const string &message, const Stmt &s) {
+        if (profiling) {
+            auto now = CompileTimeProfiler::Clock::now();
+            int64_t node_count = count_ir_nodes(s);
+            CompileTimeProfiler::record("lowering", pass_name(message), pipeline_name,
+                                        last_time, now, last_node_count, node_count);
+            last_node_count = node_count;
+            last_time = CompileTimeProfiler::Clock::now();
+        }
+    }
+
+    /** Record a step that doesn't operate on the Stmt. */
+    void profile(const string &message) {
+        if (profiling) {
+            auto now = CompileTimeProfiler::Clock::now();
+            CompileTimeProfiler::record("lowering", pass_name(message), pipeline_name, last_time, now);
+            last_time = now;
+        }
     }
 };
 
@@ -110,14 +166,18 @@ void lower_impl(const vector<Function> &output_funcs,
                 const vector<IRMutator *> &custom_passes,
                 Module &result_module) {
     auto time_start = std::chrono::high_resolution_clock::now();
+    ScopedCompileTimer timer("lowering", "lower", pipeline_name);
+    LoweringLogger log(pipeline_name);
 
     size_t initial_lowered_function_count = result_module.functions().size();
 
     // Create a deep-copy of the entire graph of Funcs.
     auto [outputs, env] = deep_copy(output_funcs, build_environment(output_funcs));
+    log.profile("Lowering after deep-copying the Funcs");
 
     bool any_strict_float = strictify_float(env, t);
     result_module.set_any_strict_float(any_strict_float);
+    log.profile("Lowering after strictifying floats");
 
     // Output functions should all be computed and stored at root.
     for (const Function &f : outputs) {
@@ -131,16 +191,17 @@ void lower_impl(const vector<Function> &output_funcs,
 
     // Substitute in wrapper Funcs
     env = wrap_func_calls(env);
+    log.profile("Lowering after wrapping calls");
 
     // Compute a realization order and determine group of functions which loops
     // are to be fused together
     auto [order, fused_groups] = realization_order(outputs, env);
+    log.profile("Lowering after computing the realization order");
 
     // Try to simplify the RHS/LHS of a function definition by propagating its
     // specializations' conditions
     simplify_specializations(env);
-
-    LoweringLogger log;
+    log.profile("Lowering after simplifying specializations");
 
     debug(1) << "Creating initial loop nests...\n";
     bool any_memoized = false;
@@ -166,6 +227,7 @@ void lower_impl(const vector<Function> &output_funcs,
     // function. Used in later bounds inference passes.
     debug(1) << "Computing bounds of each function's value\n";
     FuncValueBounds func_bounds = compute_function_value_bounds(order, env);
+    log.profile("Lowering after computing bounds of each function's value");
 
     // Clamp unsafe instances where a Func f accesses a Func g using
     // an index which depends on a third Func h.
@@ -342,8 +404,7 @@ void lower_impl(const vector<Function> &output_funcs,
 
     debug(1) << "Rebasing loops to zero...\n";
     s = rebase_loops_to_zero(s);
-    debug(2) << "Lowering after rebasing loops to zero:\n"
-             << s << "\n\n";
+    log("Lowering after rebasing loops to zero:", s);
 
     debug(1) << "Hoisting loop invariant if statements...\n";
     s = hoist_loop_invariant_if_statements(s);
@@ -381,6 +442,7 @@ void lower_impl(const vector<Function> &output_funcs,
 
     debug(1) << "Simplifying...\n";
     s = common_subexpression_elimination(s);
+    log("Lowering after common subexpression elimination:", s);
 
     debug(1) << "Lowering unsafe promises...\n";
     s = lower_unsafe_promises(s, t);
@@ -420,6 +482,7 @@ void lower_impl(const vector<Function> &output_funcs,
         for (size_t i = 0; i < custom_passes.size(); i++) {
             debug(1) << "Running custom lowering pass " << i << "...\n";
             s = custom_passes[i]->mutate(s);
+            log.profile("Lowering after custom pass " + std::to_string(i), s);
             debug(1) << "Lowering after custom pass " << i << ":\n"
                      << s << "\n\n";
         }
@@ -428,6 +491,7 @@ void lower_impl(const vector<Function> &output_funcs,
     if (t.arch != Target::Hexagon && t.has_feature(Target::HVX)) {
         debug(1) << "Splitting off Hexagon offload...\n";
         s = inject_hexagon_rpc(s, t, result_module);
+        log.profile("Lowering after splitting off Hexagon offload", s);
         debug(2) << "Lowering after splitting off Hexagon offload:\n"
                  << s << "\n";
     } else {
@@ -437,6 +501,7 @@ void lower_impl(const vector<Function> &output_funcs,
     if (t.has_gpu_feature()) {
         debug(1) << "Offloading GPU loops...\n";
         s = inject_gpu_offload(s, t);
+        log.profile("Lowering after splitting off GPU loops", s);
         debug(2) << "Lowering after splitting off GPU loops:\n"
                  << s << "\n\n";
     } else {
@@ -451,6 +516,7 @@ void lower_impl(const vector<Function> &output_funcs,
     // problem. It would be better if closures could directly reference globals
     // so they don't add overhead to the closure.
     vector<InferredArgument> inferred_args = infer_arguments(s, outputs);
+    log.profile("Lowering after inferring arguments");
 
     std::vector<LoweredFunc> closure_implementations;
     debug(1) << "Lowering Parallel Tasks...\n";
@@ -468,6 +534,7 @@ void lower_impl(const vector<Function> &output_funcs,
     for (auto &lowered_func : closure_implementations) {
         result_module.append(lowered_func);
     }
+    log.profile("Lowering after generating parallel tasks and closures", s);
     debug(2) << "Lowering after generating parallel tasks and closures:\n"
              << s << "\n\n";
 
@@ -543,6 +610,7 @@ void lower_impl(const vector<Function> &output_funcs,
         }
     };
     s = StrengthenRefs().mutate(s);
+    log.profile("Lowering after strengthening function references", s);
 
     LoweredFunc main_func(pipeline_name, public_args, s, linkage_type);
 
@@ -572,9 +640,18 @@ Module lower(const vector<Function> &output_funcs,
              bool trace_pipeline,
              const vector<IRMutator *> &custom_passes) {
     Module result_module{strip_namespaces(pipeline_name), t};
-    run_with_large_stack([&]() {
-        lower_impl(output_funcs, pipeline_name, t, args, linkage_type, requirements, trace_pipeline, custom_passes, result_module);
-    });
+    {
+        // Lowering makes and discards a great many IR nodes, which an
+        // arena makes cheaper. The nodes that survive into the module
+        // are released from it when it closes.
+        std::unique_ptr<IRArena> arena;
+        if (IRArena::mode() != IRArena::Mode::Off) {
+            arena = std::make_unique<IRArena>(IRArena::mode() == IRArena::Mode::ThreadPrivate);
+        }
+        run_with_large_stack([&]() {
+            lower_impl(output_funcs, pipeline_name, t, args, linkage_type, requirements, trace_pipeline, custom_passes, result_module);
+        });
+    }
     return result_module;
 }
 
@@ -1,6 +1,8 @@
 #include "Module.h"
 
+#include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <fstream>
 #include <future>
 #include <memory>
@@ -12,6 +14,7 @@
 #include "CompilerLogger.h"
 #include "Debug.h"
 #include "HexagonOffload.h"
+#include "IRArena.h"
 #include "IROperator.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
@@ -19,6 +22,7 @@
 #include "Pipeline.h"
 #include "PythonExtensionGen.h"
 #include "StmtToHtml.h"
+#include "ThreadPool.h"
 
 using Halide::Internal::debug;
 
@@ -752,7 +756,8 @@ void compile_multitarget(const std::string &fn_name,
                          const std::vector<Target> &targets,
                          const std::vector<std::string> &suffixes,
                          const ModuleFactory &module_factory,
-                         const CompilerLoggerFactory &compiler_logger_factory) {
+                         const CompilerLoggerFactory &compiler_logger_factory,
+                         int num_threads) {
     validate_outputs(output_files);
 
     user_assert(!fn_name.empty()) << "Function name must be specified.\n";
@@ -829,9 +834,13 @@ void compile_multitarget(const std::string &fn_name,
 
     TemporaryObjectFileDir temp_obj_dir, temp_compiler_log_dir;
     std::vector<Expr> wrapper_args;
-    std::vector<LoweredArgument> base_target_args;
-    std::vector<AutoSchedulerResults> auto_scheduler_results;
+    std::vector<std::map<OutputFileType, std::string>> sub_outs(targets.size());
+    std::vector<std::string> sub_fn_names(targets.size());
 
+    // Check the targets and work out everything that doesn't require
+    // compiling anything first. Temporary files are created in target
+    // order here, so that the contents of the static library don't
+    // depend on the order the compilation jobs below finish in.
     for (size_t i = 0; i < targets.size(); ++i) {
         const Target &target = targets[i];
 
@@ -863,33 +872,20 @@ void compile_multitarget(const std::string &fn_name,
         // Each sub-target has a function name that is the 'real' name plus a suffix
         std::string suffix = suffix_for_entry(i);
         std::string sub_fn_name = needs_wrapper ? (fn_name + suffix) : fn_name;
+        sub_fn_names[i] = sub_fn_name;
 
-        // We always produce the runtime separately, so add NoRuntime explicitly.
-        Target sub_fn_target = target.with_feature(Target::NoRuntime);
-
-        {
-            ScopedCompilerLogger activate(compiler_logger_factory, sub_fn_name, sub_fn_target);
-            Module sub_module = module_factory(sub_fn_name, sub_fn_target);
-            // Re-assign every time -- should be the same across all targets anyway,
-            // but base_target is always the last one we encounter.
-            base_target_args = sub_module.get_function_by_name(sub_fn_name).args;
-
-            auto sub_out = add_suffixes(output_files, suffix);
-            if (contains(output_files, OutputFileType::static_library)) {
-                sub_out[OutputFileType::object] = temp_obj_dir.add_temp_object_file(output_files.at(OutputFileType::static_library), suffix, target);
-                sub_out.erase(OutputFileType::static_library);
-            }
-            sub_out.erase(OutputFileType::registration);
-            sub_out.erase(OutputFileType::schedule);
-            sub_out.erase(OutputFileType::c_header);
-            if (contains(sub_out, OutputFileType::compiler_log)) {
-                sub_out[OutputFileType::compiler_log] = temp_compiler_log_dir.add_temp_file(output_files.at(OutputFileType::compiler_log), suffix, target);
-            }
-            debug(1) << "compile_multitarget: compile_sub_target " << sub_out[OutputFileType::object] << "\n";
-            sub_module.compile(sub_out);
-            const auto *r = sub_module.get_auto_scheduler_results();
-            auto_scheduler_results.push_back(r ? *r : AutoSchedulerResults());
+        auto sub_out = add_suffixes(output_files, suffix);
+        if (contains(output_files, OutputFileType::static_library)) {
+            sub_out[OutputFileType::object] = temp_obj_dir.add_temp_object_file(output_files.at(OutputFileType::static_library), suffix, target);
+            sub_out.erase(OutputFileType::static_library);
         }
+        sub_out.erase(OutputFileType::registration);
+        sub_out.erase(OutputFileType::schedule);
+        sub_out.erase(OutputFileType::c_header);
+        if (contains(sub_out, OutputFileType::compiler_log)) {
+            sub_out[OutputFileType::compiler_log] = temp_compiler_log_dir.add_temp_file(output_files.at(OutputFileType::compiler_log), suffix, target);
+        }
+        sub_outs[i] = std::move(sub_out);
 
         uint64_t cur_target_features[kFeaturesWordCount] = {0};
         for (int i = 0; i < Target::FeatureEnd; ++i) {
@@ -921,9 +917,11 @@ void compile_multitarget(const std::string &fn_name,
 
     // If we haven't specified "no runtime", build a runtime with the base target
     // and add that to the result.
+    Target runtime_target;
+    std::string runtime_path;
     if (!base_target.has_feature(Target::NoRuntime)) {
         // Start with a bare Target, set only the features we know are common to all.
-        Target runtime_target(base_target.os, base_target.arch, base_target.bits, base_target.processor_tune);
+        runtime_target = Target(base_target.os, base_target.arch, base_target.bits, base_target.processor_tune);
         for (int i = 0; i < Target::FeatureEnd; ++i) {
             // We never want NoRuntime set here.
             if (i == Target::NoRuntime) {
@@ -935,16 +933,95 @@ void compile_multitarget(const std::string &fn_name,
                 runtime_target.set_feature((Target::Feature)i);
             }
         }
-        std::string runtime_path = contains(output_files, OutputFileType::static_library) ?
-                                       temp_obj_dir.add_temp_object_file(output_files.at(OutputFileType::static_library), "_runtime", runtime_target) :
-                                       add_suffix(output_files.at(OutputFileType::object), "_runtime");
+        runtime_path = contains(output_files, OutputFileType::static_library) ?
+                           temp_obj_dir.add_temp_object_file(output_files.at(OutputFileType::static_library), "_runtime", runtime_target) :
+                           add_suffix(output_files.at(OutputFileType::object), "_runtime");
+    }
+
+    std::vector<std::vector<LoweredArgument>> sub_fn_args(targets.size());
+    std::vector<AutoSchedulerResults> auto_scheduler_results(targets.size());
+
+    // Every job starts from the same unique_name state, so the code
+    // generated for it doesn't depend on how many threads are used or
+    // what order they run in. Afterwards, this thread's counters are
+    // advanced past the names used by all of them.
+    const Internal::UniqueNameCounters name_counters = Internal::UniqueNameCounters::snapshot();
+    std::vector<Internal::UniqueNameCounters> final_name_counters(targets.size() + 1);
+
+    const auto compile_sub_target = [&](size_t i) {
+        Internal::ScopedUniqueNameCounters scoped_names(name_counters);
+
+        // We always produce the runtime separately, so add NoRuntime explicitly.
+        Target sub_fn_target = targets[i].with_feature(Target::NoRuntime);
+
+        ScopedCompilerLogger activate(compiler_logger_factory, sub_fn_names[i], sub_fn_target);
+        Module sub_module = module_factory(sub_fn_names[i], sub_fn_target);
+        sub_fn_args[i] = sub_module.get_function_by_name(sub_fn_names[i]).args;
+
+        debug(1) << "compile_multitarget: compile_sub_target " << sub_outs[i][OutputFileType::object] << "\n";
+        sub_module.compile(sub_outs[i]);
+        const auto *r = sub_module.get_auto_scheduler_results();
+        auto_scheduler_results[i] = r ? *r : AutoSchedulerResults();
+        final_name_counters[i] = scoped_names.counters();
+    };
 
+    const auto compile_runtime = [&]() {
+        Internal::ScopedUniqueNameCounters scoped_names(name_counters);
         std::map<OutputFileType, std::string> runtime_out =
             {{OutputFileType::object, runtime_path}};
         debug(1) << "compile_multitarget: compile_standalone_runtime " << runtime_out.at(OutputFileType::object) << "\n";
         compile_standalone_runtime(runtime_out, runtime_target);
+        final_name_counters.back() = scoped_names.counters();
+    };
+
+    const size_t num_jobs = targets.size() + (runtime_path.empty() ? 0 : 1);
+    if (num_threads == 0) {
+        std::string env = get_env_variable("HL_COMPILE_THREADS");
+        num_threads = env.empty() ? (int)Internal::ThreadPool<void>::num_processors_online() : std::atoi(env.c_str());
+    }
+    num_threads = std::max(1, std::min(num_threads, (int)num_jobs));
+
+    if (num_threads == 1) {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            compile_sub_target(i);
+        }
+        if (!runtime_path.empty()) {
+            compile_runtime();
+        }
+    } else {
+        debug(1) << "compile_multitarget: compiling " << num_jobs << " modules using " << num_threads << " threads\n";
+        std::vector<std::future<void>> jobs;
+        {
+            // Lowering on the pool's threads can't use thread-private
+            // IR arenas.
+            Internal::IRArena::ConcurrentCompilation concurrent;
+            Internal::ThreadPool<void> pool(num_threads);
+            // The runtime is usually the slowest to compile, so start it first.
+            if (!runtime_path.empty()) {
+                jobs.push_back(pool.async(compile_runtime));
+            }
+            for (size_t i = 0; i < targets.size(); ++i) {
+                jobs.push_back(pool.async(compile_sub_target, i));
+            }
+            // Wait for everything before letting any error escape, as the
+            // jobs refer to locals of this function.
+            for (auto &job : jobs) {
+                job.wait();
+            }
+        }
+        for (auto &job : jobs) {
+            job.get();
+        }
+    }
+    for (const auto &c : final_name_counters) {
+        if (!c.counts.empty()) {
+            Internal::UniqueNameCounters::advance_past(c);
+        }
     }
 
+    // base_target is always the last one.
+    const std::vector<LoweredArgument> &base_target_args = sub_fn_args.back();
+
     if (needs_wrapper) {
         Expr indirect_result = Call::make(Int(32), Call::call_cached_indirect_function, wrapper_args, Call::Intrinsic);
         std::string private_result_name = unique_name(fn_name + "_result");
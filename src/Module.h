@@ -221,12 +221,23 @@ std::map<OutputFileType, std::string> compile_standalone_runtime(const std::map<
 using ModuleFactory = std::function<Module(const std::string &fn_name, const Target &target)>;
 using CompilerLoggerFactory = std::function<std::unique_ptr<Internal::CompilerLogger>(const std::string &fn_name, const Target &target)>;
 
+/** Compile a pipeline for several Targets, along with a wrapper that
+ * selects between them at runtime.
+ *
+ * num_threads is the maximum number of Targets to compile at once; 0
+ * means the value of the environment variable HL_COMPILE_THREADS if it
+ * is set, or the number of cores otherwise. The outputs are the same
+ * whatever the number of threads. With more than one thread,
+ * module_factory and compiler_logger_factory are called concurrently
+ * from several threads, so they must not share mutable state; for
+ * example, they must not compile the same Pipeline object. */
 void compile_multitarget(const std::string &fn_name,
                          const std::map<OutputFileType, std::string> &output_files,
                          const std::vector<Target> &targets,
                          const std::vector<std::string> &suffixes,
                          const ModuleFactory &module_factory,
-                         const CompilerLoggerFactory &compiler_logger_factory = nullptr);
+                         const CompilerLoggerFactory &compiler_logger_factory = nullptr,
+                         int num_threads = 1);
 
 }  // namespace Halide
 
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <atomic>
+#include <mutex>
 #include <utility>
 
 #include "Argument.h"
@@ -187,6 +188,9 @@ std::map<std::string, AutoSchedulerFn> &Pipeline::get_autoscheduler_map() {
 /* static */
 std::string &Pipeline::get_default_autoscheduler_name() {
     static std::string autoscheduler_name = "";
+    // compile_multitarget may get here from several threads at once.
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
     if (autoscheduler_name.empty() && !get_autoscheduler_map().empty()) {
         autoscheduler_name = get_autoscheduler_map().begin()->first;
     }
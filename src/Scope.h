@@ -1,15 +1,19 @@
 #ifndef HALIDE_SCOPE_H
 #define HALIDE_SCOPE_H
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <stack>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "Debug.h"
 #include "Error.h"
+#include "Symbol.h"
 
 /** \file
  * Defines the Scope class, which is used for keeping track of names in a scope while traversing IR
@@ -89,11 +93,23 @@ public:
 /** A common pattern when traversing Halide IR is that you need to
  * keep track of stuff when you find a Let or a LetStmt, and that it
  * should hide previous values with the same name until you leave the
- * Let or LetStmt nodes This class helps with that. */
+ * Let or LetStmt nodes This class helps with that.
+ *
+ * Names are held as Symbols, so lookups by the Symbol of an IR node
+ * do no string hashing or comparison. push interns a string name;
+ * the other methods that take a string only look it up, as a name
+ * that was never interned cannot be in any Scope. */
 template<typename T = void>
 class Scope {
 private:
-    std::map<std::string, SmallStack<T>> table;
+    using Table = std::unordered_map<Symbol, SmallStack<T>>;
+    Table table;
+
+    using Order = std::vector<const typename Table::value_type *>;
+    // The entries of the table sorted by name, built on the first
+    // iteration after a name is added or removed. Pushing or popping a
+    // name that stays in scope leaves it valid.
+    mutable std::shared_ptr<const Order> sorted;
 
     const Scope<T> *containing_scope = nullptr;
 
@@ -102,8 +118,8 @@ public:
     Scope(Scope &&that) noexcept = default;
     Scope &operator=(Scope &&that) noexcept = default;
 
-    // Copying a scope object copies a large table full of strings and
-    // stacks. Bad idea.
+    // Copying a scope object copies a large table full of stacks. Bad
+    // idea.
     Scope(const Scope<T> &) = delete;
     Scope<T> &operator=(const Scope<T> &) = delete;
 
@@ -125,8 +141,8 @@ public:
     /** Retrieve the value referred to by a name */
     template<typename T2 = T,
              typename = typename std::enable_if<!std::is_same<T2, void>::value>::type>
-    T2 get(const std::string &name) const {
-        typename std::map<std::string, SmallStack<T>>::const_iterator iter = table.find(name);
+    T2 get(Symbol name) const {
+        typename Table::const_iterator iter = table.find(name);
         if (iter == table.end() || iter->second.empty()) {
             if (containing_scope) {
                 return containing_scope->get(name);
@@ -138,11 +154,22 @@ public:
         return iter->second.top();
     }
 
+    template<typename T2 = T,
+             typename = typename std::enable_if<!std::is_same<T2, void>::value>::type>
+    T2 get(const std::string &name) const {
+        Symbol sym;
+        if (!Symbol::find(name, &sym)) {
+            internal_error << "Name not in Scope: " << name << "\n"
+                           << *this << "\n";
+        }
+        return get(sym);
+    }
+
     /** Return a reference to an entry. Does not consider the containing scope. */
     template<typename T2 = T,
              typename = typename std::enable_if<!std::is_same<T2, void>::value>::type>
-    T2 &ref(const std::string &name) {
-        typename std::map<std::string, SmallStack<T>>::iterator iter = table.find(name);
+    T2 &ref(Symbol name) {
+        typename Table::iterator iter = table.find(name);
         if (iter == table.end() || iter->second.empty()) {
             internal_error << "Name not in Scope: " << name << "\n"
                            << *this << "\n";
@@ -150,9 +177,20 @@ public:
         return iter->second.top_ref();
     }
 
+    template<typename T2 = T,
+             typename = typename std::enable_if<!std::is_same<T2, void>::value>::type>
+    T2 &ref(const std::string &name) {
+        Symbol sym;
+        if (!Symbol::find(name, &sym)) {
+            internal_error << "Name not in Scope: " << name << "\n"
+                           << *this << "\n";
+        }
+        return ref(sym);
+    }
+
     /** Tests if a name is in scope */
-    bool contains(const std::string &name) const {
-        typename std::map<std::string, SmallStack<T>>::const_iterator iter = table.find(name);
+    bool contains(Symbol name) const {
+        typename Table::const_iterator iter = table.find(name);
         if (iter == table.end() || iter->second.empty()) {
             if (containing_scope) {
                 return containing_scope->contains(name);
@@ -163,8 +201,13 @@ public:
         return true;
     }
 
+    bool contains(const std::string &name) const {
+        Symbol sym;
+        return Symbol::find(name, &sym) && contains(sym);
+    }
+
     /** How many nested definitions of a single name exist? */
-    size_t count(const std::string &name) const {
+    size_t count(Symbol name) const {
         auto it = table.find(name);
         if (it == table.end()) {
             return 0;
@@ -173,78 +216,142 @@ public:
         }
     }
 
+    size_t count(const std::string &name) const {
+        Symbol sym;
+        return Symbol::find(name, &sym) ? count(sym) : 0;
+    }
+
     /** Add a new (name, value) pair to the current scope. Hide old
      * values that have this name until we pop this name.
      */
+    template<typename T2 = T,
+             typename = typename std::enable_if<!std::is_same<T2, void>::value>::type>
+    void push(Symbol name, T2 &&value) {
+        SmallStack<T> &stack = table[name];
+        if (stack.empty()) {
+            sorted.reset();
+        }
+        stack.push(std::forward<T2>(value));
+    }
+
     template<typename T2 = T,
              typename = typename std::enable_if<!std::is_same<T2, void>::value>::type>
     void push(const std::string &name, T2 &&value) {
-        table[name].push(std::forward<T2>(value));
+        push(Symbol(name), std::forward<T2>(value));
+    }
+
+    template<typename T2 = T,
+             typename = typename std::enable_if<std::is_same<T2, void>::value>::type>
+    void push(Symbol name) {
+        SmallStack<T> &stack = table[name];
+        if (stack.empty()) {
+            sorted.reset();
+        }
+        stack.push();
     }
 
     template<typename T2 = T,
              typename = typename std::enable_if<std::is_same<T2, void>::value>::type>
     void push(const std::string &name) {
-        table[name].push();
+        push(Symbol(name));
     }
 
     /** A name goes out of scope. Restore whatever its old value
      * was (or remove it entirely if there was nothing else of the
      * same name in an outer scope) */
-    void pop(const std::string &name) {
-        typename std::map<std::string, SmallStack<T>>::iterator iter = table.find(name);
+    void pop(Symbol name) {
+        typename Table::iterator iter = table.find(name);
         internal_assert(iter != table.end()) << "Name not in Scope: " << name << "\n"
                                              << *this << "\n";
         iter->second.pop();
         if (iter->second.empty()) {
             table.erase(iter);
+            sorted.reset();
         }
     }
 
-    /** Iterate through the scope. Does not capture any containing scope. */
+    void pop(const std::string &name) {
+        Symbol sym;
+        internal_assert(Symbol::find(name, &sym)) << "Name not in Scope: " << name << "\n"
+                                                  << *this << "\n";
+        pop(sym);
+    }
+
+    /** Iterate through the scope in order of name, so that passes
+     * that iterate over a scope behave deterministically. Does not
+     * capture any containing scope. */
     class const_iterator {
-        typename std::map<std::string, SmallStack<T>>::const_iterator iter;
+        std::shared_ptr<const Order> order;
+        size_t i = 0;
+
+        bool at_end() const {
+            return !order || i >= order->size();
+        }
 
     public:
-        explicit const_iterator(const typename std::map<std::string, SmallStack<T>>::const_iterator &i)
-            : iter(i) {
+        explicit const_iterator(std::shared_ptr<const Order> o)
+            : order(std::move(o)) {
         }
 
         const_iterator() = default;
 
         bool operator!=(const const_iterator &other) {
-            return iter != other.iter;
+            if (at_end() || other.at_end()) {
+                return at_end() != other.at_end();
+            }
+            return (*order)[i] != (*other.order)[other.i];
         }
 
         void operator++() {
-            ++iter;
+            ++i;
         }
 
         const std::string &name() {
-            return iter->first;
+            return (*order)[i]->first.str();
         }
 
         const SmallStack<T> &stack() {
-            return iter->second;
+            return (*order)[i]->second;
         }
 
         template<typename T2 = T,
                  typename = typename std::enable_if<!std::is_same<T2, void>::value>::type>
         const T2 &value() {
-            return iter->second.top_ref();
+            return (*order)[i]->second.top_ref();
         }
     };
 
     const_iterator cbegin() const {
-        return const_iterator(table.begin());
+        if (table.empty()) {
+            // Don't touch the cache, so that iterating over a shared
+            // empty scope (e.g. empty_scope()) writes nothing.
+            return const_iterator();
+        }
+        if (!sorted) {
+            auto order = std::make_shared<Order>();
+            order->reserve(table.size());
+            // Point to the entries rather than holding iterators, as
+            // iterators into an unordered_map are invalidated when an
+            // insertion rehashes it.
+            for (const auto &entry : table) {
+                order->push_back(&entry);
+            }
+            std::sort(order->begin(), order->end(),
+                      [](const typename Table::value_type *a, const typename Table::value_type *b) {
+                          return a->first.str() < b->first.str();
+                      });
+            sorted = std::move(order);
+        }
+        return const_iterator(sorted);
     }
 
     const_iterator cend() const {
-        return const_iterator(table.end());
+        return const_iterator();
     }
 
     void swap(Scope<T> &other) {
         table.swap(other.table);
+        sorted.swap(other.sorted);
         std::swap(containing_scope, other.containing_scope);
     }
 };
@@ -271,10 +378,15 @@ std::ostream &operator<<(std::ostream &stream, const Scope<T> &s) {
 template<typename T = void>
 struct ScopedBinding {
     Scope<T> *scope = nullptr;
-    std::string name;
+    Symbol name;
 
     ScopedBinding() = default;
 
+    ScopedBinding(Scope<T> &s, Symbol n, T value)
+        : scope(&s), name(n) {
+        scope->push(name, std::move(value));
+    }
+
     ScopedBinding(Scope<T> &s, const std::string &n, T value)
         : scope(&s), name(n) {
         scope->push(name, std::move(value));
@@ -301,7 +413,7 @@ struct ScopedBinding {
     ScopedBinding(const ScopedBinding &that) = delete;
     ScopedBinding(ScopedBinding &&that) noexcept
         : scope(that.scope),
-          name(std::move(that.name)) {
+          name(that.name) {
         // The move constructor must null out scope, so we don't try to pop it
         that.scope = nullptr;
     }
@@ -313,7 +425,11 @@ struct ScopedBinding {
 template<>
 struct ScopedBinding<void> {
     Scope<> *scope;
-    std::string name;
+    Symbol name;
+    ScopedBinding(Scope<> &s, Symbol n)
+        : scope(&s), name(n) {
+        scope->push(name);
+    }
     ScopedBinding(Scope<> &s, const std::string &n)
         : scope(&s), name(n) {
         scope->push(name);
@@ -334,7 +450,7 @@ struct ScopedBinding<void> {
     ScopedBinding(const ScopedBinding &that) = delete;
     ScopedBinding(ScopedBinding &&that) noexcept
         : scope(that.scope),
-          name(std::move(that.name)) {
+          name(that.name) {
         // The move constructor must null out scope, so we don't try to pop it
         that.scope = nullptr;
     }
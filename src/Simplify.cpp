@@ -22,6 +22,10 @@ int Simplify::debug_indent = 0;
 Simplify::Simplify(bool r, const Scope<Interval> *bi, const Scope<ModulusRemainder> *ai)
     : remove_dead_code(r), no_float_simplify(false) {
 
+    if (simplify_memoization_enabled()) {
+        memo = std::make_unique<Memo>();
+    }
+
     // Only respect the constant bounds from the containing scope.
     for (auto iter = bi->cbegin(); iter != bi->cend(); ++iter) {
         ExprInfo bounds;
@@ -73,19 +77,23 @@ std::pair<std::vector<Expr>, bool> Simplify::mutate_with_changes(const std::vect
 
 void Simplify::found_buffer_reference(const string &name, size_t dimensions) {
     for (size_t i = 0; i < dimensions; i++) {
-        string stride = name + ".stride." + std::to_string(i);
+        Symbol stride(name + ".stride." + std::to_string(i));
         if (var_info.contains(stride)) {
             var_info.ref(stride).old_uses++;
+            note_use(stride, false);
         }
 
-        string min = name + ".min." + std::to_string(i);
+        Symbol min(name + ".min." + std::to_string(i));
         if (var_info.contains(min)) {
             var_info.ref(min).old_uses++;
+            note_use(min, false);
         }
     }
 
-    if (var_info.contains(name)) {
-        var_info.ref(name).old_uses++;
+    Symbol sym(name);
+    if (var_info.contains(sym)) {
+        var_info.ref(sym).old_uses++;
+        note_use(sym, false);
     }
 }
 
@@ -121,13 +129,15 @@ void Simplify::ScopedFact::learn_false(const Expr &fact) {
     info.old_uses = info.new_uses = 0;
     if (const Variable *v = fact.as<Variable>()) {
         info.replacement = const_false(fact.type().lanes());
-        simplify->var_info.push(v->name, info);
+        simplify->var_info.push(v->symbol(), info);
+        simplify->facts_changed();
         pop_list.push_back(v);
     } else if (const NE *ne = fact.as<NE>()) {
         const Variable *v = ne->a.as<Variable>();
         if (v && is_const(ne->b)) {
             info.replacement = ne->b;
-            simplify->var_info.push(v->name, info);
+            simplify->var_info.push(v->symbol(), info);
+            simplify->facts_changed();
             pop_list.push_back(v);
         }
     } else if (const LT *lt = fact.as<LT>()) {
@@ -179,6 +189,7 @@ void Simplify::ScopedFact::learn_false(const Expr &fact) {
         return;
     }
     if (simplify->falsehoods.insert(fact).second) {
+        simplify->facts_changed();
         falsehoods.push_back(fact);
     }
 }
@@ -187,10 +198,11 @@ void Simplify::ScopedFact::learn_upper_bound(const Variable *v, int64_t val) {
     ExprInfo b;
     b.max_defined = true;
     b.max = val;
-    if (simplify->bounds_and_alignment_info.contains(v->name)) {
-        b.intersect(simplify->bounds_and_alignment_info.get(v->name));
+    if (simplify->bounds_and_alignment_info.contains(v->symbol())) {
+        b.intersect(simplify->bounds_and_alignment_info.get(v->symbol()));
     }
-    simplify->bounds_and_alignment_info.push(v->name, b);
+    simplify->bounds_and_alignment_info.push(v->symbol(), b);
+    simplify->facts_changed();
     bounds_pop_list.push_back(v);
 }
 
@@ -198,10 +210,11 @@ void Simplify::ScopedFact::learn_lower_bound(const Variable *v, int64_t val) {
     ExprInfo b;
     b.min_defined = true;
     b.min = val;
-    if (simplify->bounds_and_alignment_info.contains(v->name)) {
-        b.intersect(simplify->bounds_and_alignment_info.get(v->name));
+    if (simplify->bounds_and_alignment_info.contains(v->symbol())) {
+        b.intersect(simplify->bounds_and_alignment_info.get(v->symbol()));
     }
-    simplify->bounds_and_alignment_info.push(v->name, b);
+    simplify->bounds_and_alignment_info.push(v->symbol(), b);
+    simplify->facts_changed();
     bounds_pop_list.push_back(v);
 }
 
@@ -210,7 +223,8 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
     info.old_uses = info.new_uses = 0;
     if (const Variable *v = fact.as<Variable>()) {
         info.replacement = const_true(fact.type().lanes());
-        simplify->var_info.push(v->name, info);
+        simplify->var_info.push(v->symbol(), info);
+        simplify->facts_changed();
         pop_list.push_back(v);
     } else if (const EQ *eq = fact.as<EQ>()) {
         const Variable *v = eq->a.as<Variable>();
@@ -221,19 +235,21 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
             if (is_const(eq->b) || eq->b.as<Variable>()) {
                 // TODO: consider other cases where we might want to entirely substitute
                 info.replacement = eq->b;
-                simplify->var_info.push(v->name, info);
+                simplify->var_info.push(v->symbol(), info);
+                simplify->facts_changed();
                 pop_list.push_back(v);
             } else if (v->type.is_int()) {
                 // Visit the rhs again to get bounds and alignment info to propagate to the LHS
                 // TODO: Visiting it again is inefficient
                 Simplify::ExprInfo expr_info;
                 simplify->mutate(eq->b, &expr_info);
-                if (simplify->bounds_and_alignment_info.contains(v->name)) {
+                if (simplify->bounds_and_alignment_info.contains(v->symbol())) {
                     // We already know something about this variable and don't want to suppress it.
-                    auto existing_knowledge = simplify->bounds_and_alignment_info.get(v->name);
+                    auto existing_knowledge = simplify->bounds_and_alignment_info.get(v->symbol());
                     expr_info.intersect(existing_knowledge);
                 }
-                simplify->bounds_and_alignment_info.push(v->name, expr_info);
+                simplify->bounds_and_alignment_info.push(v->symbol(), expr_info);
+                simplify->facts_changed();
                 bounds_pop_list.push_back(v);
             }
         } else if (const Variable *vb = eq->b.as<Variable>()) {
@@ -245,24 +261,26 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
             // TODO: Visiting it again is inefficient
             Simplify::ExprInfo expr_info;
             simplify->mutate(eq->a, &expr_info);
-            if (simplify->bounds_and_alignment_info.contains(vb->name)) {
+            if (simplify->bounds_and_alignment_info.contains(vb->symbol())) {
                 // We already know something about this variable and don't want to suppress it.
-                auto existing_knowledge = simplify->bounds_and_alignment_info.get(vb->name);
+                auto existing_knowledge = simplify->bounds_and_alignment_info.get(vb->symbol());
                 expr_info.intersect(existing_knowledge);
             }
-            simplify->bounds_and_alignment_info.push(vb->name, expr_info);
+            simplify->bounds_and_alignment_info.push(vb->symbol(), expr_info);
+            simplify->facts_changed();
             bounds_pop_list.push_back(vb);
         } else if (modulus && remainder && (v = m->a.as<Variable>())) {
             // Learn from expressions of the form x % 8 == 3
             Simplify::ExprInfo expr_info;
             expr_info.alignment.modulus = *modulus;
             expr_info.alignment.remainder = *remainder;
-            if (simplify->bounds_and_alignment_info.contains(v->name)) {
+            if (simplify->bounds_and_alignment_info.contains(v->symbol())) {
                 // We already know something about this variable and don't want to suppress it.
-                auto existing_knowledge = simplify->bounds_and_alignment_info.get(v->name);
+                auto existing_knowledge = simplify->bounds_and_alignment_info.get(v->symbol());
                 expr_info.intersect(existing_knowledge);
             }
-            simplify->bounds_and_alignment_info.push(v->name, expr_info);
+            simplify->bounds_and_alignment_info.push(v->symbol(), expr_info);
+            simplify->facts_changed();
             bounds_pop_list.push_back(v);
         }
     } else if (const LT *lt = fact.as<LT>()) {
@@ -314,6 +332,7 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
         return;
     }
     if (simplify->truths.insert(fact).second) {
+        simplify->facts_changed();
         truths.push_back(fact);
     }
 }
@@ -340,10 +359,10 @@ Stmt Simplify::ScopedFact::substitute_facts(const Stmt &s) {
 
 Simplify::ScopedFact::~ScopedFact() {
     for (const auto *v : pop_list) {
-        simplify->var_info.pop(v->name);
+        simplify->var_info.pop(v->symbol());
     }
     for (const auto *v : bounds_pop_list) {
-        simplify->bounds_and_alignment_info.pop(v->name);
+        simplify->bounds_and_alignment_info.pop(v->symbol());
     }
     for (const auto &e : truths) {
         simplify->truths.erase(e);
@@ -351,6 +370,7 @@ Simplify::ScopedFact::~ScopedFact() {
     for (const auto &e : falsehoods) {
         simplify->falsehoods.erase(e);
     }
+    simplify->facts_changed();
 }
 
 Expr simplify(const Expr &e, bool remove_dead_let_stmts,
@@ -28,6 +28,34 @@ Expr simplify(const Expr &, bool remove_dead_code = true,
               const Scope<ModulusRemainder> &alignment = Scope<ModulusRemainder>::empty_scope());
 // @}
 
+/** Control memoization in the simplifier. When on, each call to
+ * simplify remembers the result of simplifying each subexpression, and
+ * reuses it for later subexpressions that are the same IR node or are
+ * equal to it, as long as the facts in scope (enclosing lets, bounds
+ * and alignment, conditions known to be true) have not changed in
+ * between. This speeds up the lowering of pipelines with large,
+ * repetitive expressions, such as unrolled stencils, and costs a
+ * little time for those without. Off by default; setting the
+ * environment variable HL_SIMPLIFY_MEMO=1 turns it on. */
+// @{
+void set_simplify_memoization(bool enabled);
+bool simplify_memoization_enabled();
+// @}
+
+/** Counts of lookups in the simplifier's memo, summed over all calls
+ * to simplify that have finished. */
+struct SimplifyMemoStats {
+    int64_t lookups = 0;
+    /** Lookups that found a previous result for the same IR node. */
+    int64_t identity_hits = 0;
+    /** Lookups that found a previous result for a distinct but equal
+     * IR node. */
+    int64_t structural_hits = 0;
+};
+
+SimplifyMemoStats simplify_memo_stats();
+void reset_simplify_memo_stats();
+
 /** Attempt to statically prove an expression is true using the simplifier. */
 bool can_prove(Expr e, const Scope<Interval> &bounds = Scope<Interval>::empty_scope());
 
@@ -62,7 +62,9 @@ Expr Simplify::visit(const Call *op, ExprInfo *bounds) {
             Expr arg = mutate(op->args[0], nullptr);
             return arg.same_as(op->args[0]) ? op->args[0] : arg;
         } else {
+            FactsChangeOnExit facts_restored(this);
             ScopedValue<bool> save_no_float_simplify(no_float_simplify, true);
+            facts_changed();
             Expr arg = mutate(op->args[0], nullptr);
             if (arg.same_as(op->args[0])) {
                 return op;
@@ -221,8 +221,9 @@ Expr Simplify::visit(const VectorReduce *op, ExprInfo *bounds) {
 }
 
 Expr Simplify::visit(const Variable *op, ExprInfo *bounds) {
-    if (bounds_and_alignment_info.contains(op->name)) {
-        const ExprInfo &b = bounds_and_alignment_info.get(op->name);
+    const Symbol name = op->symbol();
+    if (bounds_and_alignment_info.contains(name)) {
+        const ExprInfo &b = bounds_and_alignment_info.get(name);
         if (bounds) {
             *bounds = b;
         }
@@ -231,8 +232,8 @@ Expr Simplify::visit(const Variable *op, ExprInfo *bounds) {
         }
     }
 
-    if (var_info.contains(op->name)) {
-        auto &info = var_info.ref(op->name);
+    if (var_info.contains(name)) {
+        auto &info = var_info.ref(name);
 
         // if replacement is defined, we should substitute it in (unless
         // it's a var that has been hidden by a nested scope).
@@ -242,6 +243,7 @@ Expr Simplify::visit(const Variable *op, ExprInfo *bounds) {
                 << " of type " << op->type
                 << " with expression of type " << info.replacement.type() << "\n";
             info.new_uses++;
+            note_use(name, true);
             // We want to remutate the replacement, because we may be
             // injecting it into a context where it is known to be a
             // constant (e.g. due to an if).
@@ -250,6 +252,7 @@ Expr Simplify::visit(const Variable *op, ExprInfo *bounds) {
             // This expression was not something deemed
             // substitutable - no replacement is defined.
             info.old_uses++;
+            note_use(name, false);
             return op;
         }
     } else {
@@ -11,6 +11,9 @@
 #include "IRVisitor.h"
 #include "Scope.h"
 
+#include <memory>
+#include <unordered_map>
+
 // Because this file is only included by the simplify methods and
 // doesn't go into Halide.h, we're free to use any old names for our
 // macros.
@@ -133,7 +136,11 @@ public:
 #else
     HALIDE_ALWAYS_INLINE
     Expr mutate(const Expr &e, ExprInfo *b) {
-        // This gets inlined into every call to mutate, so do not add any code here.
+        // This gets inlined into every call to mutate, so do not add any
+        // code here beyond the check for the memo, which is usually off.
+        if (memo) {
+            return mutate_memoized(e, b);
+        }
         return Super::dispatch(e, b);
     }
 #endif
@@ -216,6 +223,78 @@ public:
     // Tracks whether or not the current IR is unconditionally unreachable.
     bool in_unreachable = false;
 
+    // Incremented whenever anything the simplification of an Expr
+    // depends on changes: var_info, bounds_and_alignment_info, truths,
+    // falsehoods, in_vector_loop, or no_float_simplify. Call
+    // facts_changed() right after changing any of them.
+    uint64_t fact_generation = 0;
+
+    HALIDE_ALWAYS_INLINE
+    void facts_changed() {
+        fact_generation++;
+    }
+
+    // Calls facts_changed() when it goes out of scope. Declare one
+    // before a ScopedValue or ScopedBinding that changes the facts, so
+    // that it runs after they are restored.
+    struct FactsChangeOnExit {
+        Simplify *simplify;
+        FactsChangeOnExit(Simplify *s)
+            : simplify(s) {
+        }
+        ~FactsChangeOnExit() {
+            simplify->facts_changed();
+        }
+    };
+
+    // A table of the results of simplifying Exprs, only present if
+    // simplifier memoization is turned on. Entries are found by
+    // structural hash, and are only reused when simplifying an equal
+    // Expr under the same fact_generation. See Simplify_Memo.cpp.
+    struct Memo {
+        // A use of a let variable, counted in var_info.
+        struct Use {
+            Symbol var;
+            bool new_use;
+        };
+
+        struct Entry {
+            Expr key, result;
+            ExprInfo bounds;
+            uint64_t generation;
+            bool has_bounds;
+            // The uses made while simplifying key, to be replayed on a hit.
+            std::vector<Use> uses;
+        };
+
+        std::vector<Entry> entries;
+        std::unordered_map<uint64_t, std::vector<size_t>> table;
+
+        // Structural hashes of the Exprs seen so far, by identity. Holds
+        // on to the Expr so that its address is not reused.
+        std::unordered_map<const IRNode *, std::pair<Expr, uint64_t>> hashes;
+
+        // The uses made while simplifying the Exprs currently being
+        // memoized, and how deeply nested those are.
+        std::vector<Use> uses;
+        int depth = 0;
+
+        int64_t lookups = 0, identity_hits = 0, structural_hits = 0;
+
+        ~Memo();
+    };
+    std::unique_ptr<Memo> memo;
+
+    Expr mutate_memoized(const Expr &e, ExprInfo *bounds);
+    uint64_t memo_hash(const Expr &e);
+
+    HALIDE_ALWAYS_INLINE
+    void note_use(Symbol var, bool new_use) {
+        if (memo && memo->depth > 0) {
+            memo->uses.push_back({var, new_use});
+        }
+    }
+
     // If we encounter a reference to a buffer (a Load, Store, Call,
     // or Provide), there's an implicit dependence on some associated
     // symbols.
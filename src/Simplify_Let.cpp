@@ -65,7 +65,7 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
         frames.emplace_back(op);
         Frame &f = frames.back();
 
-        internal_assert(!var_info.contains(op->name))
+        internal_assert(!var_info.contains(op->symbol()))
             << "Simplify only works on code where every name is unique. Repeated name: " << op->name << "\n";
 
         // If the value is trivial, make a note of it in the scope so
@@ -198,7 +198,8 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
         info.new_uses = 0;
         info.replacement = replacement;
 
-        var_info.push(op->name, info);
+        var_info.push(op->symbol(), info);
+        facts_changed();
 
         // Before we enter the body, track the alignment info
 
@@ -209,13 +210,15 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
             if (new_value_bounds.min_defined || new_value_bounds.max_defined || new_value_bounds.alignment.modulus != 1) {
                 // There is some useful information
                 bounds_and_alignment_info.push(f.new_name, new_value_bounds);
+                facts_changed();
                 f.new_value_bounds_tracked = true;
             }
         }
 
         if (no_overflow_scalar_int(f.value.type())) {
             if (value_bounds.min_defined || value_bounds.max_defined || value_bounds.alignment.modulus != 1) {
-                bounds_and_alignment_info.push(op->name, value_bounds);
+                bounds_and_alignment_info.push(op->symbol(), value_bounds);
+                facts_changed();
                 f.value_bounds_tracked = true;
             }
         }
@@ -237,14 +240,15 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
 
     for (auto it = frames.rbegin(); it != frames.rend(); it++) {
         if (it->value_bounds_tracked) {
-            bounds_and_alignment_info.pop(it->op->name);
+            bounds_and_alignment_info.pop(it->op->symbol());
         }
         if (it->new_value_bounds_tracked) {
             bounds_and_alignment_info.pop(it->new_name);
         }
 
-        VarInfo info = var_info.get(it->op->name);
-        var_info.pop(it->op->name);
+        VarInfo info = var_info.get(it->op->symbol());
+        var_info.pop(it->op->symbol());
+        facts_changed();
 
         if (it->new_value.defined() && (info.new_uses > 0 && vars_used.count(it->new_name) > 0)) {
             // The new name/value may be used
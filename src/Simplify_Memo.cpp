@@ -0,0 +1,323 @@
+#include "Simplify.h"
+#include "Simplify_Internal.h"
+
+#include "Debug.h"
+#include "IREquality.h"
+#include "Util.h"
+
+#include <atomic>
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+// Above this many entries the memo is cleared and starts over, to
+// bound the memory it holds on to.
+constexpr size_t max_memo_entries = 1 << 16;
+
+// Exprs whose simplification uses more let variables than this are
+// not worth recording, as the replay gets as expensive as the
+// simplification.
+constexpr size_t max_memo_uses = 256;
+
+// -1 means not yet read from the environment.
+std::atomic<int> memo_enabled{-1};
+
+std::atomic<int64_t> total_lookups{0}, total_identity_hits{0}, total_structural_hits{0};
+
+HALIDE_ALWAYS_INLINE
+void hash_combine(uint64_t &h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+}
+
+uint64_t hash_string(const std::string &s) {
+    return std::hash<std::string>()(s);
+}
+
+}  // namespace
+
+void set_simplify_memoization(bool enabled) {
+    memo_enabled.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+bool simplify_memoization_enabled() {
+    int e = memo_enabled.load(std::memory_order_relaxed);
+    if (e < 0) {
+        e = get_env_variable("HL_SIMPLIFY_MEMO") == "1" ? 1 : 0;
+        memo_enabled.store(e, std::memory_order_relaxed);
+    }
+    return e != 0;
+}
+
+SimplifyMemoStats simplify_memo_stats() {
+    SimplifyMemoStats stats;
+    stats.lookups = total_lookups;
+    stats.identity_hits = total_identity_hits;
+    stats.structural_hits = total_structural_hits;
+    return stats;
+}
+
+void reset_simplify_memo_stats() {
+    total_lookups = 0;
+    total_identity_hits = 0;
+    total_structural_hits = 0;
+}
+
+Simplify::Memo::~Memo() {
+    debug(3) << "Simplifier memo: " << lookups << " lookups, "
+             << identity_hits << " identity hits, "
+             << structural_hits << " structural hits\n";
+    total_lookups += lookups;
+    total_identity_hits += identity_hits;
+    total_structural_hits += structural_hits;
+}
+
+uint64_t Simplify::memo_hash(const Expr &e) {
+    if (!e.defined()) {
+        return 0;
+    }
+    auto it = memo->hashes.find(e.get());
+    if (it != memo->hashes.end()) {
+        return it->second.second;
+    }
+
+    // Equal Exprs must hash the same. The converse need not hold, as
+    // candidates are compared with equal() before being reused, so
+    // only the fields that most often distinguish nodes are included.
+    uint64_t h = (uint64_t)e.node_type();
+    hash_combine(h, ((uint64_t)e.type().code() << 32) |
+                        ((uint64_t)e.type().bits() << 16) |
+                        (uint64_t)e.type().lanes());
+
+    auto binary = [&](const auto *op) {
+        hash_combine(h, memo_hash(op->a));
+        hash_combine(h, memo_hash(op->b));
+    };
+
+    switch (e.node_type()) {
+    case IRNodeType::IntImm:
+        hash_combine(h, (uint64_t)e.as<IntImm>()->value);
+        break;
+    case IRNodeType::UIntImm:
+        hash_combine(h, e.as<UIntImm>()->value);
+        break;
+    case IRNodeType::FloatImm:
+        hash_combine(h, reinterpret_bits<uint64_t>(e.as<FloatImm>()->value));
+        break;
+    case IRNodeType::StringImm:
+        hash_combine(h, hash_string(e.as<StringImm>()->value));
+        break;
+    case IRNodeType::Broadcast:
+        hash_combine(h, memo_hash(e.as<Broadcast>()->value));
+        break;
+    case IRNodeType::Cast:
+        hash_combine(h, memo_hash(e.as<Cast>()->value));
+        break;
+    case IRNodeType::Variable:
+        hash_combine(h, e.as<Variable>()->symbol().hash());
+        break;
+    case IRNodeType::Add:
+        binary(e.as<Add>());
+        break;
+    case IRNodeType::Sub:
+        binary(e.as<Sub>());
+        break;
+    case IRNodeType::Mod:
+        binary(e.as<Mod>());
+        break;
+    case IRNodeType::Mul:
+        binary(e.as<Mul>());
+        break;
+    case IRNodeType::Div:
+        binary(e.as<Div>());
+        break;
+    case IRNodeType::Min:
+        binary(e.as<Min>());
+        break;
+    case IRNodeType::Max:
+        binary(e.as<Max>());
+        break;
+    case IRNodeType::EQ:
+        binary(e.as<EQ>());
+        break;
+    case IRNodeType::NE:
+        binary(e.as<NE>());
+        break;
+    case IRNodeType::LT:
+        binary(e.as<LT>());
+        break;
+    case IRNodeType::LE:
+        binary(e.as<LE>());
+        break;
+    case IRNodeType::GT:
+        binary(e.as<GT>());
+        break;
+    case IRNodeType::GE:
+        binary(e.as<GE>());
+        break;
+    case IRNodeType::And:
+        binary(e.as<And>());
+        break;
+    case IRNodeType::Or:
+        binary(e.as<Or>());
+        break;
+    case IRNodeType::Not:
+        hash_combine(h, memo_hash(e.as<Not>()->a));
+        break;
+    case IRNodeType::Select: {
+        const Select *op = e.as<Select>();
+        hash_combine(h, memo_hash(op->condition));
+        hash_combine(h, memo_hash(op->true_value));
+        hash_combine(h, memo_hash(op->false_value));
+        break;
+    }
+    case IRNodeType::Load: {
+        const Load *op = e.as<Load>();
+        hash_combine(h, op->symbol().hash());
+        hash_combine(h, memo_hash(op->index));
+        hash_combine(h, memo_hash(op->predicate));
+        break;
+    }
+    case IRNodeType::Ramp: {
+        const Ramp *op = e.as<Ramp>();
+        hash_combine(h, memo_hash(op->base));
+        hash_combine(h, memo_hash(op->stride));
+        break;
+    }
+    case IRNodeType::Call: {
+        const Call *op = e.as<Call>();
+        hash_combine(h, op->symbol().hash());
+        for (const Expr &arg : op->args) {
+            hash_combine(h, memo_hash(arg));
+        }
+        break;
+    }
+    case IRNodeType::Let: {
+        const Let *op = e.as<Let>();
+        hash_combine(h, op->symbol().hash());
+        hash_combine(h, memo_hash(op->value));
+        hash_combine(h, memo_hash(op->body));
+        break;
+    }
+    case IRNodeType::Shuffle: {
+        const Shuffle *op = e.as<Shuffle>();
+        for (const Expr &v : op->vectors) {
+            hash_combine(h, memo_hash(v));
+        }
+        for (int i : op->indices) {
+            hash_combine(h, (uint64_t)i);
+        }
+        break;
+    }
+    case IRNodeType::VectorReduce: {
+        const VectorReduce *op = e.as<VectorReduce>();
+        hash_combine(h, (uint64_t)op->op);
+        hash_combine(h, memo_hash(op->value));
+        break;
+    }
+    default:
+        internal_error << "Unexpected node type in memo_hash: " << e << "\n";
+    }
+
+    memo->hashes.emplace(e.get(), std::make_pair(e, h));
+    return h;
+}
+
+Expr Simplify::mutate_memoized(const Expr &e, ExprInfo *bounds) {
+    switch (e.node_type()) {
+    case IRNodeType::IntImm:
+    case IRNodeType::UIntImm:
+    case IRNodeType::FloatImm:
+    case IRNodeType::StringImm:
+    case IRNodeType::Variable:
+    case IRNodeType::Let:
+        // Leaves are cheaper to simplify than to look up, and lets
+        // change the facts in scope, so they can't be memoized anyway.
+        return Super::dispatch(e, bounds);
+    default:
+        break;
+    }
+
+    // Once something is unreachable, the simplifier stops making
+    // changes, so don't look up or record anything.
+    if (in_unreachable) {
+        return Super::dispatch(e, bounds);
+    }
+
+    memo->lookups++;
+    const bool has_bounds = (bounds != nullptr);
+    uint64_t key = memo_hash(e);
+    hash_combine(key, fact_generation);
+    hash_combine(key, has_bounds);
+
+    auto it = memo->table.find(key);
+    if (it != memo->table.end()) {
+        for (size_t i : it->second) {
+            const Memo::Entry &entry = memo->entries[i];
+            if (entry.generation != fact_generation ||
+                entry.has_bounds != has_bounds) {
+                continue;
+            }
+            if (entry.key.same_as(e)) {
+                memo->identity_hits++;
+            } else if (equal(entry.key, e)) {
+                memo->structural_hits++;
+            } else {
+                continue;
+            }
+
+            // Count the uses of let variables the original
+            // simplification made, so that dead lets are still
+            // identified correctly.
+            for (const auto &use : entry.uses) {
+                VarInfo &info = var_info.ref(use.var);
+                if (use.new_use) {
+                    info.new_uses++;
+                } else {
+                    info.old_uses++;
+                }
+            }
+            if (memo->depth > 0) {
+                memo->uses.insert(memo->uses.end(), entry.uses.begin(), entry.uses.end());
+            }
+            if (bounds) {
+                *bounds = entry.bounds;
+            }
+            return entry.result;
+        }
+    }
+
+    const uint64_t generation = fact_generation;
+    const size_t first_use = memo->uses.size();
+    ExprInfo info;
+    memo->depth++;
+    Expr result = Super::dispatch(e, has_bounds ? &info : nullptr);
+    memo->depth--;
+    if (bounds) {
+        *bounds = info;
+    }
+
+    // Only record results that didn't depend on facts that came and
+    // went during simplification, and that weren't unreachable.
+    if (generation == fact_generation &&
+        !in_unreachable &&
+        memo->uses.size() - first_use <= max_memo_uses) {
+        if (memo->entries.size() >= max_memo_entries) {
+            memo->entries.clear();
+            memo->table.clear();
+            memo->hashes.clear();
+        }
+        memo->table[key].push_back(memo->entries.size());
+        memo->entries.push_back({e, result, info, generation, has_bounds,
+                                 std::vector<Memo::Use>(memo->uses.begin() + first_use, memo->uses.end())});
+    }
+    if (memo->depth == 0) {
+        memo->uses.clear();
+    }
+
+    return result;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -209,9 +209,11 @@ Stmt Simplify::visit(const For *op) {
         return Evaluate::make(new_extent);
     }
 
+    FactsChangeOnExit facts_restored(this);
     ScopedValue<bool> old_in_vector_loop(in_vector_loop,
                                          (in_vector_loop ||
                                           op->for_type == ForType::Vectorized));
+    facts_changed();
 
     bool bounds_tracked = false;
     if (min_bounds.min_defined || (min_bounds.max_defined && extent_bounds.max_defined)) {
@@ -219,7 +221,8 @@ Stmt Simplify::visit(const For *op) {
         min_bounds.max_defined &= extent_bounds.max_defined;
         min_bounds.alignment = ModulusRemainder{};
         bounds_tracked = true;
-        bounds_and_alignment_info.push(op->name, min_bounds);
+        bounds_and_alignment_info.push(op->symbol(), min_bounds);
+        facts_changed();
     }
 
     Stmt new_body;
@@ -238,7 +241,8 @@ Stmt Simplify::visit(const For *op) {
     }
 
     if (bounds_tracked) {
-        bounds_and_alignment_info.pop(op->name);
+        bounds_and_alignment_info.pop(op->symbol());
+        facts_changed();
     }
 
     if (const Acquire *acquire = new_body.as<Acquire>()) {
@@ -375,7 +379,9 @@ Stmt Simplify::visit(const Allocate *op) {
         total_extent_info.max -= 1;
     }
 
+    FactsChangeOnExit facts_restored(this);
     ScopedBinding<ExprInfo> b(bounds_and_alignment_info, op->name + ".total_extent_bytes", total_extent_info);
+    facts_changed();
 
     Stmt body = mutate(op->body);
     Expr condition = mutate(op->condition, nullptr);
@@ -15,9 +15,9 @@ class Substitute : public IRMutator {
     const map<string, Expr> &replace;
     Scope<> hidden;
 
-    Expr find_replacement(const string &s) {
-        map<string, Expr>::const_iterator iter = replace.find(s);
-        if (iter != replace.end() && !hidden.contains(s)) {
+    Expr find_replacement(const Variable *v) {
+        map<string, Expr>::const_iterator iter = replace.find(v->name);
+        if (iter != replace.end() && !hidden.contains(v->symbol())) {
             return iter->second;
         } else {
             return Expr();
@@ -32,7 +32,7 @@ public:
     using IRMutator::visit;
 
     Expr visit(const Variable *v) override {
-        Expr r = find_replacement(v->name);
+        Expr r = find_replacement(v);
         if (r.defined()) {
             return r;
         } else {
@@ -55,7 +55,7 @@ public:
         do {
             Expr new_value = mutate(op->value);
             values_unchanged &= new_value.same_as(op->value);
-            frames.push_back(Frame{op, std::move(new_value), ScopedBinding<>(hidden, op->name)});
+            frames.push_back(Frame{op, std::move(new_value), ScopedBinding<>(hidden, op->symbol())});
             body = op->body;
             op = body.template as<T>();
         } while (op);
@@ -84,9 +84,9 @@ public:
     Stmt visit(const For *op) override {
         Expr new_min = mutate(op->min);
         Expr new_extent = mutate(op->extent);
-        hidden.push(op->name);
+        hidden.push(op->symbol());
         Stmt new_body = mutate(op->body);
-        hidden.pop(op->name);
+        hidden.pop(op->symbol());
 
         if (new_min.same_as(op->min) &&
             new_extent.same_as(op->extent) &&
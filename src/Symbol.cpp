@@ -0,0 +1,121 @@
+#include "Symbol.h"
+
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace Halide {
+namespace Internal {
+
+namespace {
+
+// The table is split into shards by hash, each with its own lock, so
+// that threads compiling different pipelines rarely contend. Most
+// lookups find a name that is already there, so they only need to
+// share the lock.
+constexpr size_t num_shards = 64;
+
+template<typename Entry>
+struct Shard {
+    std::shared_mutex mutex;
+    // Keyed by views of the names held in the entries.
+    std::unordered_map<std::string_view, Entry *> entries;
+};
+
+}  // namespace
+
+struct Symbol::Table {
+    std::array<Shard<Entry>, num_shards> shards;
+
+    Shard<Entry> &shard_for(std::string_view name) {
+        return shards[std::hash<std::string_view>()(name) % num_shards];
+    }
+
+    static Table &get() {
+        // Deliberately leaked, so that Symbols held by static objects
+        // stay valid during static destruction.
+        static Table *t = new Table;
+        return *t;
+    }
+};
+
+const Symbol::Entry *Symbol::intern(const std::string &name) {
+    if (name.empty()) {
+        return empty_entry();
+    }
+    Shard<Entry> &shard = Table::get().shard_for(name);
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(name);
+        if (it != shard.entries.end()) {
+            retain(it->second);
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.entries.find(name);
+    if (it != shard.entries.end()) {
+        retain(it->second);
+        return it->second;
+    }
+    Entry *e = new Entry;
+    e->name = name;
+    shard.entries.emplace(e->name, e);
+    return e;
+}
+
+void Symbol::release_last(const Entry *e) {
+    // Anything that could take a new reference to the entry without
+    // already holding one is looking it up in the table, so it is safe
+    // to remove it once the count drops to zero under the lock.
+    Shard<Entry> &shard = Table::get().shard_for(e->name);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (e->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        shard.entries.erase(e->name);
+        delete e;
+    }
+}
+
+bool Symbol::find(const std::string &name, Symbol *result) {
+    Shard<Entry> &shard = Table::get().shard_for(name);
+    const Entry *e;
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(name);
+        if (it == shard.entries.end()) {
+            return false;
+        }
+        e = it->second;
+        retain(e);
+    }
+    // Assigning may release the last reference to another entry in
+    // this shard, so it must happen after the lock is dropped.
+    *result = Symbol(e);
+    return true;
+}
+
+const Symbol::Entry *Symbol::empty_entry() {
+    static const Entry *e = []() {
+        Entry *e = new Entry;
+        e->permanent = true;
+        Shard<Entry> &shard = Table::get().shard_for(e->name);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.entries.emplace(e->name, e);
+        return e;
+    }();
+    return e;
+}
+
+size_t Symbol::table_size() {
+    size_t n = 0;
+    for (Shard<Entry> &shard : Table::get().shards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        n += shard.entries.size();
+    }
+    return n;
+}
+
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,225 @@
+#ifndef HALIDE_SYMBOL_H
+#define HALIDE_SYMBOL_H
+
+/** \file
+ * Defines Symbol, an interned name that can be compared and hashed in
+ * constant time.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace Halide {
+namespace Internal {
+
+/** A name held in a global table, so that two Symbols made from the
+ * same string point to the same entry. Comparing and hashing Symbols
+ * is a pointer comparison and a pointer hash, rather than a walk over
+ * the characters. Entries are reference counted, and removed from the
+ * table when the last Symbol (or LazySymbol) referring to them goes
+ * away, so the many unique names made during lowering don't
+ * accumulate in a long-running process. Use the string a Symbol
+ * refers to, not the Symbol itself, for anything that must be ordered
+ * deterministically: the address of an entry depends on the order in
+ * which names were interned. */
+class Symbol {
+    struct Entry {
+        std::string name;
+        // Entries that are never freed, such as the empty string, skip
+        // the reference counting.
+        bool permanent = false;
+        mutable std::atomic<int64_t> ref_count{1};
+    };
+
+    struct Table;
+
+    const Entry *e;
+
+    static const Entry *intern(const std::string &name);
+    static const Entry *empty_entry();
+    static void release_last(const Entry *e);
+
+    static void retain(const Entry *e) {
+        if (!e->permanent) {
+            e->ref_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void release(const Entry *e) {
+        if (e->permanent) {
+            return;
+        }
+        // Only the last reference needs the table's lock, to remove the
+        // entry without racing with another thread interning its name.
+        int64_t n = e->ref_count.load(std::memory_order_relaxed);
+        while (n > 1) {
+            if (e->ref_count.compare_exchange_weak(n, n - 1, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        release_last(e);
+    }
+
+    // Takes ownership of a reference to e.
+    explicit Symbol(const Entry *e)
+        : e(e) {
+    }
+
+public:
+    /** The Symbol for the empty string. */
+    Symbol()
+        : e(empty_entry()) {
+    }
+
+    /** Intern a name. Explicit because interning costs a lookup in the
+     * global table, which should not happen by accident. */
+    explicit Symbol(const std::string &name)
+        : e(intern(name)) {
+    }
+
+    explicit Symbol(const char *name)
+        : e(intern(name)) {
+    }
+
+    Symbol(const Symbol &other)
+        : e(other.e) {
+        retain(e);
+    }
+
+    Symbol(Symbol &&other) noexcept
+        : e(other.e) {
+        other.e = empty_entry();
+    }
+
+    Symbol &operator=(const Symbol &other) {
+        retain(other.e);
+        release(e);
+        e = other.e;
+        return *this;
+    }
+
+    Symbol &operator=(Symbol &&other) noexcept {
+        std::swap(e, other.e);
+        return *this;
+    }
+
+    ~Symbol() {
+        release(e);
+    }
+
+    /** Look up a name without interning it. Returns false, and leaves
+     * result alone, if the name isn't interned. A name that isn't
+     * interned cannot be held by anything keyed by Symbol, so queries
+     * can use this to avoid growing the table. */
+    static bool find(const std::string &name, Symbol *result);
+
+    const std::string &str() const {
+        return e->name;
+    }
+
+    /** Symbols can be used wherever a name is expected. */
+    operator const std::string &() const {
+        return e->name;
+    }
+
+    bool empty() const {
+        return e->name.empty();
+    }
+
+    bool operator==(const Symbol &other) const {
+        return e == other.e;
+    }
+
+    bool operator!=(const Symbol &other) const {
+        return e != other.e;
+    }
+
+    size_t hash() const {
+        // Entries are heap-allocated, so the low bits of the address
+        // carry little information.
+        uint64_t h = (uint64_t)(uintptr_t)e;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return (size_t)h;
+    }
+
+    /** The number of distinct names currently interned. */
+    static size_t table_size();
+
+    friend class LazySymbol;
+};
+
+inline std::ostream &operator<<(std::ostream &stream, const Symbol &s) {
+    return stream << s.str();
+}
+
+/** The Symbol for a name that does not change after it is set, looked
+ * up the first time it is needed. IR nodes keep one of these beside
+ * their name, so that only the names passes actually look up get
+ * interned, and each of those only once per node. The name stays
+ * interned as long as the node does. */
+class LazySymbol {
+    mutable std::atomic<const Symbol::Entry *> e{nullptr};
+
+    void reset() {
+        const Symbol::Entry *p = e.exchange(nullptr, std::memory_order_acq_rel);
+        if (p) {
+            Symbol::release(p);
+        }
+    }
+
+public:
+    LazySymbol() = default;
+
+    // The name this caches the Symbol for is not copied along with it.
+    LazySymbol(const LazySymbol &) {
+    }
+    LazySymbol &operator=(const LazySymbol &) {
+        reset();
+        return *this;
+    }
+
+    ~LazySymbol() {
+        reset();
+    }
+
+    Symbol get(const std::string &name) const {
+        const Symbol::Entry *p = e.load(std::memory_order_acquire);
+        if (!p) {
+            // Every thread interns the same entry, so whichever thread
+            // fills in the cache first keeps its reference, and the
+            // others drop theirs.
+            const Symbol::Entry *mine = Symbol::intern(name);
+            if (e.compare_exchange_strong(p, mine, std::memory_order_acq_rel)) {
+                p = mine;
+            } else {
+                Symbol::release(mine);
+            }
+        }
+        Symbol::retain(p);
+        return Symbol(p);
+    }
+};
+
+}  // namespace Internal
+}  // namespace Halide
+
+namespace std {
+
+template<>
+struct hash<Halide::Internal::Symbol> {
+    size_t operator()(const Halide::Internal::Symbol &s) const {
+        return s.hash();
+    }
+};
+
+}  // namespace std
+
+#endif
@@ -156,6 +156,7 @@ struct Target {
         ARMv81a = halide_target_feature_armv81a,
         SanitizerCoverage = halide_target_feature_sanitizer_coverage,
         ProfileByTimer = halide_target_feature_profile_by_timer,
+        AVX512_VNNI = halide_target_feature_avx512_vnni,
         FeatureEnd = halide_target_feature_end
     };
     Target() = default;
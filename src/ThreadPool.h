@@ -30,6 +30,9 @@
  * The ThreadPool's dtor will block until all currently-executing tasks
  * to finish (but won't schedule any more).
  *
+ * If a task throws (when built with HALIDE_WITH_EXCEPTIONS), the
+ * exception is rethrown from the corresponding future's get().
+ *
  * Note that this is a fairly simpleminded ThreadPool, meant for tasks
  * that are fairly coarse (e.g. different tasks in a test); it is specifically
  * *not* intended to be the underlying implementation for Halide runtime threads
@@ -141,17 +144,35 @@ public:
 template<typename T>
 inline void ThreadPool<T>::Job::run_unlocked(std::unique_lock<std::mutex> &unique_lock) {
     unique_lock.unlock();
-    T r = func();
-    unique_lock.lock();
-    result.set_value(std::move(r));
+#ifdef HALIDE_WITH_EXCEPTIONS
+    try {
+#endif
+        T r = func();
+        unique_lock.lock();
+        result.set_value(std::move(r));
+#ifdef HALIDE_WITH_EXCEPTIONS
+    } catch (...) {
+        unique_lock.lock();
+        result.set_exception(std::current_exception());
+    }
+#endif
 }
 
 template<>
 inline void ThreadPool<void>::Job::run_unlocked(std::unique_lock<std::mutex> &unique_lock) {
     unique_lock.unlock();
-    func();
-    unique_lock.lock();
-    result.set_value();
+#ifdef HALIDE_WITH_EXCEPTIONS
+    try {
+#endif
+        func();
+        unique_lock.lock();
+        result.set_value();
+#ifdef HALIDE_WITH_EXCEPTIONS
+    } catch (...) {
+        unique_lock.lock();
+        result.set_exception(std::current_exception());
+    }
+#endif
 }
 
 }  // namespace Internal
@@ -20,18 +20,18 @@ class UniquifyVariableNames : public IRMutator {
     using IRMutator::visit;
 
     // The mapping from old names to new names
-    Scope<string> renaming;
+    Scope<Symbol> renaming;
 
     // Get a new previously unused name for a let binding or for loop,
     // and push it onto the renaming. Will return the original name if
     // possible, but pushes unconditionally to simplify cleanup.
-    string make_new_name(const string &base) {
+    Symbol make_new_name(Symbol base) {
         if (!renaming.contains(base)) {
             renaming.push(base, base);
             return base;
         }
         for (size_t i = std::max((size_t)1, renaming.count(base));; i++) {
-            string candidate = base + "_" + std::to_string(i);
+            Symbol candidate(base.str() + "_" + std::to_string(i));
             if (!renaming.contains(candidate)) {
                 // Reserve this name for this base name
                 renaming.push(base, candidate);
@@ -47,7 +47,7 @@ class UniquifyVariableNames : public IRMutator {
         struct Frame {
             const LetOrLetStmt *op;
             Expr value;
-            string new_name;
+            Symbol new_name;
         };
 
         vector<Frame> frames;
@@ -57,7 +57,7 @@ class UniquifyVariableNames : public IRMutator {
             auto &f = frames.back();
             f.op = op;
             f.value = mutate(op->value);
-            f.new_name = make_new_name(op->name);
+            f.new_name = make_new_name(op->symbol());
             result = op->body;
             op = result.template as<LetOrLetStmt>();
         }
@@ -65,8 +65,8 @@ class UniquifyVariableNames : public IRMutator {
         result = mutate(result);
 
         for (auto it = frames.rbegin(); it != frames.rend(); it++) {
-            renaming.pop(it->op->name);
-            if (it->new_name == it->op->name &&
+            renaming.pop(it->op->symbol());
+            if (it->new_name == it->op->symbol() &&
                 result.same_as(it->op->body) &&
                 it->op->value.same_as(it->value)) {
                 result = it->op;
@@ -89,11 +89,11 @@ class UniquifyVariableNames : public IRMutator {
     Stmt visit(const For *op) override {
         Expr min = mutate(op->min);
         Expr extent = mutate(op->extent);
-        string new_name = make_new_name(op->name);
+        Symbol new_name = make_new_name(op->symbol());
         Stmt body = mutate(op->body);
-        renaming.pop(op->name);
+        renaming.pop(op->symbol());
 
-        if (new_name == op->name &&
+        if (new_name == op->symbol() &&
             body.same_as(op->body) &&
             min.same_as(op->min) &&
             extent.same_as(op->extent)) {
@@ -104,9 +104,9 @@ class UniquifyVariableNames : public IRMutator {
     }
 
     Expr visit(const Variable *op) override {
-        if (renaming.contains(op->name)) {
-            string new_name = renaming.get(op->name);
-            if (new_name != op->name) {
+        if (renaming.contains(op->symbol())) {
+            Symbol new_name = renaming.get(op->symbol());
+            if (new_name != op->symbol()) {
                 return Variable::make(op->type, new_name);
             }
         }
@@ -114,7 +114,7 @@ class UniquifyVariableNames : public IRMutator {
     }
 
 public:
-    UniquifyVariableNames(const Scope<string> *free_vars) {
+    UniquifyVariableNames(const Scope<Symbol> *free_vars) {
         renaming.set_containing_scope(free_vars);
     }
 };
@@ -126,8 +126,8 @@ class FindFreeVars : public IRVisitor {
     Scope<> scope;
 
     void visit(const Variable *op) override {
-        if (!scope.contains(op->name)) {
-            free_vars.push(op->name, op->name);
+        if (!scope.contains(op->symbol())) {
+            free_vars.push(op->symbol(), op->symbol());
         }
     }
 
@@ -137,7 +137,7 @@ class FindFreeVars : public IRVisitor {
         decltype(op->body) body;
         do {
             op->value.accept(this);
-            frame.emplace_back(scope, op->name);
+            frame.emplace_back(scope, op->symbol());
             body = op->body;
             op = body.template as<T>();
         } while (op);
@@ -156,13 +156,13 @@ class FindFreeVars : public IRVisitor {
         op->min.accept(this);
         op->extent.accept(this);
         {
-            ScopedBinding<> bind(scope, op->name);
+            ScopedBinding<> bind(scope, op->symbol());
             op->body.accept(this);
         }
     }
 
 public:
-    Scope<string> free_vars;
+    Scope<Symbol> free_vars;
 };
 }  // namespace
 
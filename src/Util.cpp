@@ -172,12 +172,57 @@ const int num_unique_name_counters = (1 << 14);
 // this is a global, which is always zero-initialized.
 std::atomic<int> unique_name_counters[num_unique_name_counters] = {};
 
+// Set by ScopedUniqueNameCounters.
+thread_local UniqueNameCounters *thread_unique_name_counters = nullptr;
+
 int unique_count(size_t h) {
     h = h & (num_unique_name_counters - 1);
+    if (thread_unique_name_counters) {
+        return thread_unique_name_counters->counts[h]++;
+    }
     return unique_name_counters[h]++;
 }
 }  // namespace
 
+UniqueNameCounters UniqueNameCounters::snapshot() {
+    UniqueNameCounters result;
+    if (thread_unique_name_counters) {
+        result.counts = thread_unique_name_counters->counts;
+    } else {
+        result.counts.resize(num_unique_name_counters);
+        for (int i = 0; i < num_unique_name_counters; i++) {
+            result.counts[i] = unique_name_counters[i];
+        }
+    }
+    return result;
+}
+
+void UniqueNameCounters::advance_past(const UniqueNameCounters &c) {
+    internal_assert(c.counts.size() == num_unique_name_counters);
+    for (int i = 0; i < num_unique_name_counters; i++) {
+        if (thread_unique_name_counters) {
+            int &current = thread_unique_name_counters->counts[i];
+            current = std::max(current, c.counts[i]);
+        } else {
+            int current = unique_name_counters[i];
+            while (current < c.counts[i] &&
+                   !unique_name_counters[i].compare_exchange_weak(current, c.counts[i])) {
+            }
+        }
+    }
+}
+
+ScopedUniqueNameCounters::ScopedUniqueNameCounters(const UniqueNameCounters &start)
+    : private_counters(start), old(thread_unique_name_counters) {
+    internal_assert(private_counters.counts.size() == num_unique_name_counters);
+    thread_unique_name_counters = &private_counters;
+}
+
+ScopedUniqueNameCounters::~ScopedUniqueNameCounters() {
+    thread_unique_name_counters = old;
+    UniqueNameCounters::advance_past(private_counters);
+}
+
 // There are three possible families of names returned by the methods below:
 // 1) char pattern: (char that isn't '$') + number (e.g. v234)
 // 2) string pattern: (string without '$') + '$' + number (e.g. fr#nk82$42)
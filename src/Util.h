@@ -147,6 +147,46 @@ std::string unique_name(char prefix);
 std::string unique_name(const std::string &prefix);
 // @}
 
+/** A copy of the counters unique_name uses. See ScopedUniqueNameCounters. */
+struct UniqueNameCounters {
+    std::vector<int> counts;
+
+    /** Take a copy of the counters in use on the calling thread. */
+    static UniqueNameCounters snapshot();
+
+    /** Advance the counters in use on the calling thread past every name
+     * handed out from the given ones. */
+    static void advance_past(const UniqueNameCounters &c);
+};
+
+/** While one of these is alive, unique_name on the calling thread counts
+ * from a private copy of the given counters instead of the process-wide
+ * ones. Several threads each doing independent work from the same
+ * snapshot therefore generate the same names no matter how their work
+ * interleaves, which keeps the output of parallel compilation
+ * deterministic. Names from different scopes may coincide, so the IR
+ * generated in one scope must not be mixed with that of another. On
+ * destruction, the counters that were in use before the scope (the
+ * process-wide ones, or those of an enclosing scope) are advanced past
+ * every name handed out in it. Threads started within the scope do not
+ * inherit it. */
+class ScopedUniqueNameCounters {
+    UniqueNameCounters private_counters;
+    UniqueNameCounters *old;
+
+public:
+    explicit ScopedUniqueNameCounters(const UniqueNameCounters &start);
+    ~ScopedUniqueNameCounters();
+
+    /** The counters as they currently stand within this scope. */
+    const UniqueNameCounters &counters() const {
+        return private_counters;
+    }
+
+    ScopedUniqueNameCounters(const ScopedUniqueNameCounters &) = delete;
+    ScopedUniqueNameCounters &operator=(const ScopedUniqueNameCounters &) = delete;
+};
+
 /** Test if the first string starts with the second string */
 bool starts_with(const std::string &str, const std::string &prefix);
 
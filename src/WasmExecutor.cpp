@@ -1,5 +1,6 @@
 #include "WasmExecutor.h"
 
+#include <chrono>
 #include <cmath>
 #include <csignal>
 #include <cstdlib>
@@ -293,6 +294,14 @@ const wasm32_ptr_t kMagicJitUserContextValue = -1;
 // failures. https://github.com/halide/Halide/issues/3738
 constexpr size_t kExtraMallocSlop = 32;
 
+// Fill in a wasm32 'struct timeval' (two int32 fields) from the host clock.
+void store_wasm32_timeval(uint8_t *dst) {
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+    const int32_t tv[2] = {(int32_t)(us / 1000000), (int32_t)(us % 1000000)};
+    memcpy(dst, tv, sizeof(tv));
+}
+
 std::vector<char> compile_to_wasm(const Module &module, const std::string &fn_name) {
     static std::mutex link_lock;
     std::lock_guard<std::mutex> lock(link_lock);
@@ -984,6 +993,18 @@ WABT_HOST_CALLBACK(free) {
 
 WABT_HOST_CALLBACK_UNIMPLEMENTED(fwrite)
 
+WABT_HOST_CALLBACK(gettimeofday) {
+    WabtContext &wabt_context = get_wabt_context(thread);
+
+    const int32_t tv = args[0].Get<int32_t>();
+
+    uint8_t *base = get_wasm_memory_base(wabt_context);
+    store_wasm32_timeval(base + tv);
+
+    results[0] = wabt::interp::Value::Make(0);
+    return wabt::Result::Ok;
+}
+
 WABT_HOST_CALLBACK(getenv) {
     WabtContext &wabt_context = get_wabt_context(thread);
 
@@ -1170,6 +1191,8 @@ WABT_HOST_CALLBACK(strlen) {
     return wabt::Result::Ok;
 }
 
+WABT_HOST_CALLBACK_UNIMPLEMENTED(usleep)
+
 WABT_HOST_CALLBACK_UNIMPLEMENTED(write)
 
 // --------------------------------------------------
@@ -1872,10 +1895,27 @@ void wasm_jit_strlen_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
     args.GetReturnValue().Set(load_scalar(context, r));
 }
 
+void wasm_jit_usleep_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    internal_error << "WebAssembly JIT does not yet support the usleep() call.";
+}
+
 void wasm_jit_write_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
     internal_error << "WebAssembly JIT does not yet support the write() call.";
 }
 
+void wasm_jit_gettimeofday_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
+    Isolate *isolate = args.GetIsolate();
+    Local<Context> context = isolate->GetCurrentContext();
+    HandleScope scope(isolate);
+
+    const int32_t tv = args[0]->Int32Value(context).ToChecked();
+
+    uint8_t *base = get_wasm_memory_base(context);
+    store_wasm32_timeval(base + tv);
+
+    args.GetReturnValue().Set(load_scalar(context, (int32_t)0));
+}
+
 void wasm_jit_getenv_callback(const v8::FunctionCallbackInfo<v8::Value> &args) {
     Isolate *isolate = args.GetIsolate();
     Local<Context> context = isolate->GetCurrentContext();
@@ -2180,6 +2220,7 @@ const HostCallbackMap &get_host_callback_map() {
         DEFINE_CALLBACK(free)
         DEFINE_CALLBACK(fwrite)
         DEFINE_CALLBACK(getenv)
+        DEFINE_CALLBACK(gettimeofday)
         DEFINE_CALLBACK(halide_error)
         DEFINE_CALLBACK(halide_print)
         DEFINE_CALLBACK(halide_trace_helper)
@@ -2189,6 +2230,7 @@ const HostCallbackMap &get_host_callback_map() {
         DEFINE_CALLBACK(memmove)
         DEFINE_CALLBACK(memset)
         DEFINE_CALLBACK(strlen)
+        DEFINE_CALLBACK(usleep)
         DEFINE_CALLBACK(write)
 
         // Posix math.
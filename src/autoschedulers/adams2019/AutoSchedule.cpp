@@ -69,19 +69,37 @@
   If set, then tiling sizes are not cached across passes.
   (see Cache.h for more information)
 
+  HL_AUTOSCHEDULE_NUM_THREADS
+  The number of threads to use to expand the states in each round of beam search. Defaults to
+  the number of cores. The schedule found doesn't depend on this.
+
+  HL_COST_MODEL_MAX_BATCH_SIZE
+  The most schedules the cost model evaluates at once. By default, this is as many as fit in a queue
+  of schedule features of about 64MB, clamped to between 1024 and 16384. The schedules enqueued in a
+  round of beam search are evaluated in as few batches as possible. Values below 1024 are raised to
+  1024, since training needs whole batches of that many schedules.
+
+  HL_SCHEDULE_DATABASE
+  If set, the path of a file in which to persist the decisions made in the best schedule found, and
+  from which to reuse them when the same sub-DAG is scheduled again, in this or another pipeline.
+  (see ScheduleDatabase.h for more information)
+
   TODO: expose these settings by adding some means to pass args to
   generator plugins instead of environment vars.
 */
 #include "HalidePlugin.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <queue>
 #include <random>
 #include <set>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -97,6 +115,7 @@
 #include "LoopNest.h"
 #include "NetworkSize.h"
 #include "PerfectHashMap.h"
+#include "ScheduleDatabase.h"
 #include "State.h"
 #include "Timer.h"
 
@@ -186,6 +205,115 @@ bool random_dropout(std::mt19937 &rng, size_t num_decisions) {
     return drop_it;
 }
 
+// Get the HL_AUTOSCHEDULE_NUM_THREADS environment variable. Purpose of this is described above.
+int get_beam_search_threads() {
+    string threads_str = get_env_variable("HL_AUTOSCHEDULE_NUM_THREADS");
+    if (!threads_str.empty()) {
+        return std::max(1, atoi(threads_str.c_str()));
+    } else {
+        return std::max(1, (int)std::thread::hardware_concurrency());
+    }
+}
+
+// A cost model that just records the schedules enqueued into it, so
+// that states can be expanded on several threads, and the schedules
+// then passed on to the real cost model in a deterministic order.
+class RecordingCostModel : public CostModel {
+public:
+    struct Request {
+        StageMapOfScheduleFeatures schedule_feats;
+        double *cost_ptr;
+    };
+    vector<Request> requests;
+
+    void set_pipeline_features(const FunctionDAG &dag,
+                               const MachineParams &params) override {
+        internal_error << "RecordingCostModel can't be configured\n";
+    }
+
+    void enqueue(const FunctionDAG &dag,
+                 const StageMapOfScheduleFeatures &schedule_feats,
+                 double *cost_ptr) override {
+        requests.push_back(Request{schedule_feats, cost_ptr});
+    }
+
+    void evaluate_costs() override {
+        internal_error << "RecordingCostModel can't evaluate costs\n";
+    }
+
+    void reset() override {
+        requests.clear();
+    }
+};
+
+// Generate the children of each of the given states, using up to
+// num_threads threads. The children of each state, and the schedules
+// enqueued into the cost model for them, are then handed on in the order
+// of the states, so the results don't depend on the number of threads.
+void expand_states(const vector<IntrusivePtr<State>> &states,
+                   const FunctionDAG &dag,
+                   const MachineParams &params,
+                   CostModel *cost_model,
+                   int64_t memory_limit,
+                   Cache *cache,
+                   int num_threads,
+                   std::function<void(IntrusivePtr<State> &&)> &accept_child) {
+    struct Expansion {
+        vector<IntrusivePtr<State>> children;
+        RecordingCostModel cost_model;
+        std::exception_ptr error;
+    };
+    vector<Expansion> expansions(states.size());
+
+    auto expand = [&](size_t i) {
+        Expansion &e = expansions[i];
+        std::function<void(IntrusivePtr<State> &&)> accept =
+            [&](IntrusivePtr<State> &&s) {
+                e.children.emplace_back(std::move(s));
+            };
+        try {
+            states[i]->generate_children(dag, params, cost_model ? &e.cost_model : nullptr,
+                                         memory_limit, accept, cache);
+        } catch (...) {
+            e.error = std::current_exception();
+        }
+    };
+
+    num_threads = std::min(num_threads, (int)states.size());
+    if (num_threads <= 1) {
+        for (size_t i = 0; i < states.size(); i++) {
+            expand(i);
+        }
+    } else {
+        std::atomic<size_t> next{0};
+        vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&]() {
+                for (size_t i = next++; i < states.size(); i = next++) {
+                    expand(i);
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+
+    for (auto &e : expansions) {
+        if (e.error) {
+            std::rethrow_exception(e.error);
+        }
+        for (auto &r : e.cost_model.requests) {
+            cost_model->enqueue(dag, r.schedule_feats, r.cost_ptr);
+        }
+        for (auto &c : e.children) {
+            accept_child(std::move(c));
+        }
+    }
+
+    cache->commit_memoized_blocks(states);
+}
+
 // A priority queue of states, sorted according to increasing
 // cost. Never shrinks, to avoid reallocations.
 // Can't use std::priority_queue because it doesn't support unique_ptr.
@@ -310,6 +438,8 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
 
     string cyos_str = get_env_variable("HL_CYOS");
 
+    const int num_threads = get_beam_search_threads();
+
     // This loop is beam search over the sequence of decisions to make.
     for (int i = 0;; i++) {
         std::unordered_map<uint64_t, int> hashes;
@@ -341,8 +471,9 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
             aslog(0) << "Warning: Huge number of states generated (" << pending.size() << ").\n";
         }
 
-        expanded = 0;
-        while (expanded < beam_size && !pending.empty()) {
+        // Pick the states to expand, then expand them all at once.
+        vector<IntrusivePtr<State>> to_expand;
+        while ((int)to_expand.size() < beam_size && !pending.empty()) {
 
             IntrusivePtr<State> state{pending.pop()};
 
@@ -419,10 +550,12 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                 return best;
             }
 
-            state->generate_children(dag, params, cost_model, memory_limit, enqueue_new_children, cache);
-            expanded++;
+            to_expand.emplace_back(std::move(state));
         }
 
+        expanded = (int)to_expand.size();
+        expand_states(to_expand, dag, params, cost_model, memory_limit, cache, num_threads, enqueue_new_children);
+
         // Drop the other states unconsidered.
         pending.clear();
 
@@ -469,7 +602,8 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
                                      std::mt19937 &rng,
                                      int beam_size,
                                      int64_t memory_limit,
-                                     const CachingOptions &options) {
+                                     const CachingOptions &options,
+                                     const ScheduleDatabase *database = nullptr) {
 
     IntrusivePtr<State> best;
 
@@ -477,6 +611,7 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
 
     // Set up cache with options and size.
     Cache cache(options, dag.nodes.size());
+    cache.database = database;
 
     // If the beam size is one, it's pointless doing multiple passes.
     int num_passes = (beam_size == 1) ? 1 : 5;
@@ -529,11 +664,15 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
         aslog(0) << "Cache (block) misses: " << cache.cache_misses << "\n";
     }
 
+    if (database) {
+        aslog(0) << "Schedule database hits: " << database->hits << "\n";
+    }
+
     return best;
 }
 
 // Keep track of how many times we evaluated a state.
-int State::cost_calculations = 0;
+std::atomic<int> State::cost_calculations{0};
 
 // The main entrypoint to generate a schedule for a pipeline.
 void generate_schedule(const std::vector<Function> &outputs,
@@ -591,8 +730,21 @@ void generate_schedule(const std::vector<Function> &outputs,
     // Options generated from environment variables, decide whether or not to cache features and/or tilings.
     CachingOptions cache_options = CachingOptions::MakeOptionsFromEnviron();
 
+    // Decisions persisted from earlier runs, to reuse for any of the same Funcs.
+    std::unique_ptr<ScheduleDatabase> database;
+    string database_path = get_env_variable("HL_SCHEDULE_DATABASE");
+    if (!database_path.empty()) {
+        database = std::make_unique<ScheduleDatabase>(database_path, dag);
+        aslog(1) << "Loaded " << database->size() << " entries from schedule database " << database_path << "\n";
+    }
+
     // Run beam search
-    optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size, memory_limit, cache_options);
+    optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size, memory_limit, cache_options, database.get());
+
+    if (database) {
+        database->record(dag, params, optimal->root.get());
+        database->save();
+    }
 
     HALIDE_TOC;
 
@@ -80,7 +80,7 @@ bool Cache::add_memoized_blocks(const State *state,
     return true;
 }
 
-void Cache::memoize_blocks(const FunctionDAG::Node *node, LoopNest *new_root) {
+void Cache::memoize_blocks(const State *state, const FunctionDAG::Node *node, LoopNest *new_root) {
     if (!options.cache_blocks) {
         return;
     }
@@ -98,8 +98,7 @@ void Cache::memoize_blocks(const FunctionDAG::Node *node, LoopNest *new_root) {
 
     internal_assert(loop_nest_found) << "memoize_blocks did not find loop nest!\n";
 
-    auto &blocks = memoized_compute_root_blocks.get_or_create(node)[vector_dim];
-
+    std::vector<IntrusivePtr<const LoopNest>> blocks;
     for (auto &child : new_root->children) {
         if (child->node == node) {
             LoopNest *new_block = new LoopNest;
@@ -110,6 +109,35 @@ void Cache::memoize_blocks(const FunctionDAG::Node *node, LoopNest *new_root) {
             cache_misses++;
         }
     }
+
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    auto &pending = pending_blocks[state];
+    pending.node = node;
+    pending.vector_dim = vector_dim;
+    for (auto &b : blocks) {
+        pending.blocks.emplace_back(std::move(b));
+    }
+}
+
+void Cache::commit_memoized_blocks(const std::vector<IntrusivePtr<State>> &expanded) {
+    if (!options.cache_blocks) {
+        return;
+    }
+
+    for (const auto &state : expanded) {
+        auto it = pending_blocks.find(state.get());
+        if (it == pending_blocks.end()) {
+            continue;
+        }
+        auto &pending = it->second;
+        auto &vector_dim_map = memoized_compute_root_blocks.get_or_create(pending.node);
+        // Another state expanded earlier in this round may have already
+        // generated the tilings for this vector dimension.
+        if (vector_dim_map.count(pending.vector_dim) == 0) {
+            vector_dim_map[pending.vector_dim] = std::move(pending.blocks);
+        }
+    }
+    pending_blocks.clear();
 }
 
 }  // namespace Autoscheduler
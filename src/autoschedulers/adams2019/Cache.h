@@ -8,6 +8,10 @@
 #include "Halide.h"
 #include "LoopNest.h"
 #include "PerfectHashMap.h"
+#include "ScheduleDatabase.h"
+
+#include <atomic>
+#include <mutex>
 
 namespace Halide {
 namespace Internal {
@@ -64,6 +68,16 @@ namespace Autoscheduler {
     Cache::add_memoized_blocks below (and in Cache.cpp).
     Additionally, if a tiling has not been cached, and it is not pruned, then the tiling will be
     cached using Cache::memoize_blocks (see below and in Cache.cpp).
+
+  If HL_SCHEDULE_DATABASE is set, the decisions made in the best schedules of earlier runs are
+  also reused, across runs and pipelines, through the ScheduleDatabase (see ScheduleDatabase.h).
+  The database is reached through Cache::database, and consulted in State::generate_children.
+
+  The states in each round of beam search may be expanded on several threads (see
+  optimal_schedule_pass in AutoSchedule.cpp). Tilings memoized while expanding a state are held
+  back until Cache::commit_memoized_blocks is called at the end of the round, and are then added in
+  the order the states were expanded, so the contents of the cache don't depend on the number of
+  threads or on the order in which they finish.
 */
 
 struct State;
@@ -101,8 +115,21 @@ struct Cache {
     CachingOptions options;
     BlockCache memoized_compute_root_blocks;
 
-    mutable size_t cache_hits = 0;
-    mutable size_t cache_misses = 0;
+    // Tilings generated while expanding each state in the current round
+    // of beam search, which are not yet visible to add_memoized_blocks.
+    struct PendingBlocks {
+        const FunctionDAG::Node *node = nullptr;
+        int vector_dim = -1;
+        std::vector<IntrusivePtr<const LoopNest>> blocks;
+    };
+    std::mutex pending_mutex;
+    std::map<const State *, PendingBlocks> pending_blocks;
+
+    // Decisions persisted from earlier runs, if any.
+    const ScheduleDatabase *database = nullptr;
+
+    mutable std::atomic<size_t> cache_hits{0};
+    mutable std::atomic<size_t> cache_misses{0};
 
     Cache() = delete;
     Cache(const CachingOptions &_options, size_t nodes_size)
@@ -126,8 +153,14 @@ struct Cache {
                              CostModel *cost_model,
                              int64_t memory_limit) const;
 
-    // Generate tilings for a specific vector dimension and memoize them.
-    void memoize_blocks(const FunctionDAG::Node *node, LoopNest *new_root);
+    // Generate tilings for a specific vector dimension and memoize them,
+    // pending the end of the round of beam search that is expanding state.
+    void memoize_blocks(const State *state, const FunctionDAG::Node *node, LoopNest *new_root);
+
+    // Add the tilings memoized while expanding each of these states, in
+    // order, keeping the first set of tilings found for each Func and
+    // vector dimension.
+    void commit_memoized_blocks(const std::vector<IntrusivePtr<State>> &expanded);
 };
 
 }  // namespace Autoscheduler
@@ -44,6 +44,26 @@ bool ends_with(const std::string &str, const std::string &suffix) {
     return true;
 }
 
+// The largest batch to evaluate at once, given the number of stages of
+// the pipeline. Beam search enqueues all the children of a round before
+// evaluating them, so larger batches mean fewer calls to the cost
+// model, with more parallelism within each one. By default, the batch
+// is limited by the size of the queue of schedule features. It is never
+// less than min_batch_size, because retrain_cost_model enqueues batches
+// of up to that many schedules before calling backprop, which must see
+// all of them.
+const int min_batch_size = 1024;
+
+int choose_max_batch_size(int num_stages) {
+    std::string max_batch_size_str = Halide::Internal::get_env_variable("HL_COST_MODEL_MAX_BATCH_SIZE");
+    if (!max_batch_size_str.empty()) {
+        return std::max(min_batch_size, atoi(max_batch_size_str.c_str()));
+    }
+    const int64_t max_queue_floats = 16 * 1024 * 1024;
+    const int64_t floats_per_schedule = (int64_t)head2_w * std::max(1, num_stages);
+    return (int)std::max((int64_t)min_batch_size, std::min((int64_t)16384, max_queue_floats / floats_per_schedule));
+}
+
 }  // namespace
 
 void DefaultCostModel::set_pipeline_features(const Internal::Autoscheduler::FunctionDAG &dag,
@@ -79,12 +99,14 @@ void DefaultCostModel::set_pipeline_features(const Internal::Autoscheduler::Func
     pipeline_feat_queue = pipeline_features;
     internal_assert(params.parallelism > 0);
     num_cores = params.parallelism;
+    max_batch_size = choose_max_batch_size(num_stages);
 }
 
 void DefaultCostModel::set_pipeline_features(const Runtime::Buffer<float> &pipeline_feats, int n) {
     pipeline_feat_queue = pipeline_feats;
     internal_assert(n > 0);
     num_cores = n;
+    max_batch_size = choose_max_batch_size(pipeline_feats.dim(2).extent());
 }
 
 void DefaultCostModel::enqueue(const Internal::Autoscheduler::FunctionDAG &dag,
@@ -142,27 +164,42 @@ void DefaultCostModel::enqueue(int ns, Runtime::Buffer<float> *schedule_feats, d
         << "schedule features has more stages (" << num_stages
         << ") than pipeline features (" << max_num_stages << ")\n";
 
-    const int batch_size = 1024;
+    // Start with a small queue, and grow it as schedules are enqueued,
+    // so that we can evaluate everything enqueued in one round of beam
+    // search at once without allocating for the largest possible batch.
+    const int initial_batch_size = std::min(max_batch_size, 256);
     if (!schedule_feat_queue.data() ||
         schedule_feat_queue.dim(2).extent() < max_num_stages) {
         internal_assert(cursor == 0);
-        schedule_feat_queue = Runtime::Buffer<float>(batch_size, head2_w, max_num_stages);
+        schedule_feat_queue = Runtime::Buffer<float>(initial_batch_size, head2_w, max_num_stages);
         if (!costs.data()) {
             internal_assert(!cost_ptrs.data());
-            costs = Runtime::Buffer<float>(batch_size);
-            cost_ptrs = Runtime::Buffer<double *>(batch_size);
+            costs = Runtime::Buffer<float>(initial_batch_size);
+            cost_ptrs = Runtime::Buffer<double *>(initial_batch_size);
         }
     }
 
-    if (cursor == batch_size) {
+    if (cursor >= max_batch_size) {
         evaluate_costs();
+    } else if (cursor == schedule_feat_queue.dim(0).extent()) {
+        const int new_batch_size = std::min(max_batch_size, cursor * 2);
+        Runtime::Buffer<float> new_queue(new_batch_size, head2_w, schedule_feat_queue.dim(2).extent());
+        new_queue.copy_from(schedule_feat_queue);
+        schedule_feat_queue = std::move(new_queue);
+    }
+
+    if (cursor == costs.dim(0).extent()) {
+        Runtime::Buffer<double *> new_cost_ptrs(schedule_feat_queue.dim(0).extent());
+        new_cost_ptrs.copy_from(cost_ptrs);
+        cost_ptrs = std::move(new_cost_ptrs);
+        costs = Runtime::Buffer<float>(schedule_feat_queue.dim(0).extent());
     }
 
     *schedule_feats = schedule_feat_queue.sliced(0, cursor);
     cost_ptrs(cursor) = cost_ptr;
 
     cursor++;
-}  // namespace Halide
+}
 
 // Backprop state. To run ADAM we need a running average of the
 // gradients and gradients squared. We add an outer dimension of
@@ -172,6 +209,11 @@ void DefaultCostModel::enqueue(int ns, Runtime::Buffer<float> *schedule_feats, d
 // the second moment.
 float DefaultCostModel::backprop(const Runtime::Buffer<const float> &true_runtimes, float learning_rate) {
     internal_assert(cursor != 0);
+    // If the queue had filled up and been evaluated partway through the
+    // batch, the runtimes would no longer line up with the schedules.
+    internal_assert(true_runtimes.dim(0).extent() == cursor)
+        << "backprop got " << true_runtimes.dim(0).extent() << " runtimes for "
+        << cursor << " enqueued schedules\n";
     internal_assert(pipeline_feat_queue.data());
     internal_assert(schedule_feat_queue.data());
 
@@ -12,7 +12,11 @@ private:
     Internal::Weights weights;
     Runtime::Buffer<float> schedule_feat_queue, pipeline_feat_queue, costs;
     Runtime::Buffer<double *> cost_ptrs;
-    int cursor, num_stages, num_cores;
+    int cursor = 0, num_stages = 0, num_cores = 0;
+
+    // The most schedules evaluated in one call to the cost model. The
+    // queue grows to hold this many schedules before evaluating them.
+    int max_batch_size = 0;
 
     const std::string weights_in_path, weights_out_path;
     const bool randomize_weights;
@@ -41,7 +45,8 @@ public:
     void set_pipeline_features(const Runtime::Buffer<float> &, int n);
 
     // Enqueue a schedule to be evaluated. The second version of this method returns a buffer of
-    // schedule_features that should be filled in by the caller.
+    // schedule_features that should be filled in by the caller, before the next call to enqueue.
+    // Schedules are evaluated in batches of up to max_batch_size(), or when evaluate_costs is called.
     void enqueue(const Internal::Autoscheduler::FunctionDAG &dag,
                  const Halide::Internal::Autoscheduler::StageMapOfScheduleFeatures &schedule_feats,
                  double *cost_ptr) override;
@@ -53,6 +58,11 @@ public:
     // Discard all schedules in the queue.
     void reset() override;
 
+    // The most schedules evaluated at once for the current pipeline.
+    int get_max_batch_size() const {
+        return max_batch_size;
+    }
+
     // Update model weights using true measured runtimes.
     float backprop(const Runtime::Buffer<const float> &true_runtimes, float learning_rate);
 
@@ -377,6 +377,7 @@ void BoundContents::Layout::allocate_some_more() const {
 }
 
 BoundContents *BoundContents::Layout::make() const {
+    std::lock_guard<std::mutex> lock(mutex);
     if (pool.empty()) {
         allocate_some_more();
     }
@@ -389,6 +390,7 @@ BoundContents *BoundContents::Layout::make() const {
 void BoundContents::Layout::release(const BoundContents *b) const {
     internal_assert(b->layout == this) << "Releasing BoundContents onto the wrong pool!";
     b->~BoundContents();
+    std::lock_guard<std::mutex> lock(mutex);
     pool.push_back(const_cast<BoundContents *>(b));
     num_live--;
 }
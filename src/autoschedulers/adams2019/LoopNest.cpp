@@ -127,7 +127,10 @@ void LoopNest::copy_from(const LoopNest &n) {
     children = n.children;
     inlined = n.inlined;
     store_at = n.store_at;
-    bounds = n.bounds;
+    {
+        std::lock_guard<std::mutex> lock(n.memo_mutex);
+        bounds = n.bounds;
+    }
     node = n.node;
     stage = n.stage;
     innermost = n.innermost;
@@ -323,6 +326,11 @@ void LoopNest::compute_features(const FunctionDAG &dag,
     }
 
     if (is_root()) {
+        // Features computed for children that missed in the features
+        // cache. They are only added to the cache once complete (see
+        // below), so that other threads never see a partial entry.
+        std::map<const LoopNest *, StageMap<ScheduleFeatures>> new_cache_entries;
+
         // TODO: This block of code is repeated below. Refactor
         for (const auto &c : children) {
 
@@ -330,16 +338,24 @@ void LoopNest::compute_features(const FunctionDAG &dag,
 
             if (use_cached_features) {
                 // Checks if the features cache has seen this state before, and use the cached features if so.
-                if (c->features_cache.count(hash_of_producers) > 0) {
-                    const auto &entry = c->features_cache.at(hash_of_producers);
+                bool found = false;
+                {
+                    std::lock_guard<std::mutex> lock(c->memo_mutex);
+                    auto cached = c->features_cache.find(hash_of_producers);
+                    if (cached != c->features_cache.end()) {
+                        const auto &entry = cached->second;
 
-                    for (auto it = entry.begin(); it != entry.end(); it++) {
-                        const auto *stage_ptr = it.key();
-                        const auto &feat = it.value();
+                        for (auto it = entry.begin(); it != entry.end(); it++) {
+                            const auto *stage_ptr = it.key();
+                            const auto &feat = it.value();
 
-                        features->insert(stage_ptr, feat);
+                            features->insert(stage_ptr, feat);
+                        }
+                        found = true;
                     }
+                }
 
+                if (found) {
                     // 'working_set_here' is required below for computing the
                     // root-level features so we compute the value that it
                     // would have had if the current loop nest had not been
@@ -355,8 +371,9 @@ void LoopNest::compute_features(const FunctionDAG &dag,
 
             if (use_cached_features) {
                 // Cache these features for future reference.
-                c->features_cache[hash_of_producers].make_large(dag.nodes[0].stages[0].max_id);
-                c->memoize_features(c->features_cache[hash_of_producers], features);
+                auto &entry = new_cache_entries[c.get()];
+                entry.make_large(dag.nodes[0].stages[0].max_id);
+                c->memoize_features(entry, features);
             }
         }
 
@@ -439,8 +456,18 @@ void LoopNest::compute_features(const FunctionDAG &dag,
                 // may not have been computed when it is accessed as a memoized
                 // feature. We memoize 'points_computed_minimum' here to ensure
                 // its value is always available
-                if (c->features_cache.count(hash_of_producers) > 0) {
-                    c->memoize_points_computed_minimum(c->features_cache[hash_of_producers], features);
+                auto new_entry = new_cache_entries.find(c.get());
+                if (new_entry != new_cache_entries.end()) {
+                    c->memoize_points_computed_minimum(new_entry->second, features);
+                    std::lock_guard<std::mutex> lock(c->memo_mutex);
+                    // If another thread cached the same features first, keep those.
+                    c->features_cache.emplace(hash_of_producers, std::move(new_entry->second));
+                } else {
+                    std::lock_guard<std::mutex> lock(c->memo_mutex);
+                    auto cached = c->features_cache.find(hash_of_producers);
+                    if (cached != c->features_cache.end()) {
+                        c->memoize_points_computed_minimum(cached->second, features);
+                    }
                 }
             }
             recompute_inlined_features(sites, features);
@@ -1014,6 +1041,7 @@ void LoopNest::compute_features(const FunctionDAG &dag,
         if (use_cached_features) {
             const auto &block = sites.get(stage).task;
             uint64_t hash_of_producers = sites.get(block->stage).hash_of_producers_stored_at_root;
+            std::lock_guard<std::mutex> lock(block->memo_mutex);
             auto &intermediate_map = block->feature_intermediates_cache[hash_of_producers].get_or_create(&(f->stages[0]));
             auto &intermediate = intermediate_map.get_or_create(stage);
 
@@ -1028,13 +1056,19 @@ void LoopNest::compute_features(const FunctionDAG &dag,
 // Get the region required of a Func at this site, from which we
 // know what region would be computed if it were scheduled here,
 // and what its loop nest would be.
-const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
-    if (bounds.contains(f)) {
-        const Bound &b = bounds.get(f);
-        // Expensive validation for debugging
-        // b->validate();
-        return b;
-    }
+Bound LoopNest::get_bounds(const FunctionDAG::Node *f) const {
+    {
+        std::lock_guard<std::mutex> lock(memo_mutex);
+        if (bounds.contains(f)) {
+            const Bound &b = bounds.get(f);
+            // Expensive validation for debugging
+            // b->validate();
+            return b;
+        }
+    }
+    // Computed without holding the lock, because this recurses into the
+    // bounds of the consumers. Two threads may compute the same bounds,
+    // in which case they agree.
     auto *bound = f->make_bound();
 
     // Compute the region required
@@ -1084,7 +1118,7 @@ const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
         f->loop_nest_for_region(i, &(bound->region_computed(0)), &(bound->loops(i, 0)));
     }
 
-    const Bound &b = set_bounds(f, bound);
+    Bound b = set_bounds(f, bound);
     // Validation is expensive, turn if off by default.
     // b->validate();
     return b;
@@ -1376,7 +1410,10 @@ IntrusivePtr<const LoopNest> LoopNest::parallelize_in_tiles(const MachineParams
     inner->innermost = innermost;
     inner->children = children;
     inner->inlined = inlined;
-    inner->bounds = bounds;
+    {
+        std::lock_guard<std::mutex> lock(memo_mutex);
+        inner->bounds = bounds;
+    }
     inner->store_at = store_at;
 
     auto *b = inner->get_bounds(node)->make_copy();
@@ -1955,6 +1992,7 @@ void LoopNest::apply(LoopLevel here,
 }
 
 void LoopNest::copy_from_including_features(const LoopNest &n) {
+    std::lock_guard<std::mutex> lock(n.memo_mutex);
     size = n.size;
     children = n.children;
     inlined = n.inlined;
@@ -2042,9 +2080,13 @@ void LoopNest::recompute_inlined_features(const StageMap<Sites> &sites, StageMap
         internal_assert(sites.contains(block->stage));
         uint64_t hash_of_producers = sites.get(block->stage).hash_of_producers_stored_at_root;
 
-        internal_assert(block->feature_intermediates_cache.count(hash_of_producers) > 0);
-        auto &intermediate_map = block->feature_intermediates_cache[hash_of_producers].get(&(f->stages[0]));
-        auto &intermediate = intermediate_map.get(stage);
+        FeatureIntermediates intermediate;
+        {
+            std::lock_guard<std::mutex> lock(block->memo_mutex);
+            internal_assert(block->feature_intermediates_cache.count(hash_of_producers) > 0);
+            auto &intermediate_map = block->feature_intermediates_cache[hash_of_producers].get(&(f->stages[0]));
+            intermediate = intermediate_map.get(stage);
+        }
 
         auto &inlined_feat = features->get(&(f->stages[0]));
         inlined_feat.inlined_calls += intermediate.inlined_calls;
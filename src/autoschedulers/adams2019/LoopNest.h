@@ -9,6 +9,7 @@
 #include "FunctionDAG.h"
 #include "PerfectHashMap.h"
 #include <map>
+#include <mutex>
 #include <set>
 #include <utility>
 #include <vector>
@@ -55,6 +56,11 @@ struct LoopNest {
     // little boxes to the left of the loop nest tree figures.
     mutable NodeMap<Bound> bounds;
 
+    // Loop nests are shared between the states of the beam search, which
+    // may be expanded in parallel. This guards the bounds and the feature
+    // caches, which are filled in lazily.
+    mutable std::mutex memo_mutex;
+
     // The Func this loop nest belongs to
     const FunctionDAG::Node *node = nullptr;
 
@@ -147,14 +153,15 @@ struct LoopNest {
     }
 
     // Set the region required of a Func at this site.
-    const Bound &set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+    Bound set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+        std::lock_guard<std::mutex> lock(memo_mutex);
         return bounds.emplace(f, b);
     }
 
     // Get the region required of a Func at this site, from which we
     // know what region would be computed if it were scheduled here,
     // and what its loop nest would be.
-    const Bound &get_bounds(const FunctionDAG::Node *f) const;
+    Bound get_bounds(const FunctionDAG::Node *f) const;
 
     // Recursively print a loop nest representation to stderr
     void dump(string prefix, const LoopNest *parent) const;
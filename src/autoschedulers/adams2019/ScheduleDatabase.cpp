@@ -0,0 +1,219 @@
+#include "ScheduleDatabase.h"
+#include "ASLog.h"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace Halide {
+namespace Internal {
+namespace Autoscheduler {
+
+namespace {
+
+const char *const database_header = "adams2019_schedule_database 1";
+
+// Read the entries of a database file into entries. A missing file is
+// an empty database. Returns false if the file is malformed.
+bool load_entries(const std::string &path, std::map<uint64_t, ScheduleDatabase::Decisions> *entries) {
+    std::ifstream f(path);
+    if (!f.is_open()) {
+        return true;
+    }
+    std::string line;
+    if (!std::getline(f, line) || line != database_header) {
+        return false;
+    }
+    while (std::getline(f, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream s(line);
+        uint64_t signature;
+        int inlined;
+        size_t n;
+        ScheduleDatabase::Decisions d;
+        if (!(s >> signature >> inlined >> d.vector_dim >> d.parallelism >> n) || n > 64) {
+            return false;
+        }
+        d.inlined = inlined != 0;
+        d.pure_size.resize(n);
+        d.tiling.resize(n);
+        for (auto &e : d.pure_size) {
+            s >> e;
+        }
+        for (auto &e : d.tiling) {
+            s >> e;
+        }
+        if (!s) {
+            return false;
+        }
+        (*entries)[signature] = std::move(d);
+    }
+    return true;
+}
+
+// Record the Funcs inlined in the loop nest, and the vector dimension
+// of the Funcs realized in it.
+void find_decisions(const LoopNest *loop,
+                    std::vector<ScheduleDatabase::Decisions> &decisions,
+                    std::vector<bool> &found) {
+    for (auto it = loop->inlined.begin(); it != loop->inlined.end(); it++) {
+        decisions[it.key()->id].inlined = true;
+        found[it.key()->id] = true;
+    }
+    for (const auto &c : loop->children) {
+        if (c->stage->index == 0 && !found[c->node->id]) {
+            decisions[c->node->id].vector_dim = c->vector_dim;
+            found[c->node->id] = true;
+        }
+        find_decisions(c.get(), decisions, found);
+    }
+}
+
+}  // namespace
+
+ScheduleDatabase::ScheduleDatabase(const std::string &path, const FunctionDAG &dag)
+    : path(path) {
+    if (!load_entries(path, &entries)) {
+        user_warning << "Ignoring malformed schedule database " << path << "\n";
+        entries.clear();
+    }
+
+    // Producers come after their consumers in the list of nodes, so
+    // walk it backwards to sign each producer before its consumers.
+    signatures.resize(dag.nodes.size());
+    for (size_t i = dag.nodes.size(); i > 0; i--) {
+        const FunctionDAG::Node &n = dag.nodes[i - 1];
+        uint64_t h = 0;
+        LoopNest::hash_combine(h, n.dimensions);
+        LoopNest::hash_combine(h, n.vector_size);
+        LoopNest::hash_combine(h, n.is_input);
+        LoopNest::hash_combine(h, n.is_output);
+        LoopNest::hash_combine(h, n.is_pointwise);
+        LoopNest::hash_combine(h, n.is_boundary_condition);
+        for (const auto &r : n.estimated_region_required) {
+            LoopNest::hash_combine(h, r.min());
+            LoopNest::hash_combine(h, r.max());
+        }
+        for (const auto &s : n.stages) {
+            LoopNest::hash_combine(h, -1);
+            for (const auto &l : s.loop) {
+                LoopNest::hash_combine(h, l.pure);
+                LoopNest::hash_combine(h, l.rvar);
+                LoopNest::hash_combine(h, l.pure_dim);
+                LoopNest::hash_combine(h, l.bounds_are_constant);
+                if (l.bounds_are_constant) {
+                    LoopNest::hash_combine(h, l.c_min);
+                    LoopNest::hash_combine(h, l.c_max);
+                }
+            }
+            for (size_t j = 0; j < PipelineFeatures::num_features(); j++) {
+                LoopNest::hash_combine(h, s.features[j]);
+            }
+            for (const auto *e : s.incoming_edges) {
+                internal_assert(e->producer->id > n.id) << "Producer " << e->producer->func.name()
+                                                        << " comes before its consumer " << n.func.name() << "\n";
+                LoopNest::hash_combine(h, signatures[e->producer->id]);
+                LoopNest::hash_combine(h, e->calls);
+                LoopNest::hash_combine(h, e->all_bounds_affine);
+                for (const auto &b : e->bounds) {
+                    for (const auto *i : {&b.first, &b.second}) {
+                        LoopNest::hash_combine(h, i->affine);
+                        LoopNest::hash_combine(h, i->uses_max);
+                        LoopNest::hash_combine(h, i->coeff);
+                        LoopNest::hash_combine(h, i->constant);
+                        LoopNest::hash_combine(h, i->consumer_dim);
+                    }
+                }
+            }
+        }
+        signatures[n.id] = h;
+    }
+}
+
+const ScheduleDatabase::Decisions *ScheduleDatabase::find(const FunctionDAG::Node *node) const {
+    auto it = entries.find(signature(node));
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void ScheduleDatabase::record(const FunctionDAG &dag, const MachineParams &params, const LoopNest *root) {
+    std::vector<Decisions> decisions(dag.nodes.size());
+    std::vector<bool> found(dag.nodes.size(), false);
+    find_decisions(root, decisions, found);
+
+    for (const auto &c : root->children) {
+        if (c->parallel && c->stage->index == 0) {
+            Decisions &d = decisions[c->node->id];
+            const auto &bounds = root->get_bounds(c->node);
+            d.tiling = c->size;
+            d.pure_size.resize(c->size.size());
+            for (size_t i = 0; i < c->size.size(); i++) {
+                d.pure_size[i] = bounds->loops(0, i).extent();
+            }
+            d.parallelism = params.parallelism;
+        }
+    }
+
+    for (const auto &n : dag.nodes) {
+        if (!n.is_input && found[n.id]) {
+            entries[signature(&n)] = std::move(decisions[n.id]);
+        }
+    }
+}
+
+void ScheduleDatabase::save() const {
+    // Other processes may have added to the database since we loaded
+    // it, so merge our entries into what's there now.
+    std::map<uint64_t, Decisions> merged;
+    if (!load_entries(path, &merged)) {
+        merged.clear();
+    }
+    for (const auto &e : entries) {
+        merged[e.first] = e.second;
+    }
+
+    // Write to a temporary file and rename it, so that readers never
+    // see a partially-written database.
+    const std::string tmp_path = path + ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream f(tmp_path);
+        f << database_header << "\n";
+        for (const auto &e : merged) {
+            const Decisions &d = e.second;
+            f << e.first << " " << (int)d.inlined << " " << d.vector_dim << " "
+              << d.parallelism << " " << d.pure_size.size();
+            for (int64_t s : d.pure_size) {
+                f << " " << s;
+            }
+            for (int64_t t : d.tiling) {
+                f << " " << t;
+            }
+            f << "\n";
+        }
+        f.close();
+        if (f.fail()) {
+            user_warning << "Failed to write schedule database " << tmp_path << "\n";
+            std::remove(tmp_path.c_str());
+            return;
+        }
+    }
+#ifdef _WIN32
+    // rename() won't replace an existing file on Windows.
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        user_warning << "Failed to replace schedule database " << path << "\n";
+        std::remove(tmp_path.c_str());
+        return;
+    }
+    aslog(1) << "Wrote " << merged.size() << " entries to schedule database " << path << "\n";
+}
+
+}  // namespace Autoscheduler
+}  // namespace Internal
+}  // namespace Halide
@@ -0,0 +1,85 @@
+#ifndef SCHEDULE_DATABASE_H
+#define SCHEDULE_DATABASE_H
+
+#include "FunctionDAG.h"
+#include "LoopNest.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Halide {
+namespace Internal {
+namespace Autoscheduler {
+
+/*
+  A database of scheduling decisions that persists across autoscheduling runs, and across
+  pipelines. It is used to warm-start the beam search when the same sub-DAG (e.g. the same blur
+  or pyramid level) is scheduled again, in a later run or in another generator.
+
+  Funcs are identified by a structural signature, which hashes the featurization and loop
+  structure of each stage of the Func, how it accesses its producers, and the signatures of
+  those producers. It doesn't depend on the names of Funcs or Vars, so structurally identical
+  sub-DAGs of different pipelines share entries.
+
+  For each signature, the database records the decisions made for that Func in the best
+  schedule found the last time it was scheduled: whether it was inlined, which dimension it was
+  vectorized over, and, if it was compute_root and parallelized, the parallel tiling of its
+  loops. When scheduling a Func with a recorded signature, State::generate_children only
+  considers the recorded decisions (where they are still legal), which cuts the branching
+  factor of the search. Where to compute the Func and how to tile it otherwise are still
+  searched as usual.
+
+  The database is a text file named by HL_SCHEDULE_DATABASE. It is read before the search, and
+  the decisions of the schedule found are merged into it afterwards.
+*/
+class ScheduleDatabase {
+public:
+    struct Decisions {
+        bool inlined = false;
+        int vector_dim = -1;
+
+        // The loop extents of the pure stage when computed at root,
+        // and the number of parallel tasks chosen for each of those
+        // loops, for the given number of cores. Empty if the Func wasn't
+        // compute_root and parallelized.
+        std::vector<int64_t> pure_size, tiling;
+        int parallelism = 0;
+    };
+
+    // Load the database at path, if there is one, and compute the
+    // signatures of the Funcs in dag.
+    ScheduleDatabase(const std::string &path, const FunctionDAG &dag);
+
+    // The recorded decisions for a Func, or nullptr if there are none.
+    const Decisions *find(const FunctionDAG::Node *node) const;
+
+    // Replace the decisions recorded for the Funcs in the dag with
+    // those made in the given schedule.
+    void record(const FunctionDAG &dag, const MachineParams &params, const LoopNest *root);
+
+    // Merge the recorded decisions into the database file.
+    void save() const;
+
+    uint64_t signature(const FunctionDAG::Node *node) const {
+        return signatures[node->id];
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    mutable std::atomic<size_t> hits{0};
+
+private:
+    std::string path;
+    std::map<uint64_t, Decisions> entries;
+    std::vector<uint64_t> signatures;
+};
+
+}  // namespace Autoscheduler
+}  // namespace Internal
+}  // namespace Halide
+
+#endif  // SCHEDULE_DATABASE_H
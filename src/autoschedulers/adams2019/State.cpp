@@ -258,6 +258,10 @@ void State::generate_children(const FunctionDAG &dag,
 
     int num_children = 0;
 
+    // The decisions made for a structurally identical Func in the best
+    // schedule of an earlier run, if any.
+    const ScheduleDatabase::Decisions *prior = cache->database ? cache->database->find(node) : nullptr;
+
     if (phase == 0) {
         // Injecting realizations
         {
@@ -296,6 +300,12 @@ void State::generate_children(const FunctionDAG &dag,
             }
         }
 
+        // Don't consider realizing it if it was inlined last time.
+        if (prior && prior->inlined && num_children > 0) {
+            cache->database->hits++;
+            return;
+        }
+
         // Construct a list of plausible dimensions to vectorize
         // over. Currently all of them. TODO: Pre-prune the list
         // of sane dimensions to vectorize a Func over to reduce
@@ -344,6 +354,13 @@ void State::generate_children(const FunctionDAG &dag,
             }
         }
 
+        // Only consider the dimension it was vectorized over last time.
+        if (prior && !prior->inlined &&
+            std::find(vector_dims.begin(), vector_dims.end(), prior->vector_dim) != vector_dims.end()) {
+            vector_dims = {prior->vector_dim};
+            cache->database->hits++;
+        }
+
         // 2) Realize it somewhere
         for (int vector_dim : vector_dims) {
             auto tile_options = root->compute_in_tiles(node, nullptr, params, vector_dim, false);
@@ -388,6 +405,30 @@ void State::generate_children(const FunctionDAG &dag,
                 return;  // successfully added cached states.
             }
 
+            // Try the tiling used last time, if the loops and the number of
+            // cores are the same.
+            if (prior && may_subtile() &&
+                prior->pure_size == *pure_size &&
+                prior->parallelism == params.parallelism) {
+                auto child = make_child();
+                LoopNest *new_root = new LoopNest;
+                new_root->copy_from(*root);
+                for (auto &c : new_root->children) {
+                    if (c->node == node) {
+                        c = c->parallelize_in_tiles(params, prior->tiling, new_root);
+                    }
+                }
+                child->root = new_root;
+                child->num_decisions_made++;
+                if (child->calculate_cost(dag, params, cost_model, cache->options, memory_limit)) {
+                    num_children++;
+                    accept_child(std::move(child));
+                    cache->memoize_blocks(this, node, new_root);
+                    cache->database->hits++;
+                    return;
+                }
+            }
+
             // Generate some candidate parallel task shapes.
             auto tilings = generate_tilings(*pure_size, node->dimensions - 1, 2, true);
 
@@ -513,7 +554,7 @@ void State::generate_children(const FunctionDAG &dag,
                     num_children++;
                     accept_child(std::move(child));
                     // Will early return if block caching is not enabled.
-                    cache->memoize_blocks(node, new_root);
+                    cache->memoize_blocks(this, node, new_root);
                 }
             }
         }
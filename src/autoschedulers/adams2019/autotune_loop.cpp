@@ -0,0 +1,853 @@
+// A driver for autotuning the cost model of the Adams2019 autoscheduler.
+//
+// Each batch compiles a number of randomly-perturbed schedules of a
+// pipeline with the autoscheduler, benchmarks them, turns them into
+// samples, and then retrains the cost model weights on all the samples
+// seen so far. The next batch then uses the retrained weights.
+//
+// Compilation runs on a pool of worker processes. Benchmarks run one at a
+// time, pinned to a separate set of cores, as soon as each sample has
+// compiled, so that compiling the rest of the batch doesn't add noise to
+// the benchmarks.
+//
+// All progress is kept in the samples directory: the status of each
+// sample, the weights used by each batch, and the latest weights. If the
+// driver is interrupted, running it again with the same arguments picks up
+// where it left off.
+//
+// This driver only runs on POSIX systems.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cmdline.h"
+
+namespace {
+
+using std::string;
+using std::vector;
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef __APPLE__
+const char *const shared_ext = ".dylib";
+#else
+const char *const shared_ext = ".so";
+#endif
+
+// Parse a list of cores like "0,2,4-7".
+vector<int> parse_cores(const string &s) {
+    vector<int> cores;
+    std::istringstream in(s);
+    string range;
+    while (std::getline(in, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int lo = std::atoi(range.substr(0, dash).c_str());
+        int hi = dash == string::npos ? lo : std::atoi(range.substr(dash + 1).c_str());
+        for (int c = lo; c <= hi; c++) {
+            cores.push_back(c);
+        }
+    }
+    return cores;
+}
+
+struct Flags {
+    string generator;
+    string pipeline;
+    string target;
+    string initial_weights_path;
+    string autoschedule_bin;
+    string halide_distrib_path;
+    string samples_path;
+    vector<string> generator_args_sets;
+    int batch_size = 32;
+    int num_batches = 1;
+    int compile_jobs = 0;
+    vector<int> compile_cores;
+    vector<int> benchmark_cores;
+    int compile_timeout = 600;
+    int benchmark_timeout = 60;
+    string machine_params;
+    int epochs = 0;
+    string rates;
+    int retrain_cores = 32;
+
+    Flags(int argc, char **argv) {
+        cmdline::parser a;
+
+        const char *kNoDesc = "";
+
+        constexpr bool kOptional = false;
+        a.add<string>("generator", '\0', "the generator to autotune");
+        a.add<string>("pipeline", '\0', "the name of the generator to autotune", kOptional, "demo");
+        a.add<string>("target", '\0', "the target to autotune for; defaults to the host, without AVX512", kOptional, "");
+        a.add<string>("initial_weights", '\0', "the weights to start from");
+        a.add<string>("autoschedule_bin", '\0', "the directory holding the autoscheduler and its tools");
+        a.add<string>("halide_distrib", '\0', "the path to a Halide distribution");
+        a.add<string>("samples", '\0', "the directory to write samples and weights to");
+        a.add<string>("generator_args", '\0',
+                      "sets of generator args, separated by spaces, with the args of each set separated by ';'",
+                      kOptional, "");
+        a.add<int>("batch_size", '\0', kNoDesc, kOptional, 32);
+        a.add<int>("num_batches", '\0', kNoDesc, kOptional, 1);
+        a.add<int>("compile_jobs", '\0', "the number of samples to compile at once; defaults to the number of compile cores",
+                   kOptional, 0);
+        a.add<string>("benchmark_cores", '\0', "the cores to benchmark on, e.g. 8-15; defaults to the upper half",
+                      kOptional, "");
+        a.add<int>("compile_timeout", '\0', "in seconds", kOptional, 600);
+        a.add<int>("benchmark_timeout", '\0', "in seconds", kOptional, 60);
+        a.add<string>("machine_params", '\0', "defaults to the number of benchmark cores, 24000000, 40", kOptional, "");
+        a.add<int>("epochs", '\0', "epochs to retrain for after each batch; defaults to the batch size", kOptional, 0);
+        a.add<string>("rates", '\0', kNoDesc, kOptional, "0.0001");
+        a.add<int>("retrain_cores", '\0', kNoDesc, kOptional, 32);
+
+        a.parse_check(argc, argv);  // exits if parsing fails
+
+        generator = a.get<string>("generator");
+        pipeline = a.get<string>("pipeline");
+        target = a.get<string>("target");
+        initial_weights_path = a.get<string>("initial_weights");
+        autoschedule_bin = a.get<string>("autoschedule_bin");
+        halide_distrib_path = a.get<string>("halide_distrib");
+        samples_path = a.get<string>("samples");
+        batch_size = a.get<int>("batch_size");
+        num_batches = a.get<int>("num_batches");
+        compile_jobs = a.get<int>("compile_jobs");
+        compile_timeout = a.get<int>("compile_timeout");
+        benchmark_timeout = a.get<int>("benchmark_timeout");
+        machine_params = a.get<string>("machine_params");
+        epochs = a.get<int>("epochs");
+        rates = a.get<string>("rates");
+        retrain_cores = a.get<int>("retrain_cores");
+
+        std::istringstream sets(a.get<string>("generator_args"));
+        string set;
+        while (sets >> set) {
+            std::replace(set.begin(), set.end(), ';', ' ');
+            generator_args_sets.push_back(set);
+        }
+        if (generator_args_sets.empty()) {
+            generator_args_sets.emplace_back();
+        }
+
+        const int num_cores = std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+        benchmark_cores = parse_cores(a.get<string>("benchmark_cores"));
+        if (benchmark_cores.empty()) {
+            for (int c = num_cores / 2; c < num_cores; c++) {
+                benchmark_cores.push_back(c);
+            }
+        }
+        for (int c = 0; c < num_cores; c++) {
+            if (std::find(benchmark_cores.begin(), benchmark_cores.end(), c) == benchmark_cores.end()) {
+                compile_cores.push_back(c);
+            }
+        }
+        if (compile_cores.empty()) {
+            // There's nowhere else to compile, so share the benchmark cores.
+            compile_cores = benchmark_cores;
+        }
+        if (compile_jobs <= 0) {
+            compile_jobs = (int)compile_cores.size();
+        }
+        if (machine_params.empty()) {
+            machine_params = std::to_string(benchmark_cores.size()) + ",24000000,40";
+        }
+        if (epochs <= 0) {
+            epochs = batch_size;
+        }
+
+        if (batch_size <= 0 || num_batches <= 0) {
+            std::cerr << "--batch_size and --num_batches must be > 0.\n";
+            std::cerr << a.usage();
+            exit(1);
+        }
+    }
+};
+
+// A command to run in a child process.
+struct Command {
+    vector<string> args;
+    // Extra environment variables, as NAME=value.
+    vector<string> env;
+    // Files to redirect the standard streams to, if not empty. Output is
+    // appended to.
+    string stdin_path, stdout_path, stderr_path;
+    // The cores to run on. Empty means any core.
+    vector<int> cores;
+    // Zero means no timeout.
+    int timeout_seconds = 0;
+};
+
+void redirect(int fd, const string &path, int flags) {
+    if (path.empty()) {
+        return;
+    }
+    int f = open(path.c_str(), flags, 0644);
+    if (f < 0 || dup2(f, fd) < 0) {
+        perror(path.c_str());
+        _exit(127);
+    }
+    close(f);
+}
+
+// Start a command in a new process group, so that it and anything it
+// starts can be killed together.
+pid_t spawn(const Command &cmd) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid > 0) {
+        setpgid(pid, pid);
+        return pid;
+    }
+
+    setpgid(0, 0);
+#ifdef __linux__
+    if (!cmd.cores.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cmd.cores) {
+            CPU_SET(c, &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            perror("sched_setaffinity");
+        }
+    }
+#endif
+    for (const auto &e : cmd.env) {
+        putenv(const_cast<char *>(e.c_str()));
+    }
+    redirect(0, cmd.stdin_path, O_RDONLY);
+    redirect(1, cmd.stdout_path, O_WRONLY | O_CREAT | O_APPEND);
+    redirect(2, cmd.stderr_path, O_WRONLY | O_CREAT | O_APPEND);
+
+    vector<char *> argv;
+    for (const auto &arg : cmd.args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execvp(argv[0], argv.data());
+    perror(argv[0]);
+    _exit(127);
+}
+
+volatile sig_atomic_t interrupted = 0;
+
+void on_signal(int) {
+    interrupted = 1;
+}
+
+// Runs commands in child processes, enforcing their timeouts.
+class ProcessPool {
+    struct Running {
+        Clock::time_point start, deadline;
+        bool has_deadline;
+        bool terminated = false;
+    };
+    std::map<pid_t, Running> running;
+    // Processes that exited while run() was waiting for another one.
+    std::deque<std::pair<pid_t, bool>> exited;
+
+    // Wait for the next process to exit, enforcing timeouts.
+    pid_t reap(bool *success) {
+        while (!interrupted) {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, WNOHANG);
+            if (pid > 0 && running.count(pid)) {
+                *success = !running[pid].terminated && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+                running.erase(pid);
+                return pid;
+            }
+            // Like timeout -k: send SIGTERM at the deadline, and SIGKILL
+            // if the process is still around after that long again.
+            const auto now = Clock::now();
+            for (auto &it : running) {
+                Running &r = it.second;
+                if (r.has_deadline && now > r.deadline) {
+                    kill(-it.first, r.terminated ? SIGKILL : SIGTERM);
+                    if (!r.terminated) {
+                        r.terminated = true;
+                        r.deadline = now + (r.deadline - r.start);
+                    }
+                }
+            }
+            usleep(20000);
+        }
+        return -1;
+    }
+
+public:
+    pid_t start(const Command &cmd) {
+        pid_t pid = spawn(cmd);
+        Running r;
+        r.has_deadline = cmd.timeout_seconds > 0;
+        r.start = Clock::now();
+        r.deadline = r.start + std::chrono::seconds(cmd.timeout_seconds);
+        running[pid] = r;
+        return pid;
+    }
+
+    // Wait for a process to exit. Returns its pid, and whether it
+    // succeeded, or -1 if interrupted.
+    pid_t wait(bool *success) {
+        if (!exited.empty()) {
+            pid_t pid = exited.front().first;
+            *success = exited.front().second;
+            exited.pop_front();
+            return pid;
+        }
+        return reap(success);
+    }
+
+    // Run a command and wait for it to finish, while the other processes
+    // carry on. Returns false if it failed or we were interrupted.
+    bool run(const Command &cmd) {
+        pid_t pid = start(cmd);
+        while (true) {
+            bool success = false;
+            pid_t done = reap(&success);
+            if (done < 0) {
+                return false;
+            }
+            if (done == pid) {
+                return success;
+            }
+            exited.emplace_back(done, success);
+        }
+    }
+
+    // Kill everything still running.
+    void kill_all() {
+        for (const auto &it : running) {
+            kill(-it.first, SIGKILL);
+        }
+        for (const auto &it : running) {
+            waitpid(it.first, nullptr, 0);
+        }
+        running.clear();
+        exited.clear();
+    }
+};
+
+bool file_exists(const string &path) {
+    struct stat s;
+    return stat(path.c_str(), &s) == 0;
+}
+
+void make_dirs(const string &path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i == path.size() || path[i] == '/') {
+            mkdir(path.substr(0, i).c_str(), 0755);
+        }
+    }
+}
+
+string read_file(const string &path) {
+    std::ifstream f(path, std::ios::binary);
+    std::stringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+// Write a file so that it either has its old contents or its new
+// contents, even if we're interrupted.
+void write_file_atomically(const string &path, const string &contents) {
+    const string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f << contents;
+        if (!f) {
+            std::cerr << "Unable to write " << tmp << "\n";
+            exit(1);
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        perror(path.c_str());
+        exit(1);
+    }
+}
+
+void copy_file_atomically(const string &from, const string &to) {
+    if (!file_exists(from)) {
+        std::cerr << "Unable to open " << from << "\n";
+        exit(1);
+    }
+    write_file_atomically(to, read_file(from));
+}
+
+// Find all the samples written so far.
+void find_samples(const string &dir, vector<string> *samples) {
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        return;
+    }
+    while (struct dirent *e = readdir(d)) {
+        const string name = e->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        const string path = dir + "/" + name;
+        struct stat s;
+        if (stat(path.c_str(), &s) != 0) {
+            continue;
+        }
+        if (S_ISDIR(s.st_mode)) {
+            find_samples(path, samples);
+        } else if (name.size() > 7 && name.substr(name.size() - 7) == ".sample") {
+            samples->push_back(path);
+        }
+    }
+    closedir(d);
+    std::sort(samples->begin(), samples->end());
+}
+
+// The highest batch id in the samples directory, or zero if there are none.
+int last_batch_id(const string &samples_path) {
+    int last = 0;
+    DIR *d = opendir(samples_path.c_str());
+    if (!d) {
+        return 0;
+    }
+    while (struct dirent *e = readdir(d)) {
+        int id = 0;
+        if (sscanf(e->d_name, "batch_%d_", &id) == 1) {
+            last = std::max(last, id);
+        }
+    }
+    closedir(d);
+    return last;
+}
+
+class Autotuner {
+    // The status of a sample, as recorded in its directory. Samples
+    // without a status haven't been compiled yet.
+    enum class Status {
+        Pending,
+        Compiled,
+        Benchmarked,
+        Failed,
+    };
+
+    struct Sample {
+        string dir;
+        string fname;
+        int id;
+        int32_t schedule_id;
+        Status status;
+    };
+
+    // A sequence of commands to run for a sample.
+    struct Job {
+        Sample *sample;
+        bool benchmark;
+        vector<Command> commands;
+        size_t next = 0;
+    };
+
+    const Flags &flags;
+    ProcessPool pool;
+
+    string weights_path() const {
+        return flags.samples_path + "/updated.weights";
+    }
+
+    static const char *status_name(Status s) {
+        switch (s) {
+        case Status::Compiled:
+            return "compiled";
+        case Status::Benchmarked:
+            return "benchmarked";
+        case Status::Failed:
+            return "failed";
+        default:
+            return "pending";
+        }
+    }
+
+    static Status read_status(const Sample &s) {
+        const string status = read_file(s.dir + "/status");
+        for (Status st : {Status::Compiled, Status::Benchmarked, Status::Failed}) {
+            if (status == status_name(st)) {
+                return st;
+            }
+        }
+        return Status::Pending;
+    }
+
+    static void set_status(Sample *s, Status status) {
+        s->status = status;
+        write_file_atomically(s->dir + "/status", status_name(status));
+    }
+
+    // Build a single featurization of the pipeline with a random schedule,
+    // and a benchmarking binary for it.
+    vector<Command> compile_commands(const Sample &s, const string &batch_dir, const string &extra_generator_args) const {
+        const string log = s.dir + "/compile_log.txt";
+
+        Command generate;
+        generate.args = {flags.generator,
+                         "-g", flags.pipeline,
+                         "-f", s.fname,
+                         "-o", s.dir,
+                         "-e", "stmt,assembly,static_library,c_header,registration,schedule,featurization",
+                         "target=" + flags.target,
+                         "auto_schedule=true"};
+        std::istringstream extra(extra_generator_args);
+        string arg;
+        while (extra >> arg) {
+            generate.args.push_back(arg);
+        }
+        generate.args.insert(generate.args.end(),
+                             {"-p", flags.autoschedule_bin + "/libautoschedule_adams2019" + shared_ext,
+                              "-s", "Adams2019"});
+
+        // Sample 0 in each batch is best effort beam search, with no
+        // randomness. The other samples are random probes biased by the
+        // cost model, with a 1% chance of operating entirely greedily.
+        const bool best_effort = s.id == 0;
+        generate.env = {"HL_SEED=" + std::to_string(s.schedule_id),
+                        "HL_WEIGHTS_DIR=" + batch_dir + "/used.weights",
+                        string("HL_RANDOM_DROPOUT=") + (best_effort ? "100" : "1"),
+                        string("HL_BEAM_SIZE=") + (best_effort ? "32" : "1"),
+                        "HL_MACHINE_PARAMS=" + flags.machine_params,
+                        // The compile jobs already use all the compile cores.
+                        "HL_AUTOSCHEDULE_NUM_THREADS=1"};
+        generate.stdout_path = generate.stderr_path = log;
+        generate.cores = flags.compile_cores;
+        generate.timeout_seconds = flags.compile_timeout;
+
+        // We don't need image I/O for this purpose, so leave out libpng
+        // and libjpeg.
+        Command link;
+        link.args = {"c++",
+                     "-std=c++17",
+                     "-I", flags.halide_distrib_path + "/include",
+                     flags.halide_distrib_path + "/tools/RunGenMain.cpp",
+                     s.dir + "/" + s.fname + ".registration.cpp",
+                     s.dir + "/" + s.fname + ".a",
+                     "-o", s.dir + "/bench",
+                     "-DHALIDE_NO_PNG", "-DHALIDE_NO_JPEG",
+                     "-ldl", "-lpthread"};
+        link.stdout_path = link.stderr_path = log;
+        link.cores = flags.compile_cores;
+        link.timeout_seconds = flags.compile_timeout;
+
+        return {generate, link};
+    }
+
+    Command benchmark_command(const Sample &s) const {
+        Command bench;
+        bench.args = {s.dir + "/bench", "--estimate_all", "--benchmarks=all"};
+        bench.env = {"HL_NUM_THREADS=" + std::to_string(flags.benchmark_cores.size())};
+        bench.stdout_path = s.dir + "/bench.txt";
+        bench.cores = flags.benchmark_cores;
+        bench.timeout_seconds = flags.benchmark_timeout;
+        return bench;
+    }
+
+    // Add the runtime, pipeline id, and schedule id to the featurization
+    // to make a sample.
+    bool write_sample(const Sample &s, int pipeline_id) {
+        // The runtime is the eighth word of the line
+        // "Benchmark for <name> produces best case of <runtime> sec/iter ..."
+        std::istringstream bench(read_file(s.dir + "/bench.txt"));
+        string line, runtime;
+        while (std::getline(bench, line)) {
+            if (line.compare(0, 14, "Benchmark for ") == 0) {
+                std::istringstream words(line);
+                for (int i = 0; i < 8; i++) {
+                    words >> runtime;
+                }
+            }
+        }
+        if (runtime.empty()) {
+            return false;
+        }
+
+        Command to_sample;
+        to_sample.args = {flags.autoschedule_bin + "/featurization_to_sample",
+                          s.dir + "/" + s.fname + ".featurization",
+                          runtime,
+                          std::to_string(pipeline_id),
+                          std::to_string(s.schedule_id),
+                          s.dir + "/" + s.fname + ".sample"};
+        return pool.run(to_sample);
+    }
+
+    // Compile and benchmark all the samples of one batch that haven't
+    // been done yet. Returns false if interrupted.
+    bool run_batch(int batch_id, int args_idx, const string &dir) {
+        const string &extra_generator_args = flags.generator_args_sets[args_idx];
+        if (!extra_generator_args.empty()) {
+            std::cout << "Adding extra generator args (" << extra_generator_args << ") for batch_" << batch_id << "\n";
+        }
+
+        // Keep the weights being used in the batch folder, both so that we
+        // can repro failures and so that a resumed batch uses the same
+        // weights.
+        make_dirs(dir);
+        if (!file_exists(dir + "/used.weights")) {
+            copy_file_atomically(weights_path(), dir + "/used.weights");
+        }
+        write_file_atomically(dir + "/extra_generator_args.txt", extra_generator_args + "\n");
+
+        vector<Sample> samples(flags.batch_size);
+        std::deque<Sample *> to_compile, to_benchmark;
+        for (int i = 0; i < flags.batch_size; i++) {
+            Sample &s = samples[i];
+            s.id = i;
+            s.dir = dir + "/" + std::to_string(i);
+            char buf[256];
+            snprintf(buf, sizeof(buf), "%s_batch_%04d_sample_%04d", flags.pipeline.c_str(), batch_id, i);
+            s.fname = buf;
+            s.schedule_id = batch_id * 10000 + i;
+            make_dirs(s.dir);
+            s.status = read_status(s);
+            if (s.status == Status::Pending) {
+                to_compile.push_back(&s);
+            } else if (s.status == Status::Compiled) {
+                to_benchmark.push_back(&s);
+            }
+        }
+
+        std::cout << "Compiling " << to_compile.size() << " and benchmarking "
+                  << to_compile.size() + to_benchmark.size() << " samples in " << dir << "\n";
+
+        std::map<pid_t, Job> jobs;
+        int compiling = 0, benchmarking = 0;
+        while (true) {
+            // Benchmarks go first, one at a time, so that they run as
+            // soon as their sample has compiled.
+            while (benchmarking == 0 && !to_benchmark.empty()) {
+                Job job{to_benchmark.front(), true, {benchmark_command(*to_benchmark.front())}};
+                to_benchmark.pop_front();
+                remove((job.sample->dir + "/bench.txt").c_str());
+                jobs[pool.start(job.commands[job.next++])] = job;
+                benchmarking++;
+            }
+            while (compiling < flags.compile_jobs && !to_compile.empty()) {
+                Sample *s = to_compile.front();
+                to_compile.pop_front();
+                Job job{s, false, compile_commands(*s, dir, extra_generator_args)};
+                remove((s->dir + "/compile_log.txt").c_str());
+                remove((s->dir + "/" + s->fname + ".featurization").c_str());
+                remove((s->dir + "/" + s->fname + ".sample").c_str());
+                jobs[pool.start(job.commands[job.next++])] = job;
+                compiling++;
+            }
+            if (jobs.empty()) {
+                break;
+            }
+
+            bool success = false;
+            pid_t pid = pool.wait(&success);
+            if (pid < 0) {
+                pool.kill_all();
+                return false;
+            }
+            auto it = jobs.find(pid);
+            if (it == jobs.end()) {
+                continue;
+            }
+            Job job = it->second;
+            jobs.erase(it);
+
+            if (success && job.next < job.commands.size()) {
+                jobs[pool.start(job.commands[job.next++])] = job;
+                continue;
+            }
+
+            Sample *s = job.sample;
+            if (!job.benchmark) {
+                compiling--;
+                if (success) {
+                    set_status(s, Status::Compiled);
+                    to_benchmark.push_back(s);
+                } else {
+                    std::cout << "Compilation failed or timed out for " << s->dir << "\n";
+                    set_status(s, Status::Failed);
+                }
+            } else {
+                benchmarking--;
+                if (!success) {
+                    std::cout << "Benchmarking failed or timed out for " << s->dir << "\n";
+                    set_status(s, Status::Failed);
+                } else if (!write_sample(*s, args_idx)) {
+                    if (interrupted) {
+                        pool.kill_all();
+                        return false;
+                    }
+                    std::cout << "featurization_to_sample failed for " << s->dir << "\n";
+                    set_status(s, Status::Failed);
+                } else {
+                    std::cout << read_file(s->dir + "/bench.txt");
+                    set_status(s, Status::Benchmarked);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Retrain the model weights on all samples seen so far, starting from
+    // the latest weights. Returns false if interrupted.
+    bool retrain() {
+        std::cout << "Retraining model...\n";
+
+        vector<string> samples;
+        find_samples(flags.samples_path, &samples);
+        string list;
+        for (const auto &s : samples) {
+            list += s + "\n";
+        }
+        const string list_path = flags.samples_path + "/retrain_samples.txt";
+        write_file_atomically(list_path, list);
+
+        // Write the new weights to a temporary file, so that an
+        // interruption can't leave us with a partially-written file.
+        const string new_weights = weights_path() + ".new";
+        Command retrain;
+        retrain.args = {flags.autoschedule_bin + "/retrain_cost_model",
+                        "--epochs=" + std::to_string(flags.epochs),
+                        "--rates=" + flags.rates,
+                        "--num_cores=" + std::to_string(flags.retrain_cores),
+                        "--initial_weights=" + weights_path(),
+                        "--weights_out=" + new_weights,
+                        "--best_benchmark=" + flags.samples_path + "/best." + flags.pipeline + ".benchmark.txt",
+                        "--best_schedule=" + flags.samples_path + "/best." + flags.pipeline + ".schedule.h"};
+        retrain.stdin_path = list_path;
+        if (!pool.run(retrain)) {
+            if (interrupted) {
+                pool.kill_all();
+                return false;
+            }
+            std::cout << "Retraining failed. Keeping the previous weights.\n";
+            return true;
+        }
+        if (rename(new_weights.c_str(), weights_path().c_str()) != 0) {
+            perror(weights_path().c_str());
+            exit(1);
+        }
+        return true;
+    }
+
+public:
+    explicit Autotuner(const Flags &flags)
+        : flags(flags) {
+    }
+
+    // Returns false if interrupted.
+    bool run() {
+        make_dirs(flags.samples_path);
+
+        if (file_exists(weights_path())) {
+            std::cout << "Using existing weights " << weights_path() << "\n";
+        } else {
+            // Only copy over the weights if we don't have any already, so
+            // that restarted jobs can continue from where they left off.
+            std::cout << "Copying starting weights from " << flags.initial_weights_path << " to " << weights_path() << "\n";
+            copy_file_atomically(flags.initial_weights_path, weights_path());
+        }
+
+        // Resume the last batch if it wasn't finished.
+        int first = last_batch_id(flags.samples_path);
+        bool finished = true;
+        for (size_t i = 0; first > 0 && i < flags.generator_args_sets.size(); i++) {
+            const string dir = flags.samples_path + "/batch_" + std::to_string(first) + "_" + std::to_string(i);
+            finished = finished && file_exists(dir + "/retrained");
+        }
+        if (finished) {
+            first++;
+        } else {
+            std::cout << "Resuming batch " << first << "\n";
+        }
+
+        for (int batch_id = first; batch_id < first + flags.num_batches; batch_id++) {
+            const auto start = Clock::now();
+            for (size_t i = 0; i < flags.generator_args_sets.size(); i++) {
+                const string dir = flags.samples_path + "/batch_" + std::to_string(batch_id) + "_" + std::to_string(i);
+                if (file_exists(dir + "/retrained")) {
+                    continue;
+                }
+                if (!run_batch(batch_id, (int)i, dir) || !retrain()) {
+                    return false;
+                }
+                write_file_atomically(dir + "/retrained", "");
+            }
+            const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - start).count();
+            std::cout << "Batch " << batch_id << " took " << seconds << " seconds to compile, benchmark, and retrain\n";
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Flags flags(argc, argv);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGHUP, &sa, nullptr);
+
+    // Use the same target for the whole run, even if it's resumed.
+    make_dirs(flags.samples_path);
+    const string target_path = flags.samples_path + "/target.txt";
+    if (flags.target.empty() && file_exists(target_path)) {
+        flags.target = read_file(target_path);
+    }
+    if (flags.target.empty()) {
+        // Use the host target -- but remove features that we don't want to
+        // train for by default, at least not yet (most notably, AVX512).
+        Command get_host_target;
+        get_host_target.args = {flags.autoschedule_bin + "/get_host_target",
+                                "avx512", "avx512_knl", "avx512_skylake", "avx512_cannonlake"};
+        get_host_target.stdout_path = target_path + ".tmp";
+        remove(get_host_target.stdout_path.c_str());
+        ProcessPool pool;
+        if (!pool.run(get_host_target)) {
+            std::cerr << "Unable to get the host target\n";
+            return 1;
+        }
+        flags.target = read_file(get_host_target.stdout_path);
+        remove(get_host_target.stdout_path.c_str());
+    }
+    while (!flags.target.empty() && isspace(flags.target.back())) {
+        flags.target.pop_back();
+    }
+    write_file_atomically(target_path, flags.target);
+    std::cout << "Training target is: " << flags.target << "\n";
+
+    Autotuner autotuner(flags);
+    if (!autotuner.run()) {
+        std::cout << "Interrupted. Run again with the same arguments to resume.\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// A microbenchmark for the cost model used by the autoscheduler. It
+// evaluates batches of synthetic schedules of various sizes, the way
+// beam search does, and reports how many schedules it evaluates per
+// second for each batch size.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cmdline.h"
+
+#include "DefaultCostModel.h"
+#include "HalideBuffer.h"
+#include "NetworkSize.h"
+
+using Halide::head1_h;
+using Halide::head1_w;
+using Halide::head2_w;
+using Halide::Runtime::Buffer;
+using std::string;
+using std::vector;
+
+struct Flags {
+    string weights_path;
+    int num_stages = 20;
+    int num_cores = 1;
+    double seconds = 0.5;
+
+    Flags(int argc, char **argv) {
+        cmdline::parser a;
+
+        const char *kNoDesc = "";
+
+        constexpr bool kOptional = false;
+        a.add<string>("weights", '\0', kNoDesc, kOptional, "");
+        a.add<int>("num_stages", '\0', kNoDesc, kOptional, 20);
+        a.add<int>("num_cores", '\0', kNoDesc, kOptional, (int)std::thread::hardware_concurrency());
+        a.add<double>("seconds", '\0', kNoDesc, kOptional, 0.5);
+
+        a.parse_check(argc, argv);  // exits if parsing fails
+
+        weights_path = a.get<string>("weights");
+        num_stages = a.get<int>("num_stages");
+        num_cores = std::max(1, a.get<int>("num_cores"));
+        seconds = a.get<double>("seconds");
+
+        if (num_stages <= 0) {
+            std::cerr << "--num_stages must be > 0.\n";
+            std::cerr << a.usage();
+            exit(1);
+        }
+    }
+};
+
+int main(int argc, char **argv) {
+    Flags flags(argc, argv);
+
+    // Use the built-in weights, unless told otherwise. The cost of
+    // evaluating the model doesn't depend on the weights.
+    auto model = Halide::make_default_cost_model(flags.weights_path);
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> feature(0.0f, 1000.0f);
+
+    Buffer<float> pipeline_features(head1_w, head1_h, flags.num_stages);
+    pipeline_features.for_each_value([&](float &f) { f = feature(rng); });
+    model->reset();
+    model->set_pipeline_features(pipeline_features, flags.num_cores);
+
+    // A pool of synthetic schedules to cycle through.
+    const int num_schedules = 64;
+    vector<Buffer<float>> schedules;
+    for (int i = 0; i < num_schedules; i++) {
+        Buffer<float> s(head2_w, flags.num_stages);
+        s.for_each_value([&](float &f) { f = feature(rng); });
+        schedules.push_back(s);
+    }
+
+    const int max_batch_size = model->get_max_batch_size();
+    vector<double> costs(max_batch_size);
+
+    std::cout << "Cost model benchmark: " << flags.num_stages << " stages, "
+              << flags.num_cores << " cores, batches of up to " << max_batch_size << "\n";
+    std::cout << std::setw(12) << "batch size"
+              << std::setw(16) << "us per batch"
+              << std::setw(20) << "schedules per sec"
+              << "\n";
+
+    for (int batch_size = 1; batch_size <= max_batch_size; batch_size *= 4) {
+        auto run_batch = [&]() {
+            for (int i = 0; i < batch_size; i++) {
+                Buffer<float> buf;
+                model->enqueue(flags.num_stages, &buf, &costs[i]);
+                buf.copy_from(schedules[i % num_schedules]);
+            }
+            model->evaluate_costs();
+        };
+
+        // Warm up, then run batches for the requested time.
+        run_batch();
+
+        using Clock = std::chrono::high_resolution_clock;
+        const auto start = Clock::now();
+        int64_t batches = 0;
+        double elapsed = 0;
+        do {
+            run_batch();
+            batches++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < flags.seconds);
+
+        std::cout << std::setw(12) << batch_size
+                  << std::setw(16) << std::fixed << std::setprecision(1) << 1e6 * elapsed / batches
+                  << std::setw(20) << std::setprecision(0) << batches * batch_size / elapsed
+                  << "\n";
+    }
+
+    return 0;
+}
@@ -124,6 +124,7 @@ public:
     template<typename T>
     using Output = GeneratorOutput<T>;
     using Generator<CostModel<training>>::auto_schedule;
+    using Generator<CostModel<training>>::get_target;
     using Generator<CostModel<training>>::get_pipeline;
 
     // Number of pipeline stages
@@ -489,22 +490,32 @@ public:
         } else {
             // We just write down a good schedule for
             // inference. Scheduling a couple of convs is easy.
+
+            // schedule for the forwards path. Use the natural vector
+            // width of the target: 8 floats for AVX2, 16 for AVX-512.
+            const int vec = std::max(8, get_target().natural_vector_size(Float(32)));
+
+            // Split the batch into tasks of one vector's worth of
+            // schedules. The autoscheduler evaluates all the
+            // schedules generated in a round of beam search at once,
+            // so batches are large enough for this to keep all the
+            // cores busy.
             Var no;
-            prediction_output.specialize(batch_size < 8).split(n, no, n, 1);
-            prediction_output.compute_root().split(n, no, n, 8).parallel(no);
+            prediction_output.specialize(batch_size < vec).split(n, no, n, 1);
+            prediction_output.compute_root().split(n, no, n, vec).parallel(no);
             prediction_output.bound(n, 0, batch_size);
 
-            // schedule for the forwards path
-            const int vec = 8;
-
             // A helper function for scheduling conv layers
-            auto schedule_conv = [&](Func conv, Func relu, const RVar &r_channels) {
+            auto schedule_conv = [&](Func conv, Func relu, const RVar &r_channels, int channels) {
                 Var ci, wi;
                 if (!training) {
+                    // Don't round the channels up to a wider vector
+                    // than divides them.
+                    const int channel_vec = channels % vec == 0 ? vec : 8;
                     relu
                         .compute_at(prediction_output, n)
                         .store_at(prediction_output, no)
-                        .tile(c, w, ci, wi, vec, 4, TailStrategy::RoundUp)
+                        .tile(c, w, ci, wi, channel_vec, 4, TailStrategy::RoundUp)
                         .vectorize(ci);
                     conv.compute_at(relu, c);
                 } else {
@@ -550,8 +561,8 @@ public:
             }
 
             // conv+relu layers
-            schedule_conv(head2_conv, head2_relu, r_head2.x);
-            schedule_conv(conv1_stage2, relu1, r1_stage2.x);
+            schedule_conv(head2_conv, head2_relu, r_head2.x, head2_channels);
+            schedule_conv(conv1_stage2, relu1, r1_stage2.x, conv1_channels);
         }
     }
 };
@@ -1,5 +1,7 @@
 #include "Halide.h"
+#include <cstdio>    // std::remove
 #include <cstdlib>   // setenv (or Windows _putenv_s)
+#include <fstream>   // std::ifstream
 #include <iostream>  // std::cerr / std::endl
 #include <map>       // std::map
 #include <string>    // std::to_string
@@ -53,6 +55,36 @@ bool test_caching(Pipeline &p1, Pipeline &p2, const Target &target, const Machin
     return true;
 }
 
+int count_lines(const std::string &path) {
+    std::ifstream f(path);
+    std::string line;
+    int lines = 0;
+    while (std::getline(f, line)) {
+        lines++;
+    }
+    return lines;
+}
+
+// Schedule two pipelines with the same structure but different names,
+// sharing a schedule database. The second should reuse the entries
+// written by the first, rather than add its own.
+bool test_schedule_database(Pipeline &p1, Pipeline &p2, const Target &target, const MachineParams &params) {
+    const std::string path = "adams2019_test_schedule_database.txt";
+    std::remove(path.c_str());
+    set_env_variable("HL_SCHEDULE_DATABASE", path, /* overwrite */ 1);
+
+    p1.auto_schedule(target, params);
+    const int lines_after_p1 = count_lines(path);
+    p2.auto_schedule(target, params);
+    const int lines_after_p2 = count_lines(path);
+
+    set_env_variable("HL_SCHEDULE_DATABASE", "", /* overwrite */ 1);
+    std::remove(path.c_str());
+
+    // A header, and at least one entry.
+    return lines_after_p1 > 1 && lines_after_p2 == lines_after_p1;
+}
+
 int main(int argc, char **argv) {
     if (argc != 2) {
         fprintf(stderr, "Usage: %s <autoscheduler-lib>\n", argv[0]);
@@ -880,6 +912,35 @@ int main(int argc, char **argv) {
         }
     }
 
+    if (true) {
+        Pipeline p1;
+        Pipeline p2;
+        for (int test_condition = 0; test_condition < 2; test_condition++) {
+            // A separable blur, with different names each time.
+            const std::string suffix = std::to_string(test_condition);
+            ImageParam im(Float(32), 2, "im" + suffix);
+            Func in("in" + suffix), blur_x("blur_x" + suffix), blur_y("blur_y" + suffix);
+            Var u("u" + suffix), v("v" + suffix);
+            in(u, v) = BoundaryConditions::repeat_edge(im)(u, v);
+            blur_x(u, v) = in(u - 1, v) + in(u, v) + in(u + 1, v);
+            blur_y(u, v) = blur_x(u, v - 1) + blur_x(u, v) + blur_x(u, v + 1);
+
+            im.set_estimates({{0, 2000}, {0, 2000}});
+            blur_y.set_estimate(u, 0, 2000).set_estimate(v, 0, 2000);
+
+            if (test_condition) {
+                p2 = Pipeline(blur_y);
+            } else {
+                p1 = Pipeline(blur_y);
+            }
+        }
+
+        if (!test_schedule_database(p1, p2, target, params)) {
+            std::cerr << "Schedule database check failed on blur" << std::endl;
+            return 1;
+        }
+    }
+
     // Reset environment variables.
     set_env_variable("HL_DISABLE_MEMOIZED_FEATURES", cache_features, /* overwrite */ 1);
     set_env_variable("HL_DISABLE_MEMOIZED_BLOCKS", cache_blocks, /* overwrite */ 1);
@@ -0,0 +1,91 @@
+#!/bin/bash
+
+# Smoke test for autotune_loop: run two small batches on the demo
+# generator, interrupting the first batch part way through and resuming
+# it, and check what ends up in the samples directory.
+
+if [ $# -ne 9 ]; then
+  echo "Usage: $0 autotune_loop demo.generator libautoschedule_adams2019 featurization_to_sample retrain_cost_model get_host_target halide_include_dir halide_tools_dir weights_file"
+  exit 1
+fi
+
+set -eu
+
+AUTOTUNE_LOOP=${1}
+GENERATOR=${2}
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/test_autotune_loop.XXXXXX")
+trap 'rm -rf "${WORK}"' EXIT
+
+# autotune_loop expects the autoscheduler and its tools in one
+# directory, and the headers and RunGenMain.cpp in a Halide
+# distribution.
+mkdir -p "${WORK}/bin" "${WORK}/distrib"
+ln -s "${3}" "${WORK}/bin/$(basename "${3}")"
+for TOOL in "${4}" "${5}" "${6}"; do
+  ln -s "${TOOL}" "${WORK}/bin/"
+done
+ln -s "${7}" "${WORK}/distrib/include"
+ln -s "${8}" "${WORK}/distrib/tools"
+WEIGHTS=${9}
+SAMPLES=${WORK}/samples
+
+fail() {
+  echo "$@"
+  exit 1
+}
+
+ARGS=(--generator="${GENERATOR}"
+      --pipeline=demo
+      --initial_weights="${WEIGHTS}"
+      --autoschedule_bin="${WORK}/bin"
+      --halide_distrib="${WORK}/distrib"
+      --samples="${SAMPLES}"
+      --batch_size=2
+      --num_batches=2
+      --epochs=4
+      --retrain_cores=1)
+
+# Interrupt the first batch once its first sample has finished compiling.
+"${AUTOTUNE_LOOP}" "${ARGS[@]}" > "${WORK}/first.txt" 2>&1 &
+PID=$!
+for i in $(seq 3000); do
+  if [ -e "${SAMPLES}/batch_1_0/0/status" ] || ! kill -0 ${PID} 2> /dev/null; then
+    break
+  fi
+  sleep 0.1
+done
+kill -TERM ${PID} 2> /dev/null || true
+if wait ${PID}; then
+  cat "${WORK}/first.txt"
+  fail "autotune_loop finished before it could be interrupted"
+fi
+grep -q "Interrupted" "${WORK}/first.txt" || { cat "${WORK}/first.txt"; fail "autotune_loop didn't report the interruption"; }
+[ -e "${SAMPLES}/batch_1_0/retrained" ] && fail "The interrupted batch was marked as retrained"
+
+# Running again with the same arguments finishes the first batch and
+# then runs the second.
+"${AUTOTUNE_LOOP}" "${ARGS[@]}" > "${WORK}/second.txt" 2>&1 || { cat "${WORK}/second.txt"; fail "Resumed autotune_loop failed"; }
+grep -q "Resuming batch 1" "${WORK}/second.txt" || { cat "${WORK}/second.txt"; fail "autotune_loop didn't resume batch 1"; }
+grep -q "Retraining failed" "${WORK}/second.txt" && { cat "${WORK}/second.txt"; fail "Retraining failed"; }
+
+[ -e "${SAMPLES}/batch_3_0" ] && fail "autotune_loop ran more batches than asked for"
+for BATCH in 1 2; do
+  DIR=${SAMPLES}/batch_${BATCH}_0
+  [ -e "${DIR}/retrained" ] || fail "${DIR} was not retrained"
+  for SAMPLE in 0 1; do
+    STATUS=$(cat "${DIR}/${SAMPLE}/status")
+    SAMPLE_FILE=${DIR}/${SAMPLE}/demo_batch_000${BATCH}_sample_000${SAMPLE}.sample
+    [ "${STATUS}" == "benchmarked" ] || fail "${DIR}/${SAMPLE} has status '${STATUS}'"
+    [ -s "${SAMPLE_FILE}" ] || fail "${SAMPLE_FILE} is missing"
+    grep -qxF "${SAMPLE_FILE}" "${SAMPLES}/retrain_samples.txt" || fail "${SAMPLE_FILE} was not used for retraining"
+  done
+done
+[ "$(wc -l < "${SAMPLES}/retrain_samples.txt")" -eq 4 ] || fail "Expected to retrain on 4 samples"
+
+# Each batch uses the weights retrained by the one before.
+cmp -s "${WEIGHTS}" "${SAMPLES}/batch_1_0/used.weights" || fail "Batch 1 didn't start from the initial weights"
+cmp -s "${SAMPLES}/batch_1_0/used.weights" "${SAMPLES}/batch_2_0/used.weights" && fail "Batch 2 didn't use retrained weights"
+cmp -s "${SAMPLES}/batch_2_0/used.weights" "${SAMPLES}/updated.weights" && fail "The weights were not retrained after batch 2"
+
+echo "Success!"
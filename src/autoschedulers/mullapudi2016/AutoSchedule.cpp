@@ -1,12 +1,15 @@
 #include "HalidePlugin.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <map>
 #include <regex>
 #include <set>
 #include <utility>
 
 #include "Halide.h"
+#include "halide_benchmark.h"
 
 namespace Halide {
 namespace Internal {
@@ -1042,6 +1045,20 @@ struct Partitioner {
     // needs to be updated whenever the grouping changes.
     map<FStage, GroupAnalysis> group_costs;
 
+    // A snapshot of the grouping of the pipeline.
+    struct Partition {
+        map<FStage, Group> groups;
+        map<FStage, set<FStage>> children;
+        map<FStage, GroupAnalysis> group_costs;
+    };
+
+    // The last 'num_partitions_to_keep' partitions visited while grouping for
+    // fast memory, oldest first. Every merge lowers the estimated cost of the
+    // pipeline, so these are the best partitions according to the cost model,
+    // which makes them the candidates worth measuring.
+    vector<Partition> recent_partitions;
+    size_t num_partitions_to_keep = 0;
+
     // Levels that are targeted by the grouping algorithm. In the 'Inline' mode, the grouping
     // algorithm groups the functions by inlining the expression for the producer function
     // into the consumer stage. In the 'FastMem' mode, the grouping is done at the level of
@@ -1098,6 +1115,14 @@ struct Partitioner {
     // reached.
     void group(Partitioner::Level level);
 
+    // Take a snapshot of the current partition, or go back to a previous one.
+    Partition get_partition() const;
+    void set_partition(const Partition &p);
+
+    // Append the current partition to 'recent_partitions', dropping the oldest
+    // one if there are more than 'num_partitions_to_keep'.
+    void record_partition();
+
     // Given a grouping choice, return a configuration for the group that gives
     // the highest estimated benefits.
     GroupConfig evaluate_choice(const GroupingChoice &group, Partitioner::Level level);
@@ -1128,6 +1153,12 @@ struct Partitioner {
     // estimated benefit and the estimated benefit.
     pair<map<string, Expr>, GroupAnalysis> find_best_tile_config(const Group &g);
 
+    // Return up to 'k' tiling configurations for a group 'g' which are estimated
+    // to be beneficial over not tiling, ordered from the highest to the lowest
+    // estimated benefit. Configurations with a non-constant benefit estimate are
+    // left out.
+    vector<map<string, Expr>> find_top_tile_configs(const Group &g, int k);
+
     // Estimate the benefit (arithmetic + memory) of 'new_grouping' over 'old_grouping'.
     // Positive values indicates that 'new_grouping' may be preferrable over 'old_grouping'.
     // When 'ensure_parallelism' is set to true, this will return an undefined cost
@@ -1628,7 +1659,66 @@ Partitioner::find_best_tile_config(const Group &g) {
     return make_pair(best_config, best_analysis);
 }
 
+vector<map<string, Expr>> Partitioner::find_top_tile_configs(const Group &g, int k) {
+    Group no_tile = g;
+    no_tile.tile_sizes = map<string, Expr>();
+    GroupAnalysis no_tile_analysis = analyze_group(no_tile, false);
+    if (!no_tile_analysis.cost.defined()) {
+        return {};
+    }
+
+    vector<pair<double, map<string, Expr>>> ranked;
+    for (const auto &config : generate_tile_configs(g.output)) {
+        Group new_group = g;
+        new_group.tile_sizes = config;
+        GroupAnalysis new_analysis = analyze_group(new_group, false);
+
+        Expr benefit = estimate_benefit(no_tile_analysis, new_analysis, false, true);
+        if (!benefit.defined()) {
+            continue;
+        }
+        const double *b = as_const_float(simplify(cast<double>(benefit)));
+        if (b && *b > 0) {
+            ranked.emplace_back(*b, config);
+        }
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const pair<double, map<string, Expr>> &a,
+                        const pair<double, map<string, Expr>> &b) { return a.first > b.first; });
+
+    vector<map<string, Expr>> configs;
+    for (size_t i = 0; i < ranked.size() && (int)i < k; i++) {
+        configs.push_back(ranked[i].second);
+    }
+    return configs;
+}
+
+Partitioner::Partition Partitioner::get_partition() const {
+    return Partition{groups, children, group_costs};
+}
+
+void Partitioner::set_partition(const Partition &p) {
+    groups = p.groups;
+    children = p.children;
+    group_costs = p.group_costs;
+    grouping_cache.clear();
+}
+
+void Partitioner::record_partition() {
+    if (num_partitions_to_keep == 0) {
+        return;
+    }
+    recent_partitions.push_back(get_partition());
+    if (recent_partitions.size() > num_partitions_to_keep) {
+        recent_partitions.erase(recent_partitions.begin());
+    }
+}
+
 void Partitioner::group(Partitioner::Level level) {
+    if (level == Partitioner::Level::FastMem) {
+        record_partition();
+    }
+
     bool fixpoint = false;
     while (!fixpoint) {
         Cost pre_merge = get_pipeline_cost();
@@ -1750,6 +1840,10 @@ void Partitioner::group(Partitioner::Level level) {
         if (debug::debug_level() >= 3) {
             disp_pipeline_costs();
         }
+
+        if (level == Partitioner::Level::FastMem) {
+            record_partition();
+        }
     }
 }
 
@@ -3160,6 +3254,412 @@ bool inline_unbounded(const vector<Function> &outputs,
     return inlined;
 }
 
+// Set a scalar parameter to the value of a constant Expr. Returns false if
+// the Expr isn't a constant of a type that can be set.
+bool set_scalar_from_expr(Parameter &p, const Expr &e) {
+    const Type t = p.type();
+    Expr c = simplify(cast(t, e));
+    halide_scalar_value_t v;
+    v.u.u64 = 0;
+    if (const int64_t *i = as_const_int(c)) {
+        switch (t.bits()) {
+        case 8:
+            v.u.i8 = (int8_t)*i;
+            break;
+        case 16:
+            v.u.i16 = (int16_t)*i;
+            break;
+        case 32:
+            v.u.i32 = (int32_t)*i;
+            break;
+        case 64:
+            v.u.i64 = *i;
+            break;
+        default:
+            return false;
+        }
+    } else if (const uint64_t *u = as_const_uint(c)) {
+        switch (t.bits()) {
+        case 1:
+            v.u.b = *u != 0;
+            break;
+        case 8:
+            v.u.u8 = (uint8_t)*u;
+            break;
+        case 16:
+            v.u.u16 = (uint16_t)*u;
+            break;
+        case 32:
+            v.u.u32 = (uint32_t)*u;
+            break;
+        case 64:
+            v.u.u64 = *u;
+            break;
+        default:
+            return false;
+        }
+    } else if (const double *f = as_const_float(c)) {
+        switch (t.bits()) {
+        case 32:
+            v.u.f32 = (float)*f;
+            break;
+        case 64:
+            v.u.f64 = *f;
+            break;
+        default:
+            return false;
+        }
+    } else {
+        return false;
+    }
+    p.set_scalar(t, v);
+    return true;
+}
+
+// Find all the Params and ImageParams used by some functions.
+class FindParameters : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    void visit(const Variable *op) override {
+        if (op->param.defined()) {
+            params.emplace(op->param.name(), op->param);
+        }
+    }
+
+    void visit(const Call *op) override {
+        IRGraphVisitor::visit(op);
+        if (op->param.defined()) {
+            params.emplace(op->param.name(), op->param);
+        }
+    }
+
+public:
+    map<string, Parameter> params;
+};
+
+// Times the pipeline with the schedule generated from the current partition
+// of a Partitioner, by JIT-compiling it for the host and running it on
+// buffers the size of the estimates. This is used by the measured-feedback
+// mode to pick among the candidate groupings and tile sizes that the cost
+// model likes best, as the cost model can be far off on some machines.
+//
+// Scalar parameters are set to their estimates while timing, and input
+// buffers which aren't already bound are bound to zero-filled buffers of the
+// required size. The schedules of the functions and the values of the
+// parameters are restored after each measurement. The total time spent
+// compiling and timing is bounded by 'time_limit' seconds.
+class PipelineTimer {
+public:
+    PipelineTimer(const vector<Function> &outputs, const map<string, Function> &env,
+                  const vector<string> &top_order, const Target &target, double time_limit)
+        : outputs(outputs), env(env), top_order(top_order), target(target),
+          jit_target(get_jit_target_from_environment()), time_limit(time_limit),
+          start(std::chrono::steady_clock::now()) {
+        // The schedule is generated for 'target', so the timings are only
+        // meaningful if the host runs the same kind of code.
+        if (target.os != jit_target.os || target.arch != jit_target.arch ||
+            target.bits != jit_target.bits || target.has_gpu_feature()) {
+            debug(1) << "Not measuring schedules: target " << target
+                     << " doesn't match the host " << jit_target << "\n";
+            return;
+        }
+
+        FindParameters find;
+        for (const auto &iter : env) {
+            if (iter.second.has_extern_definition()) {
+                debug(1) << "Not measuring schedules: pipeline has extern stage "
+                         << iter.first << "\n";
+                return;
+            }
+            iter.second.accept(&find);
+
+            // Remember the schedules to restore them after each measurement.
+            SavedSchedule saved{iter.second, deep_copy_schedule(iter.second.schedule()), {}};
+            saved.stages.push_back(iter.second.definition().schedule().get_copy());
+            for (const Definition &def : iter.second.updates()) {
+                saved.stages.push_back(def.schedule().get_copy());
+            }
+            schedules.push_back(std::move(saved));
+        }
+        params = find.params;
+
+        for (const Function &f : outputs) {
+            vector<int> mins, extents;
+            for (const string &arg : f.args()) {
+                for (const Bound &b : f.schedule().estimates()) {
+                    if (b.var == arg) {
+                        const int64_t *min = as_const_int(b.min);
+                        const int64_t *extent = as_const_int(b.extent);
+                        if (min && extent) {
+                            mins.push_back((int)*min);
+                            extents.push_back((int)*extent);
+                        }
+                        break;
+                    }
+                }
+            }
+            if (extents.size() != f.args().size()) {
+                debug(1) << "Not measuring schedules: no constant estimates for "
+                         << f.name() << "\n";
+                return;
+            }
+            output_mins.push_back(mins);
+            output_extents.push_back(extents);
+        }
+
+        supported = true;
+    }
+
+    // Whether the pipeline can be timed on the host.
+    bool can_measure() const {
+        return supported;
+    }
+
+    bool out_of_time() const {
+        return elapsed() >= time_limit;
+    }
+
+    // Generate the schedule for the current partition of 'part', and return
+    // the time in seconds to run the pipeline with it, or a negative value if
+    // the time limit has been reached or the pipeline couldn't be run.
+    double time(Partitioner &part) {
+        if (!supported || out_of_time()) {
+            return -1;
+        }
+
+        AutoSchedule sched(env, top_order);
+        part.generate_cpu_schedule(target, sched);
+
+        vector<Func> funcs;
+        for (const Function &f : outputs) {
+            funcs.emplace_back(f);
+        }
+        Pipeline p(funcs);
+
+        // Set the scalar parameters to their estimates.
+        map<string, halide_scalar_value_t> old_values;
+        for (auto &iter : params) {
+            Parameter &param = iter.second;
+            if (!param.is_buffer() && param.estimate().defined()) {
+                halide_scalar_value_t old;
+                memcpy(&old, param.scalar_address(), param.type().bytes());
+                if (set_scalar_from_expr(param, param.estimate())) {
+                    old_values.emplace(iter.first, old);
+                }
+            }
+        }
+
+        vector<Buffer<>> buffers;
+        for (size_t i = 0; i < outputs.size(); i++) {
+            for (const Type &t : outputs[i].output_types()) {
+                Buffer<> b(t, output_extents[i]);
+                b.set_min(output_mins[i]);
+                buffers.push_back(b);
+            }
+        }
+        Realization out(std::move(buffers));
+
+        // Bind the unbound inputs to buffers of the size required.
+        vector<string> bound;
+        for (const auto &iter : params) {
+            if (iter.second.is_buffer() && !iter.second.buffer().defined()) {
+                bound.push_back(iter.first);
+            }
+        }
+
+        // Errors from running the pipeline are caught by the context, and
+        // errors from compiling it are thrown. Either way, the schedule
+        // isn't measured, and everything is put back as it was.
+        TimingContext context;
+        double t = -1;
+        try {
+            p.infer_input_bounds(&context, out, jit_target);
+            for (const string &name : bound) {
+                Buffer<> b = params.at(name).buffer();
+                if (b.defined()) {
+                    memset(b.data(), 0, b.size_in_bytes());
+                }
+            }
+
+            if (!context.failed) {
+                p.realize(&context, out, jit_target);
+            }
+            if (!context.failed) {
+                Tools::BenchmarkConfig config;
+                config.min_time = 0.05;
+                config.max_time = std::max(config.min_time, std::min(0.5, time_limit - elapsed()));
+                t = Tools::benchmark([&]() { p.realize(&context, out, jit_target); }, config);
+                num_measured++;
+            }
+        } catch (const Halide::Error &e) {
+            debug(1) << "Not measuring schedule: " << e.what() << "\n";
+        }
+        if (context.failed) {
+            t = -1;
+        }
+
+        for (const string &name : bound) {
+            params.at(name).set_buffer(Buffer<>());
+        }
+        for (const auto &iter : old_values) {
+            Parameter &param = params.at(iter.first);
+            param.set_scalar(param.type(), iter.second);
+        }
+        restore_schedules();
+        return t;
+    }
+
+    int num_measurements() const {
+        return num_measured;
+    }
+
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    // Records runtime errors instead of reporting them.
+    struct TimingContext : public JITUserContext {
+        bool failed = false;
+
+        TimingContext() {
+            handlers.custom_error = error;
+        }
+
+        static void error(JITUserContext *ctx, const char *msg) {
+            debug(1) << "Not measuring schedule: " << msg << "\n";
+            static_cast<TimingContext *>(ctx)->failed = true;
+        }
+    };
+
+    struct SavedSchedule {
+        Function func;
+        FuncSchedule schedule;
+        vector<StageSchedule> stages;
+    };
+
+    static FuncSchedule deep_copy_schedule(const FuncSchedule &s) {
+        // The wrappers aren't rescheduled, so the copy can share them.
+        std::map<FunctionPtr, FunctionPtr> copied;
+        for (const auto &iter : s.wrappers()) {
+            copied[iter.second] = iter.second;
+        }
+        return s.deep_copy(copied);
+    }
+
+    void restore_schedules() {
+        for (SavedSchedule &saved : schedules) {
+            saved.func.schedule() = deep_copy_schedule(saved.schedule);
+            saved.func.definition().schedule() = saved.stages[0].get_copy();
+            for (size_t i = 1; i < saved.stages.size(); i++) {
+                saved.func.update(i - 1).schedule() = saved.stages[i].get_copy();
+            }
+        }
+    }
+
+    const vector<Function> &outputs;
+    const map<string, Function> &env;
+    const vector<string> &top_order;
+    const Target target;
+    const Target jit_target;
+    const double time_limit;
+    const std::chrono::steady_clock::time_point start;
+
+    bool supported = false;
+    int num_measured = 0;
+    vector<SavedSchedule> schedules;
+    map<string, Parameter> params;
+    vector<vector<int>> output_mins, output_extents;
+};
+
+bool same_tile_sizes(const map<string, Expr> &a, const map<string, Expr> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (const auto &iter : a) {
+        auto it = b.find(iter.first);
+        if (it == b.end() || !equal(iter.second, it->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pick among the candidate partitions recorded by the partitioner, and then
+// among the 'top_k' best tile sizes of each group according to the cost
+// model, by timing the whole pipeline with each choice. Groups are tuned one
+// at a time, starting with the most expensive one, keeping the choices made
+// for the others fixed. Whatever has been found when the time limit is
+// reached is kept. Returns the time in seconds taken by the schedule chosen,
+// or a negative value if the pipeline couldn't be timed.
+double tune_partition(Partitioner &part, PipelineTimer &timer, int top_k) {
+    double best_time = timer.time(part);
+    if (best_time < 0) {
+        return best_time;
+    }
+    debug(1) << "Measured the schedule chosen by the cost model: " << best_time * 1e3 << " ms\n";
+
+    // The most recent partition is the current one.
+    Partitioner::Partition best = part.get_partition();
+    for (int i = (int)part.recent_partitions.size() - 2; i >= 0 && !timer.out_of_time(); i--) {
+        part.set_partition(part.recent_partitions[i]);
+        double t = timer.time(part);
+        debug(1) << "Measured the partition with " << part.groups.size() << " groups: "
+                 << t * 1e3 << " ms\n";
+        if (t >= 0 && t < best_time) {
+            best_time = t;
+            best = part.get_partition();
+        }
+    }
+    part.set_partition(best);
+
+    vector<pair<double, FStage>> order;
+    for (const auto &g : part.groups) {
+        double cost = 0;
+        auto iter = part.group_costs.find(g.first);
+        if (iter != part.group_costs.end() && iter->second.cost.defined()) {
+            const Cost &c = iter->second.cost;
+            const double *f = as_const_float(simplify(cast<double>(c.arith + c.memory)));
+            cost = f ? *f : 0;
+        }
+        order.emplace_back(cost, g.first);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const pair<double, FStage> &a, const pair<double, FStage> &b) {
+                         return a.first > b.first;
+                     });
+
+    for (const auto &o : order) {
+        Partitioner::Group &g = part.groups.at(o.second);
+        for (const auto &config : part.find_top_tile_configs(g, top_k)) {
+            if (timer.out_of_time()) {
+                break;
+            }
+            if (same_tile_sizes(config, g.tile_sizes)) {
+                continue;
+            }
+            map<string, Expr> old_config = g.tile_sizes;
+            g.tile_sizes = config;
+            double t = timer.time(part);
+            debug(1) << "Measured tile sizes {";
+            for (const auto &iter : config) {
+                debug(1) << " (" << iter.first << ", " << iter.second << ")";
+            }
+            debug(1) << " } for " << o.second << ": " << t * 1e3 << " ms\n";
+            if (t >= 0 && t < best_time) {
+                best_time = t;
+                part.group_costs[o.second] = part.analyze_group(g, false);
+            } else {
+                g.tile_sizes = old_config;
+            }
+        }
+    }
+
+    debug(1) << "Measured " << timer.num_measurements() << " schedules in "
+             << timer.elapsed() << " s; best: " << best_time * 1e3 << " ms\n";
+    return best_time;
+}
+
 }  // anonymous namespace
 
 // Generate schedules for all functions in the pipeline required to compute the
@@ -3342,6 +3842,19 @@ string generate_schedules(const vector<Function> &outputs, const Target &target,
         part.disp_grouping();
     }
 
+    // In the measured-feedback mode, the best few groupings and tile sizes
+    // according to the cost model are timed on the host to pick among them.
+    // HL_MULLAPUDI_BENCHMARK_TOP_K sets the number of candidates to time for
+    // the grouping and for the tile sizes of each group, and turns the mode
+    // on. HL_MULLAPUDI_BENCHMARK_TIME_LIMIT bounds the total time spent
+    // compiling and timing candidates, in seconds (default 60).
+    int benchmark_top_k = 0;
+    string top_k_str = get_env_variable("HL_MULLAPUDI_BENCHMARK_TOP_K");
+    if (!top_k_str.empty()) {
+        benchmark_top_k = std::max(0, std::atoi(top_k_str.c_str()));
+    }
+    part.num_partitions_to_keep = benchmark_top_k;
+
     debug(2) << "Partitioner computing fast-mem group...\n";
     part.grouping_cache.clear();
     part.group(Partitioner::Level::FastMem);
@@ -3351,12 +3864,35 @@ string generate_schedules(const vector<Function> &outputs, const Target &target,
         part.disp_pipeline_graph();
     }
 
+    double measured_time = -1;
+    int num_measured = 0;
+    if (benchmark_top_k > 0) {
+        double time_limit = 60;
+        string time_limit_str = get_env_variable("HL_MULLAPUDI_BENCHMARK_TIME_LIMIT");
+        if (!time_limit_str.empty()) {
+            time_limit = std::atof(time_limit_str.c_str());
+        }
+        debug(2) << "Measuring candidate schedules...\n";
+        PipelineTimer timer(outputs, env, top_order, target, time_limit);
+        if (timer.can_measure()) {
+            measured_time = tune_partition(part, timer, benchmark_top_k);
+            num_measured = timer.num_measurements();
+            if (debug::debug_level() >= 3) {
+                part.disp_grouping();
+            }
+        }
+    }
+
     debug(2) << "Initializing AutoSchedule...\n";
     AutoSchedule sched(env, top_order);
     debug(2) << "Generating CPU schedule...\n";
     part.generate_cpu_schedule(target, sched);
 
     std::ostringstream oss;
+    if (measured_time >= 0) {
+        oss << "// Chosen by timing " << num_measured << " candidate schedules on the host. "
+            << "The fastest took " << measured_time * 1e3 << " ms.\n";
+    }
     oss << sched;
     string sched_string = oss.str();
 
@@ -333,6 +333,44 @@ extern void halide_join_thread(struct halide_thread *);
  */
 extern int halide_set_num_threads(int n);
 
+/** Select how the default thread pool schedules the iterations of
+ * parallel loops. When work stealing is enabled, parallel loops that
+ * have no semaphores to acquire and no minimum thread requirements
+ * are split into one range of iterations per worker, which workers
+ * claim without taking the thread pool lock, stealing half of another
+ * worker's remaining range when their own runs out. This reduces lock
+ * contention for fine-grained parallel loops on machines with many
+ * cores. All other tasks use the shared job stack as usual. The
+ * default is taken from the HL_WORK_STEALING environment variable
+ * (off if unset). Returns the old setting.
+ *
+ * (Only supported on 64-bit targets when using the default
+ * implementations of halide_do_par_for() and
+ * halide_do_parallel_tasks(); otherwise it is ignored.)
+ */
+extern bool halide_set_thread_pool_work_stealing(bool enable);
+
+/** Enable NUMA-aware execution. When enabled, the default thread pool
+ * pins each worker to a core, dealing workers out across NUMA nodes,
+ * and parallel loops without semaphores are split into one range of
+ * iterations per worker (as in work-stealing mode), so that the same
+ * iterations run on the same node from one call to the next, and
+ * idle workers steal from workers on their own node first. Large
+ * allocations made by halide_default_malloc are not touched until
+ * they are first written, so the pages of a buffer produced by a
+ * parallel loop end up on the nodes of the workers that produced
+ * them. When freed, these are kept for reuse by allocations of the
+ * same size, up to the limit set by
+ * halide_set_host_allocation_pool_limit, and released by
+ * halide_trim_host_allocations. The default is taken from the
+ * HL_NUMA environment variable. Must be set before the thread pool is
+ * first used (or after halide_shutdown_thread_pool) for threads to be
+ * pinned. Returns the old setting.
+ *
+ * (Only implemented on Linux; ignored elsewhere.)
+ */
+extern bool halide_set_numa_aware(bool enable);
+
 /** Halide calls these functions to allocate and free memory. To
  * replace in AOT code, use the halide_set_custom_malloc and
  * halide_set_custom_free, or (on platforms that support weak
@@ -361,6 +399,36 @@ extern halide_malloc_t halide_set_custom_malloc(halide_malloc_t user_malloc);
 extern halide_free_t halide_set_custom_free(halide_free_t user_free);
 //@}
 
+/** Tell Halide whether or not halide_default_free may hold onto host
+ * allocations to service future requests instead of returning them to
+ * the system allocator, analogous to halide_reuse_device_allocations
+ * for device memory. Pipelines that are called many times per second
+ * otherwise pay for a malloc and free of every intermediate buffer on
+ * every call. Freed blocks are cached in size classes a quarter of an
+ * octave apart, each with its own lock, up to a limit on the total
+ * unused bytes held (256MB by default). Allocations larger than 64MB
+ * are never pooled. The default is taken from the
+ * HL_REUSE_HOST_ALLOCATIONS environment variable (off if unset).
+ *
+ * If set to false, releases all unused host allocations held by the
+ * pool. */
+extern int halide_reuse_host_allocations(void *user_context, bool);
+
+/** Determines whether halide_default_malloc and halide_default_free
+ * use the host allocation pool. Override and switch based on the
+ * user_context for finer-grained control. By default just returns the
+ * value most recently set by the method above. */
+extern bool halide_can_reuse_host_allocations(void *user_context);
+
+/** Release unused host allocations held by the pool, largest first,
+ * until it holds no more than the given number of bytes. Pass zero to
+ * release everything. */
+extern int halide_trim_host_allocations(void *user_context, size_t max_unused_bytes);
+
+/** Set the most unused memory the host allocation pool may hold,
+ * trimming it if necessary. Returns the old limit. */
+extern size_t halide_set_host_allocation_pool_limit(size_t max_unused_bytes);
+
 /** Halide calls these functions to interact with the underlying
  * system runtime functions. To replace in AOT code on platforms that
  * support weak linking, define these functions yourself, or use
@@ -565,7 +633,14 @@ struct halide_trace_event_t {
  * HL_TRACE_FILE is defined, dumps the trace to that file in a
  * sequence of trace packets. The header for a trace packet is defined
  * below. If the trace is going to be large, you may want to make the
- * file a named pipe, and then read from that pipe into gzip.
+ * file a named pipe, and then read from that pipe into gzip. Setting
+ * the environment variable HL_TRACE_SAMPLE to N > 1 makes the default
+ * implementation trace only every Nth load and store event of each
+ * Func, which makes tracing much cheaper; all other events are traced.
+ * Load and store events skipped by sampling are not written, and
+ * halide_default_trace returns 0 for them instead of a unique ID. Loads
+ * and stores are never parents of other events, so nothing uses their
+ * IDs.
  *
  * halide_trace returns a unique ID which will be passed to future
  * events that "belong" to the earlier event as the parent id. The
@@ -943,6 +1018,35 @@ extern void halide_memoization_cache_release(void *user_context, void *host);
  */
 extern void halide_memoization_cache_cleanup();
 
+/** Counters describing the behavior of the memoization cache, as
+ * returned by halide_memoization_cache_get_stats. Hits and misses
+ * count calls to halide_memoization_cache_lookup. Evictions count
+ * entries discarded to keep the cache within its size limit; entries
+ * removed by halide_memoization_cache_evict are not included.
+ */
+struct halide_memoization_cache_stats_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t evicted_bytes;
+    /** Number of entries and bytes currently held by the cache, and
+     * the limit set by halide_memoization_cache_set_size. */
+    uint64_t entries;
+    int64_t current_size;
+    int64_t max_size;
+};
+
+/** Fill in the current memoization cache counters. The counters are
+ * kept per lock shard and summed here, so the result is not an atomic
+ * snapshot if other threads are using the cache concurrently.
+ */
+extern void halide_memoization_cache_get_stats(void *user_context, struct halide_memoization_cache_stats_t *stats);
+
+/** Reset the hit, miss, and eviction counters to zero. Does not
+ * affect the contents of the cache.
+ */
+extern void halide_memoization_cache_reset_stats(void *user_context);
+
 /** Verify that a given range of memory has been initialized; only used when Target::MSAN is enabled.
  *
  * The default implementation simply calls the LLVM-provided __msan_check_mem_is_initialized() function.
@@ -1345,6 +1449,7 @@ typedef enum halide_target_feature_t {
     halide_target_feature_armv81a,                ///< Enable ARMv8.1-a instructions
     halide_target_feature_sanitizer_coverage,     ///< Enable hooks for SanitizerCoverage support.
     halide_target_feature_profile_by_timer,       ///< Alternative to halide_target_feature_profile using timer interrupt for systems without threads or applicartions that need to avoid them.
+    halide_target_feature_avx512_vnni,            ///< Enable the AVX512 features supported by Cascade Lake processors. This includes all of the Skylake features, plus AVX512-VNNI.
     halide_target_feature_end                     ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
 
@@ -1717,6 +1822,24 @@ void halide_register_argv_and_metadata(
  * the -profile target flag, which runs a sampling profiler thread
  * alongside the pipeline. */
 
+/** Hardware performance counters the sampling profiler can attribute
+ * to each Func. Counting is opt-in: set the environment variable
+ * HL_PROFILER_COUNTERS=1. Only implemented on Linux, using
+ * perf_event_open, and only counts user-space events of the thread that
+ * starts the profiler and the threads it creates afterwards (such as
+ * the thread pool). If the counters can't be opened (e.g. because of
+ * /proc/sys/kernel/perf_event_paranoid), they stay zero. */
+enum halide_profiler_counter_t {
+    halide_profiler_cycles = 0,
+    halide_profiler_instructions,
+    /** Last-level cache references and misses. */
+    halide_profiler_cache_references,
+    halide_profiler_cache_misses,
+    halide_profiler_branches,
+    halide_profiler_branch_misses,
+    halide_profiler_num_counters
+};
+
 /** Per-Func state tracked by the sampling profiler. */
 struct halide_profiler_func_stats {
     /** Total time taken evaluating this Func (in nanoseconds). */
@@ -1742,6 +1865,11 @@ struct halide_profiler_func_stats {
 
     /** The total number of memory allocation of this Func. */
     int num_allocs;
+
+    /** The hardware performance counters billed to this Func, indexed
+     * by halide_profiler_counter_t. Last, so that the fields before
+     * it stay where they were before counters were added. */
+    uint64_t counters[halide_profiler_num_counters];
 };
 
 /** Per-pipeline state tracked by the sampling profiler. These exist
@@ -1787,6 +1915,12 @@ struct halide_profiler_pipeline_stats {
 
     /** The total number of memory allocation of funcs in this pipeline. */
     int num_allocs;
+
+    /** The hardware performance counters billed to funcs in this
+     * pipeline, indexed by halide_profiler_counter_t. Last, so that
+     * the fields before it stay where they were before counters were
+     * added. */
+    uint64_t counters[halide_profiler_num_counters];
 };
 
 /** The global state of the profiler. */
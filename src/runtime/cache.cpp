@@ -1,6 +1,7 @@
 #include "HalideRuntime.h"
 #include "device_buffer_utils.h"
 #include "printer.h"
+#include "runtime_internal.h"
 #include "scoped_mutex_lock.h"
 
 namespace Halide {
@@ -84,6 +85,10 @@ struct CacheEntry {
     halide_buffer_t *buf;
     uint64_t eviction_key;
     bool has_eviction_key;
+    // Total bytes of the tuple buffers, and how long it took to compute
+    // them. Together these decide which entry to evict first.
+    uint64_t bytes;
+    uint64_t recompute_ns;
 
     bool init(const uint8_t *cache_key, size_t cache_key_size,
               uint32_t key_hash,
@@ -97,6 +102,9 @@ struct CacheEntry {
 struct CacheBlockHeader {
     CacheEntry *entry;
     uint32_t hash;
+    // Time of the cache miss that allocated this block, used to measure
+    // how long the result took to compute when it is stored.
+    int64_t miss_time_ns;
 };
 
 // Each host block has extra space to store a header just before the
@@ -174,6 +182,12 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
 
     has_eviction_key = has_eviction_key_arg;
     eviction_key = eviction_key_arg;
+
+    bytes = 0;
+    for (uint32_t i = 0; i < tuple_count; i++) {
+        bytes += buf[i].size_in_bytes();
+    }
+    recompute_ns = 0;
     return true;
 }
 
@@ -196,34 +210,76 @@ WEAK uint32_t djb_hash(const uint8_t *key, size_t key_size) {
     return h;
 }
 
-WEAK halide_mutex memoization_lock = {{0}};
 
+// The cache is split into independently locked shards, chosen by the
+// key hash, so that threads looking up unrelated keys rarely contend on
+// the same mutex. Each shard has its own hash table and its own
+// MRU/LRU list; the size limit is global.
+const int kCacheShards = 16;
 const size_t kHashTableSize = 256;
 
-WEAK CacheEntry *cache_entries[kHashTableSize];
+struct CacheShard {
+    halide_mutex lock;
+    CacheEntry *entries[kHashTableSize];
+    CacheEntry *most_recently_used;
+    CacheEntry *least_recently_used;
+    int64_t size;
+    uint64_t entry_count;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t evicted_bytes;
+};
 
-WEAK CacheEntry *most_recently_used = nullptr;
-WEAK CacheEntry *least_recently_used = nullptr;
+WEAK CacheShard cache_shards[kCacheShards];
 
 const uint64_t kDefaultCacheSize = 1 << 20;
 WEAK int64_t max_cache_size = kDefaultCacheSize;
+// Sum of the shard sizes, updated atomically so that any thread can
+// check it against max_cache_size without taking a lock.
 WEAK int64_t current_cache_size = 0;
 
+// Shard to start the next eviction sweep from.
+WEAK int next_prune_shard = 0;
+
+// When choosing something to evict, look at this many unused entries at
+// the least recently used end of a shard, and no more than
+// kEvictionScanLimit entries in total.
+const int kEvictionSampleSize = 8;
+const int kEvictionScanLimit = 32;
+
+WEAK __attribute((always_inline)) CacheShard &shard_for_hash(uint32_t h) {
+    // The low bits pick the hash bucket, so use the next ones up.
+    return cache_shards[(h / kHashTableSize) % kCacheShards];
+}
+
+WEAK __attribute((always_inline)) bool cache_over_budget() {
+    return __atomic_load_n(&current_cache_size, __ATOMIC_RELAXED) >
+           __atomic_load_n(&max_cache_size, __ATOMIC_RELAXED);
+}
+
 #if CACHE_DEBUGGING
-WEAK void validate_cache() {
-    print(nullptr) << "validating cache, "
-                   << "current size " << current_cache_size
+WEAK void validate_shard(CacheShard &shard) {
+    print(nullptr) << "validating cache shard, "
+                   << "shard size " << shard.size
+                   << ", current size " << current_cache_size
                    << " of maximum " << max_cache_size << "\n";
     int entries_in_hash_table = 0;
+    int64_t bytes_in_hash_table = 0;
     for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
+        CacheEntry *entry = shard.entries[i];
         while (entry != nullptr) {
             entries_in_hash_table++;
-            if (entry->more_recent == nullptr && entry != most_recently_used) {
+            bytes_in_hash_table += entry->bytes;
+            if (&shard_for_hash(entry->hash) != &shard) {
+                halide_print(nullptr, "cache invalid case 0\n");
+                __builtin_trap();
+            }
+            if (entry->more_recent == nullptr && entry != shard.most_recently_used) {
                 halide_print(nullptr, "cache invalid case 1\n");
                 __builtin_trap();
             }
-            if (entry->less_recent == nullptr && entry != least_recently_used) {
+            if (entry->less_recent == nullptr && entry != shard.least_recently_used) {
                 halide_print(nullptr, "cache invalid case 2\n");
                 __builtin_trap();
             }
@@ -231,13 +287,13 @@ WEAK void validate_cache() {
         }
     }
     int entries_from_mru = 0;
-    CacheEntry *mru_chain = most_recently_used;
+    CacheEntry *mru_chain = shard.most_recently_used;
     while (mru_chain != nullptr) {
         entries_from_mru++;
         mru_chain = mru_chain->less_recent;
     }
     int entries_from_lru = 0;
-    CacheEntry *lru_chain = least_recently_used;
+    CacheEntry *lru_chain = shard.least_recently_used;
     while (lru_chain != nullptr) {
         entries_from_lru++;
         lru_chain = lru_chain->more_recent;
@@ -253,6 +309,11 @@ WEAK void validate_cache() {
         halide_print(nullptr, "cache invalid case 4\n");
         __builtin_trap();
     }
+    if ((uint64_t)entries_in_hash_table != shard.entry_count ||
+        bytes_in_hash_table != shard.size) {
+        halide_print(nullptr, "cache invalid case 5\n");
+        __builtin_trap();
+    }
     if (current_cache_size < 0) {
         halide_print(nullptr, "cache size is negative\n");
         __builtin_trap();
@@ -260,62 +321,144 @@ WEAK void validate_cache() {
 }
 #endif
 
-WEAK void prune_cache() {
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
-    CacheEntry *prune_candidate = least_recently_used;
-    while (current_cache_size > max_cache_size &&
-           prune_candidate != nullptr) {
-        CacheEntry *more_recent = prune_candidate->more_recent;
-
-        if (prune_candidate->in_use_count == 0) {
-            uint32_t h = prune_candidate->hash;
-            uint32_t index = h % kHashTableSize;
-
-            // Remove from hash table
-            CacheEntry *prev_hash_entry = cache_entries[index];
-            if (prev_hash_entry == prune_candidate) {
-                cache_entries[index] = prune_candidate->next;
-            } else {
-                while (prev_hash_entry != nullptr && prev_hash_entry->next != prune_candidate) {
-                    prev_hash_entry = prev_hash_entry->next;
-                }
-                halide_abort_if_false(nullptr, prev_hash_entry != nullptr);
-                prev_hash_entry->next = prune_candidate->next;
-            }
+// Move an entry to the most recently used end of its shard's list.
+WEAK void touch_entry(CacheShard &shard, CacheEntry *entry) {
+    if (entry == shard.most_recently_used) {
+        return;
+    }
+    halide_abort_if_false(nullptr, entry->more_recent != nullptr);
+    if (entry->less_recent != nullptr) {
+        entry->less_recent->more_recent = entry->more_recent;
+    } else {
+        halide_abort_if_false(nullptr, shard.least_recently_used == entry);
+        shard.least_recently_used = entry->more_recent;
+    }
+    entry->more_recent->less_recent = entry->less_recent;
 
-            // Remove from less recent chain.
-            if (least_recently_used == prune_candidate) {
-                least_recently_used = more_recent;
-            }
-            if (more_recent != nullptr) {
-                more_recent->less_recent = prune_candidate->less_recent;
-            }
+    entry->more_recent = nullptr;
+    entry->less_recent = shard.most_recently_used;
+    shard.most_recently_used->more_recent = entry;
+    shard.most_recently_used = entry;
+}
 
-            // Remove from more recent chain.
-            if (most_recently_used == prune_candidate) {
-                most_recently_used = prune_candidate->less_recent;
-            }
-            if (prune_candidate->less_recent != nullptr) {
-                prune_candidate->less_recent = more_recent;
-            }
+WEAK void insert_entry(CacheShard &shard, CacheEntry *entry) {
+    uint32_t index = entry->hash % kHashTableSize;
+    entry->next = shard.entries[index];
+    shard.entries[index] = entry;
 
-            // Decrease cache used amount.
-            for (uint32_t i = 0; i < prune_candidate->tuple_count; i++) {
-                current_cache_size -= prune_candidate->buf[i].size_in_bytes();
-            }
+    entry->more_recent = nullptr;
+    entry->less_recent = shard.most_recently_used;
+    if (shard.most_recently_used != nullptr) {
+        shard.most_recently_used->more_recent = entry;
+    }
+    shard.most_recently_used = entry;
+    if (shard.least_recently_used == nullptr) {
+        shard.least_recently_used = entry;
+    }
 
-            // Deallocate the entry.
-            prune_candidate->destroy();
-            halide_free(nullptr, prune_candidate);
-        }
+    shard.size += entry->bytes;
+    shard.entry_count++;
+    __atomic_fetch_add(&current_cache_size, (int64_t)entry->bytes, __ATOMIC_RELAXED);
+}
+
+// Unlink an entry from its shard. The caller destroys it, preferably
+// after releasing the shard lock.
+WEAK void remove_entry(CacheShard &shard, CacheEntry *entry) {
+    uint32_t index = entry->hash % kHashTableSize;
+    CacheEntry **prev = &shard.entries[index];
+    while (*prev != nullptr && *prev != entry) {
+        prev = &(*prev)->next;
+    }
+    halide_abort_if_false(nullptr, *prev != nullptr);
+    *prev = entry->next;
+    entry->next = nullptr;
 
-        prune_candidate = more_recent;
+    if (entry->more_recent != nullptr) {
+        entry->more_recent->less_recent = entry->less_recent;
+    } else {
+        shard.most_recently_used = entry->less_recent;
+    }
+    if (entry->less_recent != nullptr) {
+        entry->less_recent->more_recent = entry->more_recent;
+    } else {
+        shard.least_recently_used = entry->more_recent;
     }
+
+    shard.size -= entry->bytes;
+    shard.entry_count--;
+    __atomic_fetch_sub(&current_cache_size, (int64_t)entry->bytes, __ATOMIC_RELAXED);
+}
+
+// Returns true if a is a better eviction candidate than b, i.e. it saves
+// less recompute time per byte of cache it occupies.
+WEAK bool cheaper_to_recompute(const CacheEntry *a, const CacheEntry *b) {
+    // Compare a.ns / a.bytes < b.ns / b.bytes without dividing. Use
+    // doubles, as the products can overflow 64 bits.
+    return (double)a->recompute_ns * (double)b->bytes <
+           (double)b->recompute_ns * (double)a->bytes;
+}
+
+// Pick an entry to evict from the least recently used end of a
+// shard. Recency decides which entries are considered at all, and among
+// those the one that is cheapest to recompute for the memory it holds is
+// chosen. Entries that are in use are skipped. If nothing in the scanned
+// range can be evicted, the least recently used entry that can be is
+// chosen instead. Returns null only if every entry is in use.
+WEAK CacheEntry *choose_victim(CacheShard &shard) {
+    CacheEntry *victim = nullptr;
+    int sampled = 0;
+    int scanned = 0;
+    CacheEntry *entry = shard.least_recently_used;
+    for (; entry != nullptr && sampled < kEvictionSampleSize && scanned < kEvictionScanLimit;
+         entry = entry->more_recent) {
+        scanned++;
+        if (entry->in_use_count != 0) {
+            continue;
+        }
+        sampled++;
+        if (victim == nullptr || cheaper_to_recompute(entry, victim)) {
+            victim = entry;
+        }
+    }
+    while (victim == nullptr && entry != nullptr) {
+        if (entry->in_use_count == 0) {
+            victim = entry;
+        }
+        entry = entry->more_recent;
+    }
+    return victim;
+}
+
+// Evict entries until the cache fits in max_cache_size. Must be called
+// with no shard lock held. Shards are visited round robin, one victim
+// per shard per sweep, so that no single shard is drained before the
+// others are touched.
+WEAK void prune_cache() {
+    int start = __atomic_fetch_add(&next_prune_shard, 1, __ATOMIC_RELAXED);
+    bool evicted_any = true;
+    while (evicted_any && cache_over_budget()) {
+        evicted_any = false;
+        for (int i = 0; i < kCacheShards && cache_over_budget(); i++) {
+            CacheShard &shard = cache_shards[(unsigned)(start + i) % kCacheShards];
+            CacheEntry *victim;
+            {
+                ScopedMutexLock lock(&shard.lock);
+                victim = choose_victim(shard);
+                if (victim == nullptr) {
+                    continue;
+                }
+                remove_entry(shard, victim);
+                shard.evictions++;
+                shard.evicted_bytes += victim->bytes;
 #if CACHE_DEBUGGING
-    validate_cache();
+                validate_shard(shard);
 #endif
+            }
+            victim->destroy();
+            halide_free(nullptr, victim);
+            evicted_any = true;
+        }
+    }
 }
 
 }  // namespace Internal
@@ -329,9 +472,7 @@ WEAK void halide_memoization_cache_set_size(int64_t size) {
         size = kDefaultCacheSize;
     }
 
-    ScopedMutexLock lock(&memoization_lock);
-
-    max_cache_size = size;
+    __atomic_store_n(&max_cache_size, size, __ATOMIC_RELAXED);
     prune_cache();
 }
 
@@ -339,68 +480,63 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
                                          halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
     uint32_t h = djb_hash(cache_key, size);
     uint32_t index = h % kHashTableSize;
+    CacheShard &shard = shard_for_hash(h);
 
-    ScopedMutexLock lock(&memoization_lock);
+    {
+        ScopedMutexLock lock(&shard.lock);
 
 #if CACHE_DEBUGGING
-    debug_print_key(user_context, "halide_memoization_cache_lookup", cache_key, size);
+        debug_print_key(user_context, "halide_memoization_cache_lookup", cache_key, size);
 
-    debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
+        debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
 
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            debug_print_buffer(user_context, "Allocation bounds", *buf);
+        {
+            for (int32_t i = 0; i < tuple_count; i++) {
+                halide_buffer_t *buf = tuple_buffers[i];
+                debug_print_buffer(user_context, "Allocation bounds", *buf);
+            }
         }
-    }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
-    while (entry != nullptr) {
-        if (entry->hash == h && entry->key_size == (size_t)size &&
-            keys_equal(entry->key, cache_key, size) &&
-            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
-            entry->tuple_count == (uint32_t)tuple_count) {
-
-            // Check all the tuple buffers have the same bounds (they should).
-            bool all_bounds_equal = true;
-            for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
-                all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
-            }
-
-            if (all_bounds_equal) {
-                if (entry != most_recently_used) {
-                    halide_abort_if_false(user_context, entry->more_recent != nullptr);
-                    if (entry->less_recent != nullptr) {
-                        entry->less_recent->more_recent = entry->more_recent;
-                    } else {
-                        halide_abort_if_false(user_context, least_recently_used == entry);
-                        least_recently_used = entry->more_recent;
-                    }
-                    halide_abort_if_false(user_context, entry->more_recent != nullptr);
-                    entry->more_recent->less_recent = entry->less_recent;
+        CacheEntry *entry = shard.entries[index];
+        while (entry != nullptr) {
+            if (entry->hash == h && entry->key_size == (size_t)size &&
+                keys_equal(entry->key, cache_key, size) &&
+                buffer_has_shape(computed_bounds, entry->computed_bounds) &&
+                entry->tuple_count == (uint32_t)tuple_count) {
 
-                    entry->more_recent = nullptr;
-                    entry->less_recent = most_recently_used;
-                    if (most_recently_used != nullptr) {
-                        most_recently_used->more_recent = entry;
-                    }
-                    most_recently_used = entry;
+                // Check all the tuple buffers have the same bounds (they should).
+                bool all_bounds_equal = true;
+                for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
+                    all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
                 }
 
-                for (int32_t i = 0; i < tuple_count; i++) {
-                    halide_buffer_t *buf = tuple_buffers[i];
-                    *buf = entry->buf[i];
-                }
+                if (all_bounds_equal) {
+                    touch_entry(shard, entry);
+
+                    for (int32_t i = 0; i < tuple_count; i++) {
+                        halide_buffer_t *buf = tuple_buffers[i];
+                        *buf = entry->buf[i];
+                    }
 
-                entry->in_use_count += tuple_count;
+                    entry->in_use_count += tuple_count;
+                    shard.hits++;
 
-                return 0;
+                    return 0;
+                }
             }
+            entry = entry->next;
         }
-        entry = entry->next;
+
+        shard.misses++;
     }
 
+    // It's a miss. Allocate the buffers without holding the lock, and
+    // note the time so that the store can tell how long the computation
+    // took.
+    halide_start_clock(user_context);
+    int64_t miss_time_ns = halide_current_time_ns(user_context);
+
     for (int32_t i = 0; i < tuple_count; i++) {
         halide_buffer_t *buf = tuple_buffers[i];
 
@@ -416,12 +552,9 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
         CacheBlockHeader *header = get_pointer_to_header(buf->host);
         header->hash = h;
         header->entry = nullptr;
+        header->miss_time_ns = miss_time_ns;
     }
 
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
-
     return 1;
 }
 
@@ -431,107 +564,95 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
                                         bool has_eviction_key, uint64_t eviction_key) {
     debug(user_context) << "halide_memoization_cache_store has_eviction_key: " << has_eviction_key << " eviction_key " << eviction_key << " .\n";
 
-    uint32_t h = get_pointer_to_header(tuple_buffers[0]->host)->hash;
+    CacheBlockHeader *first_header = get_pointer_to_header(tuple_buffers[0]->host);
+    uint32_t h = first_header->hash;
+    int64_t recompute_ns = halide_current_time_ns(user_context) - first_header->miss_time_ns;
 
     uint32_t index = h % kHashTableSize;
+    CacheShard &shard = shard_for_hash(h);
 
-    ScopedMutexLock lock(&memoization_lock);
+    {
+        ScopedMutexLock lock(&shard.lock);
 
 #if CACHE_DEBUGGING
-    debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
+        debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
 
-    debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
+        debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
 
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            debug_print_buffer(user_context, "Allocation bounds", *buf);
+        {
+            for (int32_t i = 0; i < tuple_count; i++) {
+                halide_buffer_t *buf = tuple_buffers[i];
+                debug_print_buffer(user_context, "Allocation bounds", *buf);
+            }
         }
-    }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
-    while (entry != nullptr) {
-        if (entry->hash == h && entry->key_size == (size_t)size &&
-            keys_equal(entry->key, cache_key, size) &&
-            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
-            entry->tuple_count == (uint32_t)tuple_count) {
-
-            bool all_bounds_equal = true;
-            bool no_host_pointers_equal = true;
-            {
-                for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
-                    halide_buffer_t *buf = tuple_buffers[i];
-                    all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
-                    if (entry->buf[i].host == buf->host) {
-                        no_host_pointers_equal = false;
+        CacheEntry *entry = shard.entries[index];
+        while (entry != nullptr) {
+            if (entry->hash == h && entry->key_size == (size_t)size &&
+                keys_equal(entry->key, cache_key, size) &&
+                buffer_has_shape(computed_bounds, entry->computed_bounds) &&
+                entry->tuple_count == (uint32_t)tuple_count) {
+
+                bool all_bounds_equal = true;
+                bool no_host_pointers_equal = true;
+                {
+                    for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
+                        halide_buffer_t *buf = tuple_buffers[i];
+                        all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
+                        if (entry->buf[i].host == buf->host) {
+                            no_host_pointers_equal = false;
+                        }
                     }
                 }
-            }
-            if (all_bounds_equal) {
-                halide_abort_if_false(user_context, no_host_pointers_equal);
-                // This entry is still in use by the caller. Mark it as having no cache entry
-                // so halide_memoization_cache_release can free the buffer.
-                for (int32_t i = 0; i < tuple_count; i++) {
-                    get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+                if (all_bounds_equal) {
+                    halide_abort_if_false(user_context, no_host_pointers_equal);
+                    // This entry is still in use by the caller. Mark it as having no cache entry
+                    // so halide_memoization_cache_release can free the buffer.
+                    for (int32_t i = 0; i < tuple_count; i++) {
+                        get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+                    }
+                    return 0;
                 }
-                return 0;
             }
+            entry = entry->next;
         }
-        entry = entry->next;
-    }
 
-    uint64_t added_size = 0;
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            added_size += buf->size_in_bytes();
+        CacheEntry *new_entry = (CacheEntry *)halide_malloc(nullptr, sizeof(CacheEntry));
+        bool inited = false;
+        if (new_entry) {
+            inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers,
+                                     has_eviction_key, eviction_key);
         }
-    }
-    current_cache_size += added_size;
-    prune_cache();
-
-    CacheEntry *new_entry = (CacheEntry *)halide_malloc(nullptr, sizeof(CacheEntry));
-    bool inited = false;
-    if (new_entry) {
-        inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers,
-                                 has_eviction_key, eviction_key);
-    }
-    if (!inited) {
-        current_cache_size -= added_size;
+        if (!inited) {
+            // This entry is still in use by the caller. Mark it as having no cache entry
+            // so halide_memoization_cache_release can free the buffer.
+            for (int32_t i = 0; i < tuple_count; i++) {
+                get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+            }
 
-        // This entry is still in use by the caller. Mark it as having no cache entry
-        // so halide_memoization_cache_release can free the buffer.
-        for (int32_t i = 0; i < tuple_count; i++) {
-            get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+            if (new_entry) {
+                halide_free(user_context, new_entry);
+            }
+            return 0;
         }
 
-        if (new_entry) {
-            halide_free(user_context, new_entry);
+        new_entry->recompute_ns = recompute_ns > 0 ? recompute_ns : 0;
+        new_entry->in_use_count = tuple_count;
+        insert_entry(shard, new_entry);
+
+        for (int32_t i = 0; i < tuple_count; i++) {
+            get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
         }
-        return 0;
-    }
 
-    new_entry->next = cache_entries[index];
-    new_entry->less_recent = most_recently_used;
-    if (most_recently_used != nullptr) {
-        most_recently_used->more_recent = new_entry;
-    }
-    most_recently_used = new_entry;
-    if (least_recently_used == nullptr) {
-        least_recently_used = new_entry;
+#if CACHE_DEBUGGING
+        validate_shard(shard);
+#endif
     }
-    cache_entries[index] = new_entry;
 
-    new_entry->in_use_count = tuple_count;
-
-    for (int32_t i = 0; i < tuple_count; i++) {
-        get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
-    }
+    // The new entry is in use, so this can't evict it.
+    prune_cache();
 
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
     debug(user_context) << "Exiting halide_memoization_cache_store\n";
 
     return 0;
@@ -545,12 +666,13 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
     if (entry == nullptr) {
         halide_free(user_context, header);
     } else {
-        ScopedMutexLock lock(&memoization_lock);
+        CacheShard &shard = shard_for_hash(entry->hash);
+        ScopedMutexLock lock(&shard.lock);
 
         halide_abort_if_false(user_context, entry->in_use_count > 0);
         entry->in_use_count--;
 #if CACHE_DEBUGGING
-        validate_cache();
+        validate_shard(shard);
 #endif
     }
 
@@ -559,54 +681,84 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
 
 WEAK void halide_memoization_cache_cleanup() {
     debug(nullptr) << "halide_memoization_cache_cleanup\n";
-    for (auto &entry_ref : cache_entries) {
-        CacheEntry *entry = entry_ref;
-        entry_ref = nullptr;
-        while (entry != nullptr) {
-            CacheEntry *next = entry->next;
-            entry->destroy();
-            halide_free(nullptr, entry);
-            entry = next;
+    for (auto &shard : cache_shards) {
+        for (auto &entry_ref : shard.entries) {
+            CacheEntry *entry = entry_ref;
+            entry_ref = nullptr;
+            while (entry != nullptr) {
+                CacheEntry *next = entry->next;
+                entry->destroy();
+                halide_free(nullptr, entry);
+                entry = next;
+            }
         }
+        shard.most_recently_used = nullptr;
+        shard.least_recently_used = nullptr;
+        shard.size = 0;
+        shard.entry_count = 0;
     }
     current_cache_size = 0;
-    most_recently_used = nullptr;
-    least_recently_used = nullptr;
 }
 
 WEAK void halide_memoization_cache_evict(void *user_context, uint64_t eviction_key) {
-    ScopedMutexLock lock(&memoization_lock);
-
-    for (auto &entry_ref : cache_entries) {
-        CacheEntry *entry = entry_ref;
-        if (entry != nullptr) {
-            CacheEntry **prev = &entry_ref;
+    for (auto &shard : cache_shards) {
+        // Unlink the matching entries under the lock, chaining them
+        // through their (now unused) next pointers, and destroy them
+        // afterwards.
+        CacheEntry *evicted = nullptr;
+        {
+            ScopedMutexLock lock(&shard.lock);
+
+            CacheEntry *entry = shard.least_recently_used;
             while (entry != nullptr) {
-                CacheEntry *next = entry->next;
+                CacheEntry *more_recent = entry->more_recent;
                 if (entry->has_eviction_key && entry->eviction_key == eviction_key) {
-                    *prev = next;
-                    if (entry->more_recent != nullptr) {
-                        entry->more_recent->less_recent = entry->less_recent;
-                    } else {
-                        most_recently_used = entry->less_recent;
-                    }
-                    if (entry->less_recent != nullptr) {
-                        entry->less_recent->more_recent = entry->more_recent;
-                    } else {
-                        least_recently_used = entry->more_recent;
-                    }
-                    entry->destroy();
-                    halide_free(user_context, entry);
-                } else {
-                    prev = &entry->next;
+                    remove_entry(shard, entry);
+                    entry->next = evicted;
+                    evicted = entry;
                 }
-                entry = next;
+                entry = more_recent;
             }
-        }
-    }
 #if CACHE_DEBUGGING
-    validate_cache();
+            validate_shard(shard);
 #endif
+        }
+        while (evicted != nullptr) {
+            CacheEntry *next = evicted->next;
+            evicted->destroy();
+            halide_free(user_context, evicted);
+            evicted = next;
+        }
+    }
+}
+
+WEAK void halide_memoization_cache_get_stats(void *user_context, halide_memoization_cache_stats_t *stats) {
+    stats->hits = 0;
+    stats->misses = 0;
+    stats->evictions = 0;
+    stats->evicted_bytes = 0;
+    stats->entries = 0;
+    stats->current_size = 0;
+    for (auto &shard : cache_shards) {
+        ScopedMutexLock lock(&shard.lock);
+        stats->hits += shard.hits;
+        stats->misses += shard.misses;
+        stats->evictions += shard.evictions;
+        stats->evicted_bytes += shard.evicted_bytes;
+        stats->entries += shard.entry_count;
+        stats->current_size += shard.size;
+    }
+    stats->max_size = __atomic_load_n(&max_cache_size, __ATOMIC_RELAXED);
+}
+
+WEAK void halide_memoization_cache_reset_stats(void *user_context) {
+    for (auto &shard : cache_shards) {
+        ScopedMutexLock lock(&shard.lock);
+        shard.hits = 0;
+        shard.misses = 0;
+        shard.evictions = 0;
+        shard.evicted_bytes = 0;
+    }
 }
 
 namespace {
@@ -0,0 +1,39 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+WEAK bool halide_numa_enabled() {
+    return false;
+}
+
+WEAK bool halide_set_numa_aware(bool enable) {
+    return false;
+}
+
+WEAK int halide_numa_get_cpu_nodes(int *nodes, int num_cpus) {
+    for (int i = 0; i < num_cpus; i++) {
+        nodes[i] = 0;
+    }
+    return 1;
+}
+
+WEAK int halide_numa_pin_current_thread(int cpu) {
+    return -1;
+}
+
+WEAK void halide_numa_set_thread_slot(int slot) {
+}
+
+WEAK int halide_numa_get_thread_slot() {
+    return 0;
+}
+
+WEAK void *halide_numa_alloc_untouched(size_t size) {
+    return nullptr;
+}
+
+WEAK void halide_numa_free_untouched(void *ptr, size_t size) {
+}
+
+}  // extern "C"
@@ -0,0 +1,17 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+WEAK bool halide_profiler_counters_open() {
+    return false;
+}
+
+WEAK bool halide_profiler_counters_read(uint64_t *values) {
+    return false;
+}
+
+WEAK void halide_profiler_counters_close() {
+}
+
+}  // extern "C"
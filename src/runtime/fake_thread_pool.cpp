@@ -121,6 +121,10 @@ WEAK int halide_set_num_threads(int n) {
     return 1;
 }
 
+WEAK bool halide_set_thread_pool_work_stealing(bool enable) {
+    return false;
+}
+
 WEAK halide_do_task_t halide_set_custom_do_task(halide_do_task_t f) {
     halide_do_task_t result = custom_do_task;
     custom_do_task = f;
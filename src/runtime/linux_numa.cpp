@@ -0,0 +1,152 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+extern size_t fread(void *, size_t, size_t, void *);
+extern int sched_setaffinity(int pid, size_t cpusetsize, const void *mask);
+
+typedef unsigned int pthread_key_t;
+extern int pthread_key_create(pthread_key_t *key, void (*destructor)(void *));
+extern int pthread_setspecific(pthread_key_t key, const void *value);
+extern void *pthread_getspecific(pthread_key_t key);
+
+}  // extern "C"
+
+// The largest cpu index that can be placed. Matches the size of the
+// default cpu_set_t in glibc.
+#define HALIDE_NUMA_MAX_CPUS 1024
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// Zero means not yet decided, one means off, two means on.
+WEAK int numa_mode = 0;
+
+// Holds each worker thread's slot plus one, so that threads with no
+// slot read back zero.
+WEAK pthread_key_t numa_slot_key;
+WEAK bool numa_slot_key_created = false;
+
+// Parse a sysfs cpu list such as "0-15,32-47" and record the given
+// node for each cpu in it.
+WEAK void parse_numa_cpu_list(const char *str, int node, int *nodes, int num_cpus) {
+    while (*str) {
+        int first = 0;
+        while (*str >= '0' && *str <= '9') {
+            first = first * 10 + (*str++ - '0');
+        }
+        int last = first;
+        if (*str == '-') {
+            str++;
+            last = 0;
+            while (*str >= '0' && *str <= '9') {
+                last = last * 10 + (*str++ - '0');
+            }
+        }
+        for (int cpu = first; cpu <= last && cpu < num_cpus; cpu++) {
+            nodes[cpu] = node;
+        }
+        if (*str != ',') {
+            break;
+        }
+        str++;
+    }
+}
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK bool halide_numa_enabled() {
+    if (!numa_mode) {
+        char *str = getenv("HL_NUMA");
+        numa_mode = (str && atoi(str) != 0) ? 2 : 1;
+    }
+    return numa_mode == 2;
+}
+
+WEAK bool halide_set_numa_aware(bool enable) {
+    bool old = halide_numa_enabled();
+    numa_mode = enable ? 2 : 1;
+    return old;
+}
+
+WEAK int halide_numa_get_cpu_nodes(int *nodes, int num_cpus) {
+    for (int i = 0; i < num_cpus; i++) {
+        nodes[i] = 0;
+    }
+    int num_nodes = 0;
+    char path[64];
+    char cpu_list[1024];
+    while (true) {
+        char *end = path + sizeof(path);
+        char *dst = halide_string_to_string(path, end, "/sys/devices/system/node/node");
+        dst = halide_int64_to_string(dst, end, num_nodes, 1);
+        halide_string_to_string(dst, end, "/cpulist");
+        void *f = fopen(path, "r");
+        if (!f) {
+            break;
+        }
+        size_t len = fread(cpu_list, 1, sizeof(cpu_list) - 1, f);
+        fclose(f);
+        cpu_list[len] = 0;
+        parse_numa_cpu_list(cpu_list, num_nodes, nodes, num_cpus);
+        num_nodes++;
+    }
+    // Kernels built without NUMA support have no node directory.
+    return num_nodes ? num_nodes : 1;
+}
+
+WEAK int halide_numa_pin_current_thread(int cpu) {
+    if (cpu < 0 || cpu >= HALIDE_NUMA_MAX_CPUS) {
+        return -1;
+    }
+    uint64_t mask[HALIDE_NUMA_MAX_CPUS / 64];
+    memset(mask, 0, sizeof(mask));
+    mask[cpu / 64] = (uint64_t)1 << (cpu % 64);
+    // A pid of zero means the calling thread.
+    return sched_setaffinity(0, sizeof(mask), mask);
+}
+
+WEAK void halide_numa_set_thread_slot(int slot) {
+    // Called by the thread pool with its lock held, before any thread
+    // reads a slot, so creating the key here doesn't race.
+    if (!numa_slot_key_created) {
+        if (pthread_key_create(&numa_slot_key, nullptr) != 0) {
+            return;
+        }
+        numa_slot_key_created = true;
+    }
+    pthread_setspecific(numa_slot_key, (void *)(intptr_t)(slot + 1));
+}
+
+WEAK int halide_numa_get_thread_slot() {
+    if (!numa_slot_key_created) {
+        return 0;
+    }
+    intptr_t v = (intptr_t)pthread_getspecific(numa_slot_key);
+    return v ? (int)(v - 1) : 0;
+}
+
+WEAK void *halide_numa_alloc_untouched(size_t size) {
+    // Fresh anonymous pages are not backed by memory until first
+    // written, so they end up on the node of the thread that writes
+    // them.
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    return ptr;
+}
+
+WEAK void halide_numa_free_untouched(void *ptr, size_t size) {
+    munmap(ptr, size);
+}
+
+}  // extern "C"
@@ -0,0 +1,142 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+extern int syscall(int num, ...);
+extern ssize_t read(int fd, void *buf, size_t count);
+extern int uname(void *buf);
+
+}  // extern "C"
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// The first version of struct perf_event_attr. The kernel accepts any
+// version it knows about, and zero fills the fields we leave out.
+struct perf_event_attr_v0 {
+    uint32_t type;
+    uint32_t size;
+    uint64_t config;
+    uint64_t sample_period;
+    uint64_t sample_type;
+    uint64_t read_format;
+    uint64_t flags;
+    uint32_t wakeup_events;
+    uint32_t bp_type;
+    uint64_t config1;
+};
+
+WEAK int perf_counter_fds[halide_profiler_num_counters];
+WEAK bool perf_counters_are_open = false;
+
+// The runtime isn't compiled for a particular architecture, so find the
+// syscall number for perf_event_open from the machine we're running on.
+WEAK int perf_event_open_syscall_number() {
+    // struct utsname is six 65-byte strings; the machine is the fifth.
+    char names[6 * 65];
+    if (uname(names) != 0) {
+        return -1;
+    }
+    const char *machine = names + 4 * 65;
+    if (strncmp(machine, "x86_64", 6) == 0 ||
+        (machine[0] == 'i' && strncmp(machine + 2, "86", 2) == 0)) {
+#ifdef BITS_64
+        return 298;
+#else
+        return 336;
+#endif
+    } else if (strncmp(machine, "aarch64", 7) == 0 ||
+               strncmp(machine, "arm", 3) == 0) {
+#ifdef BITS_64
+        return 241;
+#else
+        return 364;
+#endif
+    } else if (strncmp(machine, "riscv64", 7) == 0) {
+        return 241;
+    }
+    return -1;
+}
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK bool halide_profiler_counters_open() {
+    if (perf_counters_are_open) {
+        return true;
+    }
+    const int sys_perf_event_open = perf_event_open_syscall_number();
+    if (sys_perf_event_open < 0) {
+        return false;
+    }
+    for (int i = 0; i < halide_profiler_num_counters; i++) {
+        perf_event_attr_v0 attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = 0;  // PERF_TYPE_HARDWARE
+        attr.size = sizeof(attr);
+        // halide_profiler_counter_t is in the same order as the
+        // PERF_COUNT_HW_* events: cycles, instructions, cache references,
+        // cache misses, branch instructions, branch misses.
+        attr.config = i;
+        // PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING,
+        // so we can scale the counts if the kernel has to multiplex the
+        // counters.
+        attr.read_format = 1 | 2;
+        // inherit | exclude_kernel | exclude_hv. Counting only user
+        // space works with the default perf_event_paranoid setting.
+        attr.flags = (1 << 1) | (1 << 5) | (1 << 6);
+        // Count this thread, and the threads it creates from now on, on
+        // any cpu.
+        perf_counter_fds[i] = syscall(sys_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    // Without cycles and instructions there's nothing worth reporting.
+    if (perf_counter_fds[halide_profiler_cycles] < 0 ||
+        perf_counter_fds[halide_profiler_instructions] < 0) {
+        perf_counters_are_open = true;
+        halide_profiler_counters_close();
+        return false;
+    }
+    perf_counters_are_open = true;
+    return true;
+}
+
+WEAK bool halide_profiler_counters_read(uint64_t *values) {
+    if (!perf_counters_are_open) {
+        return false;
+    }
+    for (int i = 0; i < halide_profiler_num_counters; i++) {
+        // The count, the time enabled, and the time running.
+        uint64_t data[3];
+        if (perf_counter_fds[i] < 0 ||
+            read(perf_counter_fds[i], data, sizeof(data)) != (ssize_t)sizeof(data)) {
+            values[i] = 0;
+        } else if (data[2] == 0 || data[2] >= data[1]) {
+            values[i] = data[0];
+        } else {
+            values[i] = (uint64_t)((double)data[0] * data[1] / data[2]);
+        }
+    }
+    return true;
+}
+
+WEAK void halide_profiler_counters_close() {
+    if (!perf_counters_are_open) {
+        return;
+    }
+    for (int i = 0; i < halide_profiler_num_counters; i++) {
+        if (perf_counter_fds[i] >= 0) {
+            close(perf_counter_fds[i]);
+        }
+        perf_counter_fds[i] = -1;
+    }
+    perf_counters_are_open = false;
+}
+
+}  // extern "C"
@@ -2,28 +2,292 @@
 #include "runtime_internal.h"
 
 #include "printer.h"
+#include "scoped_mutex_lock.h"
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// In NUMA-aware mode, allocations at least this large are made with
+// fresh pages so that they are placed by first touch.
+constexpr size_t numa_untouched_allocation_threshold = 1 << 20;
+
+// Mappings are rounded up to a multiple of this, so that allocations
+// of nearly the same size can reuse each other's mappings.
+constexpr size_t numa_mapping_granularity = 64 * 1024;
+
+// The pointer returned by the underlying allocator is stored just
+// before each block we hand out. Its low bits say how to release the
+// block.
+constexpr size_t block_from_malloc = 0;
+// Fresh pages from halide_numa_alloc_untouched. The size of the
+// mapping is stored before the pointer.
+constexpr size_t block_from_numa = 1;
+// A block owned by the host allocation pool. Its size class is stored
+// before the pointer.
+constexpr size_t block_from_pool = 2;
+constexpr size_t block_kind_mask = 3;
+
+// The host allocation pool caches freed blocks in size classes a
+// quarter of an octave apart, from 64 bytes up to 64 MB. Larger
+// allocations bypass the pool.
+constexpr int host_pool_min_class_bits = 6;
+constexpr int host_pool_max_class_bits = 26;
+constexpr int host_pool_num_classes = (host_pool_max_class_bits - host_pool_min_class_bits) * 4 + 1;
+
+struct host_pool_class {
+    // Protects free_list. One lock per class, so that threads
+    // allocating different sizes don't contend.
+    halide_mutex lock;
+    // Unused blocks, chained through their first word.
+    void *free_list;
+};
+
+WEAK host_pool_class host_pool_classes[host_pool_num_classes];
+
+// Zero means not yet decided, one means off, two means on.
+WEAK int host_pool_mode = 0;
+
+// Freed NUMA mappings, chained through their first word, kept so that
+// a pipeline run over and over doesn't pay for mapping and faulting in
+// its large buffers each time. Pages stay on the node that first
+// touched them, which in steady state is the node of the worker that
+// writes them again. Unlike the host pool this is always on, as
+// mapping fresh pages each time is far slower than malloc. It counts
+// towards the same limit on unused bytes.
+WEAK halide_mutex numa_pool_lock;
+WEAK void *numa_pool_free_list = nullptr;
+
+// The total size of the blocks sitting in free lists, and the most
+// the pool will hold before handing freed blocks back to free().
+WEAK size_t host_pool_unused_bytes = 0;
+WEAK size_t host_pool_max_unused_bytes = 256 * 1024 * 1024;
+
+// Find the size class for an allocation, or -1 if it is too large to
+// pool. The size of the class is returned in class_size.
+ALWAYS_INLINE int host_pool_size_class(size_t size, size_t *class_size) {
+    if (size <= ((size_t)1 << host_pool_min_class_bits)) {
+        *class_size = (size_t)1 << host_pool_min_class_bits;
+        return 0;
+    }
+    // The size lies in (2^(bits - 1), 2^bits]. Round it up to a
+    // multiple of 2^(bits - 3), which leaves four classes per octave.
+    int bits = 64 - __builtin_clzll((uint64_t)size - 1);
+    if (bits > host_pool_max_class_bits) {
+        return -1;
+    }
+    size_t step = (size_t)1 << (bits - 3);
+    size_t steps = (size + step - 1) >> (bits - 3);
+    *class_size = steps * step;
+    return (bits - host_pool_min_class_bits - 1) * 4 + (int)(steps - 5) + 1;
+}
+
+ALWAYS_INLINE size_t host_pool_class_size(int size_class) {
+    if (size_class == 0) {
+        return (size_t)1 << host_pool_min_class_bits;
+    }
+    int bits = (size_class - 1) / 4 + host_pool_min_class_bits + 1;
+    size_t steps = (size_class - 1) % 4 + 5;
+    return steps << (bits - 3);
+}
+
+// Allocate from the underlying allocator, reserving at least
+// header_words words before the aligned pointer returned.
+ALWAYS_INLINE void *aligned_malloc_with_header(size_t x, size_t alignment, size_t header_words, size_t kind) {
+    void *orig = malloc(x + alignment + (header_words - 1) * sizeof(void *));
+    if (orig == nullptr) {
+        return nullptr;
+    }
+    void *ptr = (void *)(((size_t)orig + alignment + header_words * sizeof(void *) - 1) & ~(alignment - 1));
+    ((void **)ptr)[-1] = (void *)((size_t)orig | kind);
+    return ptr;
+}
+
+ALWAYS_INLINE void release_block(void *ptr) {
+    void *orig = ((void **)ptr)[-1];
+    size_t kind = (size_t)orig & block_kind_mask;
+    orig = (void *)((size_t)orig & ~block_kind_mask);
+    if (kind == block_from_numa) {
+        halide_numa_free_untouched(orig, ((size_t *)ptr)[-2]);
+    } else {
+        free(orig);
+    }
+}
+
+// Take a freed mapping of the given size from the NUMA pool, or
+// return null if there isn't one.
+WEAK void *numa_pool_take(size_t mapping_size) {
+    void *ptr;
+    {
+        ScopedMutexLock lock(&numa_pool_lock);
+        void **prev = &numa_pool_free_list;
+        for (ptr = *prev; ptr != nullptr; prev = (void **)ptr, ptr = *prev) {
+            if (((size_t *)ptr)[-2] == mapping_size) {
+                *prev = *(void **)ptr;
+                break;
+            }
+        }
+    }
+    if (ptr != nullptr) {
+        __atomic_fetch_sub(&host_pool_unused_bytes, mapping_size, __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+// Release unused pooled blocks, largest first, until the pool holds
+// no more than max_unused bytes.
+WEAK void host_pool_trim(size_t max_unused) {
+    // NUMA mappings are larger than any pooled block.
+    while (__atomic_load_n(&host_pool_unused_bytes, __ATOMIC_RELAXED) > max_unused) {
+        void *block;
+        {
+            ScopedMutexLock lock(&numa_pool_lock);
+            block = numa_pool_free_list;
+            if (block == nullptr) {
+                break;
+            }
+            numa_pool_free_list = *(void **)block;
+        }
+        __atomic_fetch_sub(&host_pool_unused_bytes, ((size_t *)block)[-2], __ATOMIC_RELAXED);
+        release_block(block);
+    }
+    for (int c = host_pool_num_classes - 1; c >= 0; c--) {
+        const size_t class_size = host_pool_class_size(c);
+        while (__atomic_load_n(&host_pool_unused_bytes, __ATOMIC_RELAXED) > max_unused) {
+            void *block;
+            {
+                ScopedMutexLock lock(&host_pool_classes[c].lock);
+                block = host_pool_classes[c].free_list;
+                if (block == nullptr) {
+                    break;
+                }
+                host_pool_classes[c].free_list = *(void **)block;
+            }
+            __atomic_fetch_sub(&host_pool_unused_bytes, class_size, __ATOMIC_RELAXED);
+            release_block(block);
+        }
+    }
+}
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+using namespace Halide::Runtime::Internal;
 
 extern "C" {
 
 extern void *malloc(size_t);
 extern void free(void *);
 
+WEAK bool halide_can_reuse_host_allocations(void *user_context) {
+    if (!host_pool_mode) {
+        char *str = getenv("HL_REUSE_HOST_ALLOCATIONS");
+        host_pool_mode = (str && atoi(str) != 0) ? 2 : 1;
+    }
+    return host_pool_mode == 2;
+}
+
+WEAK int halide_reuse_host_allocations(void *user_context, bool flag) {
+    host_pool_mode = flag ? 2 : 1;
+    if (!flag) {
+        host_pool_trim(0);
+    }
+    return 0;
+}
+
+WEAK int halide_trim_host_allocations(void *user_context, size_t max_unused_bytes) {
+    host_pool_trim(max_unused_bytes);
+    return 0;
+}
+
+WEAK size_t halide_set_host_allocation_pool_limit(size_t max_unused_bytes) {
+    size_t old = host_pool_max_unused_bytes;
+    host_pool_max_unused_bytes = max_unused_bytes;
+    host_pool_trim(max_unused_bytes);
+    return old;
+}
+
 WEAK void *halide_default_malloc(void *user_context, size_t x) {
     // Allocate enough space for aligning the pointer we return.
     const size_t alignment = halide_malloc_alignment();
-    void *orig = malloc(x + alignment);
-    if (orig == nullptr) {
-        // Will result in a failed assertion and a call to halide_error
-        return nullptr;
+
+    if (x >= numa_untouched_allocation_threshold && halide_numa_enabled()) {
+        // Get pages that won't be backed by memory until written, so
+        // that they land on the node of whichever worker first writes
+        // them. The mapping is page-aligned, so we can store the size
+        // and a tagged pointer to it in the padding before the
+        // pointer we return.
+        const size_t mapping_size = (x + alignment + numa_mapping_granularity - 1) & ~(numa_mapping_granularity - 1);
+        void *ptr = numa_pool_take(mapping_size);
+        if (ptr != nullptr) {
+            return ptr;
+        }
+        void *orig = halide_numa_alloc_untouched(mapping_size);
+        if (orig != nullptr) {
+            ptr = (void *)((size_t)orig + alignment);
+            ((void **)ptr)[-1] = (void *)((size_t)orig | block_from_numa);
+            ((size_t *)ptr)[-2] = mapping_size;
+            return ptr;
+        }
     }
-    // We want to store the original pointer prior to the pointer we return.
-    void *ptr = (void *)(((size_t)orig + alignment + sizeof(void *) - 1) & ~(alignment - 1));
-    ((void **)ptr)[-1] = orig;
-    return ptr;
+
+    if (halide_can_reuse_host_allocations(user_context)) {
+        size_t class_size;
+        int size_class = host_pool_size_class(x, &class_size);
+        if (size_class >= 0) {
+            void *ptr;
+            {
+                ScopedMutexLock lock(&host_pool_classes[size_class].lock);
+                ptr = host_pool_classes[size_class].free_list;
+                if (ptr != nullptr) {
+                    host_pool_classes[size_class].free_list = *(void **)ptr;
+                }
+            }
+            if (ptr != nullptr) {
+                __atomic_fetch_sub(&host_pool_unused_bytes, class_size, __ATOMIC_RELAXED);
+                return ptr;
+            }
+            ptr = aligned_malloc_with_header(class_size, alignment, 2, block_from_pool);
+            if (ptr != nullptr) {
+                ((size_t *)ptr)[-2] = (size_t)size_class;
+            }
+            return ptr;
+        }
+    }
+
+    // Will result in a failed assertion and a call to halide_error if
+    // this fails.
+    return aligned_malloc_with_header(x, alignment, 1, block_from_malloc);
 }
 
 WEAK void halide_default_free(void *user_context, void *ptr) {
-    free(((void **)ptr)[-1]);
+    size_t kind = (size_t)(((void **)ptr)[-1]) & block_kind_mask;
+    if (kind == block_from_numa) {
+        size_t mapping_size = ((size_t *)ptr)[-2];
+        size_t unused = __atomic_add_fetch(&host_pool_unused_bytes, mapping_size, __ATOMIC_RELAXED);
+        if (unused <= host_pool_max_unused_bytes) {
+            ScopedMutexLock lock(&numa_pool_lock);
+            *(void **)ptr = numa_pool_free_list;
+            numa_pool_free_list = ptr;
+            return;
+        }
+        __atomic_fetch_sub(&host_pool_unused_bytes, mapping_size, __ATOMIC_RELAXED);
+    }
+    if (kind == block_from_pool && halide_can_reuse_host_allocations(user_context)) {
+        int size_class = (int)((size_t *)ptr)[-2];
+        size_t class_size = host_pool_class_size(size_class);
+        size_t unused = __atomic_add_fetch(&host_pool_unused_bytes, class_size, __ATOMIC_RELAXED);
+        if (unused <= host_pool_max_unused_bytes) {
+            ScopedMutexLock lock(&host_pool_classes[size_class].lock);
+            *(void **)ptr = host_pool_classes[size_class].free_list;
+            host_pool_classes[size_class].free_list = ptr;
+            return;
+        }
+        // The pool is full.
+        __atomic_fetch_sub(&host_pool_unused_bytes, class_size, __ATOMIC_RELAXED);
+    }
+    release_block(ptr);
 }
 }
 
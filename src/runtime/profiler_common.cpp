@@ -1,5 +1,6 @@
 #include "HalideRuntime.h"
 #include "printer.h"
+#include "runtime_internal.h"
 #include "scoped_mutex_lock.h"
 
 // Note: The profiler thread may out-live any valid user_context, or
@@ -43,6 +44,22 @@ public:
     }
 };
 
+// Zero means not yet decided, one means off, two means on.
+WEAK int profiler_counters_mode = 0;
+
+// Whether the hardware performance counters are open, and their values
+// at the last sample.
+WEAK bool profiler_counting = false;
+WEAK uint64_t profiler_prev_counters[halide_profiler_num_counters];
+
+WEAK bool profiler_counters_requested() {
+    if (!profiler_counters_mode) {
+        char *str = getenv("HL_PROFILER_COUNTERS");
+        profiler_counters_mode = (str && atoi(str) != 0) ? 2 : 1;
+    }
+    return profiler_counters_mode == 2;
+}
+
 WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipeline_name, int num_funcs, const uint64_t *func_names) {
     halide_profiler_state *s = halide_profiler_get_state();
 
@@ -67,6 +84,9 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
     p->num_funcs = num_funcs;
     p->runs = 0;
     p->time = 0;
+    for (int c = 0; c < halide_profiler_num_counters; c++) {
+        p->counters[c] = 0;
+    }
     p->samples = 0;
     p->memory_current = 0;
     p->memory_peak = 0;
@@ -81,6 +101,9 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
     }
     for (int i = 0; i < num_funcs; i++) {
         p->funcs[i].time = 0;
+        for (int c = 0; c < halide_profiler_num_counters; c++) {
+            p->funcs[i].counters[c] = 0;
+        }
         p->funcs[i].name = (const char *)(func_names[i]);
         p->funcs[i].memory_current = 0;
         p->funcs[i].memory_peak = 0;
@@ -95,7 +118,7 @@ WEAK halide_profiler_pipeline_stats *find_or_create_pipeline(const char *pipelin
     return p;
 }
 
-WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int active_threads) {
+WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int active_threads, const uint64_t *counters) {
     halide_profiler_pipeline_stats *p_prev = nullptr;
     for (halide_profiler_pipeline_stats *p = s->pipelines; p;
          p = (halide_profiler_pipeline_stats *)(p->next)) {
@@ -114,6 +137,12 @@ WEAK void bill_func(halide_profiler_state *s, int func_id, uint64_t time, int ac
             p->samples++;
             p->active_threads_numerator += active_threads;
             p->active_threads_denominator += 1;
+            if (counters) {
+                for (int c = 0; c < halide_profiler_num_counters; c++) {
+                    f->counters[c] += counters[c];
+                    p->counters[c] += counters[c];
+                }
+            }
             return;
         }
         p_prev = p;
@@ -132,6 +161,24 @@ extern "C" WEAK int halide_profiler_sample(struct halide_profiler_state *s, uint
         active_threads = s->active_threads;
     }
     uint64_t t_now = halide_current_time_ns(nullptr);
+
+    // Like the time, the counts since the last sample are all billed to
+    // the current func. They are read even when no func is running, so
+    // that work outside of Halide isn't billed to the next func. They
+    // don't see execution on a remote device.
+    uint64_t counters[halide_profiler_num_counters];
+    const uint64_t *counter_deltas = nullptr;
+    if (profiler_counting && halide_profiler_counters_read(counters)) {
+        for (int c = 0; c < halide_profiler_num_counters; c++) {
+            const uint64_t now = counters[c];
+            counters[c] = now > profiler_prev_counters[c] ? now - profiler_prev_counters[c] : 0;
+            profiler_prev_counters[c] = now;
+        }
+        if (!s->get_remote_profiler_state) {
+            counter_deltas = counters;
+        }
+    }
+
     if (func == halide_profiler_please_stop) {
 #if TIMER_PROFILING
         s->sampling_thread = nullptr;
@@ -140,7 +187,7 @@ extern "C" WEAK int halide_profiler_sample(struct halide_profiler_state *s, uint
     } else if (func >= 0) {
         // Assume all time since I was last awake is due to
         // the currently running func.
-        bill_func(s, func, t_now - *prev_t, active_threads);
+        bill_func(s, func, t_now - *prev_t, active_threads, counter_deltas);
     }
     *prev_t = t_now;
     return s->sleep_time;
@@ -226,6 +273,11 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
         halide_start_clock(user_context);
         s->sampling_thread = halide_spawn_thread(sampling_profiler_thread, nullptr);
 #endif
+        // Open the counters after starting the sampling thread, so they
+        // don't count it. The sampler can't run until we release the lock.
+        if (profiler_counters_requested() && halide_profiler_counters_open()) {
+            profiler_counting = halide_profiler_counters_read(profiler_prev_counters);
+        }
     }
 
     halide_profiler_pipeline_stats *p =
@@ -325,6 +377,32 @@ WEAK void halide_profiler_memory_free(void *user_context,
     __sync_sub_and_fetch(&f_stats->memory_current, decr);
 }
 
+}  // extern "C"
+
+namespace {
+
+// Print the ratios of hardware counters that tell compute-bound from
+// memory-bound code: instructions per cycle, and the fraction of
+// last-level cache references and of branches that missed.
+template<typename Printer>
+void print_counter_ratios(Printer &sstr, const uint64_t *counters) {
+    auto ratio = [&](const char *name, int num, int den, float scale) {
+        if (counters[den] == 0) {
+            return;
+        }
+        sstr << " " << name << ": " << (float)(scale * counters[num] / counters[den]);
+        // We don't need 6 decimal places.
+        sstr.erase(4);
+    };
+    ratio("ipc", halide_profiler_instructions, halide_profiler_cycles, 1.0f);
+    ratio("llc miss%", halide_profiler_cache_misses, halide_profiler_cache_references, 100.0f);
+    ratio("branch miss%", halide_profiler_branch_misses, halide_profiler_branches, 100.0f);
+}
+
+}  // namespace
+
+extern "C" {
+
 WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_state *s) {
     StringStreamPrinter<1024> sstr(user_context);
 
@@ -347,6 +425,14 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
         }
         sstr << " heap allocations: " << p->num_allocs
              << "  peak heap usage: " << p->memory_peak << " bytes\n";
+        const bool print_counters = p->counters[halide_profiler_cycles] != 0;
+        if (print_counters) {
+            sstr << " cycles: " << p->counters[halide_profiler_cycles]
+                 << "  instructions: " << p->counters[halide_profiler_instructions]
+                 << " ";
+            print_counter_ratios(sstr, p->counters);
+            sstr << "\n";
+        }
         halide_print(user_context, sstr.str());
 
         bool print_f_states = p->time || p->memory_total;
@@ -428,6 +514,9 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
                 if (fs->stack_peak > 0) {
                     sstr << " stack: " << fs->stack_peak;
                 }
+                if (print_counters && fs->counters[halide_profiler_cycles]) {
+                    print_counter_ratios(sstr, fs->counters);
+                }
                 sstr << "\n";
 
                 halide_print(user_context, sstr.str());
@@ -493,6 +582,9 @@ halide_profiler_shutdown() {
     halide_profiler_report_unlocked(nullptr, s);
 
     halide_profiler_reset_unlocked(s);
+
+    halide_profiler_counters_close();
+    profiler_counting = false;
 }
 
 namespace {
@@ -87,6 +87,24 @@ WEAK void halide_default_free(void *user_context, void *ptr) {
     aligned_free(ptr);
 }
 
+// Small host allocations are already served from a fixed set of
+// reusable buffers on this platform, so there is no separate pool.
+WEAK bool halide_can_reuse_host_allocations(void *user_context) {
+    return false;
+}
+
+WEAK int halide_reuse_host_allocations(void *user_context, bool flag) {
+    return 0;
+}
+
+WEAK int halide_trim_host_allocations(void *user_context, size_t max_unused_bytes) {
+    return 0;
+}
+
+WEAK size_t halide_set_host_allocation_pool_limit(size_t max_unused_bytes) {
+    return 0;
+}
+
 namespace Halide {
 namespace Runtime {
 namespace Internal {
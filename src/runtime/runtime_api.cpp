@@ -23,6 +23,7 @@ extern "C" void halide_unused_force_include_types();
 extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_buffer_copy,
     (void *)&halide_buffer_to_string,
+    (void *)&halide_can_reuse_host_allocations,
     (void *)&halide_can_use_target_features,
     (void *)&halide_cond_broadcast,
     (void *)&halide_cond_signal,
@@ -115,8 +116,10 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_malloc,
     (void *)&halide_memoization_cache_cleanup,
     (void *)&halide_memoization_cache_evict,
+    (void *)&halide_memoization_cache_get_stats,
     (void *)&halide_memoization_cache_lookup,
     (void *)&halide_memoization_cache_release,
+    (void *)&halide_memoization_cache_reset_stats,
     (void *)&halide_memoization_cache_set_size,
     (void *)&halide_memoization_cache_store,
     (void *)&halide_metal_acquire_context,
@@ -176,6 +179,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_qurt_hvx_unlock,
     (void *)&halide_qurt_hvx_unlock_as_destructor,
     (void *)&halide_release_jit_module,
+    (void *)&halide_reuse_host_allocations,
     (void *)&halide_semaphore_init,
     (void *)&halide_semaphore_release,
     (void *)&halide_semaphore_try_acquire,
@@ -192,7 +196,10 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_set_custom_trace,
     (void *)&halide_set_error_handler,
     (void *)&halide_set_gpu_device,
+    (void *)&halide_set_host_allocation_pool_limit,
     (void *)&halide_set_num_threads,
+    (void *)&halide_set_numa_aware,
+    (void *)&halide_set_thread_pool_work_stealing,
     (void *)&halide_set_trace_file,
     (void *)&halide_shutdown_thread_pool,
     (void *)&halide_shutdown_trace,
@@ -203,6 +210,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_string_to_string,
     (void *)&halide_trace,
     (void *)&halide_trace_helper,
+    (void *)&halide_trim_host_allocations,
     (void *)&halide_uint64_to_string,
     (void *)&halide_use_jit_module,
     (void *)&halide_d3d12compute_acquire_context,
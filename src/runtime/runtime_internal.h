@@ -72,6 +72,15 @@ typedef int32_t intptr_t;
 #define STDOUT_FILENO 1
 #define STDERR_FILENO 2
 
+// From <sys/mman.h>. These are the values on Linux for x86, ARM,
+// PowerPC and RISC-V. On other targets mmap fails with these flags, and
+// callers must fall back to malloc.
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+#define MAP_PRIVATE 0x02
+#define MAP_ANONYMOUS 0x20
+#define MAP_FAILED ((void *)-1)
+
 // Commonly-used extern functions
 extern "C" {
 void *halide_malloc(void *user_context, size_t x);
@@ -92,6 +101,7 @@ int strncmp(const char *s, const char *t, size_t n);
 size_t strlen(const char *s);
 const char *strchr(const char *s, int c);
 void *memcpy(void *s1, const void *s2, size_t n);
+void *memmove(void *s1, const void *s2, size_t n);
 int memcmp(const void *s1, const void *s2, size_t n);
 void *memset(void *s, int val, size_t n);
 // Use fopen+fileno+fclose instead of open+close - the value of the
@@ -106,6 +116,8 @@ int remove(const char *pathname);
 int ioctl(int fd, unsigned long request, ...);
 char *strncpy(char *dst, const char *src, size_t n);
 void abort();
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+int munmap(void *addr, size_t length);
 
 // Below are prototypes for various functions called by generated code
 // and parts of the runtime but not exposed to users:
@@ -158,6 +170,27 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
                                         const uint64_t *func_names);
 WEAK int halide_host_cpu_count();
 
+// NUMA topology and placement, used by the thread pool and allocator
+// when NUMA-aware execution is enabled. Only implemented on Linux;
+// elsewhere the machine is a single node and placement is a no-op.
+WEAK bool halide_numa_enabled();
+WEAK int halide_numa_get_cpu_nodes(int *nodes, int num_cpus);
+WEAK int halide_numa_pin_current_thread(int cpu);
+// The thread pool slot of the calling thread, so that a worker that
+// starts a nested parallel loop knows where it is. Threads that never
+// set a slot, such as the one that started the pipeline, are slot 0.
+WEAK void halide_numa_set_thread_slot(int slot);
+WEAK int halide_numa_get_thread_slot();
+WEAK void *halide_numa_alloc_untouched(size_t size);
+WEAK void halide_numa_free_untouched(void *ptr, size_t size);
+
+// Hardware performance counters for the sampling profiler, indexed by
+// halide_profiler_counter_t. Only implemented on Linux; elsewhere they
+// can't be opened.
+WEAK bool halide_profiler_counters_open();
+WEAK bool halide_profiler_counters_read(uint64_t *values);
+WEAK void halide_profiler_counters_close();
+
 WEAK int halide_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf,
                                        const struct halide_device_interface_t *device_interface);
 WEAK int halide_device_and_host_free(void *user_context, struct halide_buffer_t *buf);
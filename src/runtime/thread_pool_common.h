@@ -30,6 +30,36 @@ namespace Halide {
 namespace Runtime {
 namespace Internal {
 
+// A contiguous range of loop iterations [begin, end), relative to the
+// min of the job it belongs to, packed into a single word so that it
+// can be updated with a compare-and-swap. Used when the thread pool is
+// in work-stealing mode: the worker that owns a range claims
+// iterations from the bottom, and idle workers steal the top half.
+struct steal_range {
+    uint64_t bits;
+
+    // Whether a worker has taken ownership of this range. Protected
+    // by the work queue mutex.
+    bool claimed;
+
+    // The pool slot of the worker that owns the range, or -1 if none
+    // does yet. Written under the work queue mutex, but read without
+    // it by thieves deciding which ranges are on their node.
+    int owner_slot;
+
+    ALWAYS_INLINE static uint64_t pack(uint32_t begin, uint32_t end) {
+        return ((uint64_t)end << 32) | begin;
+    }
+
+    ALWAYS_INLINE static uint32_t begin_of(uint64_t bits) {
+        return (uint32_t)bits;
+    }
+
+    ALWAYS_INLINE static uint32_t end_of(uint64_t bits) {
+        return (uint32_t)(bits >> 32);
+    }
+};
+
 struct work {
     halide_parallel_task_t task;
 
@@ -50,6 +80,16 @@ struct work {
     // which condition variable is the owner sleeping on. nullptr if it isn't sleeping.
     bool owner_is_sleeping;
 
+    // In work-stealing mode, the remaining iterations of the job are
+    // split across one range per participating worker, so that
+    // iterations can be claimed without holding the work queue
+    // lock. nullptr if the job is scheduled from the shared stack one
+    // iteration at a time.
+    steal_range *steal_ranges;
+    int num_steal_ranges;
+    // The first range that may not have been claimed yet.
+    int next_steal_range;
+
     ALWAYS_INLINE bool make_runnable() {
         for (; next_semaphore < task.num_semaphores; next_semaphore++) {
             if (!halide_default_semaphore_try_acquire(task.semaphores[next_semaphore].semaphore,
@@ -81,6 +121,11 @@ ALWAYS_INLINE int clamp_num_threads(int threads) {
     }
 }
 
+WEAK bool default_work_stealing() {
+    char *str = getenv("HL_WORK_STEALING");
+    return str && atoi(str) != 0;
+}
+
 WEAK int default_desired_num_threads() {
     char *threads_str = getenv("HL_NUM_THREADS");
     if (!threads_str) {
@@ -100,6 +145,12 @@ struct work_queue_t {
     // The desired number threads doing work (HL_NUM_THREADS).
     int desired_threads_working;
 
+    // Whether jobs without semaphores or blocking requirements are
+    // executed with per-worker iteration ranges and randomized
+    // stealing (HL_WORK_STEALING). Zero means not yet decided, one
+    // means off, two means on.
+    int work_stealing;
+
     // All fields after this must be zero in the initial state. See assert_zeroed
     // Field serves both to mark the offset in struct and as layout padding.
     int zero_marker;
@@ -140,10 +191,30 @@ struct work_queue_t {
     // to prevent deadlock due to oversubscription of threads.
     int threads_reserved;
 
+    // Whether workers are pinned to cores and parallel loops are
+    // partitioned by worker (HL_NUMA). Decided when the pool starts.
+    bool numa_aware;
+
+    // In NUMA-aware mode, the core each worker slot is pinned to and
+    // the node that core belongs to. Slot zero is the thread that
+    // enqueued the work, which is never pinned; slot i + 1 is
+    // threads[i].
+    int slot_cpu[MAX_THREADS];
+    int slot_node[MAX_THREADS];
+
     ALWAYS_INLINE bool running() const {
         return !shutdown;
     }
 
+    ALWAYS_INLINE bool use_steal_ranges() const {
+#ifdef BITS_32
+        // The packed ranges require 64-bit atomics.
+        return false;
+#else
+        return work_stealing == 2 || numa_aware;
+#endif
+    }
+
     // Used to check initial state is correct.
     ALWAYS_INLINE void assert_zeroed() const {
         // Assert that all fields except the mutex and desired threads count are zeroed.
@@ -202,7 +273,202 @@ WEAK void dump_job_state() {
 
 WEAK void worker_thread(void *);
 
-WEAK void worker_thread_already_locked(work *owned_job) {
+WEAK void remove_job_already_locked(work *job) {
+    work **prev_ptr = &work_queue.jobs;
+    while (*prev_ptr != job) {
+        prev_ptr = &((*prev_ptr)->next_job);
+    }
+    *prev_ptr = job->next_job;
+}
+
+// The number of ranges to split a job into in work-stealing mode, or
+// zero if the job should be scheduled from the shared stack. Only
+// jobs which never block and need no semaphores are eligible, so the
+// thread reservation logic is unaffected.
+WEAK int num_steal_ranges_already_locked(const work *job) {
+    if (!work_queue.use_steal_ranges() ||
+        job->task.serial ||
+        job->task.num_semaphores != 0 ||
+        job->task.min_threads != 0) {
+        return 0;
+    }
+    // Give each thread that could help a range of iterations to start
+    // on, but no more ranges than iterations.
+    int num_ranges = work_queue.threads_created + 1;
+    if (num_ranges > job->task.extent) {
+        num_ranges = job->task.extent;
+    }
+    return num_ranges < 2 ? 0 : num_ranges;
+}
+
+// Split the iterations of a job evenly across the given ranges. Must
+// be called with the work queue locked, before any worker has
+// started on the job.
+WEAK void init_steal_ranges(work *job, steal_range *ranges, int num_ranges) {
+    uint64_t extent = (uint64_t)job->task.extent;
+    for (int i = 0; i < num_ranges; i++) {
+        uint32_t begin = (uint32_t)((extent * i) / num_ranges);
+        uint32_t end = (uint32_t)((extent * (i + 1)) / num_ranges);
+        ranges[i].bits = steal_range::pack(begin, end);
+        ranges[i].claimed = false;
+        ranges[i].owner_slot = -1;
+    }
+    job->steal_ranges = ranges;
+    job->num_steal_ranges = num_ranges;
+    job->next_steal_range = 0;
+}
+
+// Pick a range for a worker joining the job to own, or return -1 if
+// they have all been taken. In NUMA-aware mode a worker always gets
+// the range matching its slot when it is free, so that the same
+// iterations are run on the same node each time the loop runs.
+WEAK int claim_steal_range_already_locked(work *job, int slot) {
+    int claimed = -1;
+    if (work_queue.numa_aware &&
+        slot < job->num_steal_ranges &&
+        !job->steal_ranges[slot].claimed) {
+        claimed = slot;
+    }
+    while (claimed < 0 && job->next_steal_range < job->num_steal_ranges) {
+        int i = job->next_steal_range++;
+        if (!job->steal_ranges[i].claimed) {
+            claimed = i;
+        }
+    }
+    if (claimed >= 0) {
+        job->steal_ranges[claimed].claimed = true;
+        Synchronization::atomic_store_release(&job->steal_ranges[claimed].owner_slot, &slot);
+    }
+    return claimed;
+}
+
+#ifndef BITS_32
+
+// Claim the lowest iteration of a range. Called by the worker that
+// owns the range.
+ALWAYS_INLINE bool pop_steal_range(steal_range *range, uint32_t *idx) {
+    uint64_t expected;
+    Synchronization::atomic_load_acquire(&range->bits, &expected);
+    while (true) {
+        uint32_t begin = steal_range::begin_of(expected);
+        uint32_t end = steal_range::end_of(expected);
+        if (begin >= end) {
+            return false;
+        }
+        uint64_t desired = steal_range::pack(begin + 1, end);
+        if (Synchronization::atomic_cas_weak_relacq_relaxed(&range->bits, &expected, &desired)) {
+            *idx = begin;
+            return true;
+        }
+    }
+}
+
+// Steal the top half of some other worker's range, visiting the
+// victims starting from a random one. self is the thief's own range
+// (or -1) and slot its place in the pool. In NUMA-aware mode, ranges
+// owned by workers on the same node as the thief are tried first.
+ALWAYS_INLINE bool steal_from_ranges(work *job, int self, int slot, uint32_t *rng,
+                                     uint32_t *stolen_begin, uint32_t *stolen_end) {
+    // xorshift32
+    uint32_t r = *rng;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    *rng = r;
+
+    const int n = job->num_steal_ranges;
+    const bool prefer_local = work_queue.numa_aware && slot > 0;
+    for (int k = 0; k < (prefer_local ? 2 * n : n); k++) {
+        int victim = (int)((r + (uint32_t)k) % (uint32_t)n);
+        if (victim == self) {
+            continue;
+        }
+        steal_range *range = job->steal_ranges + victim;
+        if (k < n && prefer_local) {
+            // Ranges not yet owned by anyone, or owned by the
+            // unpinned slot 0, are left for the second pass.
+            int owner;
+            Synchronization::atomic_load_relaxed(&range->owner_slot, &owner);
+            if (owner <= 0 || work_queue.slot_node[owner] != work_queue.slot_node[slot]) {
+                continue;
+            }
+        }
+        uint64_t expected;
+        Synchronization::atomic_load_acquire(&range->bits, &expected);
+        while (true) {
+            uint32_t begin = steal_range::begin_of(expected);
+            uint32_t end = steal_range::end_of(expected);
+            if (begin >= end) {
+                break;
+            }
+            uint32_t mid = begin + (end - begin) / 2;
+            uint64_t desired = steal_range::pack(begin, mid);
+            if (Synchronization::atomic_cas_weak_relacq_relaxed(&range->bits, &expected, &desired)) {
+                *stolen_begin = mid;
+                *stolen_end = end;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Run iterations of a job in work-stealing mode until all of its
+// ranges are empty or an iteration fails. Called without the work
+// queue lock held.
+WEAK int run_steal_ranges(work *job, int self, int slot) {
+    uint32_t rng = (uint32_t)(uintptr_t)&rng ^ (uint32_t)(self * 0x9e3779b9u);
+    if (rng == 0) {
+        rng = 1;
+    }
+    int result = 0;
+    while (result == 0) {
+        uint32_t begin, end;
+        if (self >= 0 && pop_steal_range(job->steal_ranges + self, &begin)) {
+            end = begin + 1;
+        } else if (!steal_from_ranges(job, self, slot, &rng, &begin, &end)) {
+            break;
+        } else if (self >= 0 && end - begin > 1) {
+            // Keep the first stolen iteration and publish the rest in
+            // our own (currently empty) range, so that it can in
+            // turn be stolen from.
+            uint64_t bits = steal_range::pack(begin + 1, end);
+            Synchronization::atomic_store_release(&job->steal_ranges[self].bits, &bits);
+            end = begin + 1;
+        }
+
+        for (uint32_t i = begin; i < end && result == 0; i++) {
+            int idx = job->task.min + (int)i;
+            if (job->task_fn) {
+                result = halide_do_task(job->user_context, job->task_fn,
+                                        idx, job->task.closure);
+            } else {
+                result = halide_do_loop_task(job->user_context, job->task.fn,
+                                             idx, 1, job->task.closure, job);
+            }
+        }
+    }
+
+    if (result != 0) {
+        // Empty every range so the other workers stop promptly.
+        for (int i = 0; i < job->num_steal_ranges; i++) {
+            uint64_t empty = 0;
+            Synchronization::atomic_store_release(&job->steal_ranges[i].bits, &empty);
+        }
+    }
+    return result;
+}
+
+#else
+
+WEAK int run_steal_ranges(work *job, int self, int slot) {
+    halide_abort_if_false(nullptr, false && "Work stealing requires 64-bit atomics.\n");
+    return -1;
+}
+
+#endif
+
+WEAK void worker_thread_already_locked(work *owned_job, int slot) {
     int spin_count = 0;
     const int max_spin_count = 40;
 
@@ -213,12 +479,8 @@ WEAK void worker_thread_already_locked(work *owned_job) {
         if (owned_job) {
             if (owned_job->exit_status != 0) {
                 if (owned_job->active_workers == 0) {
-                    while (job != owned_job) {
-                        prev_ptr = &job->next_job;
-                        job = job->next_job;
-                    }
-                    *prev_ptr = job->next_job;
-                    job->task.extent = 0;
+                    remove_job_already_locked(owned_job);
+                    owned_job->task.extent = 0;
                     continue;  // So loop exit is always in the same place.
                 }
             } else if (owned_job->parent_job && owned_job->parent_job->exit_status != 0) {
@@ -371,6 +633,23 @@ WEAK void worker_thread_already_locked(work *owned_job) {
                 job->next_job = work_queue.jobs;
                 work_queue.jobs = job;
             }
+        } else if (job->steal_ranges) {
+            // Leave the job on the stack so that more workers can
+            // join it, and take a range of iterations to own.
+            int self = claim_steal_range_already_locked(job, slot);
+
+            // Release the lock and claim or steal iterations until
+            // there are none left.
+            halide_mutex_unlock(&work_queue.mutex);
+            result = run_steal_ranges(job, self, slot);
+            halide_mutex_lock(&work_queue.mutex);
+
+            // Every range has been drained, so the job is complete
+            // once the workers still running iterations finish.
+            if (job->task.extent != 0) {
+                remove_job_already_locked(job);
+                job->task.extent = 0;
+            }
         } else {
             // Claim a task from it.
             work myjob = *job;
@@ -438,11 +717,67 @@ WEAK void worker_thread_already_locked(work *owned_job) {
 }
 
 WEAK void worker_thread(void *arg) {
+    // The argument is the worker's slot in the pool.
+    int slot = (int)(intptr_t)arg;
+    if (work_queue.numa_aware) {
+        halide_numa_pin_current_thread(work_queue.slot_cpu[slot]);
+    }
     halide_mutex_lock(&work_queue.mutex);
-    worker_thread_already_locked((work *)arg);
+    if (work_queue.numa_aware) {
+        halide_numa_set_thread_slot(slot);
+    }
+    worker_thread_already_locked(nullptr, slot);
     halide_mutex_unlock(&work_queue.mutex);
 }
 
+// Assign a core to each worker slot, dealing them out round-robin
+// across the NUMA nodes so that the pool spans every socket even when
+// it has fewer threads than there are cores.
+WEAK void init_numa_slots_already_locked() {
+    int num_cpus = halide_host_cpu_count();
+    if (num_cpus > 1024) {
+        num_cpus = 1024;
+    }
+    if (num_cpus < 1) {
+        num_cpus = 1;
+    }
+    int *cpu_node = (int *)__builtin_alloca(sizeof(int) * num_cpus);
+    int num_nodes = halide_numa_get_cpu_nodes(cpu_node, num_cpus);
+    int *next_cpu = (int *)__builtin_alloca(sizeof(int) * num_nodes);
+    for (int n = 0; n < num_nodes; n++) {
+        next_cpu[n] = 0;
+    }
+
+    // The thread starting the pool is slot 0. Recording that also
+    // sets up the per-thread slots before any worker exists.
+    halide_numa_set_thread_slot(0);
+    work_queue.slot_cpu[0] = -1;
+    work_queue.slot_node[0] = -1;
+    int node = 0;
+    for (int slot = 1; slot < MAX_THREADS; slot++) {
+        // Find the next core on this node, wrapping around if the
+        // pool is larger than the machine.
+        int cpu = -1;
+        for (int tries = 0; tries < num_nodes && cpu < 0; tries++) {
+            for (int i = 0; i < num_cpus; i++) {
+                int c = (next_cpu[node] + i) % num_cpus;
+                if (cpu_node[c] == node) {
+                    cpu = c;
+                    next_cpu[node] = c + 1;
+                    break;
+                }
+            }
+            if (cpu < 0) {
+                // A node with memory but no cores.
+                node = (node + 1) % num_nodes;
+            }
+        }
+        work_queue.slot_cpu[slot] = cpu;
+        work_queue.slot_node[slot] = cpu < 0 ? 0 : cpu_node[cpu];
+        node = (node + 1) % num_nodes;
+    }
+}
+
 WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_parent) {
     if (!work_queue.initialized) {
         work_queue.assert_zeroed();
@@ -454,6 +789,13 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
             work_queue.desired_threads_working = default_desired_num_threads();
         }
         work_queue.desired_threads_working = clamp_num_threads(work_queue.desired_threads_working);
+        if (!work_queue.work_stealing) {
+            work_queue.work_stealing = default_work_stealing() ? 2 : 1;
+        }
+        work_queue.numa_aware = halide_numa_enabled();
+        if (work_queue.numa_aware) {
+            init_numa_slots_already_locked();
+        }
         work_queue.initialized = true;
     }
 
@@ -513,8 +855,9 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
             // We might need to make some new threads, if work_queue.desired_threads_working has
             // increased, or if there aren't enough threads to complete this new task.
             work_queue.a_team_size++;
+            int slot = work_queue.threads_created + 1;
             work_queue.threads[work_queue.threads_created++] =
-                halide_spawn_thread(worker_thread, nullptr);
+                halide_spawn_thread(worker_thread, (void *)(intptr_t)slot);
         }
         log_message("enqueue_work_already_locked top level job " << jobs[0].task.name << " with min_threads " << min_threads << " work_queue.threads_created " << work_queue.threads_created << " work_queue.threads_reserved " << work_queue.threads_reserved);
         if (job_has_acquires || job_may_block) {
@@ -532,8 +875,6 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
 
     // Push the jobs onto the stack.
     for (int i = num_jobs - 1; i >= 0; i--) {
-        // We could bubble it downwards based on some heuristics, but
-        // it's not strictly necessary to do so.
         jobs[i].next_job = work_queue.jobs;
         jobs[i].siblings = &jobs[0];
         jobs[i].sibling_count = num_jobs;
@@ -629,9 +970,19 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     job.siblings = &job;  // guarantees no other job points to the same siblings.
     job.sibling_count = 0;
     job.parent_job = nullptr;
+    job.steal_ranges = nullptr;
     halide_mutex_lock(&work_queue.mutex);
     enqueue_work_already_locked(1, &job, nullptr);
-    worker_thread_already_locked(&job);
+    // Other workers can't see the job until we release the lock, so
+    // it is safe to set up its ranges after it has been enqueued.
+    int num_ranges = num_steal_ranges_already_locked(&job);
+    if (num_ranges) {
+        init_steal_ranges(&job, (steal_range *)__builtin_alloca(sizeof(steal_range) * num_ranges), num_ranges);
+    }
+    // A worker running a nested parallel loop keeps its own slot, so
+    // it owns the range for its slot and steals from its own node.
+    int slot = work_queue.numa_aware ? halide_numa_get_thread_slot() : 0;
+    worker_thread_already_locked(&job, slot);
     halide_mutex_unlock(&work_queue.mutex);
     return job.exit_status;
 }
@@ -655,6 +1006,7 @@ WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
         jobs[i].next_semaphore = 0;
         jobs[i].owner_is_sleeping = false;
         jobs[i].parent_job = (work *)task_parent;
+        jobs[i].steal_ranges = nullptr;
     }
 
     if (num_tasks == 0) {
@@ -663,11 +1015,18 @@ WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
 
     halide_mutex_lock(&work_queue.mutex);
     enqueue_work_already_locked(num_tasks, jobs, (work *)task_parent);
+    for (int i = 0; i < num_tasks; i++) {
+        int num_ranges = num_steal_ranges_already_locked(jobs + i);
+        if (num_ranges) {
+            init_steal_ranges(jobs + i, (steal_range *)__builtin_alloca(sizeof(steal_range) * num_ranges), num_ranges);
+        }
+    }
+    int slot = work_queue.numa_aware ? halide_numa_get_thread_slot() : 0;
     int exit_status = 0;
     for (int i = 0; i < num_tasks; i++) {
         // It doesn't matter what order we join the tasks in, because
         // we'll happily assist with siblings too.
-        worker_thread_already_locked(jobs + i);
+        worker_thread_already_locked(jobs + i, slot);
         if (jobs[i].exit_status != 0) {
             exit_status = jobs[i].exit_status;
         }
@@ -693,6 +1052,17 @@ WEAK int halide_set_num_threads(int n) {
     return old;
 }
 
+WEAK bool halide_set_thread_pool_work_stealing(bool enable) {
+    halide_mutex_lock(&work_queue.mutex);
+    if (!work_queue.work_stealing) {
+        work_queue.work_stealing = default_work_stealing() ? 2 : 1;
+    }
+    bool old = work_queue.work_stealing == 2;
+    work_queue.work_stealing = enable ? 2 : 1;
+    halide_mutex_unlock(&work_queue.mutex);
+    return old;
+}
+
 WEAK void halide_shutdown_thread_pool() {
     if (work_queue.initialized) {
         // Wake everyone up and tell them the party's over and it's time
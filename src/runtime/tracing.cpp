@@ -73,18 +73,25 @@ public:
     SharedExclusiveSpinLock() = default;
 };
 
-const static int buffer_size = 1024 * 1024;
-
-class TraceBuffer {
+// The trace buffer is split into shards, so that threads writing
+// packets at the same time usually don't contend for the same cursor
+// and lock. Each thread writes to the shard picked by the address of
+// its stack, which distinguishes threads without needing thread local
+// storage.
+const static int shard_count = 16;
+const static int shard_size = 128 * 1024;
+
+class TraceBufferShard {
     SharedExclusiveSpinLock lock;
     uint32_t cursor = 0, overage = 0;
-    uint8_t buf[buffer_size];
+    uint8_t buf[shard_size];
 
-    // Attempt to atomically acquire space in the buffer to write a
-    // packet. Returns nullptr if the buffer was full.
+public:
+    // Attempt to atomically acquire space in the shard to write a
+    // packet. Returns nullptr if the shard was full.
     ALWAYS_INLINE halide_trace_packet_t *try_acquire_packet(void *user_context, uint32_t size) {
         lock.acquire_shared();
-        halide_abort_if_false(user_context, size <= buffer_size);
+        halide_abort_if_false(user_context, size <= shard_size);
         uint32_t my_cursor = __sync_fetch_and_add(&cursor, size);
         if (my_cursor + size > sizeof(buf)) {
             // Don't try to back it out: instead, just allow this request to fail
@@ -99,47 +106,174 @@ class TraceBuffer {
         }
     }
 
-public:
-    // Wait for all writers to finish with their packets, stall any
-    // new writers, and flush the buffer to the fd.
-    ALWAYS_INLINE void flush(void *user_context, int fd) {
+    // Release a packet, allowing it to be written out with flush
+    ALWAYS_INLINE void release_packet(halide_trace_packet_t *) {
+        // Need a memory barrier to guarantee all the writes are done.
+        __sync_synchronize();
+        lock.release_shared();
+    }
+
+    // Wait for all writers to finish with their packets, and stall
+    // any new writers. Returns the number of bytes of packets in the
+    // shard.
+    ALWAYS_INLINE uint32_t acquire_exclusive() {
         lock.acquire_exclusive();
-        bool success = true;
-        if (cursor) {
-            cursor -= overage;
-            success = (cursor == (uint32_t)write(fd, buf, cursor));
-            cursor = 0;
-            overage = 0;
+        cursor -= overage;
+        overage = 0;
+        return cursor;
+    }
+
+    ALWAYS_INLINE const halide_trace_packet_t *packet_at(uint32_t offset) const {
+        return (const halide_trace_packet_t *)(buf + offset);
+    }
+
+    // Discard the first 'used' bytes of packets, which have been
+    // written out, and let writers continue.
+    ALWAYS_INLINE void consume_and_release_exclusive(uint32_t used) {
+        if (used < cursor) {
+            memmove(buf, buf + used, cursor - used);
         }
+        cursor -= used;
         lock.release_exclusive();
+    }
+
+    ALWAYS_INLINE void init() {
+        cursor = 0;
+        overage = 0;
+        lock.init();
+    }
+
+    TraceBufferShard() = default;
+};
+
+class TraceBuffer {
+    TraceBufferShard shards[shard_count];
+    // Serializes flushes, and protects the staging buffer.
+    ScopedSpinLock::AtomicFlag flush_lock = 0;
+    // Packets merged from the shards, waiting to be written.
+    uint8_t staging[shard_size];
+    uint32_t staged = 0;
+
+    ALWAYS_INLINE TraceBufferShard &my_shard() {
+        // Thread stacks are far apart, and a thread's stack pointer
+        // moves much less than this shift while it is tracing.
+        int on_stack;
+        uint32_t h = (uint32_t)(((uintptr_t)&on_stack) >> 18) * 0x9e3779b1U;
+        return shards[h >> 28];
+    }
+
+    ALWAYS_INLINE bool write_staged(int fd) {
+        bool success = (staged == (uint32_t)write(fd, staging, staged));
+        staged = 0;
+        return success;
+    }
+
+    // Wait for all writers to finish with their packets, stall any
+    // new writers, and write the packets with ids up to max_id to the
+    // fd. The packets in the shards are merged in order of their ids,
+    // which are assigned in the order the events occurred.
+    ALWAYS_INLINE void flush_up_to(void *user_context, int fd, int32_t max_id) {
+        ScopedSpinLock flush_guard(&flush_lock);
+
+        uint32_t begin[shard_count], end[shard_count];
+        int nonempty = 0, last_nonempty = 0;
+        for (int i = 0; i < shard_count; i++) {
+            begin[i] = 0;
+            end[i] = shards[i].acquire_exclusive();
+            if (end[i] > 0) {
+                nonempty++;
+                last_nonempty = i;
+            }
+        }
+
+        bool success = true;
+        if (nonempty == 1) {
+            // Nothing to merge.
+            const TraceBufferShard &s = shards[last_nonempty];
+            success = (end[last_nonempty] == (uint32_t)write(fd, s.packet_at(0), end[last_nonempty]));
+            begin[last_nonempty] = end[last_nonempty];
+        } else if (nonempty > 1) {
+            while (true) {
+                int next = -1;
+                for (int i = 0; i < shard_count; i++) {
+                    if (begin[i] < end[i] &&
+                        (next < 0 || shards[i].packet_at(begin[i])->id < shards[next].packet_at(begin[next])->id)) {
+                        next = i;
+                    }
+                }
+                if (next < 0) {
+                    break;
+                }
+                const halide_trace_packet_t *p = shards[next].packet_at(begin[next]);
+                if (p->id > max_id) {
+                    break;
+                }
+                if (staged + p->size > sizeof(staging)) {
+                    success = write_staged(fd) && success;
+                }
+                memcpy(staging + staged, p, p->size);
+                staged += p->size;
+                begin[next] += p->size;
+            }
+            success = write_staged(fd) && success;
+        }
+
+        for (int i = 0; i < shard_count; i++) {
+            shards[i].consume_and_release_exclusive(begin[i]);
+        }
         halide_abort_if_false(user_context, success && "Could not write to trace file");
     }
 
+    // The largest id of the packets in a shard. Threads sharing a shard
+    // may write their packets slightly out of order, so this must look
+    // at all of them.
+    ALWAYS_INLINE int32_t max_id_in(TraceBufferShard *shard) {
+        int32_t result = 0;
+        uint32_t end = shard->acquire_exclusive();
+        for (uint32_t offset = 0; offset < end; offset += shard->packet_at(offset)->size) {
+            result = max(result, shard->packet_at(offset)->id);
+        }
+        shard->consume_and_release_exclusive(0);
+        return result;
+    }
+
+public:
+    // Flush everything in the buffer to the fd.
+    ALWAYS_INLINE void flush(void *user_context, int fd) {
+        flush_up_to(user_context, fd, 0x7fffffff);
+    }
+
+    // Make space in a full shard by writing out its packets, along
+    // with just the packets in the other shards that come before them,
+    // so the file stays in id order without emptying every shard
+    // whenever one of them fills up.
+    ALWAYS_INLINE void flush_shard(void *user_context, int fd, TraceBufferShard *shard) {
+        flush_up_to(user_context, fd, max_id_in(shard));
+    }
+
     // Acquire and return a packet's worth of space in the trace
     // buffer, flushing the trace buffer to the given fd to make space
     // if necessary. The region acquired is protected from other
-    // threads writing or reading to it, so it must be released before
-    // a flush can occur.
-    ALWAYS_INLINE halide_trace_packet_t *acquire_packet(void *user_context, int fd, uint32_t size) {
+    // threads writing or reading to it, so it must be released with
+    // the shard returned before a flush can occur.
+    ALWAYS_INLINE halide_trace_packet_t *acquire_packet(void *user_context, int fd, uint32_t size,
+                                                        TraceBufferShard **shard) {
+        *shard = &my_shard();
         halide_trace_packet_t *packet = nullptr;
-        while (!(packet = try_acquire_packet(user_context, size))) {
-            // Couldn't acquire space to write a packet. Flush and try again.
-            flush(user_context, fd);
+        while (!(packet = (*shard)->try_acquire_packet(user_context, size))) {
+            // Couldn't acquire space to write a packet. Flush this
+            // shard and try again.
+            flush_shard(user_context, fd, *shard);
         }
         return packet;
     }
 
-    // Release a packet, allowing it to be written out with flush
-    ALWAYS_INLINE void release_packet(halide_trace_packet_t *) {
-        // Need a memory barrier to guarantee all the writes are done.
-        __sync_synchronize();
-        lock.release_shared();
-    }
-
     ALWAYS_INLINE void init() {
-        cursor = 0;
-        overage = 0;
-        lock.init();
+        for (int i = 0; i < shard_count; i++) {
+            shards[i].init();
+        }
+        flush_lock = 0;
+        staged = 0;
     }
 
     TraceBuffer() = default;
@@ -151,6 +285,45 @@ WEAK ScopedSpinLock::AtomicFlag halide_trace_file_lock = 0;
 WEAK bool halide_trace_file_initialized = false;
 WEAK void *halide_trace_file_internally_opened = nullptr;
 
+// If greater than one, only every Nth load and store event of each
+// Func is traced. Zero indicates uninitialized.
+WEAK int halide_trace_sample_period = 0;
+
+// Counts of the load and store events of each Func, indexed by a hash
+// of the Func's name. Funcs with colliding hashes share a count.
+const static int sample_count_table_size = 256;
+WEAK uint32_t halide_trace_sample_counts[sample_count_table_size];
+
+WEAK int get_trace_sample_period() {
+    int period = halide_trace_sample_period;
+    if (period == 0) {
+        ScopedSpinLock lock(&halide_trace_file_lock);
+        if (halide_trace_sample_period == 0) {
+            const char *sample = getenv("HL_TRACE_SAMPLE");
+            const int n = sample ? atoi(sample) : 1;
+            halide_trace_sample_period = n > 1 ? n : 1;
+        }
+        period = halide_trace_sample_period;
+    }
+    return period;
+}
+
+// Returns true if this event should be skipped when sampling.
+ALWAYS_INLINE bool skip_sampled_event(const halide_trace_event_t *e) {
+    if (e->event != halide_trace_load && e->event != halide_trace_store) {
+        // Keep all the events that give the trace its structure.
+        return false;
+    }
+    const int period = get_trace_sample_period();
+    if (period <= 1) {
+        return false;
+    }
+    // Each Func's name is a constant, so its address identifies the Func.
+    uint32_t h = (uint32_t)(((uintptr_t)e->func) >> 3) * 0x9e3779b1U;
+    uint32_t count = __sync_fetch_and_add(&halide_trace_sample_counts[h >> 24], 1);
+    return (count % period) != 0;
+}
+
 }  // namespace Internal
 }  // namespace Runtime
 }  // namespace Halide
@@ -160,11 +333,28 @@ extern "C" {
 WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t *e) {
     static int32_t ids = 1;
 
+    if (skip_sampled_event(e)) {
+        // Nothing uses the ids of load and store events.
+        return 0;
+    }
+
     int32_t my_id = __sync_fetch_and_add(&ids, 1);
 
     // If we're dumping to a file, use a binary format
     int fd = halide_get_trace_file(user_context);
     if (fd > 0) {
+        if (!halide_trace_buffer) {
+            // The fd may have been set with halide_set_trace_file.
+            ScopedSpinLock lock(&halide_trace_file_lock);
+            if (!halide_trace_buffer) {
+                TraceBuffer *buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
+                halide_abort_if_false(user_context, buffer && "Could not allocate trace buffer");
+                buffer->init();
+                __sync_synchronize();
+                halide_trace_buffer = buffer;
+            }
+        }
+
         // Compute the total packet size
         uint32_t value_bytes = (uint32_t)(e->type.lanes * e->type.bytes());
         uint32_t header_bytes = (uint32_t)sizeof(halide_trace_packet_t);
@@ -175,7 +365,8 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
         uint32_t total_size = (total_size_without_padding + 3) & ~3;
 
         // Claim some space to write to in the trace buffer
-        halide_trace_packet_t *packet = halide_trace_buffer->acquire_packet(user_context, fd, total_size);
+        TraceBufferShard *shard = nullptr;
+        halide_trace_packet_t *packet = halide_trace_buffer->acquire_packet(user_context, fd, total_size, &shard);
 
         if (total_size > 4096) {
             print(nullptr) << total_size << "\n";
@@ -199,7 +390,7 @@ WEAK int32_t halide_default_trace(void *user_context, const halide_trace_event_t
         memcpy((void *)packet->trace_tag(), e->trace_tag ? e->trace_tag : "", trace_tag_bytes);
 
         // Release it
-        halide_trace_buffer->release_packet(packet);
+        shard->release_packet(packet);
 
         // We should also flush the trace buffer if we hit an event
         // that might be the end of the trace.
@@ -343,6 +534,11 @@ WEAK void halide_set_trace_file(int fd) {
 extern int errno;
 
 WEAK int halide_get_trace_file(void *user_context) {
+    // Once the file is known, don't make every event take the lock.
+    int fd = halide_trace_file;
+    if (fd >= 0) {
+        return fd;
+    }
     ScopedSpinLock lock(&halide_trace_file_lock);
     if (halide_trace_file < 0) {
         const char *trace_file_name = getenv("HL_TRACE_FILE");
@@ -351,10 +547,6 @@ WEAK int halide_get_trace_file(void *user_context) {
             halide_abort_if_false(user_context, file && "Failed to open trace file\n");
             halide_set_trace_file(fileno(file));
             halide_trace_file_internally_opened = file;
-            if (!halide_trace_buffer) {
-                halide_trace_buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
-                halide_trace_buffer->init();
-            }
         } else {
             halide_set_trace_file(0);
         }
@@ -374,6 +566,7 @@ WEAK int halide_shutdown_trace() {
         halide_trace_file_internally_opened = nullptr;
         if (halide_trace_buffer) {
             free(halide_trace_buffer);
+            halide_trace_buffer = nullptr;
         }
         return ret;
     } else {
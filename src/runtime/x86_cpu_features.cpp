@@ -36,6 +36,7 @@ WEAK CpuFeatures halide_get_cpu_features() {
     features.set_known(halide_target_feature_avx512_skylake);
     features.set_known(halide_target_feature_avx512_cannonlake);
     features.set_known(halide_target_feature_avx512_sapphirerapids);
+    features.set_known(halide_target_feature_avx512_vnni);
 
     int32_t info[4];
     cpuid(info, 1);
@@ -86,6 +87,9 @@ WEAK CpuFeatures halide_get_cpu_features() {
             }
             if ((info2[1] & avx512_skylake) == avx512_skylake) {
                 features.set_available(halide_target_feature_avx512_skylake);
+                if ((info2[2] & avx512vnni) == avx512vnni) {
+                    features.set_available(halide_target_feature_avx512_vnni);
+                }
             }
             if ((info2[1] & avx512_cannonlake) == avx512_cannonlake) {
                 features.set_available(halide_target_feature_avx512_cannonlake);
@@ -0,0 +1,104 @@
+#include "Halide.h"
+#include <cmath>
+#include <stdio.h>
+
+using namespace Halide;
+
+// Check that timing candidate schedules (HL_MULLAPUDI_BENCHMARK_TOP_K)
+// actually times some, gives a schedule that computes the same thing,
+// and leaves the params it sets for timing as they were.
+
+const int size = 256;
+
+Func make_pipeline(ImageParam input, Param<int> offset) {
+    Var x("x"), y("y");
+    Func clamped = BoundaryConditions::repeat_edge(input);
+    Func blur_x("blur_x");
+    blur_x(x, y) = clamped(x - offset, y) + clamped(x, y) + clamped(x + offset, y);
+    Func blur_y("blur_y");
+    blur_y(x, y) = blur_x(x, y - 1) + blur_x(x, y) + blur_x(x, y + 1);
+    Func output("output");
+    output(x, y) = blur_y(x, y) * 0.1f + input(x, y);
+    return output;
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("[SKIP] Autoschedulers do not support WebAssembly.\n");
+        return 0;
+    }
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <autoscheduler-lib>\n", argv[0]);
+        return 1;
+    }
+
+    load_plugin(argv[1]);
+
+#ifdef _WIN32
+    _putenv_s("HL_MULLAPUDI_BENCHMARK_TOP_K", "2");
+    _putenv_s("HL_MULLAPUDI_BENCHMARK_TIME_LIMIT", "10");
+#else
+    setenv("HL_MULLAPUDI_BENCHMARK_TOP_K", "2", 1);
+    setenv("HL_MULLAPUDI_BENCHMARK_TIME_LIMIT", "10", 1);
+#endif
+
+    ImageParam input(Float(32), 2, "input");
+    Param<int> offset("offset");
+    offset.set_estimate(1);
+    offset.set(2);
+    input.set_estimates({{0, size}, {0, size}});
+
+    Func ref = make_pipeline(input, offset);
+    Func output = make_pipeline(input, offset);
+    output.set_estimates({{0, size}, {0, size}});
+
+    Target target = get_jit_target_from_environment();
+    Pipeline p(output);
+    AutoSchedulerResults results = p.auto_schedule(target);
+
+    // The schedule source says how many candidates were timed, and how
+    // long the one chosen took.
+    int num_measured = 0;
+    double best_ms = 0;
+    if (sscanf(results.schedule_source.c_str(),
+               "// Chosen by timing %d candidate schedules on the host. The fastest took %lf ms.",
+               &num_measured, &best_ms) != 2) {
+        printf("No candidate schedules were timed. Schedule:\n%s\n", results.schedule_source.c_str());
+        return 1;
+    }
+    if (num_measured < 1 || !std::isfinite(best_ms) || best_ms <= 0) {
+        printf("Implausible measurements: %d candidates, fastest %f ms\n", num_measured, best_ms);
+        return 1;
+    }
+    printf("Timed %d candidate schedules; the fastest took %f ms\n", num_measured, best_ms);
+
+    // Timing binds the unbound input and sets the scalar params to their
+    // estimates, which must all be undone.
+    if (input.get().defined()) {
+        printf("The autoscheduler left the input bound\n");
+        return 1;
+    }
+    if (offset.get() != 2) {
+        printf("The autoscheduler changed offset from 2 to %d\n", offset.get());
+        return 1;
+    }
+
+    Buffer<float> in(size, size);
+    in.for_each_element([&](int x, int y) { in(x, y) = (float)((x * 7 + y * 13) % 64); });
+    input.set(in);
+
+    Buffer<float> expected = ref.realize({size, size}, target);
+    Buffer<float> actual = p.realize({size, size}, target);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (expected(x, y) != actual(x, y)) {
+                printf("output(%d, %d) = %f instead of %f\n", x, y, actual(x, y), expected(x, y));
+                return 1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
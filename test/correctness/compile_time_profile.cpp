@@ -0,0 +1,127 @@
+#include "Halide.h"
+#include <cstdio>
+#include <sstream>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+const CompileTimeEvent *find_event(const std::vector<CompileTimeEvent> &events, const std::string &name) {
+    for (const auto &e : events) {
+        if (e.name == name) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+int main(int argc, char **argv) {
+    CompileTimeProfiler::set_enabled(true);
+    CompileTimeProfiler::reset();
+
+    Var x("x"), y("y");
+    Func g("g"), f("f");
+    g(x, y) = x + y;
+    f(x, y) = g(x, y) + g(x + 1, y);
+    g.compute_at(f, y);
+    f.vectorize(x, 8);
+    f.compile_jit();
+
+    std::vector<CompileTimeEvent> events = CompileTimeProfiler::events();
+
+    const CompileTimeEvent *lower = find_event(events, "lower");
+    if (!lower) {
+        printf("No event for lowering as a whole\n");
+        return 1;
+    }
+    if (lower->context != "f") {
+        printf("Lowering event has context %s instead of f\n", lower->context.c_str());
+        return 1;
+    }
+
+    // Passes that always run should be there, with sizes, and nested
+    // within the lowering event.
+    for (const char *name : {"creating initial loop nests",
+                             "storage flattening",
+                             "vectorizing",
+                             "computing bounds of each function's value"}) {
+        const CompileTimeEvent *e = find_event(events, name);
+        if (!e) {
+            printf("No event for pass: %s\n", name);
+            return 1;
+        }
+        if (e->category != "lowering" || e->context != "f") {
+            printf("Pass %s has category %s and context %s\n", name, e->category.c_str(), e->context.c_str());
+            return 1;
+        }
+        if (e->start_us < lower->start_us ||
+            e->start_us + e->duration_us > lower->start_us + lower->duration_us) {
+            printf("Pass %s is not within the lowering event\n", name);
+            return 1;
+        }
+    }
+
+    const CompileTimeEvent *initial = find_event(events, "creating initial loop nests");
+    if (initial->size_before != 0 || initial->size_after <= 0) {
+        printf("Creating the initial loop nest took the IR from %lld to %lld nodes\n",
+               (long long)initial->size_before, (long long)initial->size_after);
+        return 1;
+    }
+
+    // Consecutive passes should agree on the size of the IR between them.
+    const CompileTimeEvent *prev = nullptr;
+    for (const auto &e : events) {
+        if (e.category != "lowering" || e.size_before < 0) {
+            continue;
+        }
+        if (prev && prev->size_after != e.size_before) {
+            printf("%s ended with %lld nodes, but %s started with %lld\n",
+                   prev->name.c_str(), (long long)prev->size_after,
+                   e.name.c_str(), (long long)e.size_before);
+            return 1;
+        }
+        prev = &e;
+    }
+
+    Target target = get_jit_target_from_environment();
+    if (target.arch != Target::WebAssembly) {
+        const CompileTimeEvent *opt = find_event(events, "LLVM optimization");
+        if (!opt || opt->size_before <= 0 || opt->size_after <= 0) {
+            printf("Missing or empty event for LLVM optimization\n");
+            return 1;
+        }
+        if (!find_event(events, "JIT code generation")) {
+            printf("No event for JIT code generation\n");
+            return 1;
+        }
+    }
+
+    // Check the outputs look like what the tools consuming them expect.
+    std::ostringstream json, trace;
+    CompileTimeProfiler::emit_json(json);
+    CompileTimeProfiler::emit_chrome_trace(trace);
+    if (json.str().find("\"summary\"") == std::string::npos ||
+        json.str().find("\"storage flattening\"") == std::string::npos) {
+        printf("Unexpected JSON report:\n%s\n", json.str().c_str());
+        return 1;
+    }
+    if (trace.str().find("\"traceEvents\"") == std::string::npos ||
+        trace.str().find("\"ph\": \"X\"") == std::string::npos ||
+        trace.str().find("\"computing bounds of each function's value\"") == std::string::npos) {
+        printf("Unexpected Chrome trace:\n%s\n", trace.str().c_str());
+        return 1;
+    }
+
+    // Turning profiling off stops recording.
+    CompileTimeProfiler::set_enabled(false);
+    CompileTimeProfiler::reset();
+    Func h("h");
+    h(x) = x * 2;
+    h.compile_jit();
+    if (!CompileTimeProfiler::events().empty()) {
+        printf("Events were recorded with profiling disabled\n");
+        return 1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -221,6 +221,79 @@ void test_compile_to_everything(Func j, bool do_object) {
     }
 }
 
+void test_compile_in_parallel() {
+    const char *o = get_host_target().os == Target::Windows ? ".obj" : ".o";
+
+    std::vector<std::string> target_strings = {
+        "host-profile-no_bounds_query",
+        "host-no_asserts",
+        "host",
+    };
+
+    std::vector<Target> targets;
+    for (auto s : target_strings) {
+        targets.emplace_back(s);
+    }
+
+    // Each call builds its own pipeline, so it's safe to call concurrently.
+    auto module_producer = [](const std::string &name, const Target &target) -> Module {
+        Func f, g;
+        Var x, y;
+        f(x, y) = x + y;
+        g(x, y) = f(x, y) + f(x + 1, y) * 3;
+        f.compute_at(g, y).vectorize(x, 4);
+        g.parallel(y);
+        return g.compile_to_module({}, name, target);
+    };
+
+    // Compile serially and in parallel from the same starting point, and
+    // check that the results are identical.
+    const auto start = Internal::UniqueNameCounters::snapshot();
+    std::map<std::string, std::vector<char>> results[2];
+    for (int threads : {1, 4}) {
+        std::string filename_prefix = get_output_path_prefix("c7_" + std::to_string(threads));
+        std::map<OutputFileType, std::string> outputs = {
+            {OutputFileType::c_header, filename_prefix + ".h"},
+            {OutputFileType::llvm_assembly, filename_prefix + ".ll"},
+            {OutputFileType::object, filename_prefix + o},
+            {OutputFileType::stmt, filename_prefix + ".stmt"},
+        };
+
+        std::vector<std::string> files;
+        files.push_back(filename_prefix + "_runtime" + o);
+        files.push_back(filename_prefix + "_wrapper" + o);
+        for (auto s : target_strings) {
+            for (const char *ext : {".ll", ".stmt", o}) {
+                files.push_back(filename_prefix + "-" + s + ext);
+            }
+        }
+        for (auto f : files) {
+            Internal::ensure_no_file_exists(f);
+        }
+
+        {
+            Internal::ScopedUniqueNameCounters names(start);
+            compile_multitarget("c7", outputs, targets, target_strings, module_producer, nullptr, threads);
+        }
+
+        for (auto f : files) {
+            Internal::assert_file_exists(f);
+        }
+        for (auto s : target_strings) {
+            for (const char *ext : {".ll", ".stmt"}) {
+                results[threads == 1][s + ext] = Internal::read_entire_file(filename_prefix + "-" + s + ext);
+            }
+        }
+    }
+
+    for (const auto &it : results[0]) {
+        if (it.second != results[1][it.first]) {
+            printf("Serial and parallel compilation produced different %s\n", it.first.c_str());
+            exit(1);
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     Param<float> factor("factor");
     Func f, g, h, j;
@@ -240,6 +313,7 @@ int main(int argc, char **argv) {
     test_compile_to_object_files_single_target(j);
     test_compile_to_everything(j, /*do_object*/ true);
     test_compile_to_everything(j, /*do_object*/ false);
+    test_compile_in_parallel();
 
     printf("Success!\n");
     return 0;
@@ -0,0 +1,98 @@
+#include "Halide.h"
+#include <sstream>
+#include <thread>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+Func make_pipeline() {
+    ImageParam in(Int(32), 2, "in");
+    Func blur_x("blur_x"), blur_y("blur_y");
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+    blur_x(x, y) = in(x - 1, y) + in(x, y) + in(x + 1, y);
+    blur_y(x, y) = blur_x(x, y - 1) + blur_x(x, y) + blur_x(x, y + 1);
+    blur_y.tile(x, y, xi, yi, 32, 8).vectorize(xi, 8).unroll(yi, 2).parallel(y);
+    blur_x.compute_at(blur_y, x).vectorize(x, 8);
+    return blur_y;
+}
+
+int main(int argc, char **argv) {
+    Func f = make_pipeline();
+
+    // Lowering should produce the same IR whatever the arena mode.
+    const UniqueNameCounters start = UniqueNameCounters::snapshot();
+    std::string lowered[3];
+    Module private_module("", get_host_target());
+    IRArena::Mode modes[3] = {IRArena::Mode::Off, IRArena::Mode::Shared, IRArena::Mode::ThreadPrivate};
+    for (int i = 0; i < 3; i++) {
+        IRArena::set_mode(modes[i]);
+        ScopedUniqueNameCounters counters(start);
+        Module m = f.compile_to_module({}, "f", get_host_target());
+        std::ostringstream s;
+        s << m;
+        lowered[i] = s.str();
+        if (modes[i] == IRArena::Mode::ThreadPrivate) {
+            private_module = m;
+        }
+    }
+    IRArena::set_mode(IRArena::Mode::Off);
+    if (lowered[0] != lowered[1] || lowered[0] != lowered[2]) {
+        printf("Lowering with an arena changed the result\n");
+        return 1;
+    }
+
+    // Nodes from a thread-private arena must be usable from other
+    // threads once lowering is done.
+    Stmt body = private_module.functions().front().body;
+    if (!body.get()->ref_count.is_arena_allocated() ||
+        body.get()->ref_count.is_thread_private()) {
+        printf("Lowered IR should be arena-allocated and no longer thread-private\n");
+        return 1;
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([=]() {
+            for (int j = 0; j < 1000; j++) {
+                Stmt copy = body;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    body = Stmt();
+    const int64_t chunks_before = IRArena::chunks_in_use();
+    std::thread([m = std::move(private_module)]() mutable {
+        m = Module("", get_host_target());
+    }).join();
+    if (IRArena::chunks_in_use() >= chunks_before) {
+        printf("Freeing the module on another thread should have released some chunks\n");
+        return 1;
+    }
+
+    // A pipeline lowered in a thread-private arena can be compiled.
+    IRArena::set_mode(IRArena::Mode::ThreadPrivate);
+    Func g = make_pipeline();
+    g.compile_jit();
+    IRArena::set_mode(IRArena::Mode::Off);
+
+    // While other threads may be compiling, an arena asked to be
+    // thread-private uses atomic reference counts.
+    for (bool concurrent : {false, true}) {
+        std::unique_ptr<IRArena::ConcurrentCompilation> c;
+        if (concurrent) {
+            c = std::make_unique<IRArena::ConcurrentCompilation>();
+        }
+        IRArena arena(true);
+        Expr e = Variable::make(Int(32), "x") + 1;
+        if (!e.get()->ref_count.is_arena_allocated() ||
+            e.get()->ref_count.is_thread_private() != !concurrent) {
+            printf("An arena opened %s other compilations should %sbe thread-private\n",
+                   concurrent ? "during" : "without", concurrent ? "not " : "");
+            return 1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
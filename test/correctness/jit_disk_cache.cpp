@@ -0,0 +1,172 @@
+#include "Halide.h"
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Halide;
+
+// Each phase of this test runs in a forked child, so that every
+// compile_jit starts from the same process state, just as successive
+// runs of the same program would.
+
+#ifndef _WIN32
+
+std::string cache_dir;
+
+std::vector<std::string> cache_files() {
+    std::vector<std::string> result;
+    DIR *d = opendir(cache_dir.c_str());
+    while (dirent *e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name != "." && name != "..") {
+            result.push_back(cache_dir + "/" + name);
+        }
+    }
+    closedir(d);
+    return result;
+}
+
+int compile_and_run(Func f, Param<int> p, int64_t expected_hits, int64_t expected_misses, int64_t expected_rejected) {
+    Internal::JITCache::set_directory(cache_dir);
+    f.compile_jit();
+
+    Internal::JITCacheStats stats = Internal::JITCache::stats();
+    if (stats.hits != expected_hits ||
+        stats.misses != expected_misses ||
+        stats.rejected != expected_rejected) {
+        printf("Expected %lld hits, %lld misses and %lld rejected entries. Got %lld, %lld and %lld.\n",
+               (long long)expected_hits, (long long)expected_misses, (long long)expected_rejected,
+               (long long)stats.hits, (long long)stats.misses, (long long)stats.rejected);
+        return 1;
+    }
+    if (stats.stores != expected_misses) {
+        printf("Every miss should have written an entry: %lld misses, %lld stores\n",
+               (long long)stats.misses, (long long)stats.stores);
+        return 1;
+    }
+
+    p.set(3);
+    Buffer<int> out = f.realize({64, 64});
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            int correct = (x * y + 3) * 2 + 1;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Run a phase in a child process and return its exit status.
+int in_child(const std::function<int()> &phase) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int result = phase();
+        fflush(stdout);
+        _exit(result);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+#endif
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] This test uses fork(), which is unavailable on Windows.\n");
+    return 0;
+#else
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] The JIT disk cache does not apply to the WebAssembly JIT.\n");
+        return 0;
+    }
+
+    cache_dir = Internal::dir_make_temp();
+
+    Param<int> p("p");
+    Var x("x"), y("y");
+    Func g("g"), f("f");
+    g(x, y) = x * y + p;
+    f(x, y) = g(x, y) * 2 + 1;
+    g.compute_root().vectorize(x, 8);
+    f.parallel(y);
+
+    // A fresh cache misses and writes an entry.
+    if (in_child([&]() { return compile_and_run(f, p, 0, 1, 0); }) != 0) {
+        printf("First compilation failed\n");
+        return 1;
+    }
+    if (cache_files().size() != 1) {
+        printf("Expected one cache entry, found %d\n", (int)cache_files().size());
+        return 1;
+    }
+
+    // The second run loads the entry instead of compiling.
+    if (in_child([&]() { return compile_and_run(f, p, 1, 0, 0); }) != 0) {
+        printf("Second compilation failed\n");
+        return 1;
+    }
+
+    // A truncated entry is rejected and replaced.
+    {
+        std::string entry = cache_files()[0];
+        std::vector<char> contents = Internal::read_entire_file(entry);
+        contents.resize(contents.size() / 2);
+        Internal::write_entire_file(entry, contents);
+    }
+    if (in_child([&]() { return compile_and_run(f, p, 0, 1, 1); }) != 0) {
+        printf("Compilation after corrupting the cache failed\n");
+        return 1;
+    }
+    if (in_child([&]() { return compile_and_run(f, p, 1, 0, 0); }) != 0) {
+        printf("Compilation after repairing the cache failed\n");
+        return 1;
+    }
+
+    // An entry whose header claims sizes larger than the file is
+    // rejected without trying to allocate them.
+    {
+        std::string entry = cache_files()[0];
+        std::vector<char> contents = Internal::read_entire_file(entry);
+        // The skeleton size follows the magic number, the format
+        // version, the key length and the 32-character key.
+        const size_t skeleton_size_offset = 8 + 4 + 4 + 32;
+        const uint64_t huge = (uint64_t)1 << 62;
+        memcpy(&contents[skeleton_size_offset], &huge, sizeof(huge));
+        Internal::write_entire_file(entry, contents);
+    }
+    if (in_child([&]() { return compile_and_run(f, p, 0, 1, 1); }) != 0) {
+        printf("Compilation after corrupting the entry's sizes failed\n");
+        return 1;
+    }
+
+    // A different schedule is a different key.
+    f.vectorize(x, 4);
+    if (in_child([&]() { return compile_and_run(f, p, 0, 1, 0); }) != 0) {
+        printf("Compilation of a changed pipeline failed\n");
+        return 1;
+    }
+    if (cache_files().size() != 2) {
+        printf("Expected two cache entries, found %d\n", (int)cache_files().size());
+        return 1;
+    }
+
+    for (const auto &file : cache_files()) {
+        Internal::file_unlink(file);
+    }
+    Internal::dir_rmdir(cache_dir);
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
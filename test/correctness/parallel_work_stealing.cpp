@@ -0,0 +1,103 @@
+#include "Halide.h"
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+const int num_tasks = 10000;
+std::atomic<int> calls[num_tasks];
+
+extern "C" DLLEXPORT int count_call(int x) {
+    calls[x]++;
+    return x;
+}
+
+namespace halide_externs {
+HalideExtern_1(int, count_call, int);
+}
+
+int main(int argc, char **argv) {
+    // Run everything with the work-stealing scheduler in the thread
+    // pool, with enough workers that they steal from each other even
+    // on machines with fewer cores.
+    char env[] = "HL_WORK_STEALING=1";
+    putenv(env);
+#ifdef _WIN32
+    _putenv_s("HL_NUM_THREADS", "4");
+#else
+    setenv("HL_NUM_THREADS", "4", 1);
+#endif
+    Internal::JITSharedRuntime::release_all();
+
+    {
+        // Every iteration of a parallel loop must run exactly once.
+        Var x;
+        Func f;
+        f(x) = halide_externs::count_call(x);
+        f.parallel(x);
+
+        for (int i = 0; i < num_tasks; i++) {
+            calls[i] = 0;
+        }
+        Buffer<int> im = f.realize({num_tasks});
+        for (int i = 0; i < num_tasks; i++) {
+            if (im(i) != i || calls[i] != 1) {
+                printf("Iteration %d ran %d times\n", i, calls[i].load());
+                return -1;
+            }
+        }
+    }
+
+    {
+        // Nested parallelism, with tiny extents to exercise ranges
+        // that are shorter than the number of workers.
+        Var x, y, z;
+        Func f;
+        f(x, y, z) = x * y + z * 3 + 1;
+        f.parallel(x).parallel(y).parallel(z);
+
+        for (int size : {1, 2, 3, 64}) {
+            Buffer<int> im = f.realize({size, size, size});
+            for (int z = 0; z < size; z++) {
+                for (int y = 0; y < size; y++) {
+                    for (int x = 0; x < size; x++) {
+                        if (im(x, y, z) != x * y + z * 3 + 1) {
+                            printf("im(%d, %d, %d) = %d\n", x, y, z, im(x, y, z));
+                            return -1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (get_jit_target_from_environment().arch != Target::WebAssembly) {
+        // Async producers are scheduled through semaphores, so they
+        // must coexist with stealing consumers.
+        Var x, y;
+        Func producer, consumer;
+        producer(x, y) = x + y;
+        consumer(x, y) = producer(x - 1, y) + producer(x + 1, y);
+        consumer.parallel(y);
+        producer.compute_at(consumer, y).async();
+
+        Buffer<int> im = consumer.realize({64, 64});
+        for (int y = 0; y < 64; y++) {
+            for (int x = 0; x < 64; x++) {
+                if (im(x, y) != 2 * (x + y)) {
+                    printf("im(%d, %d) = %d\n", x, y, im(x, y));
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
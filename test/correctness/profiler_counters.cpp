@@ -0,0 +1,131 @@
+#include "Halide.h"
+
+#include <cstdio>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// Check that the sampling profiler reports hardware performance counters
+// when HL_PROFILER_COUNTERS=1, and still reports everything else when the
+// counters can't be opened.
+
+using namespace Halide;
+
+namespace {
+
+std::string report;
+
+void my_print(JITUserContext *, const char *msg) {
+    report += msg;
+}
+
+// Run a pipeline with a slow Func under the profiler. If
+// block_counters is true, run it with no file descriptors left, so
+// perf_event_open fails as it does where it's forbidden. Returns false if
+// the profiler didn't report the pipeline.
+bool run(Pipeline &p, bool block_counters) {
+    report.clear();
+    // The counters are opened when each runtime first starts profiling,
+    // so start from a fresh one.
+    Internal::JITSharedRuntime::release_all();
+    p.invalidate_cache();
+    p.jit_handlers().custom_print = my_print;
+    const Target t = get_jit_target_from_environment().with_feature(Target::Profile);
+    p.compile_jit(t);
+
+#ifdef __linux__
+    struct rlimit old_limit;
+    if (block_counters) {
+        // The lowest free descriptor is one past the last one in a row
+        // that are all open, so limiting descriptors to below it leaves
+        // none free.
+        int fd = open("/dev/null", O_RDONLY);
+        close(fd);
+        getrlimit(RLIMIT_NOFILE, &old_limit);
+        struct rlimit limit = old_limit;
+        limit.rlim_cur = fd;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+
+    p.realize({512, 512}, t);
+
+#ifdef __linux__
+    if (block_counters) {
+        setrlimit(RLIMIT_NOFILE, &old_limit);
+    }
+#endif
+
+    if (report.find(" total time: ") == std::string::npos ||
+        report.find("expensive") == std::string::npos) {
+        printf("The profiler didn't report the pipeline:\n%s\n", report.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool has_counters() {
+    return report.find(" cycles: ") != std::string::npos;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] The profiler is not supported under WebAssembly.\n");
+        return 0;
+    }
+
+#ifdef _WIN32
+    _putenv_s("HL_PROFILER_COUNTERS", "1");
+#else
+    setenv("HL_PROFILER_COUNTERS", "1", 1);
+#endif
+
+    // Take long enough for the profiler to take many samples of the
+    // expensive Func.
+    Func expensive("expensive"), output("output");
+    Var x, y;
+    Expr e = cast<float>(x + y);
+    for (int i = 0; i < 30; i++) {
+        e = sin(e);
+    }
+    expensive(x, y) = e;
+    output(x, y) = expensive(x, y) * 2.0f;
+    expensive.compute_root();
+    Pipeline p(output);
+
+    if (!run(p, false)) {
+        return 1;
+    }
+    if (has_counters()) {
+        // The counters were opened, so the expensive Func must have had
+        // some of them billed to it.
+        if (report.find(" instructions: ") == std::string::npos ||
+            report.find("ipc: ") == std::string::npos) {
+            printf("The profiler reported cycles, but not instructions:\n%s\n", report.c_str());
+            return 1;
+        }
+        printf("Hardware performance counters are available.\n");
+    } else {
+        printf("Hardware performance counters are not available here.\n");
+    }
+
+#ifdef __linux__
+    if (!run(p, true)) {
+        return 1;
+    }
+    if (has_counters()) {
+        printf("The profiler reported counters it should have failed to open:\n%s\n", report.c_str());
+        return 1;
+    }
+#endif
+
+    printf("Success!\n");
+    return 0;
+}
@@ -27,7 +27,10 @@ public:
         : SimdOpCheckTest(t, w, h) {
         // We only test the skylake variant of avx512 here
         use_avx512 = (target.has_feature(Target::AVX512_Cannonlake) ||
-                      target.has_feature(Target::AVX512_Skylake));
+                      target.has_feature(Target::AVX512_Skylake) ||
+                      target.has_feature(Target::AVX512_VNNI));
+        use_avx512_vnni = (target.has_feature(Target::AVX512_VNNI) ||
+                           target.has_feature(Target::AVX512_SapphireRapids));
         if (target.has_feature(Target::AVX512) && !use_avx512) {
             std::cerr << "Warning: This test is only configured for the skylake variant of avx512. Expect failures\n";
         }
@@ -545,6 +548,12 @@ public:
                 check("vdpbf16ps*zmm", 16, sum(f32(in_bf16(2 * x + r)) * in_bf16(2 * x + r + 32)));
                 check("vdpbf16ps*ymm", 8, sum(f32(in_bf16(2 * x + r)) * in_bf16(2 * x + r + 32)));
                 check("vdpbf16ps*xmm", 4, sum(f32(in_bf16(2 * x + r)) * in_bf16(2 * x + r + 32)));
+            }
+        }
+        if (use_avx512_vnni) {
+            {
+                // 16 bit, 2 element dot product
+                RDom r(0, 2);
                 check("vpdpwssd*zmm", 16, sum(i32(in_i16(2 * x + r)) * in_i16(2 * x + r + 32)));
                 check("vpdpwssd*ymm", 8, sum(i32(in_i16(2 * x + r)) * in_i16(2 * x + r + 32)));
                 check("vpdpwssd*xmm", 4, sum(i32(in_i16(2 * x + r)) * in_i16(2 * x + r + 32)));
@@ -558,6 +567,10 @@ public:
                 check("vpdpbusd*ymm", 8, sum(i32(in_i8(4 * x + r)) * in_u8(4 * x + r + 32)));
                 check("vpdpbusd*xmm", 4, sum(i32(in_u8(4 * x + r)) * in_i8(4 * x + r + 32)));
                 check("vpdpbusd*xmm", 4, sum(i32(in_i8(4 * x + r)) * in_u8(4 * x + r + 32)));
+                // The form used by quantized conv and fully connected layers,
+                // which widen both operands to 32 bits.
+                check("vpdpbusd*zmm", 16, sum(i32(in_u8(4 * x + r)) * i32(in_i8(4 * x + r + 32))));
+                check("vpdpbusd*ymm", 8, sum(i32(in_u8(4 * x + r)) * i32(in_i8(4 * x + r + 32))));
             }
             {
                 // 16 bit, 2 element saturaing dot product
@@ -2224,6 +2237,7 @@ public:
 private:
     bool use_avx2{false};
     bool use_avx512{false};
+    bool use_avx512_vnni{false};
     bool use_avx{false};
     bool use_power_arch_2_07{false};
     bool use_sse41{false};
@@ -0,0 +1,125 @@
+#include "Halide.h"
+#include <sstream>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Simplify with and without the memo, and check the results agree.
+template<typename T>
+bool check_same(const T &ir, SimplifyMemoStats *stats) {
+    set_simplify_memoization(false);
+    T plain = simplify(ir);
+    set_simplify_memoization(true);
+    reset_simplify_memo_stats();
+    T memoized = simplify(ir);
+    *stats = simplify_memo_stats();
+    if (!equal(plain, memoized)) {
+        std::cerr << "Memoization changed the result of simplification:\n"
+                  << "Input: " << ir << "\n"
+                  << "Without memo: " << plain << "\n"
+                  << "With memo: " << memoized << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::string lowered(Func f, const UniqueNameCounters &start) {
+    ScopedUniqueNameCounters counters(start);
+    Module m = f.compile_to_module({}, "f", get_host_target());
+    std::ostringstream s;
+    s << m;
+    return s.str();
+}
+
+int main(int argc, char **argv) {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    SimplifyMemoStats stats;
+
+    // Equal subexpressions built separately are found by their
+    // structure, and the same node reached twice by its identity.
+    {
+        Expr e = 0;
+        for (int i = 0; i < 8; i++) {
+            e += (x * 2 + 3) * (y + 1 - 1);
+        }
+        Expr shared = max(x + y * 4, 0) + 1;
+        e += shared * shared;
+        if (!check_same(e, &stats)) {
+            return 1;
+        }
+        if (stats.structural_hits == 0 || stats.identity_hits == 0) {
+            printf("Expected both structural and identity hits. Got %lld and %lld from %lld lookups\n",
+                   (long long)stats.structural_hits, (long long)stats.identity_hits, (long long)stats.lookups);
+            return 1;
+        }
+    }
+
+    // Uses of let variables in reused results must still be counted,
+    // or the lets would be removed as dead.
+    {
+        Expr t = Variable::make(Int(32), "t");
+        Expr body = 0;
+        for (int i = 0; i < 4; i++) {
+            body += min(t * 3, y) + (t * 3 + 1);
+        }
+        Stmt s = LetStmt::make("t", x * x + y,
+                               Evaluate::make(Call::make(Int(32), "sink", {body}, Call::Extern)));
+        if (!check_same(s, &stats)) {
+            return 1;
+        }
+        if (stats.structural_hits == 0) {
+            printf("Expected structural hits within the let body\n");
+            return 1;
+        }
+    }
+
+    // Results can't be reused when the facts in scope differ.
+    {
+        Expr a = (x % 4) * 2 + y;
+        Expr b = (x % 4) * 2 + y;
+        Stmt s = IfThenElse::make(x == 5,
+                                  Evaluate::make(Call::make(Int(32), "sink", {a}, Call::Extern)),
+                                  Evaluate::make(Call::make(Int(32), "sink", {b}, Call::Extern)));
+        if (!check_same(s, &stats)) {
+            return 1;
+        }
+    }
+
+    // A whole pipeline with an unrolled stencil lowers the same way.
+    {
+        ImageParam in(Float(32), 2, "in");
+        Func f("f");
+        Var u("u"), v("v");
+        Expr sum = 0.0f;
+        for (int dy = -2; dy <= 2; dy++) {
+            for (int dx = -2; dx <= 2; dx++) {
+                sum += in(u + dx, v + dy) * (float)(dx * dx + dy * dy + 1);
+            }
+        }
+        f(u, v) = sum;
+        Var ui("ui");
+        f.split(u, u, ui, 4).unroll(ui).vectorize(u, 8);
+
+        const UniqueNameCounters start = UniqueNameCounters::snapshot();
+        set_simplify_memoization(false);
+        std::string plain = lowered(f, start);
+        set_simplify_memoization(true);
+        reset_simplify_memo_stats();
+        std::string memoized = lowered(f, start);
+        stats = simplify_memo_stats();
+        set_simplify_memoization(false);
+
+        if (plain != memoized) {
+            printf("Memoization changed the lowered pipeline:\n%s\nvs\n%s\n", plain.c_str(), memoized.c_str());
+            return 1;
+        }
+        if (stats.identity_hits + stats.structural_hits == 0) {
+            printf("Expected memo hits while lowering the stencil\n");
+            return 1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
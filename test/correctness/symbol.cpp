@@ -0,0 +1,171 @@
+#include "Halide.h"
+#include <thread>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+int main(int argc, char **argv) {
+    // Symbols made from equal strings are the same Symbol.
+    {
+        std::string a = "symbol_test_name";
+        std::string b = std::string("symbol_test_") + "name";
+        if (Symbol(a) != Symbol(b) || &Symbol(a).str() != &Symbol(b).str()) {
+            printf("Equal names were interned as different Symbols\n");
+            return 1;
+        }
+        if (Symbol(a) == Symbol("symbol_test_other") || Symbol() != Symbol("")) {
+            printf("Unexpected Symbol comparison\n");
+            return 1;
+        }
+    }
+
+    // IR nodes give the Symbol of their name.
+    {
+        Expr x = Variable::make(Int(32), "x");
+        Expr l = Let::make("x", 3, x + 1);
+        if (x.as<Variable>()->symbol() != Symbol("x") ||
+            l.as<Let>()->symbol() != x.as<Variable>()->symbol()) {
+            printf("IR nodes have the wrong Symbols\n");
+            return 1;
+        }
+    }
+
+    // Scopes can be used through either Symbols or strings.
+    {
+        Scope<int> scope;
+        scope.push("a", 1);
+        scope.push(Symbol("a"), 2);
+        if (scope.get("a") != 2 || scope.get(Symbol("a")) != 2 || scope.count("a") != 2) {
+            printf("Scope lookups by Symbol and string disagree\n");
+            return 1;
+        }
+        scope.pop("a");
+        if (scope.get(Symbol("a")) != 1) {
+            printf("Popping a name by string didn't reveal the outer value\n");
+            return 1;
+        }
+        scope.pop(Symbol("a"));
+        if (scope.contains("a")) {
+            printf("Name still in scope after being popped\n");
+            return 1;
+        }
+
+        Scope<int> outer;
+        outer.push("b", 3);
+        scope.set_containing_scope(&outer);
+        if (!scope.contains(Symbol("b")) || scope.get(Symbol("b")) != 3) {
+            printf("Symbol lookups don't find names in a containing scope\n");
+            return 1;
+        }
+    }
+
+    // Looking up a string that was never pushed doesn't intern it.
+    {
+        Scope<int> scope;
+        scope.push("symbol_test_present", 1);
+        size_t before = Symbol::table_size();
+        if (scope.contains("symbol_test_absent") || scope.count("symbol_test_absent") != 0) {
+            printf("Scope contains a name that was never pushed\n");
+            return 1;
+        }
+        Symbol sym;
+        if (Symbol::find("symbol_test_absent", &sym) || !Symbol::find("symbol_test_present", &sym) ||
+            sym != Symbol("symbol_test_present")) {
+            printf("Symbol::find gave the wrong answer\n");
+            return 1;
+        }
+        if (Symbol::table_size() != before) {
+            printf("Lookups that missed added names to the symbol table\n");
+            return 1;
+        }
+    }
+
+    // Iterating over a scope visits names in order, whatever the order
+    // they were interned in.
+    {
+        Scope<> scope;
+        for (const char *name : {"symbol_test_z", "symbol_test_a", "symbol_test_m", "symbol_test_b"}) {
+            scope.push(name);
+        }
+        std::vector<std::string> names;
+        for (auto it = scope.cbegin(); it != scope.cend(); ++it) {
+            names.push_back(it.name());
+        }
+        if (names != std::vector<std::string>{"symbol_test_a", "symbol_test_b", "symbol_test_m", "symbol_test_z"}) {
+            printf("Scope was not iterated over in order of name\n");
+            return 1;
+        }
+
+        // The order is rebuilt when names are added or removed.
+        scope.pop("symbol_test_m");
+        scope.push("symbol_test_c");
+        names.clear();
+        for (auto it = scope.cbegin(); it != scope.cend(); ++it) {
+            names.push_back(it.name());
+        }
+        if (names != std::vector<std::string>{"symbol_test_a", "symbol_test_b", "symbol_test_c", "symbol_test_z"}) {
+            printf("Scope iteration didn't reflect added and removed names\n");
+            return 1;
+        }
+    }
+
+    // Interning from many threads at once gives one Symbol per name.
+    {
+        const int num_threads = 8, num_names = 1000;
+        std::vector<std::vector<Symbol>> symbols(num_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < num_names; i++) {
+                    symbols[t].emplace_back("symbol_test_thread_" + std::to_string(i));
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        for (int t = 1; t < num_threads; t++) {
+            if (symbols[t] != symbols[0]) {
+                printf("Threads interned the same names as different Symbols\n");
+                return 1;
+            }
+        }
+    }
+
+    // Names are removed from the table once nothing refers to them, so
+    // unique generated names don't accumulate.
+    {
+        size_t before = Symbol::table_size();
+        {
+            std::vector<Symbol> symbols;
+            std::vector<Expr> exprs;
+            Scope<int> scope;
+            for (int i = 0; i < 100; i++) {
+                std::string name = unique_name("symbol_test_unique");
+                symbols.emplace_back(name);
+                Expr v = Variable::make(Int(32), name);
+                scope.push(v.as<Variable>()->symbol(), i);
+                exprs.push_back(v);
+            }
+            if (Symbol::table_size() != before + 100) {
+                printf("Expected 100 new names in the symbol table, got %d\n",
+                       (int)(Symbol::table_size() - before));
+                return 1;
+            }
+            Symbol copy = symbols[0];
+            symbols.clear();
+            if (!scope.contains(copy) || Symbol::table_size() != before + 100) {
+                printf("Names still in use were removed from the symbol table\n");
+                return 1;
+            }
+        }
+        if (Symbol::table_size() != before) {
+            printf("%d unused names were left in the symbol table\n",
+                   (int)(Symbol::table_size() - before));
+            return 1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
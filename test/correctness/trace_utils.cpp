@@ -0,0 +1,194 @@
+#include "HalideTraceUtils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Check that traces round-trip through CompactTraceWriter and
+// TraceReader, in both the raw and the compact format.
+
+using namespace Halide::Internal;
+
+namespace {
+
+struct PacketDesc {
+    halide_trace_event_code_t event;
+    int32_t id, parent_id;
+    halide_type_t type;
+    int32_t value_index;
+    std::vector<int32_t> coordinates;
+    std::string func, trace_tag;
+};
+
+// Lay out a packet as halide_default_trace does. Values are only
+// meaningful for loads and stores; other events get zeros.
+void make_packet(const PacketDesc &d, Packet *p) {
+    memset((void *)p, 0, sizeof(*p));
+    p->event = d.event;
+    p->id = d.id;
+    p->parent_id = d.parent_id;
+    p->type = d.type;
+    p->value_index = d.value_index;
+    p->dimensions = (int32_t)d.coordinates.size();
+    memcpy(p->coordinates(), d.coordinates.data(), d.coordinates.size() * sizeof(int32_t));
+    uint8_t *value = (uint8_t *)p->value();
+    const int value_bytes = d.type.lanes * d.type.bytes();
+    if (d.event == halide_trace_load || d.event == halide_trace_store) {
+        for (int i = 0; i < value_bytes; i++) {
+            value[i] = (uint8_t)(d.id * 31 + i * 7);
+        }
+    }
+    memcpy(p->func(), d.func.c_str(), d.func.size() + 1);
+    memcpy((char *)p->trace_tag(), d.trace_tag.c_str(), d.trace_tag.size() + 1);
+    const size_t size = sizeof(halide_trace_packet_t) + d.coordinates.size() * sizeof(int32_t) +
+                        value_bytes + d.func.size() + 1 + d.trace_tag.size() + 1;
+    p->size = (uint32_t)((size + 3) & ~3);
+}
+
+// A pipeline's worth of packets, with every event type, several types,
+// vector values, negative and far apart coordinates, and ids that go
+// backwards, as they do when packets from many threads are merged.
+std::vector<PacketDesc> make_trace() {
+    const halide_type_t i32(halide_type_int, 32), u8(halide_type_uint, 8);
+    const halide_type_t f32x4(halide_type_float, 32, 4), i16(halide_type_int, 16);
+    const halide_type_t f64(halide_type_float, 64), u1(halide_type_uint, 1);
+    std::vector<PacketDesc> trace = {
+        {halide_trace_begin_pipeline, 1, 0, i32, 0, {}, "pipeline", ""},
+        {halide_trace_tag, 2, 1, i32, 0, {}, "f", "func_type_and_dim: 1 0 8 1 2 0 16 -5 8"},
+        {halide_trace_tag, 3, 1, i32, 0, {}, "f", "another tag"},
+        {halide_trace_begin_realization, 4, 1, i32, 0, {0, 16, -5, 8}, "f", ""},
+        {halide_trace_produce, 5, 4, i32, 0, {0, 16, -5, 8}, "f", ""},
+        {halide_trace_store, 7, 5, u8, 0, {0, -5}, "f", ""},
+        {halide_trace_store, 6, 5, u8, 0, {1, -5}, "f", ""},
+        {halide_trace_store, 8, 5, u8, 0, {15, 2}, "f", ""},
+        {halide_trace_store, 9, 5, f32x4, 0, {0, 1, 2, 3, 7, 7, 7, 7}, "f", ""},
+        {halide_trace_store, 10, 5, i16, 1, {-1000000, 2000000}, "f", ""},
+        {halide_trace_store, 11, 5, u1, 0, {3, 3}, "f", ""},
+        {halide_trace_load, 12, 5, f64, 0, {4}, "g", ""},
+        {halide_trace_load, 13, 5, f64, 0, {5}, "g", ""},
+        {halide_trace_end_produce, 14, 5, i32, 0, {0, 16, -5, 8}, "f", ""},
+        {halide_trace_consume, 15, 4, i32, 0, {0, 16, -5, 8}, "f", ""},
+        {halide_trace_load, 16, 15, u8, 0, {0, -5}, "f", ""},
+        {halide_trace_load, 17, 15, u8, 0, {1, -4}, "f", ""},
+        {halide_trace_end_consume, 18, 15, i32, 0, {0, 16, -5, 8}, "f", ""},
+        {halide_trace_end_realization, 19, 4, i32, 0, {0, 16, -5, 8}, "f", ""},
+        {halide_trace_end_pipeline, 20, 1, i32, 0, {}, "pipeline", ""},
+    };
+    return trace;
+}
+
+bool same_packet(const Packet &a, const Packet &b) {
+    return a.size == b.size &&
+           a.id == b.id &&
+           a.parent_id == b.parent_id &&
+           a.type == b.type &&
+           a.event == b.event &&
+           a.value_index == b.value_index &&
+           a.dimensions == b.dimensions &&
+           memcmp(a.coordinates(), b.coordinates(), a.dimensions * sizeof(int32_t)) == 0 &&
+           memcmp(a.value(), b.value(), a.type.lanes * a.type.bytes()) == 0 &&
+           strcmp(a.func(), b.func()) == 0 &&
+           strcmp(a.trace_tag(), b.trace_tag()) == 0;
+}
+
+// Read back a trace from the start of the file, and check it matches the
+// packets written.
+bool check_trace(FILE *f, bool compact, const std::vector<Packet> &expected) {
+    rewind(f);
+    TraceReader reader(f);
+    if (reader.is_compact() != compact) {
+        printf("Expected a %s trace\n", compact ? "compact" : "raw");
+        return false;
+    }
+    for (size_t i = 0;; i++) {
+        Packet p;
+        const bool got = reader.next(&p);
+        if (i == expected.size()) {
+            if (got) {
+                printf("Read more packets than were written\n");
+                return false;
+            }
+            return true;
+        }
+        if (!got) {
+            printf("Read %d packets, but %d were written\n", (int)i, (int)expected.size());
+            return false;
+        }
+        if (!same_packet(p, expected[i])) {
+            printf("Packet %d (id %d, event %d, func %s) doesn't match the packet written\n",
+                   (int)i, expected[i].id, expected[i].event, expected[i].func());
+            return false;
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    std::vector<Packet> packets;
+    for (const PacketDesc &d : make_trace()) {
+        packets.emplace_back();
+        make_packet(d, &packets.back());
+    }
+
+    FILE *raw = tmpfile();
+    FILE *compact = tmpfile();
+    if (!raw || !compact) {
+        printf("Couldn't make temporary files\n");
+        return 1;
+    }
+
+    CompactTraceWriter writer(compact);
+    for (const Packet &p : packets) {
+        fwrite(&p, p.size, 1, raw);
+        writer.write(p);
+    }
+    fflush(raw);
+    fflush(compact);
+
+    if (!check_trace(raw, false, packets) ||
+        !check_trace(compact, true, packets)) {
+        return 1;
+    }
+
+    // Converting a raw trace, as HalideTraceSummary -o does, gives the
+    // same file as encoding the packets directly.
+    FILE *converted = tmpfile();
+    if (!converted) {
+        printf("Couldn't make temporary files\n");
+        return 1;
+    }
+    {
+        rewind(raw);
+        TraceReader reader(raw);
+        CompactTraceWriter converter(converted);
+        Packet p;
+        while (reader.next(&p)) {
+            converter.write(p);
+        }
+        if (converter.bytes_written() != writer.bytes_written()) {
+            printf("Converting the raw trace wrote %d bytes, but encoding it wrote %d\n",
+                   (int)converter.bytes_written(), (int)writer.bytes_written());
+            return 1;
+        }
+    }
+    fflush(converted);
+    if (!check_trace(converted, true, packets)) {
+        return 1;
+    }
+
+    // An empty file is an empty raw trace.
+    FILE *empty = tmpfile();
+    if (!empty || !check_trace(empty, false, {})) {
+        return 1;
+    }
+
+    fclose(raw);
+    fclose(compact);
+    fclose(converted);
+    fclose(empty);
+
+    printf("Success!\n");
+    return 0;
+}
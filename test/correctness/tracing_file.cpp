@@ -0,0 +1,131 @@
+#include "Halide.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <vector>
+
+// Check the binary trace written by the default trace handler when many
+// threads write packets at once, with and without sampling.
+
+using namespace Halide;
+
+namespace {
+
+const int W = 512;
+const int H = 256;
+
+void set_env(const char *name, const char *value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
+// Read a trace file, and check that every packet is intact, and that the
+// stores of f have the right values and come after their parent events.
+// Returns the number of stores of f, or -1 on failure.
+int check_trace(const std::string &path, bool expect_all_stores) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::set<int> ids;
+    std::vector<bool> stored(W * H, false);
+    int stores = 0;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        const halide_trace_packet_t *p = (const halide_trace_packet_t *)(data.data() + offset);
+        if (data.size() - offset < sizeof(halide_trace_packet_t) ||
+            p->size < sizeof(halide_trace_packet_t) ||
+            p->size > data.size() - offset) {
+            printf("Truncated or corrupt packet at offset %d\n", (int)offset);
+            return -1;
+        }
+        offset += p->size;
+
+        if (!ids.insert(p->id).second) {
+            printf("Packet id %d appears more than once\n", p->id);
+            return -1;
+        }
+        if (p->event != halide_trace_begin_pipeline && !ids.count(p->parent_id)) {
+            printf("Packet %d was written before its parent %d\n", p->id, p->parent_id);
+            return -1;
+        }
+
+        if (p->event != halide_trace_store || strcmp(p->func(), "f") != 0) {
+            continue;
+        }
+        const int x = p->coordinates()[0];
+        const int y = p->coordinates()[1];
+        const int value = *(const int *)p->value();
+        if (p->dimensions != 2 || x < 0 || x >= W || y < 0 || y >= H || value != x + y * W) {
+            printf("Bad store packet %d: f(%d, %d) = %d\n", p->id, x, y, value);
+            return -1;
+        }
+        if (stored[x + y * W]) {
+            printf("f(%d, %d) was stored more than once\n", x, y);
+            return -1;
+        }
+        stored[x + y * W] = true;
+        stores++;
+    }
+
+    if (expect_all_stores && stores != W * H) {
+        printf("Expected %d stores of f, got %d\n", W * H, stores);
+        return -1;
+    }
+    return stores;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support writing trace files.\n");
+        return 0;
+    }
+
+    // Use enough threads that they write to many shards of the trace
+    // buffer, and enough stores that the shards fill up many times.
+    set_env("HL_NUM_THREADS", "8");
+
+    Func f("f");
+    Var x, y;
+    f(x, y) = x + y * W;
+    f.parallel(y).trace_stores();
+    Pipeline p(f);
+
+    std::string path = Internal::get_test_tmp_dir() + "tracing_file.bin";
+    Internal::ensure_no_file_exists(path);
+    set_env("HL_TRACE_FILE", path.c_str());
+    p.realize({W, H});
+    if (check_trace(path, true) < 0) {
+        return 1;
+    }
+
+    // The trace file and sample period are read once by each runtime, so
+    // get a fresh one to sample the stores.
+    Internal::JITSharedRuntime::release_all();
+    p.invalidate_cache();
+    std::string sampled_path = Internal::get_test_tmp_dir() + "tracing_file_sampled.bin";
+    Internal::ensure_no_file_exists(sampled_path);
+    set_env("HL_TRACE_FILE", sampled_path.c_str());
+    set_env("HL_TRACE_SAMPLE", "10");
+    p.realize({W, H});
+    const int sampled_stores = check_trace(sampled_path, false);
+    if (sampled_stores < 0) {
+        return 1;
+    }
+    if (sampled_stores != (W * H + 9) / 10) {
+        printf("Expected %d sampled stores of f, got %d\n", (W * H + 9) / 10, sampled_stores);
+        return 1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
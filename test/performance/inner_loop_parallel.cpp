@@ -19,32 +19,38 @@ int main(int argc, char **argv) {
 
     Pipeline p(f);
 
-    // Having more threads than tasks shouldn't hurt performance too much.
-    double correct_time = 0;
-
-    for (int t = 2; t <= 64; t *= 2) {
-        std::ostringstream ss;
-        ss << "HL_NUM_THREADS=" << t;
-        std::string str = ss.str();
-        char buf[32] = {0};
-        memcpy(buf, str.c_str(), str.size());
-        putenv(buf);
-        p.invalidate_cache();
-        Halide::Internal::JITSharedRuntime::release_all();
-
-        p.compile_jit();
-        // Start the thread pool without giving any hints as to the
-        // number of tasks we'll be using.
-        p.realize({t, 1});
-        double min_time = benchmark([&]() { return p.realize({2, 1000000}); });
-
-        printf("%d: %f ms\n", t, min_time * 1e3);
-        if (t == 2) {
-            correct_time = min_time;
-        } else if (min_time > correct_time * 5) {
-            printf("Unacceptable overhead when using %d threads for 2 tasks: %f ms vs %f ms\n",
-                   t, min_time, correct_time);
-            return -1;
+    // Run with both the shared job stack and the work-stealing scheduler.
+    char stealing_env[2][32] = {"HL_WORK_STEALING=0", "HL_WORK_STEALING=1"};
+    for (int stealing = 0; stealing < 2; stealing++) {
+        putenv(stealing_env[stealing]);
+
+        // Having more threads than tasks shouldn't hurt performance too much.
+        double correct_time = 0;
+
+        for (int t = 2; t <= 64; t *= 2) {
+            std::ostringstream ss;
+            ss << "HL_NUM_THREADS=" << t;
+            std::string str = ss.str();
+            char buf[32] = {0};
+            memcpy(buf, str.c_str(), str.size());
+            putenv(buf);
+            p.invalidate_cache();
+            Halide::Internal::JITSharedRuntime::release_all();
+
+            p.compile_jit();
+            // Start the thread pool without giving any hints as to the
+            // number of tasks we'll be using.
+            p.realize({t, 1});
+            double min_time = benchmark([&]() { return p.realize({2, 1000000}); });
+
+            printf("%s %d: %f ms\n", stealing ? "work stealing" : "shared stack", t, min_time * 1e3);
+            if (t == 2) {
+                correct_time = min_time;
+            } else if (min_time > correct_time * 5) {
+                printf("Unacceptable overhead when using %d threads for 2 tasks: %f ms vs %f ms\n",
+                       t, min_time, correct_time);
+                return -1;
+            }
         }
     }
 
@@ -0,0 +1,84 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Each configuration runs in a forked child, so that the peak RSS of
+// one isn't inflated by another.
+
+#ifndef _WIN32
+
+// A large pipeline: a chain of unrolled stencils.
+Func make_pipeline() {
+    ImageParam in(Float(32), 2, "in");
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+    Func prev = BoundaryConditions::repeat_edge(in);
+    std::vector<Func> stages;
+    for (int i = 0; i < 12; i++) {
+        Func next("stage_" + std::to_string(i));
+        Expr e = 0.0f;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                e += prev(x + dx, y + dy) * (float)(i + dx * 3 + dy + 5);
+            }
+        }
+        next(x, y) = e;
+        stages.push_back(next);
+        prev = next;
+    }
+    Func out = stages.back();
+    out.tile(x, y, xi, yi, 64, 8).vectorize(xi, 8).unroll(yi).parallel(y);
+    for (size_t i = 0; i + 1 < stages.size(); i++) {
+        stages[i].compute_at(out, x).vectorize(x, 8).unroll(y);
+    }
+    return out;
+}
+
+void measure(IRArena::Mode mode, const char *name) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        IRArena::set_mode(mode);
+        Func f = make_pipeline();
+        double t = Tools::benchmark(3, 1, [&]() {
+            f.compile_to_module({}, "f", get_host_target());
+        });
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        printf("%-24s lowering: %8.2f ms, peak RSS: %8ld kB\n", name, t * 1e3, (long)usage.ru_maxrss);
+        fflush(stdout);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+#endif
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] This test uses fork(), which is unavailable on Windows.\n");
+    return 0;
+#else
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    measure(IRArena::Mode::Off, "heap");
+    measure(IRArena::Mode::Shared, "arena");
+    measure(IRArena::Mode::ThreadPrivate, "thread-private arena");
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
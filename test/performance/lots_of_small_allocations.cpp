@@ -12,10 +12,18 @@ int main(int argc, char **argv) {
 
     Param<int> p;
 
-    const char *names[3] = {"heap", "pseudostack", "stack"};
+    const char *names[4] = {"heap", "pseudostack", "stack", "heap with host allocation pool"};
+
+    char reuse_env[] = "HL_REUSE_HOST_ALLOCATIONS=1";
+
+    double t[4];
+    for (int i = 0; i < 4; i++) {
+        if (i == 3) {
+            // Let the runtime cache freed heap allocations.
+            putenv(reuse_env);
+            Halide::Internal::JITSharedRuntime::release_all();
+        }
 
-    double t[3];
-    for (int i = 0; i < 3; i++) {
         Var x("x");
 
         Func in;
@@ -35,7 +43,7 @@ int main(int argc, char **argv) {
         chain.back().split(x, xo, xi, p, TailStrategy::RoundUp);
         for (size_t j = 0; j < chain.size() - 1; j++) {
             chain[j].compute_at(chain.back(), xo);
-            if (i != 0) {
+            if (i == 1 || i == 2) {
                 chain[j].store_in(MemoryType::Stack);
             }
             if (i == 2) {
@@ -72,6 +80,8 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    printf("Speedup from host allocation pool: %f\n", t[0] / t[3]);
+
     printf("Success!\n");
     return 0;
 }
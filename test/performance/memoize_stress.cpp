@@ -0,0 +1,128 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+/** \file Many threads realizing the same memoized pipeline with
+ * different parameters, in the way a server handling concurrent
+ * requests would. Most requests use one of a few hot keys and the rest
+ * are spread over a set too large to fit in the cache, so the run
+ * exercises hits, misses and evictions all at once.
+ */
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+const int kThreads = 16;
+const int kRequestsPerThread = 200;
+const int kHotKeys = 4;
+const int kColdKeys = 64;
+const int kSize = 64;
+
+std::atomic<bool> mismatch{false};
+
+int32_t expected(int x, int y, int p) {
+    int32_t e = x + y * kSize + p;
+    for (int i = 0; i < 20; i++) {
+        e = (e * 17 + p) % 1021;
+    }
+    return e + 1;
+}
+
+struct memoized_pipeline {
+    Param<int32_t> p;
+    Func expensive, f;
+    Var x, y;
+
+    memoized_pipeline() {
+        Expr e = x + y * kSize + p;
+        for (int i = 0; i < 20; i++) {
+            e = (e * 17 + p) % 1021;
+        }
+        expensive(x, y) = e;
+        f(x, y) = expensive(x, y) + 1;
+        expensive.compute_root().memoize();
+    }
+};
+
+void worker(int index, memoized_pipeline &pipeline) {
+    uint32_t seed = index * 7919 + 1;
+    for (int i = 0; i < kRequestsPerThread; i++) {
+        seed = seed * 1664525 + 1013904223;
+        int key = ((seed >> 8) % 4 != 0) ? (seed >> 16) % kHotKeys : kHotKeys + (seed >> 16) % kColdKeys;
+        Buffer<int32_t> result = pipeline.f.realize({kSize, kSize}, get_jit_target_from_environment(),
+                                                    {{pipeline.p, key}});
+        if (result(3, 5) != expected(3, 5, key)) {
+            printf("Mismatch for key %d at (3, 5): %d vs %d\n", key, result(3, 5), expected(3, 5, key));
+            mismatch = true;
+        }
+    }
+}
+
+void run_all(memoized_pipeline &pipeline) {
+    std::thread threads[kThreads];
+    for (auto &thread : threads) {
+        thread = std::thread(worker, (int)(&thread - threads), std::ref(pipeline));
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    memoized_pipeline pipeline;
+    pipeline.f.compile_jit();
+
+    // Enough room for the hot keys and a quarter of the cold ones.
+    const int64_t entry_bytes = kSize * kSize * sizeof(int32_t);
+    Internal::JITSharedRuntime::memoization_cache_set_size(entry_bytes * (kHotKeys + kColdKeys / 4));
+
+    // Check a few keys in full before timing anything.
+    for (int key = 0; key < kHotKeys + kColdKeys; key += 7) {
+        pipeline.p.set(key);
+        Buffer<int32_t> result = pipeline.f.realize({kSize, kSize});
+        for (int y = 0; y < kSize; y++) {
+            for (int x = 0; x < kSize; x++) {
+                if (result(x, y) != expected(x, y, key)) {
+                    printf("Mismatch for key %d at (%d, %d): %d vs %d\n", key, x, y, result(x, y), expected(x, y, key));
+                    return 1;
+                }
+            }
+        }
+    }
+
+    Internal::JITSharedRuntime::memoization_cache_reset_stats();
+    double t = benchmark(3, 1, [&]() { run_all(pipeline); });
+
+    halide_memoization_cache_stats_t stats;
+    Internal::JITSharedRuntime::memoization_cache_get_stats(&stats);
+    const int requests = kThreads * kRequestsPerThread;
+    printf("%d threads x %d requests: %f ms per round, %f us per request\n",
+           kThreads, kRequestsPerThread, t * 1e3, t * 1e6 / requests);
+    printf("hits %llu, misses %llu, evictions %llu (%llu bytes), %llu entries using %lld of %lld bytes\n",
+           (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           (unsigned long long)stats.evictions, (unsigned long long)stats.evicted_bytes,
+           (unsigned long long)stats.entries, (long long)stats.current_size, (long long)stats.max_size);
+
+    // Return cache size to default.
+    Internal::JITSharedRuntime::memoization_cache_set_size(0);
+
+    if (mismatch) {
+        return 1;
+    }
+    if (stats.hits == 0 || stats.misses == 0 || stats.evictions == 0) {
+        printf("Expected hits, misses and evictions\n");
+        return 1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -26,10 +26,25 @@ int main(int argc, char **argv) {
     g(x, y) = math;
 
     f.parallel(y);
+    Pipeline p(f);
 
-    Buffer<float> imf = f.realize({W, H});
+    Buffer<float> imf = p.realize({W, H});
 
-    double parallelTime = benchmark([&]() { f.realize(imf); });
+    double parallelTime = benchmark([&]() { p.realize(imf); });
+
+    // Compare against the work-stealing scheduler in the thread pool.
+    // The compiled pipeline holds on to the runtime it was linked
+    // against, so recompile it as well as dropping the shared runtime.
+    char work_stealing_env[] = "HL_WORK_STEALING=1";
+    putenv(work_stealing_env);
+    Halide::Internal::JITSharedRuntime::release_all();
+    p.invalidate_cache();
+    p.realize(imf);
+    double stealingTime = benchmark([&]() { p.realize(imf); });
+    char no_work_stealing_env[] = "HL_WORK_STEALING=0";
+    putenv(no_work_stealing_env);
+    Halide::Internal::JITSharedRuntime::release_all();
+    p.invalidate_cache();
 
     printf("Realizing g\n");
     Buffer<float> img = g.realize({W, H});
@@ -47,9 +62,10 @@ int main(int argc, char **argv) {
         }
     }
 
-    printf("Times: %f %f\n", serialTime, parallelTime);
+    printf("Times: %f %f %f\n", serialTime, parallelTime, stealingTime);
     double speedup = serialTime / parallelTime;
     printf("Speedup: %f\n", speedup);
+    printf("Speedup with work stealing: %f\n", serialTime / stealingTime);
 
     if (speedup < 1.5) {
         fprintf(stderr, "WARNING: Parallel should be faster\n");
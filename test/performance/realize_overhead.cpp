@@ -1,5 +1,6 @@
 #include "Halide.h"
 #include <iostream>
+#include <string>
 
 #include "halide_benchmark.h"
 
@@ -135,6 +136,40 @@ int main(int argc, char **argv) {
         std::cout << "One argument Pipeline realize reusing Realization/Target/ParamMap time " << t * 1e6 << "us.\n";
     }
 
+    const char *old_reuse = getenv("HL_REUSE_HOST_ALLOCATIONS");
+    const std::string old_reuse_value = old_reuse ? old_reuse : "";
+    char reuse_env[2][32] = {"HL_REUSE_HOST_ALLOCATIONS=0", "HL_REUSE_HOST_ALLOCATIONS=1"};
+    for (int reuse = 0; reuse < 2; reuse++) {
+        // A pipeline with an intermediate that is heap-allocated and
+        // freed on every call, with and without the host allocation pool.
+        putenv(reuse_env[reuse]);
+        Internal::JITSharedRuntime::release_all();
+
+        Func f, g;
+        Var x;
+        f(x) = x;
+        g(x) = f(x) + f(x + 1);
+        f.compute_root();
+        g.compile_jit();
+
+        Buffer<int32_t> buf(1024);
+        double t = benchmark([&]() { g.realize(buf); });
+        std::cout << "Func with heap intermediate realize time " << (reuse ? "with" : "without")
+                  << " host allocation pool " << t * 1e6 << "us.\n";
+    }
+    // Put the setting back as it was, and drop the runtime that has the
+    // pool turned on, so that it doesn't carry over to what follows.
+#ifdef _WIN32
+    _putenv_s("HL_REUSE_HOST_ALLOCATIONS", old_reuse_value.c_str());
+#else
+    if (old_reuse) {
+        setenv("HL_REUSE_HOST_ALLOCATIONS", old_reuse_value.c_str(), 1);
+    } else {
+        unsetenv("HL_REUSE_HOST_ALLOCATIONS");
+    }
+#endif
+    Internal::JITSharedRuntime::release_all();
+
     for (int i = 10; i < 100; i += 10) {
         Func f;
         std::vector<Param<int>> params(i);
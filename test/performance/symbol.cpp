@@ -0,0 +1,97 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include <cstdio>
+#include <map>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// A large pipeline: a chain of unrolled stencils.
+Func make_pipeline() {
+    ImageParam in(Float(32), 2, "in");
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+    Func prev = BoundaryConditions::repeat_edge(in);
+    std::vector<Func> stages;
+    for (int i = 0; i < 12; i++) {
+        Func next("stage_" + std::to_string(i));
+        Expr e = 0.0f;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                e += prev(x + dx, y + dy) * (float)(i + dx * 3 + dy + 5);
+            }
+        }
+        next(x, y) = e;
+        stages.push_back(next);
+        prev = next;
+    }
+    Func out = stages.back();
+    out.tile(x, y, xi, yi, 64, 8).vectorize(xi, 8).unroll(yi).parallel(y);
+    for (size_t i = 0; i + 1 < stages.size(); i++) {
+        stages[i].compute_at(out, x).vectorize(x, 8).unroll(y);
+    }
+    return out;
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    // Look up the names of variables the way a pass does while
+    // traversing IR: by the name of each node, in a table of the names
+    // bound by enclosing lets. A std::map keyed by string is how Scope
+    // used to hold names.
+    const int num_names = 64;
+    std::vector<Expr> vars;
+    std::map<std::string, int> by_string;
+    Scope<int> by_symbol;
+    for (int i = 0; i < num_names; i++) {
+        std::string name = unique_name("t") + ".s0.x.x_vo";
+        vars.push_back(Variable::make(Int(32), name));
+        by_string[name] = i;
+        by_symbol.push(name, i);
+    }
+
+    const int reps = 1000;
+    int sum_string = 0, sum_symbol = 0;
+    double t_string = Tools::benchmark(5, 1, [&]() {
+        for (int r = 0; r < reps; r++) {
+            for (const Expr &v : vars) {
+                sum_string += by_string.find(v.as<Variable>()->name)->second;
+            }
+        }
+    });
+    double t_symbol = Tools::benchmark(5, 1, [&]() {
+        for (int r = 0; r < reps; r++) {
+            for (const Expr &v : vars) {
+                sum_symbol += by_symbol.get(v.as<Variable>()->symbol());
+            }
+        }
+    });
+    if (sum_string != sum_symbol) {
+        printf("Lookups by string and by Symbol found different values\n");
+        return 1;
+    }
+    const double lookups = (double)reps * num_names;
+    printf("Lookup by string:  %6.2f ns\n"
+           "Lookup by Symbol:  %6.2f ns\n",
+           t_string * 1e9 / lookups, t_symbol * 1e9 / lookups);
+
+    if (t_symbol > t_string) {
+        printf("Looking up names by Symbol was slower than by string\n");
+        return 1;
+    }
+
+    // Lowering time for a large pipeline. Run this on builds with and
+    // without interned names to compare them.
+    Func f = make_pipeline();
+    double t_lower = Tools::benchmark(3, 1, [&]() {
+        f.compile_to_module({}, "f", get_host_target());
+    });
+    printf("Lowering:          %6.2f ms (%d names interned)\n",
+           t_lower * 1e3, (int)Symbol::table_size());
+
+    printf("Success!\n");
+    return 0;
+}
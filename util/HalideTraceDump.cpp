@@ -13,7 +13,8 @@
 
 /** \file
  *
- * A tool which can read a binary Halide trace file, and dump files
+ * A tool which can read a binary Halide trace file, in either the raw or
+ * the compact format, and dump files
  * containing the final pixel values recorded for each traced Func.
  *
  * Currently dumps into supported Halide image formats.
@@ -273,7 +274,8 @@ void usage(char *const *argv) {
         "Usage: " + string(argv[0]) +
         " -i trace_file -t {png,jpg,pgm,tmp,mat}\n"
         "\n"
-        "This tool reads a binary trace produced by Halide, and dumps all\n"
+        "This tool reads a binary trace produced by Halide, or converted to the\n"
+        "compact format by HalideTraceSummary, and dumps all\n"
         "Funcs into individual image files in the current directory.\n"
         "To generate a suitable binary trace, use Func::trace_stores(), or the\n"
         "target features trace_stores and trace_realizations, and run with\n"
@@ -325,6 +327,8 @@ int main(int argc, char *const *argv) {
         exit(1);
     }
 
+    TraceReader reader(file_desc);
+
     printf("[INFO] Starting parse of binary trace...\n");
     int packet_count = 0;
 
@@ -334,7 +338,7 @@ int main(int argc, char *const *argv) {
 
     for (;;) {
         Packet p;
-        if (!p.read_from_filedesc(file_desc)) {
+        if (!reader.next(&p)) {
             printf("[INFO] Finished pass 1 after %d packets.\n", packet_count);
             break;
         }
@@ -356,8 +360,7 @@ int main(int argc, char *const *argv) {
     }
 
     packet_count = 0;
-    fseek(file_desc, 0, SEEK_SET);
-    if (ferror(file_desc)) {
+    if (!reader.rewind()) {
         fprintf(stderr, "Error: couldn't seek back to beginning of trace file. Aborting.\n");
         exit(-1);
     }
@@ -368,7 +371,7 @@ int main(int argc, char *const *argv) {
 
     for (;;) {
         Packet p;
-        if (!p.read_from_filedesc(file_desc)) {
+        if (!reader.next(&p)) {
             printf("[INFO] Finished pass 2 after %d packets.\n", packet_count);
             if (file_desc != nullptr) {
                 fclose(file_desc);
@@ -0,0 +1,374 @@
+#include "HalideRuntime.h"
+#include "HalideTraceUtils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** \file
+ *
+ * A tool which reads a binary Halide trace, in either the raw format
+ * written by halide_default_trace or the compact format, and summarizes
+ * how each traced Func is accessed: how often each element is loaded and
+ * stored, how far apart the accesses to an element are, and how many
+ * distinct elements are touched over time. It can also convert a trace to
+ * the compact format as it goes.
+ *
+ * The trace is processed one packet at a time, so the memory used grows
+ * with the number of distinct elements touched, not the length of the
+ * trace.
+ */
+
+using namespace Halide;
+using namespace Internal;
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Histograms with a bucket for zero, and then one for each power of two.
+struct Histogram {
+    static constexpr int num_buckets = 34;
+    uint64_t counts[num_buckets] = {0};
+
+    void add(uint64_t x) {
+        int bucket = 0;
+        while (x > 0 && bucket < num_buckets - 1) {
+            x >>= 1;
+            bucket++;
+        }
+        counts[bucket]++;
+    }
+
+    void print(const char *title, const char *unit) const {
+        int last = num_buckets - 1;
+        while (last >= 0 && counts[last] == 0) {
+            last--;
+        }
+        if (last < 0) {
+            return;
+        }
+        uint64_t total = 0;
+        for (int i = 0; i <= last; i++) {
+            total += counts[i];
+        }
+        printf("  %s:\n", title);
+        for (int i = 0; i <= last; i++) {
+            if (counts[i] == 0) {
+                continue;
+            }
+            const uint64_t lo = i == 0 ? 0 : (uint64_t)1 << (i - 1);
+            const uint64_t hi = i == 0 ? 0 : ((uint64_t)1 << i) - 1;
+            char range[64];
+            if (lo == hi) {
+                snprintf(range, sizeof(range), "%llu", (unsigned long long)lo);
+            } else {
+                snprintf(range, sizeof(range), "%llu-%llu", (unsigned long long)lo, (unsigned long long)hi);
+            }
+            printf("    %24s %-10s %12llu %6.2f%%\n", range, unit,
+                   (unsigned long long)counts[i], 100.0 * counts[i] / total);
+        }
+    }
+};
+
+// What we remember about each element of a Func that has been accessed.
+struct ElementInfo {
+    // The index (counting accesses to the Func) of the last access.
+    uint64_t last_access;
+    // The footprint window in which this element was last accessed.
+    uint64_t last_window;
+    uint32_t loads;
+    uint32_t stores;
+};
+
+struct FuncStats {
+    uint64_t loads = 0, stores = 0;
+    uint64_t load_packets = 0, store_packets = 0;
+    uint64_t realizations = 0;
+    int dimensions = -1;
+    vector<int> min_coords, max_coords;
+
+    // Keyed by a hash of the value index and the coordinates.
+    std::unordered_map<uint64_t, ElementInfo> elements;
+
+    // The distinct elements touched in the current footprint window.
+    uint64_t window_footprint = 0;
+    // The distinct elements touched in each footprint window so far.
+    vector<uint64_t> footprint;
+
+    // The number of accesses to the Func between two accesses to the same
+    // element.
+    Histogram reuse_distance;
+
+    uint64_t accesses() const {
+        return loads + stores;
+    }
+};
+
+uint64_t element_key(const Packet &p, int lane, int dims) {
+    // FNV-1a.
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&](uint32_t x) {
+        for (int i = 0; i < 4; i++) {
+            h = (h ^ (x & 0xff)) * 1099511628211ULL;
+            x >>= 8;
+        }
+    };
+    mix((uint32_t)p.value_index);
+    for (int d = 0; d < dims; d++) {
+        mix((uint32_t)p.get_coord(p.type.lanes * d + lane));
+    }
+    return h;
+}
+
+class Summarizer {
+public:
+    explicit Summarizer(uint64_t window)
+        : window(window) {
+    }
+
+    void add(const Packet &p) {
+        packets++;
+        event_counts[p.event]++;
+        if (p.event == halide_trace_begin_realization) {
+            funcs[p.func()].realizations++;
+            return;
+        }
+        if (p.event != halide_trace_load && p.event != halide_trace_store) {
+            return;
+        }
+
+        FuncStats &f = funcs[p.func()];
+        const int lanes = p.type.lanes;
+        const int dims = p.dimensions / lanes;
+        if (f.dimensions < 0) {
+            f.dimensions = dims;
+            f.min_coords.resize(dims, INT32_MAX);
+            f.max_coords.resize(dims, INT32_MIN);
+        } else if (f.dimensions != dims) {
+            fprintf(stderr, "Error: packet dimensionality doesn't match previous packets of Func %s. Aborting.\n", p.func());
+            exit(-1);
+        }
+        const bool is_load = p.event == halide_trace_load;
+        if (is_load) {
+            f.load_packets++;
+        } else {
+            f.store_packets++;
+        }
+
+        for (int lane = 0; lane < lanes; lane++) {
+            // Start a new footprint window every `window` element accesses
+            // to any Func.
+            if (window > 0 && accesses > 0 && accesses % window == 0) {
+                end_window();
+            }
+            accesses++;
+
+            for (int d = 0; d < dims; d++) {
+                const int c = p.get_coord(lanes * d + lane);
+                f.min_coords[d] = std::min(f.min_coords[d], c);
+                f.max_coords[d] = std::max(f.max_coords[d], c);
+            }
+
+            const uint64_t access = f.accesses();
+            auto inserted = f.elements.emplace(element_key(p, lane, dims), ElementInfo{access, windows, 0, 0});
+            ElementInfo &e = inserted.first->second;
+            if (inserted.second) {
+                f.window_footprint++;
+            } else {
+                f.reuse_distance.add(access - e.last_access - 1);
+                if (e.last_window != windows) {
+                    f.window_footprint++;
+                }
+                e.last_access = access;
+                e.last_window = windows;
+            }
+            if (is_load) {
+                f.loads++;
+                e.loads++;
+            } else {
+                f.stores++;
+                e.stores++;
+            }
+        }
+    }
+
+    void print() {
+        if (window > 0 && accesses % window != 0) {
+            end_window();
+        }
+
+        static const char *const event_names[] = {
+            "load", "store", "begin_realization", "end_realization",
+            "produce", "end_produce", "consume", "end_consume",
+            "begin_pipeline", "end_pipeline", "tag"};
+        printf("Packets: %llu\n", (unsigned long long)packets);
+        for (const auto &it : event_counts) {
+            const char *name = it.first >= 0 && it.first <= halide_trace_tag ? event_names[it.first] : "unknown";
+            printf("  %-20s %12llu\n", name, (unsigned long long)it.second);
+        }
+
+        for (const auto &it : funcs) {
+            const FuncStats &f = it.second;
+            if (f.accesses() == 0) {
+                continue;
+            }
+            printf("\nFunc %s:\n", it.first.c_str());
+            printf("  loads: %llu (%llu packets), stores: %llu (%llu packets), realizations: %llu\n",
+                   (unsigned long long)f.loads, (unsigned long long)f.load_packets,
+                   (unsigned long long)f.stores, (unsigned long long)f.store_packets,
+                   (unsigned long long)f.realizations);
+            printf("  bounds:");
+            for (int d = 0; d < f.dimensions; d++) {
+                printf(" [%d, %d]", f.min_coords[d], f.max_coords[d]);
+            }
+            printf("\n");
+            printf("  distinct elements: %llu\n", (unsigned long long)f.elements.size());
+
+            Histogram loads_per_element, stores_per_element;
+            for (const auto &e : f.elements) {
+                loads_per_element.add(e.second.loads);
+                stores_per_element.add(e.second.stores);
+            }
+            loads_per_element.print("loads per element", "loads");
+            stores_per_element.print("stores per element", "stores");
+            f.reuse_distance.print("reuse distance (accesses to this Func between accesses to an element)", "accesses");
+        }
+
+        if (window > 0) {
+            printf("\nFootprint (distinct elements touched per window of %llu accesses):\n", (unsigned long long)window);
+            printf("%12s", "window");
+            for (const auto &it : funcs) {
+                if (it.second.accesses() > 0) {
+                    printf(" %16s", it.first.c_str());
+                }
+            }
+            printf("\n");
+            for (uint64_t w = 0; w < windows; w++) {
+                printf("%12llu", (unsigned long long)w);
+                for (const auto &it : funcs) {
+                    if (it.second.accesses() > 0) {
+                        printf(" %16llu", (unsigned long long)it.second.footprint[w]);
+                    }
+                }
+                printf("\n");
+            }
+        }
+    }
+
+private:
+    void end_window() {
+        for (auto &it : funcs) {
+            it.second.footprint.resize(windows, 0);
+            it.second.footprint.push_back(it.second.window_footprint);
+            it.second.window_footprint = 0;
+        }
+        windows++;
+    }
+
+    uint64_t window;
+    uint64_t windows = 0;
+    uint64_t packets = 0;
+    uint64_t accesses = 0;
+    map<int, uint64_t> event_counts;
+    map<string, FuncStats> funcs;
+};
+
+void usage(char *const *argv) {
+    const string usage =
+        "Usage: " + string(argv[0]) +
+        " [-i trace_file] [-o compact_trace_file] [-w window]\n"
+        "\n"
+        "This tool reads a binary trace produced by Halide, from trace_file or\n"
+        "stdin, and prints a summary of the loads and stores of each traced\n"
+        "Func: histograms of the loads and stores per element and of the reuse\n"
+        "distance between accesses to an element, and, if a window is given,\n"
+        "the footprint of each Func in each window of that many accesses.\n"
+        "The trace may be in the raw format written by Halide, or the compact\n"
+        "format written by -o, which converts the trace as it is read.\n"
+        "To generate a suitable binary trace, use Func::trace_loads() and\n"
+        "Func::trace_stores(), or the target features trace_loads and\n"
+        "trace_stores, and run with HL_TRACE_FILE=<filename>.\n";
+    fprintf(stderr, "%s\n", usage.c_str());
+    exit(1);
+}
+
+}  // namespace
+
+int main(int argc, char *const *argv) {
+    const char *in_filename = nullptr;
+    const char *out_filename = nullptr;
+    uint64_t window = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv);
+        } else if (arg == "-i") {
+            in_filename = argv[++i];
+        } else if (arg == "-o") {
+            out_filename = argv[++i];
+        } else if (arg == "-w") {
+            window = strtoull(argv[++i], nullptr, 10);
+        } else {
+            usage(argv);
+        }
+    }
+
+    FILE *in = stdin;
+    if (in_filename) {
+        in = fopen(in_filename, "rb");
+        if (in == nullptr) {
+            fprintf(stderr, "Error opening file: %s. Exiting.\n", in_filename);
+            exit(1);
+        }
+    }
+    FILE *out = nullptr;
+    if (out_filename) {
+        out = fopen(out_filename, "wb");
+        if (out == nullptr) {
+            fprintf(stderr, "Error opening file: %s. Exiting.\n", out_filename);
+            exit(1);
+        }
+    }
+
+    TraceReader reader(in);
+    std::unique_ptr<CompactTraceWriter> writer;
+    if (out) {
+        writer.reset(new CompactTraceWriter(out));
+    }
+
+    Summarizer summarizer(window);
+    uint64_t raw_bytes = 0;
+    Packet p;
+    while (reader.next(&p)) {
+        raw_bytes += p.size;
+        summarizer.add(p);
+        if (writer) {
+            writer->write(p);
+        }
+    }
+
+    printf("Trace format: %s\n", reader.is_compact() ? "compact" : "raw");
+    summarizer.print();
+
+    if (writer) {
+        printf("\nWrote compact trace %s: %llu bytes, from %llu bytes of packets (%.1fx smaller)\n",
+               out_filename, (unsigned long long)writer->bytes_written(), (unsigned long long)raw_bytes,
+               writer->bytes_written() ? (double)raw_bytes / writer->bytes_written() : 0.0);
+        writer.reset();
+        fclose(out);
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+    return 0;
+}
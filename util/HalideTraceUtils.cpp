@@ -12,8 +12,12 @@ bool Packet::read_from_stdin() {
 }
 
 bool Packet::read_from_filedesc(FILE *fdesc) {
+    return read_from_filedesc(fdesc, 0);
+}
+
+bool Packet::read_from_filedesc(FILE *fdesc, size_t bytes_already_read) {
     size_t header_size = sizeof(halide_trace_packet_t);
-    if (!Packet::read(this, header_size, fdesc)) {
+    if (!Packet::read((uint8_t *)this + bytes_already_read, header_size - bytes_already_read, fdesc)) {
         return false;
     }
     size_t payload_size = size - header_size;
@@ -51,5 +55,275 @@ void bad_type_error(halide_type_t type) {
     exit(-1);
 }
 
+// The first byte of a raw trace is the low byte of the size of a packet,
+// which is always a multiple of four, so the odd first byte here tells the
+// formats apart. The last byte is the version of the format.
+const uint8_t compact_trace_magic[5] = {0x89, 'H', 'T', 'R', 1};
+
+namespace {
+
+enum {
+    record_has_type = 0x10,
+    record_has_trace_tag = 0x20,
+};
+
+bool has_value(int event) {
+    return event == halide_trace_load || event == halide_trace_store;
+}
+
+void put_varint(std::vector<uint8_t> &out, uint64_t x) {
+    while (x >= 0x80) {
+        out.push_back((uint8_t)(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back((uint8_t)x);
+}
+
+void put_svarint(std::vector<uint8_t> &out, int64_t x) {
+    put_varint(out, ((uint64_t)x << 1) ^ (uint64_t)(x >> 63));
+}
+
+int64_t unzigzag(uint64_t x) {
+    return (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+}
+
+[[noreturn]] void bad_compact_trace(const char *why) {
+    fprintf(stderr, "Malformed compact trace: %s\n", why);
+    exit(-1);
+}
+
+}  // namespace
+
+CompactTraceWriter::CompactTraceWriter(FILE *fdesc)
+    : fdesc(fdesc) {
+    strings[""] = 0;
+    if (fwrite(compact_trace_magic, sizeof(compact_trace_magic), 1, fdesc) != 1) {
+        perror("Failed during write");
+        exit(-1);
+    }
+    bytes = sizeof(compact_trace_magic);
+}
+
+void CompactTraceWriter::put_string(const char *s) {
+    auto it = strings.find(s);
+    if (it != strings.end()) {
+        put_varint(record, it->second);
+        return;
+    }
+    const uint32_t index = (uint32_t)strings.size();
+    const size_t len = strlen(s);
+    strings.emplace(s, index);
+    put_varint(record, index);
+    put_varint(record, len);
+    record.insert(record.end(), s, s + len);
+}
+
+void CompactTraceWriter::write(const halide_trace_packet_t &p) {
+    record.clear();
+
+    const char *func = p.func();
+    const char *trace_tag = p.trace_tag();
+    auto func_it = strings.find(func);
+    const uint32_t func_index = func_it != strings.end() ? func_it->second : (uint32_t)strings.size();
+    CompactTraceState::Context &context = state.context(func_index, p.event);
+    const bool new_type = context.coordinates.empty() || !(context.type == p.type);
+
+    uint8_t code = (uint8_t)p.event;
+    if (new_type) {
+        code |= record_has_type;
+    }
+    if (*trace_tag) {
+        code |= record_has_trace_tag;
+    }
+    record.push_back(code);
+    put_string(func);
+    put_svarint(record, (int64_t)p.id - ((int64_t)state.last_id + 1));
+    put_svarint(record, (int64_t)p.id - p.parent_id);
+    state.last_id = p.id;
+    if (new_type) {
+        record.push_back(p.type.code);
+        record.push_back(p.type.bits);
+        put_varint(record, p.type.lanes);
+        context.type = p.type;
+    }
+    put_varint(record, (uint32_t)p.value_index);
+    put_varint(record, (uint32_t)p.dimensions);
+
+    // Coordinates are mostly a small step from those of the previous
+    // access to the same Func.
+    context.coordinates.resize(p.dimensions + 1, 0);
+    const int *coordinates = p.coordinates();
+    for (int i = 0; i < p.dimensions; i++) {
+        put_svarint(record, (int64_t)coordinates[i] - context.coordinates[i]);
+        context.coordinates[i] = coordinates[i];
+    }
+
+    if (has_value(p.event)) {
+        const uint8_t *value = (const uint8_t *)p.value();
+        record.insert(record.end(), value, value + p.type.lanes * p.type.bytes());
+    }
+    if (*trace_tag) {
+        put_string(trace_tag);
+    }
+
+    if (fwrite(record.data(), 1, record.size(), fdesc) != record.size()) {
+        perror("Failed during write");
+        exit(-1);
+    }
+    bytes += record.size();
+}
+
+TraceReader::TraceReader(FILE *fdesc)
+    : fdesc(fdesc) {
+    start();
+}
+
+void TraceReader::start() {
+    peeked_size = fread(peeked, 1, sizeof(peeked), fdesc);
+    compact = peeked_size == sizeof(peeked) &&
+              memcmp(peeked, compact_trace_magic, sizeof(peeked) - 1) == 0;
+    if (compact) {
+        if (peeked[sizeof(peeked) - 1] != compact_trace_magic[sizeof(peeked) - 1]) {
+            bad_compact_trace("unsupported version");
+        }
+        peeked_size = 0;
+    }
+    strings.assign(1, std::string());
+    state = CompactTraceState();
+}
+
+bool TraceReader::rewind() {
+    if (fseek(fdesc, 0, SEEK_SET) != 0) {
+        return false;
+    }
+    start();
+    return true;
+}
+
+bool TraceReader::next(Packet *p) {
+    if (compact) {
+        return next_compact(p);
+    }
+    if (peeked_size > 0) {
+        // A raw trace shorter than the header of one packet is empty.
+        const size_t n = peeked_size;
+        peeked_size = 0;
+        if (n < sizeof(peeked)) {
+            return false;
+        }
+        memcpy((void *)p, peeked, n);
+        return p->read_from_filedesc(fdesc, n);
+    }
+    return p->read_from_filedesc(fdesc);
+}
+
+uint64_t TraceReader::get_varint() {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(fdesc);
+        if (c == EOF) {
+            bad_compact_trace("unexpected EOF mid-record");
+        }
+        result |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return result;
+        }
+    }
+    bad_compact_trace("varint too long");
+}
+
+const std::string &TraceReader::get_string() {
+    const uint64_t index = get_varint();
+    if (index < strings.size()) {
+        return strings[index];
+    } else if (index > strings.size()) {
+        bad_compact_trace("string index out of range");
+    }
+    std::string s(get_varint(), '\0');
+    if (!s.empty() && fread(&s[0], 1, s.size(), fdesc) != s.size()) {
+        bad_compact_trace("unexpected EOF mid-record");
+    }
+    strings.push_back(std::move(s));
+    return strings.back();
+}
+
+bool TraceReader::next_compact(Packet *p) {
+    const int code = getc(fdesc);
+    if (code == EOF) {
+        if (ferror(fdesc)) {
+            perror("Failed during read");
+            exit(-1);
+        }
+        return false;
+    }
+    const int event = code & 0xf;
+    if (event > halide_trace_tag) {
+        bad_compact_trace("bad event code");
+    }
+
+    const std::string &func = get_string();
+    const uint32_t func_index = (uint32_t)(&func - strings.data());
+    CompactTraceState::Context &context = state.context(func_index, event);
+
+    p->event = (halide_trace_event_code_t)event;
+    p->id = (int32_t)(state.last_id + 1 + unzigzag(get_varint()));
+    p->parent_id = (int32_t)(p->id - unzigzag(get_varint()));
+    state.last_id = p->id;
+    if (code & record_has_type) {
+        uint8_t type_bytes[2];
+        if (fread(type_bytes, 1, 2, fdesc) != 2) {
+            bad_compact_trace("unexpected EOF mid-record");
+        }
+        context.type = halide_type_t((halide_type_code_t)type_bytes[0], type_bytes[1], (uint16_t)get_varint());
+    } else if (context.coordinates.empty()) {
+        bad_compact_trace("missing type");
+    }
+    p->type = context.type;
+    p->value_index = (int32_t)get_varint();
+    p->dimensions = (int32_t)get_varint();
+
+    const size_t value_bytes = p->type.lanes * p->type.bytes();
+    const size_t payload_size = p->dimensions * sizeof(int32_t) + value_bytes + func.size() + 1;
+    if (payload_size > sizeof(p->payload)) {
+        fprintf(stderr, "Payload larger than %d bytes in trace stream (%d)\n", (int)sizeof(p->payload), (int)payload_size);
+        abort();
+    }
+
+    context.coordinates.resize(p->dimensions + 1, 0);
+    int *coordinates = p->coordinates();
+    for (int i = 0; i < p->dimensions; i++) {
+        context.coordinates[i] = (int32_t)(context.coordinates[i] + unzigzag(get_varint()));
+        coordinates[i] = context.coordinates[i];
+    }
+
+    uint8_t *value = (uint8_t *)p->value();
+    if (has_value(event)) {
+        if (value_bytes && fread(value, 1, value_bytes, fdesc) != value_bytes) {
+            bad_compact_trace("unexpected EOF mid-record");
+        }
+    } else {
+        memset(value, 0, value_bytes);
+    }
+    // Copy the func name before reading the trace tag, which may grow the
+    // string table.
+    memcpy(p->func(), func.c_str(), func.size() + 1);
+
+    const char *trace_tag = "";
+    if (code & record_has_trace_tag) {
+        trace_tag = get_string().c_str();
+    }
+    const size_t trace_tag_bytes = strlen(trace_tag) + 1;
+    const size_t size = sizeof(halide_trace_packet_t) + payload_size + trace_tag_bytes;
+    if (size - sizeof(halide_trace_packet_t) + 3 > sizeof(p->payload)) {
+        fprintf(stderr, "Payload larger than %d bytes in trace stream (%d)\n", (int)sizeof(p->payload), (int)(size - sizeof(halide_trace_packet_t)));
+        abort();
+    }
+    char *dst = (char *)p->trace_tag();
+    memcpy(dst, trace_tag, trace_tag_bytes);
+    p->size = (uint32_t)((size + 3) & ~3);
+    memset(dst + trace_tag_bytes, 0, p->size - size);
+    return true;
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -2,8 +2,12 @@
 #define HALIDE_TRACE_UTILS_H
 
 #include "HalideRuntime.h"
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Halide {
 namespace Internal {
@@ -89,11 +93,116 @@ struct Packet : public halide_trace_packet_t {
     // Grab a packet from a particular fctl file descriptor. Returns false when end is reached.
     bool read_from_filedesc(FILE *fdesc);
 
+    // As above, but the first bytes_already_read bytes of the packet have
+    // already been read into this Packet.
+    bool read_from_filedesc(FILE *fdesc, size_t bytes_already_read);
+
 private:
     // Do a blocking read of some number of bytes from a unistd file descriptor.
     bool read(void *d, size_t size, FILE *fdesc);
 };
 
+/** The compact trace format. A compact trace starts with
+ * compact_trace_magic, followed by one record per packet:
+ *
+ *   u8       the event code in the low four bits, 0x10 if a type follows,
+ *            0x20 if a trace tag follows
+ *   string   the func name
+ *   svarint  the id, relative to the previous id plus one
+ *   svarint  the id minus the parent id
+ *   [u8 type code, u8 bits, varint lanes], if the type differs from the
+ *            previous record with the same func and event code
+ *   varint   the value index
+ *   varint   the number of coordinates
+ *   svarint  each coordinate, relative to the same coordinate of the
+ *            previous record with the same func and event code
+ *   bytes    the value, for loads and stores only
+ *   [string  the trace tag]
+ *
+ * Strings are a varint index into a table of the strings seen so far,
+ * which starts out holding just the empty string. An index equal to the
+ * size of the table adds a string to it, which follows as a varint length
+ * and then its bytes. Varints are unsigned LEB128; svarints are zigzag
+ * encoded first. Decoding a record gives back the packet that was encoded,
+ * except for the values of events other than loads and stores, which
+ * aren't meaningful and decode as zeros. */
+extern const uint8_t compact_trace_magic[5];
+
+// The state the encoder and decoder of a compact trace keep in sync.
+class CompactTraceState {
+public:
+    struct Context {
+        halide_type_t type;
+        std::vector<int32_t> coordinates;
+    };
+
+    // The previous record with this func and event code.
+    Context &context(uint32_t func, int event) {
+        return contexts[((uint64_t)func << 4) | (event & 0xf)];
+    }
+
+    int32_t last_id = 0;
+
+private:
+    std::unordered_map<uint64_t, Context> contexts;
+};
+
+// Writes packets to a file in the compact trace format.
+class CompactTraceWriter {
+public:
+    // Writes the header to the file.
+    explicit CompactTraceWriter(FILE *fdesc);
+
+    void write(const halide_trace_packet_t &p);
+
+    uint64_t bytes_written() const {
+        return bytes;
+    }
+
+private:
+    void put_string(const char *s);
+
+    FILE *fdesc;
+    uint64_t bytes = 0;
+    std::vector<uint8_t> record;
+    std::unordered_map<std::string, uint32_t> strings;
+    CompactTraceState state;
+};
+
+// Reads the packets of a trace one at a time, from either the stream of
+// halide_trace_packet_t written by halide_default_trace, or the compact
+// trace format.
+class TraceReader {
+public:
+    // Reads the start of the file to find out which format it is in.
+    explicit TraceReader(FILE *fdesc);
+
+    // Returns false when the end of the trace is reached.
+    bool next(Packet *p);
+
+    // Go back to the start of the trace. Returns false if the file can't
+    // seek.
+    bool rewind();
+
+    bool is_compact() const {
+        return compact;
+    }
+
+private:
+    void start();
+    bool next_compact(Packet *p);
+    uint64_t get_varint();
+    const std::string &get_string();
+
+    FILE *fdesc;
+    bool compact = false;
+    // The bytes read to find out the format of a raw trace.
+    uint8_t peeked[sizeof(compact_trace_magic)];
+    size_t peeked_size = 0;
+    std::vector<std::string> strings;
+    CompactTraceState state;
+};
+
 }  // namespace Internal
 }  // namespace Halide
 